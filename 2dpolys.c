@@ -16,6 +16,7 @@
 #include "spotfx.h"
 #include "water.h"
 #include "util.h"
+#include "pool.h"
 
 #ifdef OPT_ON
 #pragma optimize( "gty", on )
@@ -51,7 +52,7 @@ extern	MCLOADHEADER		MCloadheadert0;
 ===================================================================*/
 FMPOLY		FmPolys[ MAXNUMOF2DPOLYS ];
 u_int16_t		FirstFmPolyUsed;
-u_int16_t		FirstFmPolyFree;
+pool_t			FmPolyPool;
 u_int32_t		TotalFmPolysInUse = 0;
 TPAGEINFO	FmPolyTPages[ MAXTPAGESPERTLOAD + 1 ];
 
@@ -69,7 +70,7 @@ void InitFmPoly( void )
 	int i;
 
 	FirstFmPolyUsed = (u_int16_t) -1;
-	FirstFmPolyFree = 0;
+	pool_init( &FmPolyPool, "fmpolys", MAXNUMOF2DPOLYS );
 
 	for( i=0;i<MAXNUMOF2DPOLYS;i++)
 	{
@@ -95,10 +96,9 @@ void InitFmPoly( void )
 		FmPolys[i].NextInTPage = (u_int16_t) -1;
 		FmPolys[i].PrevInTPage = (u_int16_t) -1;
 
-		FmPolys[i].Next = i + 1;
+		FmPolys[i].Next = (u_int16_t) -1;
 		FmPolys[i].Prev = (u_int16_t) -1;
 	}
-	FmPolys[MAXNUMOF2DPOLYS-1].Next = (u_int16_t) -1;
 
 	InitFmPolyTPages();
 }
@@ -113,9 +113,10 @@ u_int16_t FindFreeFmPoly( void )
 {
 	u_int16_t i;
 
-	i = FirstFmPolyFree;
-	if( i == (u_int16_t) -1 ) return i;
+	i = pool_alloc( &FmPolyPool );
+	if( i == POOL_NONE ) return i;
 
+	FmPolys[i].Next = (u_int16_t) -1;
 	FmPolys[i].Prev = FirstFmPolyUsed;
 
 	if ( FirstFmPolyUsed != (u_int16_t) -1)
@@ -124,7 +125,6 @@ u_int16_t FindFreeFmPoly( void )
 	}
 
 	FirstFmPolyUsed = i;
-	FirstFmPolyFree = FmPolys[i].Next;
 
 	TotalFmPolysInUse++;
 
@@ -158,7 +158,7 @@ void KillUsedFmPoly( u_int16_t i )
 	RemoveFmPolyFromTPage( i, GetTPage( *FmPolys[i].Frm_Info, 0 ) );
 
 	FmPolys[i].Prev = (u_int16_t) -1;
-	FmPolys[i].Next = FirstFmPolyFree;
+	FmPolys[i].Next = (u_int16_t) -1;
 	FmPolys[i].LifeCount = 0.0F;
 	FmPolys[i].xsize = ( 16.0F * GLOBAL_SCALE );
 	FmPolys[i].ysize = ( 16.0F * GLOBAL_SCALE );
@@ -182,7 +182,7 @@ void KillUsedFmPoly( u_int16_t i )
    	FmPolys[i].UpVector.z = 0.0F;
 	FmPolys[i].Speed = 0.0F;
 	FmPolys[i].Frm_Info = NULL;
-	FirstFmPolyFree	= i;
+	pool_free( &FmPolyPool, i );
 }
 
 /*===================================================================
@@ -1678,7 +1678,8 @@ bool FmPolyDispGroupClipped( u_int16_t Group, /*LPDIRECT3DEXECUTEBUFFER ExecBuff
 
 	if( !TotalVerts ) return( false );
 
-	renderObject->numTextureGroups = 0;
+	if( !RESET_TEXTURE_GROUPS( renderObject ) )
+		return false;
 
 /*===================================================================
 		Lock Exec Buffer and get ready to fill in...
@@ -2039,7 +2040,8 @@ bool FmPolyDispGroupUnclipped( /*LPDIRECT3DEXECUTEBUFFER ExecBuffer*/RENDEROBJEC
 
 	if( !TotalVerts ) return( false );
 
-	renderObject->numTextureGroups = 0;
+	if( !RESET_TEXTURE_GROUPS( renderObject ) )
+		return false;
 
 /*===================================================================
 		Lock Exec Buffer and get ready to fill in...
@@ -2359,13 +2361,15 @@ void FadeColour( u_int8_t * Colour, u_int8_t WantedColour, float Speed )
 FILE * SaveFmPolys( FILE * fp )
 {
 	u_int16_t i;
+	u_int16_t FirstFree;
 	int16_t	Frm_Info_Index;
 
 	if( fp )
 	{
+		FirstFree = pool_free_slot( &FmPolyPool, 0 );
 		fwrite( &TotalFmPolysInUse, sizeof( u_int32_t ),1 ,fp );
 		fwrite( &FirstFmPolyUsed, sizeof( FirstFmPolyUsed ), 1, fp );
-		fwrite( &FirstFmPolyFree, sizeof( FirstFmPolyFree ), 1, fp );
+		fwrite( &FirstFree, sizeof( FirstFree ), 1, fp );
 
 		for( i = 0; i < ( MAXTPAGESPERTLOAD + 1 ); i++ )
 		{
@@ -2410,14 +2414,7 @@ FILE * SaveFmPolys( FILE * fp )
 			i = FmPolys[ i ].Prev;
 		}
 
-
-		i = FirstFmPolyFree;
-
-		while( i != (u_int16_t) -1 )
-		{
-			fwrite( &FmPolys[ i ].Next, sizeof( u_int16_t ), 1, fp );
-			i = FmPolys[ i ].Next;
-		}
+		pool_save_free( &FmPolyPool, fp );
 	}
 
 	return( fp );
@@ -2431,13 +2428,16 @@ FILE * SaveFmPolys( FILE * fp )
 FILE * LoadFmPolys( FILE * fp )
 {
 	u_int16_t i;
+	u_int16_t FirstFree;
+	u_int16_t NextFree;
 	int16_t	Frm_Info_Index;
 
 	if( fp )
 	{
 		fread( &TotalFmPolysInUse, sizeof( u_int32_t ),1 ,fp );
 		fread( &FirstFmPolyUsed, sizeof( FirstFmPolyUsed ), 1, fp );
-		fread( &FirstFmPolyFree, sizeof( FirstFmPolyFree ), 1, fp );
+		fread( &FirstFree, sizeof( FirstFree ), 1, fp );
+		pool_clear( &FmPolyPool );
 
 		for( i = 0; i < ( MAXTPAGESPERTLOAD + 1 ); i++ )
 		{
@@ -2479,10 +2479,11 @@ FILE * LoadFmPolys( FILE * fp )
 			fread( &FmPolys[ i ].UpSpeed, sizeof( float ), 1, fp );
 			fread( &FmPolys[ i ].xsize, sizeof( float ), 1, fp );
 			fread( &FmPolys[ i ].ysize, sizeof( float ), 1, fp );
+			pool_mark( &FmPolyPool, i );
 			i = FmPolys[ i ].Prev;
 		}
 
-		i = FirstFmPolyFree;
+		i = FirstFree;
 
 		while( i != (u_int16_t) -1 )
 		{
@@ -2505,11 +2506,15 @@ FILE * LoadFmPolys( FILE * fp )
 			FmPolys[i].UpVector.z = 0.0F;
 			FmPolys[i].NextInTPage = (u_int16_t) -1;
 			FmPolys[i].PrevInTPage = (u_int16_t) -1;
+			FmPolys[i].Next = (u_int16_t) -1;
 			FmPolys[i].Prev = (u_int16_t) -1;
 
-			fread( &FmPolys[ i ].Next, sizeof( u_int16_t ), 1, fp );
-			i = FmPolys[ i ].Next;
+			pool_load_free( &FmPolyPool, i );
+			fread( &NextFree, sizeof( u_int16_t ), 1, fp );
+			i = NextFree;
 		}
+
+		pool_rebuild( &FmPolyPool );
 	}
 
 	return( fp );
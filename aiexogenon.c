@@ -36,7 +36,7 @@ extern	VECTOR	SlideLeft;
 extern	VECTOR	SlideRight;
 extern	PRIMARYWEAPONATTRIB	PrimaryWeaponAttribs[];
 extern	SECONDARYWEAPONATTRIB	SecondaryWeaponAttribs[];
-extern	PRIMARYWEAPONBULLET	PrimBulls[MAXPRIMARYWEAPONBULLETS];
+extern	PRIMARYWEAPONBULLET	*	PrimBulls;
 extern	int		Exogenon_Num_StartPos;
 extern	VECTOR	Exogenon_StartPos[6];
 void ExogenonAim( ENEMY * Enemy );
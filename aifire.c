@@ -34,7 +34,7 @@ extern	VECTOR	Forward;
 extern	VECTOR	SlideUp;
 extern	PRIMARYWEAPONATTRIB	PrimaryWeaponAttribs[];
 extern	SECONDARYWEAPONATTRIB	SecondaryWeaponAttribs[];
-extern	PRIMARYWEAPONBULLET	PrimBulls[MAXPRIMARYWEAPONBULLETS];
+extern	PRIMARYWEAPONBULLET	*	PrimBulls;
 
 /*===================================================================
 	Procedure	:	TURRET Fire At Target..
@@ -35,7 +35,7 @@ extern	VECTOR	SlideLeft;
 extern	VECTOR	SlideRight;
 extern	PRIMARYWEAPONATTRIB	PrimaryWeaponAttribs[];
 extern	SECONDARYWEAPONATTRIB	SecondaryWeaponAttribs[];
-extern	PRIMARYWEAPONBULLET	PrimBulls[MAXPRIMARYWEAPONBULLETS];
+extern	PRIMARYWEAPONBULLET	*	PrimBulls;
 
 // Globals
 void AI_FLESHMORPH_RANDOMFIREBALL( register ENEMY * Enemy );
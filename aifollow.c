@@ -29,7 +29,7 @@
 extern	float framelag;
 extern	AIMDATA AimData;
 extern	VECTOR	Forward;
-extern	SECONDARYWEAPONBULLET	SecBulls[MAXSECONDARYWEAPONBULLETS];
+extern	SECONDARYWEAPONBULLET	*	SecBulls;
 extern	VECTOR	SlideUp;
 /*===================================================================
 	Procedure	:	AIR Follow Path
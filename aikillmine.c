@@ -32,7 +32,7 @@ extern	VECTOR	Forward;
 extern	VECTOR	SlideUp;
 extern	PRIMARYWEAPONATTRIB	PrimaryWeaponAttribs[];
 extern	SECONDARYWEAPONATTRIB	SecondaryWeaponAttribs[];
-extern	SECONDARYWEAPONBULLET	SecBulls[MAXSECONDARYWEAPONBULLETS];
+extern	SECONDARYWEAPONBULLET	*	SecBulls;
 /*===================================================================
 	Procedure	:	AIR KillMine
 	Input		:	ENEMY * Enemy
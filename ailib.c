@@ -25,6 +25,7 @@
 #include "controls.h"
 #include "ai.h"
 #include "lines.h"
+#include "pool.h"
 
 #ifdef OPT_ON
 #pragma optimize( "gty", on )
@@ -43,8 +44,8 @@ extern	MCLOADHEADER	MCloadheader;
 extern	MCLOADHEADER	MCloadheadert0;
 extern	LINE			Lines[ MAXLINES ];
 extern	NODENETWORKHEADER	NodeNetworkHeader;
-extern	SECONDARYWEAPONBULLET	SecBulls[MAXSECONDARYWEAPONBULLETS];
-extern	u_int16_t		FirstSecBullUsed;
+extern	SECONDARYWEAPONBULLET	*	SecBulls;
+extern	pool_t		SecBullPool;
 bool WouldObjectCollide( OBJECT *Obj, VECTOR *Move_Off, float radius, BGOBJECT **BGObject );
 
 //--------------------------------------------------------------------------
@@ -67,8 +68,7 @@ void AI_GetNearestMINETarget( void )
 	u_int16_t	i;
 	float	dist;
 
-	i = FirstSecBullUsed;
-	while( i != (u_int16_t) -1 )
+	for( i = pool_first( &SecBullPool ); i != POOL_NONE; i = pool_next( &SecBullPool, i ) )
 	{
 		if( SecBulls[ i ].SecType == SEC_MINE )
 		{
@@ -88,8 +88,7 @@ void AI_GetNearestMINETarget( void )
 				}
 			}
 		}
-		i = SecBulls[ i ].Prev;											/* Next SecBull */
-	}																				
+	}
 }
 /*===================================================================
 	Procedure	:	Find Nearest Ship in any group...
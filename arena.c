@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include "main.h"
+#include "util.h"
+#include "arena.h"
+
+// released by ReleaseMloadheader
+arena_t LevelArena = ARENA_INIT( "level", 1024*1024 );
+
+// reset at the start of RenderScene
+arena_t FrameArena = ARENA_INIT( "frame", 256*1024 );
+
+#define ARENA_HEADER	( ( sizeof( arena_chunk_t ) + ARENA_ALIGN - 1 ) & ~( ARENA_ALIGN - 1 ) )
+
+static arena_chunk_t * arena_new_chunk( arena_t * a, size_t size )
+{
+	arena_chunk_t * chunk;
+	size_t header = ARENA_HEADER;
+
+	if( size < a->chunk_size )
+		size = a->chunk_size;
+
+	chunk = (arena_chunk_t *) malloc( header + size );
+	if( !chunk )
+	{
+		Msg( "arena %s: failed to allocate %d byte chunk\n", a->name, (int) size );
+		return NULL;
+	}
+
+	chunk->size = header + size;
+	chunk->used = header;
+	chunk->next = a->chunks;
+	a->chunks = chunk;
+	a->reserved += chunk->size;
+
+	return chunk;
+}
+
+void * arena_alloc( arena_t * a, size_t size )
+{
+	arena_chunk_t * chunk = a->chunks;
+	void * p;
+
+	size = ( size + ARENA_ALIGN - 1 ) & ~( ARENA_ALIGN - 1 );
+
+	if( !chunk || chunk->used + size > chunk->size )
+	{
+		// first chunk after a release is sized to hold a whole level
+		chunk = arena_new_chunk( a, ( !a->chunks && a->peak > size ) ? a->peak : size );
+		if( !chunk )
+			return NULL;
+	}
+
+	p = (char *) chunk + chunk->used;
+	chunk->used += size;
+
+	a->used += size;
+	a->allocs++;
+	if( a->used > a->peak )
+		a->peak = a->used;
+
+	return p;
+}
+
+void * arena_calloc( arena_t * a, size_t num, size_t size )
+{
+	void * p = arena_alloc( a, num * size );
+	if( p )
+		memset( p, 0, num * size );
+	return p;
+}
+
+char * arena_strdup( arena_t * a, const char * str )
+{
+	size_t len = strlen( str ) + 1;
+	char * p = (char *) arena_alloc( a, len );
+	if( p )
+		memcpy( p, str, len );
+	return p;
+}
+
+static void arena_free_chunks( arena_t * a )
+{
+	arena_chunk_t * chunk;
+
+	while( a->chunks )
+	{
+		chunk = a->chunks;
+		a->chunks = chunk->next;
+		free( chunk );
+	}
+	a->reserved = 0;
+}
+
+void arena_release( arena_t * a )
+{
+	if( a->chunks )
+		DebugPrintf( "arena %s: released %d bytes in %d allocations ( %d reserved, %d peak )\n",
+			a->name, (int) a->used, a->allocs, (int) a->reserved, (int) a->peak );
+
+	arena_free_chunks( a );
+
+	a->used = 0;
+	a->allocs = 0;
+	a->generation++;
+}
+
+void arena_reset( arena_t * a )
+{
+	// spilling into a second chunk means the peak has grown, start again
+	// so the next allocation makes one chunk big enough for all of it
+	if( a->chunks && a->chunks->next )
+		arena_free_chunks( a );
+	else if( a->chunks )
+		a->chunks->used = ARENA_HEADER;
+
+	a->used = 0;
+	a->allocs = 0;
+	a->generation++;
+}
@@ -0,0 +1,73 @@
+#ifndef ARENA_INCLUDED
+#define ARENA_INCLUDED
+
+/*
+
+	description:
+
+			bump allocator for data that all dies at the same time,
+			nothing is freed on its own, the whole arena is released
+			in one go
+
+	setup:
+
+			arena_t a = ARENA_INIT( "level", 1024*1024 );
+
+	allocating:
+
+			p = arena_alloc( &a, size );			// not cleared
+			p = arena_calloc( &a, num, size );		// cleared
+
+	releasing everything:
+
+			arena_release( &a );
+
+	reusing the memory ( once per frame for FrameArena ):
+
+			arena_reset( &a );
+
+	anything still holding a pointer from before a reset can tell
+	by comparing the generation it saved with a.generation
+
+	memory comes from malloc in chunks, anything bigger than a chunk
+	gets a chunk of its own.  the first chunk after a release is made
+	big enough to hold everything the arena held last time.
+
+*/
+
+#include "main.h"
+
+#define ARENA_ALIGN		(16)
+
+typedef struct arena_chunk_s {
+	struct arena_chunk_s * next;
+	size_t size;
+	size_t used;
+} arena_chunk_t;
+
+typedef struct {
+	char *			name;
+	size_t			chunk_size;		// minimum size of each chunk
+	arena_chunk_t * chunks;			// newest first
+	size_t			used;			// bytes handed out since the last release
+	size_t			reserved;		// bytes held in chunks
+	size_t			peak;			// most bytes ever handed out between releases
+	int				allocs;			// allocations since the last release
+	u_int32_t		generation;		// bumped by every reset or release
+} arena_t;
+
+#define ARENA_INIT( NAME, CHUNK_SIZE )	{ (NAME), (CHUNK_SIZE), NULL, 0, 0, 0, 0, 0 }
+
+void *	arena_alloc		( arena_t * a, size_t size );
+void *	arena_calloc	( arena_t * a, size_t num, size_t size );
+char *	arena_strdup	( arena_t * a, const char * str );
+void	arena_release	( arena_t * a );
+void	arena_reset		( arena_t * a );
+
+// everything that lives exactly as long as the loaded level geometry
+extern arena_t LevelArena;
+
+// transient data that only lives until the start of the next frame
+extern arena_t FrameArena;
+
+#endif
@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+#include "main.h"
+#include "util.h"
+#include "file.h"
+#include "render.h"
+#include "new3d.h"
+#include "mload.h"
+#include "tload.h"
+#include "bsp.h"
+#include "collision.h"
+#include "vlight.h"
+#include "xmem.h"
+#include "bench.h"
+
+/*===================================================================
+	main.c is left out of the benchmarks, these are the parts of it
+	the rest of the game reaches for
+===================================================================*/
+bool Debug = true;
+bool ShowFrameRate = false;
+bool ShowInfo = false;
+int cliSleep = 0;
+render_info_t render_info;
+bool QuitRequested = false;
+
+void CleanUpAndPostQuit( void )
+{
+	QuitRequested = true;
+}
+
+extern MLOADHEADER Mloadheader;
+extern MCLOADHEADER MCloadheader;
+extern MCLOADHEADER MCloadheadert0;
+extern TLOADHEADER Tloadheader;
+
+bench_options_t bench_options = { ".", "ship", 1, 100000, 5, NULL };
+volatile u_int32_t bench_sink;
+
+typedef struct {
+	const char *	name;
+	int				count;
+	double			median;		// ns/op
+	double			best;		// ns/op
+} bench_result_t;
+
+static const char *		bench_name;
+static u_int32_t		bench_state;
+static bench_result_t	bench_results[ BENCH_MAX_CASES ];
+static int				bench_num_results;
+
+/*===================================================================
+	Procedure	:	Read the command line and start up the parts of
+				:	the game every benchmark needs
+	Input		:	argc , argv , name of the benchmark
+	Output		:	bool false if the command line is bad
+===================================================================*/
+bool bench_init( int argc, char ** argv, const char * name )
+{
+	int i;
+
+	bench_name = name;
+
+	for( i = 1; i < argc; i++ )
+	{
+		// every option takes a value
+		if( i + 1 >= argc )
+		{
+			fprintf( stderr, "%s: %s needs a value\n", name, argv[ i ] );
+			return false;
+		}
+		if( !strcasecmp( argv[ i ], "-chdir" ) )
+			bench_options.chdir = argv[ ++i ];
+		else if( !strcasecmp( argv[ i ], "-level" ) )
+			bench_options.level = argv[ ++i ];
+		else if( !strcasecmp( argv[ i ], "-seed" ) )
+			bench_options.seed = (u_int32_t) strtoul( argv[ ++i ], NULL, 0 );
+		else if( !strcasecmp( argv[ i ], "-count" ) )
+			bench_options.count = atoi( argv[ ++i ] );
+		else if( !strcasecmp( argv[ i ], "-runs" ) )
+			bench_options.runs = atoi( argv[ ++i ] );
+		else if( !strcasecmp( argv[ i ], "-o" ) )
+			bench_options.output = argv[ ++i ];
+		else
+		{
+			fprintf( stderr, "%s: unknown option %s\n", name, argv[ i ] );
+			return false;
+		}
+	}
+
+	if( bench_options.count < 1 )
+		bench_options.count = 1;
+	if( bench_options.runs < 1 )
+		bench_options.runs = 1;
+
+	// xorshift gets stuck on zero
+	bench_state = bench_options.seed ? bench_options.seed : 1;
+
+	if( chdir( bench_options.chdir ) )
+	{
+		fprintf( stderr, "%s: cannot change to %s\n", name, bench_options.chdir );
+		return false;
+	}
+
+#ifdef DEBUG_ON
+	XMem_Init();
+#endif
+
+	vlight_init();
+
+	return true;
+}
+
+/*===================================================================
+	Procedure	:	Load the level the same way ChangeLevel does,
+				:	leaving out everything that is not geometry
+	Input		:	nothing
+	Output		:	bool false if any part failed to load
+===================================================================*/
+bool bench_load_level( void )
+{
+	char mxv[ 256 ];
+	char bsp[ 256 ];
+	char mc[ 256 ];
+	char mcz[ 256 ];
+	char * l = bench_options.level;
+
+	sprintf( mxv, "data\\levels\\%s\\%s.mxv", l, l );
+	sprintf( bsp, "data\\levels\\%s\\%s.bsp", l, l );
+	sprintf( mc, "data\\levels\\%s\\%s.mc", l, l );
+	sprintf( mcz, "data\\levels\\%s\\%sz.mc", l, l );
+
+	if( !InitTload( &Tloadheader ) ||
+		!PreMload( mxv, &Mloadheader ) ||
+		!Mload( mxv, &Mloadheader ) )
+	{
+		fprintf( stderr, "%s: failed to load %s\n", bench_name, mxv );
+		return false;
+	}
+
+#ifdef BSP_ONLY
+	if( !Bspload( bsp, &Bsp_Header[ 0 ] ) )
+	{
+		fprintf( stderr, "%s: failed to load %s\n", bench_name, bsp );
+		return false;
+	}
+#else
+	Bspload( bsp, &Bsp_Header[ 0 ] );
+#endif
+	Bsp_Header[ 1 ].State = false;
+
+	if( !MCload( mc, &MCloadheader ) || !MCload( mcz, &MCloadheadert0 ) )
+	{
+		fprintf( stderr, "%s: failed to load %s\n", bench_name, mc );
+		return false;
+	}
+
+	return true;
+}
+
+u_int64_t bench_nanos( void )
+{
+#if defined(WIN32)
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER now;
+	if( !freq.QuadPart )
+		QueryPerformanceFrequency( &freq );
+	QueryPerformanceCounter( &now );
+	return (u_int64_t)( ( (double) now.QuadPart * 1e9 ) / (double) freq.QuadPart );
+#elif defined(MACOSX)
+	struct timeval tv;
+	gettimeofday( &tv, NULL );
+	return (u_int64_t) tv.tv_sec * 1000000000ULL + (u_int64_t) tv.tv_usec * 1000ULL;
+#else
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (u_int64_t) ts.tv_sec * 1000000000ULL + (u_int64_t) ts.tv_nsec;
+#endif
+}
+
+u_int32_t bench_rand( void )
+{
+	bench_state ^= bench_state << 13;
+	bench_state ^= bench_state >> 17;
+	bench_state ^= bench_state << 5;
+	return bench_state;
+}
+
+float bench_randf( float lo, float hi )
+{
+	return lo + ( hi - lo ) * ( (float) ( bench_rand() >> 8 ) * ( 1.0F / 16777216.0F ) );
+}
+
+void bench_random_dir( VECTOR * dir )
+{
+	float len;
+
+	do
+	{
+		dir->x = bench_randf( -1.0F, 1.0F );
+		dir->y = bench_randf( -1.0F, 1.0F );
+		dir->z = bench_randf( -1.0F, 1.0F );
+		len = VectorLength( dir );
+	}
+	while( len > 1.0F || len < 0.01F );
+
+	dir->x /= len;
+	dir->y /= len;
+	dir->z /= len;
+}
+
+/*===================================================================
+	Procedure	:	Pick a point inside a random group of the level
+	Input		:	where to put the point and its group
+	Output		:	bool false if no point inside a group was found
+===================================================================*/
+bool bench_random_point( VECTOR * pos, u_int16_t * group )
+{
+	int tries;
+	u_int16_t g;
+
+	if( !Mloadheader.num_groups )
+		return false;
+
+	for( tries = 0; tries < 1000; tries++ )
+	{
+		g = (u_int16_t) ( bench_rand() % Mloadheader.num_groups );
+		pos->x = Mloadheader.Group[ g ].center.x + bench_randf( -1.0F, 1.0F ) * Mloadheader.Group[ g ].half_size.x;
+		pos->y = Mloadheader.Group[ g ].center.y + bench_randf( -1.0F, 1.0F ) * Mloadheader.Group[ g ].half_size.y;
+		pos->z = Mloadheader.Group[ g ].center.z + bench_randf( -1.0F, 1.0F ) * Mloadheader.Group[ g ].half_size.z;
+		if( PointInsideSkin( pos, g ) )
+		{
+			*group = g;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int compare_double( const void * a, const void * b )
+{
+	double da = *(const double *) a;
+	double db = *(const double *) b;
+
+	return ( da > db ) - ( da < db );
+}
+
+/*===================================================================
+	Procedure	:	Time an operation over count inputs
+	Input		:	name in the json , operation , number of inputs
+	Output		:	nothing
+===================================================================*/
+void bench_case( const char * name, bench_op_t op, int count )
+{
+	double * runs;
+	bench_result_t * r;
+	u_int64_t start;
+	int run, i;
+
+	if( bench_num_results == BENCH_MAX_CASES )
+	{
+		fprintf( stderr, "%s: too many cases, %s left out\n", bench_name, name );
+		return;
+	}
+	if( count < 1 )
+		return;
+
+	runs = (double *) malloc( bench_options.runs * sizeof( double ) );
+	if( !runs )
+		return;
+
+	// one pass untimed so the caches and branch predictors are warm
+	for( i = 0; i < count; i++ )
+		op( i );
+
+	for( run = 0; run < bench_options.runs; run++ )
+	{
+		start = bench_nanos();
+		for( i = 0; i < count; i++ )
+			op( i );
+		runs[ run ] = (double) ( bench_nanos() - start ) / count;
+	}
+
+	qsort( runs, bench_options.runs, sizeof( double ), compare_double );
+
+	r = &bench_results[ bench_num_results++ ];
+	r->name = name;
+	r->count = count;
+	r->median = runs[ bench_options.runs / 2 ];
+	r->best = runs[ 0 ];
+
+	fprintf( stderr, "%s: %-24s %10.1f ns/op\n", bench_name, name, r->median );
+
+	free( runs );
+}
+
+/*===================================================================
+	Procedure	:	Write every case timed so far as json
+	Input		:	nothing
+	Output		:	int exit code for main
+===================================================================*/
+int bench_report( void )
+{
+	FILE * f = stdout;
+	bench_result_t * r;
+	int i;
+
+	if( bench_options.output )
+	{
+		f = fopen( bench_options.output, "w" );
+		if( !f )
+		{
+			fprintf( stderr, "%s: cannot write %s\n", bench_name, bench_options.output );
+			return 1;
+		}
+	}
+
+	fprintf( f, "{\n" );
+	fprintf( f, "\t\"bench\": \"%s\",\n", bench_name );
+	fprintf( f, "\t\"level\": \"%s\",\n", bench_options.level );
+	fprintf( f, "\t\"seed\": %u,\n", bench_options.seed );
+	fprintf( f, "\t\"runs\": %d,\n", bench_options.runs );
+	fprintf( f, "\t\"cases\": [" );
+	for( i = 0; i < bench_num_results; i++ )
+	{
+		r = &bench_results[ i ];
+		fprintf( f, "%s\n\t\t{ \"name\": \"%s\", \"ops\": %d, \"ns_per_op\": %.2f, \"best_ns_per_op\": %.2f, \"ops_per_sec\": %.0f }",
+			( i ) ? "," : "", r->name, r->count, r->median, r->best,
+			( r->median > 0.0 ) ? 1e9 / r->median : 0.0 );
+	}
+	fprintf( f, "\n\t]\n}\n" );
+
+	if( f != stdout )
+		fclose( f );
+
+	return 0;
+}
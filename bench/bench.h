@@ -0,0 +1,74 @@
+#ifndef BENCH_INCLUDED
+#define BENCH_INCLUDED
+
+/*
+
+	description:
+
+			shared harness for the standalone benchmarks in this folder,
+			each one links the real game code with rendering stubbed
+			out and times a hot path on a real level, so changes to it
+			can be measured apart from the full game
+
+	building and running:
+
+			make bench
+			bench/bench_collision -chdir ../skeleton -level ship -seed 7
+
+	command line, all optional:
+
+			-chdir <folder>		folder holding data/ ( default . )
+			-level <name>		level under data/levels ( default ship )
+			-seed <n>			random seed ( default 1 )
+			-count <n>			operations per case ( default 100000 )
+			-runs <n>			timed passes per case ( default 5 )
+			-o <file>			write the json there instead of stdout
+
+	in a benchmark:
+
+			bench_init( argc, argv, "collision" );
+			bench_load_level();
+			... fill an input table from bench_rand() ...
+			bench_case( "ray", ray_op, count );
+			return bench_report();
+
+	inputs are made up front so only the operation is timed, each
+	case is run -runs times and the median and fastest pass are
+	reported as ns/op and ops/s in one json object
+
+*/
+
+#include "main.h"
+#include "new3d.h"
+
+#define BENCH_MAX_CASES	(32)
+
+typedef void ( *bench_op_t )( int i );
+
+typedef struct {
+	char	*	chdir;
+	char	*	level;
+	u_int32_t	seed;
+	int			count;
+	int			runs;
+	char	*	output;
+} bench_options_t;
+
+extern bench_options_t bench_options;
+
+// stops the compiler dropping an operation whose result goes unused
+extern volatile u_int32_t bench_sink;
+
+bool		bench_init			( int argc, char ** argv, const char * name );
+bool		bench_load_level	( void );
+u_int64_t	bench_nanos			( void );
+
+u_int32_t	bench_rand			( void );
+float		bench_randf			( float lo, float hi );
+void		bench_random_dir	( VECTOR * dir );
+bool		bench_random_point	( VECTOR * pos, u_int16_t * group );
+
+void		bench_case			( const char * name, bench_op_t op, int count );
+int			bench_report		( void );
+
+#endif
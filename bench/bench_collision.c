@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "main.h"
+#include "new3d.h"
+#include "mload.h"
+#include "bsp.h"
+#include "collision.h"
+#include "controls.h"
+#include "ships.h"
+#include "bench.h"
+
+/*
+	background collision hot paths on random points inside the level:
+
+		ray					BackgroundCollide, a bullet length ray
+		point_in_group		PointInsideSkin, half the probes end up outside
+		outside_group		AmIOutsideGroup, the bounding box test
+		move_group			MoveGroup along the same rays
+		sphere_sweep		BackgroundSphereCollide, a ship moving for a frame
+		qcollide			QCollide, the same ship move through the full path
+		qcollide_feelers	QCollide casting its feeler rays instead of the sweep
+		would_collide		WouldObjectCollide, the ship move ObjectCollide makes
+		would_collide_feelers	the same through the feeler rays
+*/
+
+#define RAY_LENGTH		( 8192.0F * GLOBAL_SCALE )
+#define STEP_LENGTH		( MAXTURBOSPEED * 4.0F )
+
+extern MLOADHEADER Mloadheader;
+extern MCLOADHEADER MCloadheadert0;
+
+static VECTOR *		Pos;
+static u_int16_t *	Group;
+static VECTOR *		Ray;
+static VECTOR *		Step;
+static VECTOR *		Probe;
+
+static void ray_op( int i )
+{
+	VECTOR end, target;
+	u_int16_t end_group;
+	NORMAL normal;
+
+	bench_sink += BackgroundCollide( &MCloadheadert0, &Mloadheader, &Pos[ i ], Group[ i ], &Ray[ i ],
+									 &end, &end_group, &normal, &target, false, NULL );
+}
+
+static void point_in_group_op( int i )
+{
+	bench_sink += PointInsideSkin( &Probe[ i ], Group[ i ] );
+}
+
+static void outside_group_op( int i )
+{
+	bench_sink += AmIOutsideGroup( &Mloadheader, &Probe[ i ], Group[ i ] );
+}
+
+static void move_group_op( int i )
+{
+	bench_sink += MoveGroup( &Mloadheader, &Pos[ i ], Group[ i ], &Ray[ i ] );
+}
+
+static void sphere_sweep_op( int i )
+{
+	float time;
+	VECTOR point;
+	NORMAL normal;
+
+	bench_sink += BackgroundSphereCollide( &Pos[ i ], Group[ i ], &Step[ i ], SHIP_RADIUS,
+										   &time, &point, &normal, false, NULL );
+}
+
+static void qcollide_op( int i )
+{
+	VECTOR point;
+	u_int16_t group;
+	NORMAL normal;
+
+	bench_sink += QCollide( &Pos[ i ], Group[ i ], &Step[ i ], SHIP_RADIUS, &point, &group, &normal );
+}
+
+static OBJECT		Ship;
+
+static void would_collide_op( int i )
+{
+	VECTOR move;
+
+	Ship.Pos = Pos[ i ];
+	Ship.Group = Group[ i ];
+	move = Step[ i ];
+	bench_sink += WouldObjectCollide( &Ship, &move, SHIP_RADIUS, NULL );
+}
+
+int main( int argc, char ** argv )
+{
+	VECTOR dir;
+	float len;
+	int count, i;
+
+	if( !bench_init( argc, argv, "collision" ) || !bench_load_level() )
+		return 1;
+
+	count = bench_options.count;
+	Pos = (VECTOR *) malloc( count * sizeof( VECTOR ) );
+	Group = (u_int16_t *) malloc( count * sizeof( u_int16_t ) );
+	Ray = (VECTOR *) malloc( count * sizeof( VECTOR ) );
+	Step = (VECTOR *) malloc( count * sizeof( VECTOR ) );
+	Probe = (VECTOR *) malloc( count * sizeof( VECTOR ) );
+	if( !Pos || !Group || !Ray || !Step || !Probe )
+	{
+		fprintf( stderr, "collision: no memory for %d inputs\n", count );
+		return 1;
+	}
+
+	for( i = 0; i < count; i++ )
+	{
+		if( !bench_random_point( &Pos[ i ], &Group[ i ] ) )
+		{
+			fprintf( stderr, "collision: no point inside %s\n", bench_options.level );
+			return 1;
+		}
+		bench_random_dir( &dir );
+		len = bench_randf( 0.0F, RAY_LENGTH );
+		Ray[ i ].x = dir.x * len;
+		Ray[ i ].y = dir.y * len;
+		Ray[ i ].z = dir.z * len;
+		len = bench_randf( 0.0F, STEP_LENGTH );
+		Step[ i ].x = dir.x * len;
+		Step[ i ].y = dir.y * len;
+		Step[ i ].z = dir.z * len;
+		Probe[ i ].x = Pos[ i ].x + Ray[ i ].x * 0.25F;
+		Probe[ i ].y = Pos[ i ].y + Ray[ i ].y * 0.25F;
+		Probe[ i ].z = Pos[ i ].z + Ray[ i ].z * 0.25F;
+	}
+
+	bench_case( "ray", ray_op, count );
+	bench_case( "point_in_group", point_in_group_op, count );
+	bench_case( "outside_group", outside_group_op, count );
+	bench_case( "move_group", move_group_op, count );
+	bench_case( "sphere_sweep", sphere_sweep_op, count );
+	bench_case( "qcollide", qcollide_op, count );
+	bench_case( "would_collide", would_collide_op, count );
+#ifdef SWEPT_SPHERE_COLLISION
+	SweptSphereCollision = false;
+#endif
+	bench_case( "qcollide_feelers", qcollide_op, count );
+	bench_case( "would_collide_feelers", would_collide_op, count );
+#ifdef SWEPT_SPHERE_COLLISION
+	SweptSphereCollision = true;
+#endif
+
+	return bench_report();
+}
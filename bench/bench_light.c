@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "new3d.h"
+#include "lights.h"
+#include "vlight.h"
+#include "bench.h"
+
+/*
+	vertex lighting kernels on a cell sized run of random vertices,
+	needs no level:
+
+		point_scalar		vlight_add_c, a point light
+		point				vlight_add, the kernel picked for this cpu
+		spot_scalar			vlight_add_c, a spot light
+		spot				vlight_add
+
+	every light is then run through XLightVertsScalar, the loops the
+	level was lit with before the kernels, and through every kernel
+	this cpu can run from the same colours, the program fails if any
+	vertex comes out different from XLightVertsScalar
+*/
+
+#define RUN_VERTS		(64)					// about what a level cell holds
+#define BOX_SIZE		( 4096.0F * GLOBAL_SCALE )
+
+static VLIGHT *		Point;
+static VLIGHT *		Spot;
+static float *		Rows;					// x, y then z, PITCH apart
+static u_int16_t *	Index;
+static LVERTEX		Verts[ RUN_VERTS ];
+static LVERTEX		Check[ RUN_VERTS ];
+static LVERTEX		Reference[ RUN_VERTS ];
+static COLOR		Base[ RUN_VERTS ];
+
+#define PITCH	( RUN_VERTS + VLIGHT_PAD )
+
+static void light_run( vlight_add_t add, VLIGHT * light )
+{
+	add( light, Rows, &Rows[ PITCH ], &Rows[ 2 * PITCH ], Index, Verts, RUN_VERTS );
+	bench_sink += Verts[ Index[ 0 ] ].color;
+}
+
+static void point_scalar_op( int i )
+{
+	light_run( vlight_add_c, &Point[ i ] );
+}
+
+static void point_op( int i )
+{
+	light_run( vlight_add, &Point[ i ] );
+}
+
+static void spot_scalar_op( int i )
+{
+	light_run( vlight_add_c, &Spot[ i ] );
+}
+
+static void spot_op( int i )
+{
+	light_run( vlight_add, &Spot[ i ] );
+}
+
+static void random_light( VLIGHT * light, bool spot )
+{
+	VECTOR dir;
+
+	light->spot = spot;
+	light->x = bench_randf( -BOX_SIZE, BOX_SIZE );
+	light->y = bench_randf( -BOX_SIZE, BOX_SIZE );
+	light->z = bench_randf( -BOX_SIZE, BOX_SIZE );
+	light->size = bench_randf( MIN_LIGHT_SIZE * 0.5F, BOX_SIZE * 2.0F );
+	light->r = bench_randf( 0.0F, 255.0F );
+	light->g = bench_randf( 0.0F, 255.0F );
+	light->b = bench_randf( 0.0F, 255.0F );
+	bench_random_dir( &dir );
+	light->dirx = dir.x;
+	light->diry = dir.y;
+	light->dirz = dir.z;
+	light->cos_arc = bench_randf( 0.0F, 0.95F );
+}
+
+// the same light as lights.c keeps it
+static void make_xlight( XLIGHT * xlight, VLIGHT * light )
+{
+	memset( xlight, 0, sizeof( XLIGHT ) );
+	xlight->Type = light->spot ? SPOT_LIGHT : POINT_LIGHT;
+	xlight->Pos.x = light->x;
+	xlight->Pos.y = light->y;
+	xlight->Pos.z = light->z;
+	xlight->Size = light->size;
+	xlight->r = light->r;
+	xlight->g = light->g;
+	xlight->b = light->b;
+	xlight->Dir.x = light->dirx;
+	xlight->Dir.y = light->diry;
+	xlight->Dir.z = light->dirz;
+	xlight->CosArc = light->cos_arc;
+}
+
+static bool same_as_reference( const char * name, LVERTEX * verts )
+{
+	int i;
+
+	for( i = 0; i < RUN_VERTS; i++ )
+	{
+		if( verts[ i ].color != Reference[ i ].color )
+		{
+			fprintf( stderr, "light: %s kernel gave %08x not %08x for vertex %d\n",
+				name, (unsigned) verts[ i ].color, (unsigned) Reference[ i ].color, i );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// every kernel and the scalar loops from the same colours, any difference at all is a failure
+static bool same_colours( VLIGHT * light )
+{
+	XLIGHT xlight;
+	vlight_add_t add;
+	const char * name;
+	int i, k;
+
+	for( i = 0; i < RUN_VERTS; i++ )
+		Reference[ i ].color = Base[ i ];
+
+	make_xlight( &xlight, light );
+	XLightVertsScalar( &xlight, Reference, Index, RUN_VERTS );
+
+	for( k = 0; ( add = vlight_kernel( k, &name ) ); k++ )
+	{
+		for( i = 0; i < RUN_VERTS; i++ )
+			Check[ i ].color = Base[ i ];
+
+		add( light, Rows, &Rows[ PITCH ], &Rows[ 2 * PITCH ], Index, Check, RUN_VERTS );
+		if( !same_as_reference( name, Check ) )
+			return false;
+	}
+
+	return true;
+}
+
+int main( int argc, char ** argv )
+{
+	int count, i, k;
+
+	if( !bench_init( argc, argv, "light" ) )
+		return 1;
+
+	count = bench_options.count;
+	Point = (VLIGHT *) malloc( count * sizeof( VLIGHT ) );
+	Spot = (VLIGHT *) malloc( count * sizeof( VLIGHT ) );
+	Rows = (float *) calloc( 3 * PITCH, sizeof( float ) );
+	Index = (u_int16_t *) malloc( RUN_VERTS * sizeof( u_int16_t ) );
+	if( !Point || !Spot || !Rows || !Index )
+	{
+		fprintf( stderr, "light: no memory for %d lights\n", count );
+		return 1;
+	}
+
+	// the run is in cell order, which is not the order of the vertex buffer
+	for( i = 0; i < RUN_VERTS; i++ )
+	{
+		Index[ i ] = (u_int16_t) ( ( i * 37 ) % RUN_VERTS );
+		Rows[ i ] = bench_randf( -BOX_SIZE, BOX_SIZE );
+		Rows[ PITCH + i ] = bench_randf( -BOX_SIZE, BOX_SIZE );
+		Rows[ 2 * PITCH + i ] = bench_randf( -BOX_SIZE, BOX_SIZE );
+		Base[ i ] = bench_rand();
+		Verts[ i ].color = Base[ i ];
+	}
+
+	// the scalar loops read the positions out of the vertices themselves
+	for( i = 0; i < RUN_VERTS; i++ )
+	{
+		Reference[ Index[ i ] ].x = Rows[ i ];
+		Reference[ Index[ i ] ].y = Rows[ PITCH + i ];
+		Reference[ Index[ i ] ].z = Rows[ 2 * PITCH + i ];
+	}
+
+	for( i = 0; i < count; i++ )
+	{
+		random_light( &Point[ i ], false );
+		random_light( &Spot[ i ], true );
+	}
+
+	// a vertex right on a light, where a spot light has no direction to it
+	Point[ 0 ].x = Spot[ 0 ].x = Rows[ 0 ];
+	Point[ 0 ].y = Spot[ 0 ].y = Rows[ PITCH ];
+	Point[ 0 ].z = Spot[ 0 ].z = Rows[ 2 * PITCH ];
+
+	bench_case( "point_scalar", point_scalar_op, count );
+	bench_case( "point", point_op, count );
+	bench_case( "spot_scalar", spot_scalar_op, count );
+	bench_case( "spot", spot_op, count );
+
+	for( i = 0; i < count; i++ )
+	{
+		for( k = 0; k < 2; k++ )
+		{
+			if( !same_colours( k ? &Spot[ i ] : &Point[ i ] ) )
+				return 1;
+		}
+	}
+
+	return bench_report();
+}
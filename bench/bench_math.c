@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "main.h"
+#include "new3d.h"
+#include "quat.h"
+#include "bench.h"
+
+/*
+	matrix and quaternion batches, needs no level:
+
+		matrix_multiply		MatrixMultiply
+		apply_matrix		ApplyMatrix
+		matrix_transpose	MatrixTranspose
+		quat_multiply		QuatMultiply
+		quat_to_matrix		QuatToMatrix
+		quat_from_vector	QuatFromVector2
+		quat_slerp			Quaternion_Slerp
+*/
+
+static MATRIX *	MatA;
+static MATRIX *	MatB;
+static MATRIX *	MatOut;
+static QUAT *	QuatA;
+static QUAT *	QuatB;
+static QUAT *	QuatOut;
+static VECTOR *	Vec;
+static VECTOR *	VecOut;
+static float *	Alpha;
+
+static void matrix_multiply_op( int i )
+{
+	MatrixMultiply( &MatA[ i ], &MatB[ i ], &MatOut[ i ] );
+}
+
+static void apply_matrix_op( int i )
+{
+	ApplyMatrix( &MatA[ i ], &Vec[ i ], &VecOut[ i ] );
+}
+
+static void matrix_transpose_op( int i )
+{
+	MatrixTranspose( &MatA[ i ], &MatOut[ i ] );
+}
+
+static void quat_multiply_op( int i )
+{
+	QuatMultiply( &QuatA[ i ], &QuatB[ i ], &QuatOut[ i ] );
+}
+
+static void quat_to_matrix_op( int i )
+{
+	QuatToMatrix( &QuatA[ i ], &MatOut[ i ] );
+}
+
+static void quat_from_vector_op( int i )
+{
+	QuatFromVector2( &Vec[ i ], &QuatOut[ i ] );
+}
+
+static void quat_slerp_op( int i )
+{
+	Quaternion_Slerp( Alpha[ i ], &QuatA[ i ], &QuatB[ i ], &QuatOut[ i ], 0 );
+}
+
+static void random_quat( QUAT * q )
+{
+	q->w = bench_randf( -1.0F, 1.0F );
+	q->x = bench_randf( -1.0F, 1.0F );
+	q->y = bench_randf( -1.0F, 1.0F );
+	q->z = bench_randf( -1.0F, 1.0F );
+	QuatNormalise( q );
+}
+
+int main( int argc, char ** argv )
+{
+	int count, i;
+
+	if( !bench_init( argc, argv, "math" ) )
+		return 1;
+
+	count = bench_options.count;
+	MatA = (MATRIX *) malloc( count * sizeof( MATRIX ) );
+	MatB = (MATRIX *) malloc( count * sizeof( MATRIX ) );
+	MatOut = (MATRIX *) malloc( count * sizeof( MATRIX ) );
+	QuatA = (QUAT *) malloc( count * sizeof( QUAT ) );
+	QuatB = (QUAT *) malloc( count * sizeof( QUAT ) );
+	QuatOut = (QUAT *) malloc( count * sizeof( QUAT ) );
+	Vec = (VECTOR *) malloc( count * sizeof( VECTOR ) );
+	VecOut = (VECTOR *) malloc( count * sizeof( VECTOR ) );
+	Alpha = (float *) malloc( count * sizeof( float ) );
+	if( !MatA || !MatB || !MatOut || !QuatA || !QuatB || !QuatOut || !Vec || !VecOut || !Alpha )
+	{
+		fprintf( stderr, "math: no memory for %d inputs\n", count );
+		return 1;
+	}
+
+	for( i = 0; i < count; i++ )
+	{
+		random_quat( &QuatA[ i ] );
+		random_quat( &QuatB[ i ] );
+		QuatToMatrix( &QuatA[ i ], &MatA[ i ] );
+		QuatToMatrix( &QuatB[ i ], &MatB[ i ] );
+		bench_random_dir( &Vec[ i ] );
+		Alpha[ i ] = bench_randf( 0.0F, 1.0F );
+	}
+
+	bench_case( "matrix_multiply", matrix_multiply_op, count );
+	bench_case( "apply_matrix", apply_matrix_op, count );
+	bench_case( "matrix_transpose", matrix_transpose_op, count );
+	bench_case( "quat_multiply", quat_multiply_op, count );
+	bench_case( "quat_to_matrix", quat_to_matrix_op, count );
+	bench_case( "quat_from_vector", quat_from_vector_op, count );
+	bench_case( "quat_slerp", quat_slerp_op, count );
+
+	// outputs are only read here so none of the batches can be skipped
+	for( i = 0; i < count; i++ )
+		bench_sink += (u_int32_t) ( MatOut[ i ]._11 + QuatOut[ i ].w + VecOut[ i ].x );
+
+	return bench_report();
+}
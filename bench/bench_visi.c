@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "main.h"
+#include "new3d.h"
+#include "quat.h"
+#include "render.h"
+#include "mload.h"
+#include "camera.h"
+#include "visi.h"
+#include "bench.h"
+
+/*
+	portal visibility from random cameras inside the level:
+
+		find_visible		FindVisible for one camera looking a random way
+*/
+
+// same view as a full screen 640x480 camera, see SetFOV in oct2.c
+#define VIEW_WIDTH		(640)
+#define VIEW_HEIGHT		(480)
+#define VIEW_NEAR		( 100.0F * GLOBAL_SCALE )
+#define VIEW_FAR		( 49152.0F * GLOBAL_SCALE )
+
+extern MLOADHEADER Mloadheader;
+extern render_info_t render_info;
+extern float hfov;
+
+static CAMERA			Camera;
+static VECTOR *			Pos;
+static u_int16_t *		Group;
+static RENDERMATRIX *	View;
+
+static void find_visible_op( int i )
+{
+	VISGROUP * g;
+
+	Camera.Pos = Pos[ i ];
+	Camera.GroupImIn = Group[ i ];
+	Camera.View = View[ i ];
+
+	FindVisible( &Camera, &Mloadheader );
+
+	for( g = Camera.visible.first_visible; g; g = g->next_visible )
+		bench_sink++;
+}
+
+// the view matrix Build_View makes for a camera at pos with orientation mat
+static void build_view( VECTOR * pos, MATRIX * mat, RENDERMATRIX * view )
+{
+	MATRIX inv;
+	VECTOR trans, trans2;
+
+	MatrixTranspose( mat, &inv );
+	trans.x = -pos->x;
+	trans.y = -pos->y;
+	trans.z = -pos->z;
+	ApplyMatrix( &inv, &trans, &trans2 );
+
+	view->_11 = mat->_11; view->_12 = mat->_12; view->_13 = mat->_13; view->_14 = mat->_14;
+	view->_21 = mat->_21; view->_22 = mat->_22; view->_23 = mat->_23; view->_24 = mat->_24;
+	view->_31 = mat->_31; view->_32 = mat->_32; view->_33 = mat->_33; view->_34 = mat->_34;
+	view->_41 = trans2.x; view->_42 = trans2.y; view->_43 = trans2.z; view->_44 = mat->_44;
+}
+
+int main( int argc, char ** argv )
+{
+	VECTOR dir;
+	QUAT quat;
+	MATRIX mat;
+	float viewplane_distance;
+	int count, i;
+
+	if( !bench_init( argc, argv, "visi" ) || !bench_load_level() )
+		return 1;
+
+	render_info.aspect_ratio = (float) VIEW_WIDTH / (float) VIEW_HEIGHT;
+
+	Camera.enable = true;
+	Camera.Viewport.X = 0;
+	Camera.Viewport.Y = 0;
+	Camera.Viewport.Width = VIEW_WIDTH;
+	Camera.Viewport.Height = VIEW_HEIGHT;
+	Camera.Viewport.MinZ = 0.0F;
+	Camera.Viewport.MaxZ = 1.0F;
+	Camera.Viewport.ScaleX = VIEW_WIDTH * 0.5F;
+	Camera.Viewport.ScaleY = VIEW_HEIGHT * 0.5F;
+
+	viewplane_distance = (float) ( VIEW_WIDTH / ( 2 * tan( hfov * PI / 180.0F * 0.5 ) ) );
+	Camera.Proj._11 = 2 * viewplane_distance / VIEW_WIDTH;
+	Camera.Proj._22 = 2 * viewplane_distance / VIEW_HEIGHT;
+	Camera.Proj._33 = VIEW_FAR / ( VIEW_FAR - VIEW_NEAR );
+	Camera.Proj._34 = 1.0F;
+	Camera.Proj._43 = -VIEW_FAR * VIEW_NEAR / ( VIEW_FAR - VIEW_NEAR );
+	Camera.Proj._44 = 0.0F;
+
+	count = bench_options.count;
+	Pos = (VECTOR *) malloc( count * sizeof( VECTOR ) );
+	Group = (u_int16_t *) malloc( count * sizeof( u_int16_t ) );
+	View = (RENDERMATRIX *) malloc( count * sizeof( RENDERMATRIX ) );
+	if( !Pos || !Group || !View )
+	{
+		fprintf( stderr, "visi: no memory for %d cameras\n", count );
+		return 1;
+	}
+
+	for( i = 0; i < count; i++ )
+	{
+		if( !bench_random_point( &Pos[ i ], &Group[ i ] ) )
+		{
+			fprintf( stderr, "visi: no point inside %s\n", bench_options.level );
+			return 1;
+		}
+		bench_random_dir( &dir );
+		QuatFromVector2( &dir, &quat );
+		QuatToMatrix( &quat, &mat );
+		build_view( &Pos[ i ], &mat, &View[ i ] );
+	}
+
+	bench_case( "find_visible", find_visible_op, count );
+
+	return bench_report();
+}
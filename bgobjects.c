@@ -32,6 +32,7 @@
 #include "controls.h"
 #include "util.h"
 #include "oct2.h"
+#include "pool.h"
 
 /*===================================================================
 	External Variables
@@ -42,7 +43,7 @@ extern	VECTOR			SlideUp;
 extern	VECTOR			SlideDown;
 extern	VECTOR			SlideLeft;
 extern	VECTOR			SlideRight;
-extern	MODEL			Models[ MAXNUMOFMODELS ];
+extern	MODEL			*	Models;
 extern	float			framelag;
 extern	MATRIX			MATRIX_Identity;
 extern	int16_t			LevelNum;
@@ -59,7 +60,8 @@ extern	int				NumOfTrigMods;
 extern	int16_t			NextNewModel;
 extern	LINE			Lines[ MAXLINES ];
 extern	MLOADHEADER		Mloadheader;
-extern	ENEMY			Enemies[ MAXENEMIES ];
+extern	ENEMY			*	Enemies;
+extern	pool_t			EnemyPool;
 extern	ENEMY		*	EnemyGroups[ MAXGROUPS ];
 extern	ENEMY_TYPES		EnemyTypes[ MAX_ENEMY_TYPES ];
 extern	PICKUP	*		PickupGroups[ MAXGROUPS ];
@@ -80,7 +82,7 @@ extern	SECONDARYWEAPONBULLET *	SecBullGroups[ MAXGROUPS ];
 ===================================================================*/
 BGO_FILE	*	BGOFilesPtr = NULL;
 BGOBJECT	*	FirstBGObjectUsed = NULL;
-BGOBJECT	*	FirstBGObjectFree = NULL;
+pool_t			BGObjectPool;
 BGOBJECT		BGObjects[ MAXBGOBJECTS ];
 bool			ShowColZones = false;
 
@@ -115,7 +117,7 @@ void InitBGObjects( void )
 	u_int16_t	i;
 
 	FirstBGObjectUsed = NULL;
-	FirstBGObjectFree = &BGObjects[ 0 ];
+	pool_init( &BGObjectPool, "bgobjects", MAXBGOBJECTS );
 
 	for( i = 0; i < MAXBGOBJECTS; i++ )
 	{
@@ -126,12 +128,7 @@ void InitBGObjects( void )
 		BGObjects[ i ].Index = i;
 		BGObjects[ i ].NextUsed = NULL;
 		BGObjects[ i ].PrevUsed = NULL;
-		BGObjects[ i ].NextFree = &BGObjects[ i + 1 ];
-		BGObjects[ i ].PrevFree = &BGObjects[ i - 1 ];
 	}
-
-	BGObjects[ 0 ].PrevFree = NULL;
-	BGObjects[ MAXBGOBJECTS - 1 ].NextFree = NULL;
 }
 
 /*===================================================================
@@ -141,17 +138,14 @@ void InitBGObjects( void )
 ===================================================================*/
 BGOBJECT * FindFreeBGObject( void )
 {
-	BGOBJECT * Object;
+	BGOBJECT * Object = NULL;
+	u_int16_t i;
 
-	Object = FirstBGObjectFree;
+	i = pool_alloc( &BGObjectPool );
 
-	if( Object != NULL )
+	if( i != POOL_NONE )
 	{
-		FirstBGObjectFree = Object->NextFree;
-		if( FirstBGObjectFree != NULL )
-		{
-			FirstBGObjectFree->PrevFree = NULL;
-		}
+		Object = &BGObjects[ i ];
 
 		if( FirstBGObjectUsed != NULL )
 		{
@@ -209,11 +203,6 @@ void KillUsedBGObject( BGOBJECT * Object )
 			}
 		}
 
-		if( FirstBGObjectFree != NULL )
-		{
-			FirstBGObjectFree->PrevFree = Object;
-		}
-
 		if( Object->ModelIndex != (u_int16_t) -1 )
 		{
 			KillUsedModel( Object->ModelIndex );
@@ -228,9 +217,7 @@ void KillUsedBGObject( BGOBJECT * Object )
 			Object->NumChildren = 0;
 		}
 
-		Object->NextFree = FirstBGObjectFree;
-		Object->PrevFree = NULL;
-		FirstBGObjectFree = Object;
+		pool_free( &BGObjectPool, Object->Index );
 	}
 }
 
@@ -2030,7 +2017,7 @@ bool CheckBGObjectToEnemies( BGOBJECT * Object )
 
 			if( ( Enemy->Status & ENEMY_STATUS_Enable ) && Enemy->Alive )
 			{
-				if( DebugCount > MAXENEMIES )
+				if( DebugCount > EnemyPool.size )
 				{
 					Msg( "CheckBGObjectToEnemies() Link list corrupt!!" );
 					return( (u_int16_t) -1 );
@@ -2325,13 +2312,14 @@ FILE * SaveBGObjects( FILE * fp )
 {
 	int		i;
 	u_int16_t	TempIndex = (u_int16_t) -1;
+	u_int16_t	FirstFree;
 
 	if( fp )
 	{
 		if( FirstBGObjectUsed != NULL ) fwrite( &FirstBGObjectUsed->Index, sizeof( u_int16_t ), 1, fp );
 		else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
-		if( FirstBGObjectFree != NULL ) fwrite( &FirstBGObjectFree->Index, sizeof( u_int16_t ), 1, fp );
-		else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
+		FirstFree = pool_free_slot( &BGObjectPool, 0 );
+		fwrite( &FirstFree, sizeof( u_int16_t ), 1, fp );
 		
 		for( i = 0; i < MAXBGOBJECTS; i++ )
 		{
@@ -2407,10 +2395,8 @@ FILE * SaveBGObjects( FILE * fp )
 			else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
 			if( BGObjects[ i ].NextUsed != NULL ) fwrite( &BGObjects[ i ].NextUsed->Index, sizeof( u_int16_t ), 1, fp );
 			else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
-			if( BGObjects[ i ].PrevFree != NULL ) fwrite( &BGObjects[ i ].PrevFree->Index, sizeof( u_int16_t ), 1, fp );
-			else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
-			if( BGObjects[ i ].NextFree != NULL ) fwrite( &BGObjects[ i ].NextFree->Index, sizeof( u_int16_t ), 1, fp );
-			else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
+			fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );		// was PrevFree
+			fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );		// was NextFree
 		}
 	}
 
@@ -2427,15 +2413,14 @@ FILE * LoadBGObjects( FILE * fp )
 	int		i;
 	u_int16_t	TempIndex;
 	int16_t	NumChildren;
+	BGOBJECT *	Object;
 
 	if( fp )
 	{
 		fread( &TempIndex, sizeof( u_int16_t ), 1, fp );
 		if( TempIndex != (u_int16_t) -1 ) FirstBGObjectUsed = &BGObjects[ TempIndex ];
 		else FirstBGObjectUsed = NULL;
-		fread( &TempIndex, sizeof( u_int16_t ), 1, fp );
-		if( TempIndex != (u_int16_t) -1 ) FirstBGObjectFree = &BGObjects[ TempIndex ];
-		else FirstBGObjectFree = NULL;
+		fread( &TempIndex, sizeof( u_int16_t ), 1, fp );		// first free, the pool is rebuilt below
 
 		for( i = 0; i < MAXBGOBJECTS; i++ )
 		{
@@ -2533,13 +2518,14 @@ FILE * LoadBGObjects( FILE * fp )
 			fread( &TempIndex, sizeof( u_int16_t ), 1, fp );
 			if( TempIndex != (u_int16_t) -1 ) BGObjects[ i ].NextUsed = &BGObjects[ TempIndex ];
 			else  BGObjects[ i ].NextUsed = NULL;
-			fread( &TempIndex, sizeof( u_int16_t ), 1, fp );
-			if( TempIndex != (u_int16_t) -1 ) BGObjects[ i ].PrevFree = &BGObjects[ TempIndex ];
-			else  BGObjects[ i ].PrevFree = NULL;
-			fread( &TempIndex, sizeof( u_int16_t ), 1, fp );
-			if( TempIndex != (u_int16_t) -1 ) BGObjects[ i ].NextFree = &BGObjects[ TempIndex ];
-			else  BGObjects[ i ].NextFree = NULL;
+			fread( &TempIndex, sizeof( u_int16_t ), 1, fp );		// was PrevFree
+			fread( &TempIndex, sizeof( u_int16_t ), 1, fp );		// was NextFree
 		}
+
+		pool_clear( &BGObjectPool );
+		for( Object = FirstBGObjectUsed; Object != NULL; Object = Object->NextUsed )
+			pool_mark( &BGObjectPool, Object->Index );
+		pool_rebuild( &BGObjectPool );
 	}
 
 	return( fp );
@@ -137,8 +137,6 @@ typedef struct BGOBJECT {
 
 	struct	BGOBJECT	*	PrevUsed;
 	struct	BGOBJECT	*	NextUsed;
-	struct	BGOBJECT	*	PrevFree;
-	struct	BGOBJECT	*	NextFree;
 
 } BGOBJECT;
 
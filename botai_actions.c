@@ -499,11 +499,11 @@ bool BOTAI_ShootEnemyMines()
 
 	TargetMine = -1;
 
-	// search all secondary bullets
-	for(i = 0; i< MAXSECONDARYWEAPONBULLETS; i++)
+	// search all live secondary bullets
+	for(i = pool_first( &SecBullPool ); i != POOL_NONE; i = pool_next( &SecBullPool, i ))
 	{
 		// for mines that aren't my own
-		if(SecBulls[i].SecType == SEC_MINE && SecBulls[i].Owner !=WhoIAm && SecBulls[i].Used)
+		if(SecBulls[i].SecType == SEC_MINE && SecBulls[i].Owner !=WhoIAm)
 		{
 			// that i can see
 			if( BOTAI_ClearLOS( &Ships[WhoIAm].Object.Pos, Ships[WhoIAm].Object.Group, &SecBulls[i].Pos ))
@@ -37,6 +37,7 @@
 #include "util.h"
 #include "timer.h"
 #include "ai.h"
+#include "pool.h"
 
 extern bool TeamGame;
 extern BYTE	TeamNumber[MAX_PLAYERS];
@@ -44,11 +45,14 @@ extern BYTE WhoIAm;
 extern MCLOADHEADER	MCloadheader;
 extern MCLOADHEADER	MCloadheadert0;
 extern MLOADHEADER Mloadheader;
-extern MODEL Models[MAXNUMOFMODELS];
+extern MODEL * Models;
 extern PICKUP Pickups[ MAXPICKUPS ];
 extern PRIMARYWEAPONATTRIB PrimaryWeaponAttribs[ TOTALPRIMARYWEAPONS ];
-extern PRIMARYWEAPONBULLET PrimBulls[ MAXPRIMARYWEAPONBULLETS ];
-extern SECONDARYWEAPONBULLET SecBulls[ MAXSECONDARYWEAPONBULLETS ];
+extern PRIMARYWEAPONBULLET * PrimBulls;
+extern SECONDARYWEAPONBULLET * SecBulls;
+extern pool_t PrimBullPool;
+extern pool_t SecBullPool;
+extern pool_t PickupPool;
 extern SHIPCONTROL control;
 extern SHIPHEALTHMSG PlayerHealths[ MAX_PLAYERS+1 ];
 extern VECTOR Backward;
@@ -642,7 +642,7 @@ void BOTAI_GetNearestPickup()
 	GettingPickup = -1;
 
 	// for all pickups
-	for(i=0; i<MAXPICKUPS; i++)
+	for(i = pool_first( &PickupPool ); i != POOL_NONE; i = pool_next( &PickupPool, i ))
 	{
 		// that are enabled
 		if(Pickups[i].Type == (u_int16_t) -1)
@@ -766,10 +766,10 @@ float BOTAI_WhenWillBulletHitMe(VECTOR * MyPos)
 	float Cos;
 
 	// primary weapon bullets
-	for(i = 0; i < MAXPRIMARYWEAPONBULLETS; i++)
+	for(i = pool_first( &PrimBullPool ); i != POOL_NONE; i = pool_next( &PrimBullPool, i ))
 	{
-		// that are active and aren't my own
-		if(PrimBulls[i].Used && PrimBulls[i].Owner != WhoIAm)
+		// that aren't my own
+		if(PrimBulls[i].Owner != WhoIAm)
 		{
 			// set the collision radius
 			switch( PrimaryWeaponAttribs[ PrimBulls[i].Weapon ].ColType )
@@ -815,10 +815,10 @@ float BOTAI_WhenWillBulletHitMe(VECTOR * MyPos)
 
 	// missiles
 	HomingMissile = -1;
-	for(i = 0; i< MAXSECONDARYWEAPONBULLETS; i++)
+	for(i = pool_first( &SecBullPool ); i != POOL_NONE; i = pool_next( &SecBullPool, i ))
 	{
-		// ignore inactive missiles or my own
-		if(!SecBulls[i].Used || SecBulls[i].Owner == WhoIAm)
+		// ignore my own
+		if(SecBulls[i].Owner == WhoIAm)
 			continue;
 
 		// get the distance from me and time to impact
@@ -12,6 +12,7 @@
 #include "file.h"
 
 #include "util.h"
+#include "memo.h"
 
 
 #define BSP_VERSION_NUMBER	(1)
@@ -36,7 +37,7 @@ extern bool AmIOutsideGroup( MLOADHEADER * m, VECTOR * EndPos, u_int16_t EndGrou
 /*===================================================================
 		Globals ...
 ===================================================================*/
-bool FindCollision( BSP_NODE * node_ptr, VECTOR * start_point_ptr, VECTOR * end_point_ptr );
+static bool FindCollision( BSP_TREE * tree, u_int16_t node, VECTOR * start_point_ptr, VECTOR * end_point_ptr );
 
 BSP_HEADER Bsp_Header[ 2 ];
 float ColRad;
@@ -58,9 +59,11 @@ bool Bsp_Duplicate( BSP_HEADER *src, BSP_HEADER *dup )
 		duptree = &dup->Bsp_Tree[ j ];
 		duptree->NumNodes = srctree->NumNodes;
 		duptree->Root = (BSP_NODE *) calloc( srctree->NumNodes, sizeof( BSP_NODE ) );
-		if ( !duptree->Root )
+		duptree->Flat = (BSP_FLATNODE *) calloc( srctree->NumNodes, sizeof( BSP_FLATNODE ) );
+		if ( !duptree->Root || !duptree->Flat )
 			return false;
 		memmove( duptree->Root, srctree->Root, srctree->NumNodes * sizeof( BSP_NODE ) );//memcpy
+		memmove( duptree->Flat, srctree->Flat, srctree->NumNodes * sizeof( BSP_FLATNODE ) );
 	}
 	return true;
 }
@@ -88,12 +91,19 @@ bool Bsp_Identical( BSP_HEADER *b1, BSP_HEADER *b2 )
 }
 
 
+#define BSP_UNPACKED	((u_int16_t) -1)
+
 static bool BSP_Loadtree( BSP_TREE *t, char **Buffer )
 {
 	BSP_RAWNODE * Raw;
+	BSP_RAWNODE * From;
 	BSP_NODE * New;
+	BSP_FLATNODE * Flat;
 	int16_t		*	int16_tpnt;
-	int16_t		e;
+	u_int16_t	*	order;		// file node of each packed node
+	u_int16_t	*	packed;		// packed node of each file node
+	u_int16_t	*	stack;
+	int			e, n, sp;
 
 	// get the number of nodes and move to next pointer
 	int16_tpnt = ( int16_t * ) *Buffer;
@@ -103,38 +113,86 @@ static bool BSP_Loadtree( BSP_TREE *t, char **Buffer )
 	// initialize the root node and set aside enough space
 	// set aside size of N BSP_NODE's
 	t->Root = (BSP_NODE * ) calloc( t->NumNodes , sizeof( BSP_NODE ) );
-	if ( !t->Root )
+	t->Flat = (BSP_FLATNODE * ) calloc( t->NumNodes , sizeof( BSP_FLATNODE ) );
+	order = (u_int16_t *) malloc( t->NumNodes * sizeof( u_int16_t ) );
+	packed = (u_int16_t *) malloc( t->NumNodes * sizeof( u_int16_t ) );
+	stack = (u_int16_t *) malloc( 2 * t->NumNodes * sizeof( u_int16_t ) );
+	if ( !t->Root || !t->Flat || !order || !packed || !stack )
+	{
+		if( order ) free( order );
+		if( packed ) free( packed );
+		if( stack ) free( stack );
 		return false;
+	}
 	
 	// cast buffer to BSP_RAWNODE for extracting values
 	Raw = (BSP_RAWNODE *) *Buffer;
 
+	// lay the nodes out depth first, front side first, so a walk
+	// mostly moves forward through memory
+	for( e = 0 ; e < t->NumNodes ; e++ )
+		packed[ e ] = BSP_UNPACKED;
+	n = 0;
+	sp = 0;
+	stack[ sp++ ] = 0;
+	while( sp )
+	{
+		e = stack[ --sp ];
+		if( packed[ e ] != BSP_UNPACKED )
+			continue;
+		packed[ e ] = (u_int16_t) n;
+		order[ n++ ] = (u_int16_t) e;
+		if( Raw[ e ].Back )
+			stack[ sp++ ] = (u_int16_t) Raw[ e ].Back;
+		if( Raw[ e ].Front )
+			stack[ sp++ ] = (u_int16_t) Raw[ e ].Front;
+	}
+	// anything the root can't reach keeps its place in the file order
+	for( e = 0 ; e < t->NumNodes ; e++ )
+	{
+		if( packed[ e ] == BSP_UNPACKED )
+		{
+			packed[ e ] = (u_int16_t) n;
+			order[ n++ ] = (u_int16_t) e;
+		}
+	}
+
 	// initialize first node
 	New = t->Root;
 	New->Parent = NULL;
+	Flat = t->Flat;
 	
 	// pack on node heirachy
-	for( e = 0 ; e < t->NumNodes ; e++ )
+	for( n = 0 ; n < t->NumNodes ; n++ )
 	{
-		New->Normal = Raw->Normal;
-		New->Offset = Raw->Offset;
-		New->Colour = Raw->Colour;
-		if( !Raw->Front ) New->Front = NULL;
+		From = &Raw[ order[ n ] ];
+		New->Normal = From->Normal;
+		New->Offset = From->Offset;
+		New->Colour = From->Colour;
+		Flat->Normal = From->Normal;
+		Flat->Offset = From->Offset;
+		if( !From->Front ) New->Front = NULL;
 		else{
-			New->Front = t->Root + Raw->Front;
+			Flat->Front = packed[ From->Front ];
+			New->Front = t->Root + Flat->Front;
 			New->Front->Parent = New;
 		}
-		if( !Raw->Back ) New->Back = NULL;
+		if( !From->Back ) New->Back = NULL;
 		else{
-			New->Back  = t->Root + Raw->Back;
+			Flat->Back = packed[ From->Back ];
+			New->Back  = t->Root + Flat->Back;
 			New->Back->Parent = New;
 		}
 		New++;
-		Raw++;
+		Flat++;
 	}
 
+	free( order );
+	free( packed );
+	free( stack );
+
 	// rest of data is garbage
-	*Buffer = (char*) Raw;
+	*Buffer = (char*) ( Raw + t->NumNodes );
 
 	return true;
 }
@@ -305,6 +363,9 @@ bool Bspload( char * Filename, BSP_HEADER *Bsp_Header )
 #endif
 	Bsp_Header->State = true;
 
+	// nothing found in the last level's trees is any good now
+	memo_invalidate();
+
 #ifdef BSP_ONLY
 	if ( !BSP_LoadPortals( Filename ) )
 		return false;
@@ -336,6 +397,11 @@ void Bspfree( void )
 					free(Bsp_Header[ bsp_num ].Bsp_Tree[i].Root);
 					Bsp_Header[ bsp_num ].Bsp_Tree[i].Root = NULL;
 				}
+				if( Bsp_Header[ bsp_num ].Bsp_Tree[i].Flat )
+				{
+					free(Bsp_Header[ bsp_num ].Bsp_Tree[i].Flat);
+					Bsp_Header[ bsp_num ].Bsp_Tree[i].Flat = NULL;
+				}
 			}
 			Bsp_Header[ bsp_num ].NumGroups = 0;
 			Bsp_Header[ bsp_num ].State = false;
@@ -357,6 +423,9 @@ void Bspfree( void )
 				if ( bp->bsp.Root )
 					free( bp->bsp.Root );
 				bp->bsp.Root = NULL;
+				if ( bp->bsp.Flat )
+					free( bp->bsp.Flat );
+				bp->bsp.Flat = NULL;
 			}
 			if ( pg->portal )
 				free( pg->portal );
@@ -365,6 +434,8 @@ void Bspfree( void )
 		}
 		Bsp_Portal_Header.state = false;
 	}
+
+	memo_invalidate();
 #endif
 }
 
@@ -384,6 +455,12 @@ VECTOR OldCollidePoint;
 float CollisionRadius = 0.0F;
 
 bool RayCollide( BSP_HEADER *Bsp_Header, VECTOR *StartPos, VECTOR *Dir, VECTOR *ImpactPoint, VECTOR *ImpactNormal, float *ImpactOffset , u_int16_t group)
+{
+	return RayCollideTree( &Bsp_Header->Bsp_Tree[ group % Bsp_Header->NumGroups ], StartPos, Dir, ImpactPoint, ImpactNormal, ImpactOffset );
+}
+
+// RayCollide on a tree the caller already looked up, for runs of rays in one group
+bool RayCollideTree( BSP_TREE *tree, VECTOR *StartPos, VECTOR *Dir, VECTOR *ImpactPoint, VECTOR *ImpactNormal, float *ImpactOffset )
 {
 	bool collided;
 	VECTOR EndPos;
@@ -397,7 +474,7 @@ bool RayCollide( BSP_HEADER *Bsp_Header, VECTOR *StartPos, VECTOR *Dir, VECTOR *
 	EndPos.z = StartPos->z + Dir->z;
 	Depth = 0;
 
-	collided = FindCollision( Bsp_Header->Bsp_Tree[ group % Bsp_Header->NumGroups ].Root, StartPos, &EndPos );
+	collided = FindCollision( tree, 0, StartPos, &EndPos );
 	
 	if ( collided && CollideNode )
 	{
@@ -428,238 +505,593 @@ bool RayCollide( BSP_HEADER *Bsp_Header, VECTOR *StartPos, VECTOR *Dir, VECTOR *
 
 /*===================================================================
 	Procedure	:		Define if a ray hits a solid..
-	Input		:		BSP_NODE * Start node
+	Input		:		BSP_TREE * tree
+						u_int16_t node to start from
 						VECTOR * Start Position
 						VECTOR * end Position
 	Output		:		bool
 ===================================================================*/
-bool FindCollision( BSP_NODE * node_ptr, VECTOR * start_point_ptr, VECTOR * end_point_ptr )
+
+#define BSP_STACK	(64)	// splits left to come back to before falling back on recursion
+
+// far side of a split, walked if nothing on the near side was hit
+typedef struct BSP_SPLIT
 {
+	u_int16_t	node;
+	u_int16_t	far_node;	// 0 if none
+	bool		side;		// start point behind the plane
+	VECTOR		point;		// where the segment crosses the plane
+	VECTOR		end;
+} BSP_SPLIT;
+
+static bool FindCollision( BSP_TREE * tree, u_int16_t node, VECTOR * start_point_ptr, VECTOR * end_point_ptr )
+{
+	BSP_FLATNODE	* nodes = tree->Flat;
+	BSP_FLATNODE	* node_ptr;
+	BSP_SPLIT		stack[ BSP_STACK ];
+	BSP_SPLIT	*	split;
+	int				sp = 0;
+	VECTOR			start_point;
+	VECTOR			end_point;
 	float		d1, d2;
 	VECTOR		intersection_point;
-	BSP_NODE	* near_node_ptr;
-	BSP_NODE	* far_node_ptr;
+	u_int16_t	near_node;
+	u_int16_t	far_node;
 	float div;
 	float distance2plane;
 	bool	side;
+	bool	result;
+	bool	parallel;
+
+	if( !start_point_ptr || !nodes || !end_point_ptr ) return false;
+
+	start_point = *start_point_ptr;
+	end_point = *end_point_ptr;
 
 	Depth++;
 
-start:
-
-	// BUG: some reason bully got a null pointer here on either start_point_ptr or node_ptr
-	// was a recursive call from the very last line of this function
-
-/*
-	Thread 0 (crashed)
- 0  ProjectX_1.13.1000.exe!FindCollision [bsp.c : 449 + 0x8]
-    eip = 0x0041d5db   esp = 0x0012f704   ebp = 0x0012f74c   ebx = 0x00000001
-    esi = 0x00000002   edi = 0x00000a28   eax = 0x00120124   ecx = 0x0012f79c
-    edx = 0x2dbd85a5   efl = 0x00210206
- 1  ProjectX_1.13.1000.exe!FindCollision [bsp.c : 567 + 0x10]
-    eip = 0x0041da5c   esp = 0x0012f754   ebp = 0x0012f7a8
- 2  ProjectX_1.13.1000.exe!RayCollide [bsp.c : 401 + 0x1f]
-    eip = 0x0041d50f   esp = 0x0012f7b0   ebp = 0x0012f7cc
- 3  ProjectX_1.13.1000.exe!OneGroupPolyCol [collision.c : 1408 + 0x24]
-    eip = 0x0041e9c8   esp = 0x0012f7d4   ebp = 0x0012f86c
- 4  ProjectX_1.13.1000.exe!BackgroundCollide [collision.c : 697 + 0x30]
-    eip = 0x0041e213   esp = 0x0012f874   ebp = 0x0012f950
- 5  ProjectX_1.13.1000.exe!ObjectCollide [collision.c : 3204 + 0x50]
-    eip = 0x00420896   esp = 0x0012f958   ebp = 0x0012fae4
- 6  ProjectX_1.13.1000.exe!ProcessShips [ships.c : 1078 + 0x1a]
-    eip = 0x004dc5c8   esp = 0x0012faec   ebp = 0x0012fcc4
- 7  ProjectX_1.13.1000.exe!MainRoutines [oct2.c : 5397 + 0x4]
-    eip = 0x0047a326   esp = 0x0012fccc   ebp = 0x0012fccc
- 8  ProjectX_1.13.1000.exe!MainGame [oct2.c : 5596 + 0x4]
-    eip = 0x0047a7c7   esp = 0x0012fcd4   ebp = 0x0012fd40
- 9  ProjectX_1.13.1000.exe!RenderScene [oct2.c : 3956 + 0xc]
-    eip = 0x004778be   esp = 0x0012fd48   ebp = 0x0012fef0
-10  ProjectX_1.13.1000.exe!RenderLoop [d3dmain.cpp : 1207 + 0x17]
-    eip = 0x00431a86   esp = 0x0012fef8   ebp = 0x0012ff00
-11  ProjectX_1.13.1000.exe!WinMain [d3dmain.cpp : 232 + 0x4]
-    eip = 0x0043077a   esp = 0x0012ff08   ebp = 0x0012ff28
-12  ProjectX_1.13.1000.exe!__tmainCRTStartup [crt0.c : 324 + 0x1b]
-    eip = 0x005417e5   esp = 0x0012ff30   ebp = 0x0012ffc0
-13  kernel32.dll + 0x16fe6
-    eip = 0x7c816fe7   esp = 0x0012ffc8   ebp = 0x0012fff0
-
-*/
-
-	if( !start_point_ptr || !node_ptr || !end_point_ptr ) return false;
-
-	d1 = POINT_TO_PLANE( start_point_ptr, node_ptr ) - CollisionRadius;
-	d2 = POINT_TO_PLANE(   end_point_ptr, node_ptr ) - CollisionRadius;
-
-    if( d1 < TOLER && d1 > -TOLER ) d1 = 0.0F;
-    if( d2 < TOLER && d2 > -TOLER )
+	for( ;; )
 	{
-		if( d1 == 0 )
-		{
-			// d1 + d2 = 0 Parallel ray....
-			BSP_NODE *Back_CollideNode;
-			VECTOR Back_CollidePoint;
+		node_ptr = &nodes[ node ];
+		parallel = false;
+
+		d1 = POINT_TO_PLANE( &start_point, node_ptr ) - CollisionRadius;
+		d2 = POINT_TO_PLANE(   &end_point, node_ptr ) - CollisionRadius;
 
-			if ( node_ptr->Back && node_ptr->Front )
+		if( d1 < TOLER && d1 > -TOLER ) d1 = 0.0F;
+		if( d2 < TOLER && d2 > -TOLER )
+		{
+			if( d1 == 0 )
 			{
-				if ( FindCollision( node_ptr->Back, start_point_ptr, end_point_ptr ) )
+				// d1 + d2 = 0 Parallel ray....
+				BSP_NODE *Back_CollideNode;
+				VECTOR Back_CollidePoint;
+
+				// rare enough to just recurse into both sides
+				parallel = true;
+				if ( node_ptr->Back && node_ptr->Front )
 				{
-					Back_CollideNode = CollideNode;
-					Back_CollidePoint = CollidePoint;
-					if ( FindCollision( node_ptr->Front, start_point_ptr, end_point_ptr ) )
+					if ( FindCollision( tree, node_ptr->Back, &start_point, &end_point ) )
 					{
-						VECTOR dv;
-
-						dv.x = Back_CollidePoint.x - start_point_ptr->x;
-						dv.y = Back_CollidePoint.y - start_point_ptr->y;
-						dv.z = Back_CollidePoint.z - start_point_ptr->z;
-						d1 = VectorLength( &dv );
-						dv.x = CollidePoint.x - start_point_ptr->x;
-						dv.y = CollidePoint.y - start_point_ptr->y;
-						dv.z = CollidePoint.z - start_point_ptr->z;
-						d2 = VectorLength( &dv );
-						if ( d1 < d2 )
+						Back_CollideNode = CollideNode;
+						Back_CollidePoint = CollidePoint;
+						if ( FindCollision( tree, node_ptr->Front, &start_point, &end_point ) )
+						{
+							VECTOR dv;
+
+							dv.x = Back_CollidePoint.x - start_point.x;
+							dv.y = Back_CollidePoint.y - start_point.y;
+							dv.z = Back_CollidePoint.z - start_point.z;
+							d1 = VectorLength( &dv );
+							dv.x = CollidePoint.x - start_point.x;
+							dv.y = CollidePoint.y - start_point.y;
+							dv.z = CollidePoint.z - start_point.z;
+							d2 = VectorLength( &dv );
+							if ( d1 < d2 )
+							{
+								CollideNode = Back_CollideNode;
+								CollidePoint = Back_CollidePoint;
+							}
+						}
+						else
 						{
 							CollideNode = Back_CollideNode;
 							CollidePoint = Back_CollidePoint;
 						}
+						result = true;
 					}
 					else
 					{
-						CollideNode = Back_CollideNode;
-						CollidePoint = Back_CollidePoint;
+						result = FindCollision( tree, node_ptr->Front, &start_point, &end_point );
 					}
-					return true;
 				}
-				else
+				else if ( node_ptr->Back )
+				{
+					node = node_ptr->Back;
+					continue;
+				}
+				else if ( node_ptr->Front )
 				{
-					return FindCollision( node_ptr->Front, start_point_ptr, end_point_ptr );
+					node = node_ptr->Front;
+					continue;
+				}
+				else // oh shit...what do we do now???
+				{
+					result = false;
 				}
 			}
-			else if ( node_ptr->Back )
+			else
 			{
-				return FindCollision( node_ptr->Back, start_point_ptr, end_point_ptr );
+				d2 = 0.0F;
 			}
-			else if ( node_ptr->Front )
+		}
+
+		if( parallel )
+		{
+			// settled above
+		}
+		else if( (d1 < -CollisionRadius) && (d2 < -CollisionRadius) )
+		{
+			if( node_ptr->Back )
+			{
+				node = node_ptr->Back;
+				continue;
+			}
+			// Entire segment inside a solid.
+			result = true;
+		}
+		else if( (d1 >= CollisionRadius) && (d2 >= CollisionRadius) )
+		{
+			if( node_ptr->Front )
 			{
-				return FindCollision( node_ptr->Front, start_point_ptr, end_point_ptr );
+				node = node_ptr->Front;
+				continue;
 			}
-			else // oh shit...what do we do now???
+			result = false;
+		}
+		else
+		{
+			// We intersect the Plane...
+			div = ( RayDir.x * node_ptr->Normal.x) + 
+				  ( RayDir.y * node_ptr->Normal.y) + 
+				  ( RayDir.z * node_ptr->Normal.z);
+			distance2plane = POINT_TO_PLANE( &RayPos , node_ptr ) - CollisionRadius;
+
+			distance2plane = distance2plane / div;
+			intersection_point.x = RayPos.x - ( RayDir.x * distance2plane );
+			intersection_point.y = RayPos.y - ( RayDir.y * distance2plane );
+			intersection_point.z = RayPos.z - ( RayDir.z * distance2plane );
+
+			if( side = d1 < 0 )
 			{
-				return false;
+				near_node = node_ptr->Back;
+				far_node = node_ptr->Front;
+			}else{
+				near_node = node_ptr->Front;
+				far_node = node_ptr->Back;
 			}
 
-			return true;
+			if( !near_node && side )
+			{
+				result = true;
+			}
+			else if( near_node && sp < BSP_STACK )
+			{
+				// walk the near side first, come back for the far side if it misses
+				split = &stack[ sp++ ];
+				split->node = node;
+				split->far_node = far_node;
+				split->side = side;
+				split->point = intersection_point;
+				split->end = end_point;
+				end_point = intersection_point;
+				node = near_node;
+				continue;
+			}
+			else if( near_node && FindCollision( tree, near_node, &start_point, &intersection_point ) )
+			{
+				result = true;
+			}
+			else
+			{
+				CollideNode = tree->Root + node;
+				CollidePoint = intersection_point;
+				if ( !far_node )
+				{
+					result = !side;
+				}
+				else
+				{
+					start_point = intersection_point;
+					node = far_node;
+					continue;
+				}
+			}
 		}
-		d2 = 0.0F;
-	}
 
-	if( (d1 < -CollisionRadius) && (d2 < -CollisionRadius) )
-	{
-		if( node_ptr = node_ptr->Back )
+		// a hit ends the walk, a miss goes on to the far side of the last split
+		for( ;; )
 		{
-			goto start;
+			if( result || !sp )
+				return result;
+			split = &stack[ --sp ];
+			CollideNode = tree->Root + split->node;
+			CollidePoint = split->point;
+			if ( split->far_node )
+				break;
+			result = !split->side;
 		}
-		// Entire segment inside a solid.
-		return true;
+		start_point = split->point;
+		end_point = split->end;
+		node = split->far_node;
 	}
-	if( (d1 >= CollisionRadius) && (d2 >= CollisionRadius) )
+}
+/*===================================================================
+	Procedure	:		Define if a point is inside or outside
+	Input		:		VECTOR * Pos , BSP_FLATNODE * nodes , u_int16_t node
+	Output		:		bool
+===================================================================*/
+static bool PISDistFrom( VECTOR *Pos, BSP_FLATNODE *nodes, u_int16_t node )
+{
+	BSP_FLATNODE *n;
+	u_int16_t stack[ BSP_STACK ];	// back sides of planes the point was on
+	int sp = 0;
+	float d;
+
+	for( ;; )
 	{
-		if( node_ptr = node_ptr->Front )
+		// go down the BSP tree
+		n = &nodes[ node ];
+		d = n->Normal.x * Pos->x + n->Normal.y * Pos->y + n->Normal.z * Pos->z + n->Offset;
+		if ( d > TOLER  )
+		{ // definitely in front of plane
+			if ( n->Front )
+			{
+				node = n->Front;
+				continue;
+			}
+			return true;
+		}
+		if ( d < -TOLER )
+		{ // definitely behind plane
+			if ( n->Back )
+			{
+				node = n->Back;
+				continue;
+			}
+			OldCollideNode = NULL;
+			// solid this way, try the back of the last plane the point was on
+			if ( !sp )
+				return false;
+			node = stack[ --sp ];
+			continue;
+		}
+		// somewhere in between plane +/- TOLER (tricky case)
+		// inside if it is inside on either side
+		if ( !n->Front )
+			return true;
+		if ( n->Back )
 		{
-			goto start;
+			if ( sp < BSP_STACK )
+				stack[ sp++ ] = n->Back;
+			else if ( PISDistFrom( Pos, nodes, n->Back ) )
+				return true;
 		}
-		return false;
+		node = n->Front;
 	}
-   	// We intersect the Plane...
-
-
-	div = ( RayDir.x * node_ptr->Normal.x) + 
-   		  ( RayDir.y * node_ptr->Normal.y) + 
-   		  ( RayDir.z * node_ptr->Normal.z);
-	distance2plane = POINT_TO_PLANE( &RayPos , node_ptr ) - CollisionRadius;
-
-   	distance2plane = distance2plane / div;
-   	intersection_point.x = RayPos.x - ( RayDir.x * distance2plane );
-   	intersection_point.y = RayPos.y - ( RayDir.y * distance2plane );
-   	intersection_point.z = RayPos.z - ( RayDir.z * distance2plane );
-   	
-	if( side = d1 < 0 )
-   	{
-   		near_node_ptr = node_ptr->Back;
-   		far_node_ptr = node_ptr->Front;
-   	}else{
-   		near_node_ptr = node_ptr->Front;
-   		far_node_ptr = node_ptr->Back;
-   	}
-
-   	if( ( !near_node_ptr && ( side ) ) ||
-   		( near_node_ptr && FindCollision( near_node_ptr, start_point_ptr, &intersection_point ) ) )
-   	{
-   		return true;
-   	}
-	CollideNode = node_ptr;
-	CollidePoint = intersection_point;
-	if ( !far_node_ptr )
+}
+
+bool PISDist( VECTOR *Pos, BSP_TREE *tree )
+{
+	if ( !tree->Flat )
+		return false;
+	return PISDistFrom( Pos, tree->Flat, 0 );
+}
+
+/*===================================================================
+	Swept sphere
+
+	Each plane is pushed out by the radius as the tree is walked, a
+	piece of the move goes down the front when the sphere reaches in
+	front of the plane and down the back when it reaches behind, so
+	one walk finds the first time the sphere touches solid.  Face
+	contacts are exact, at outside corners the sphere stops a little
+	early as there are no bevel planes.
+
+	A plane is passed down as node + 1, negative when the solid is in
+	front of it.  entry is the plane whose crossing started the piece,
+	into is one the sphere started within the radius of and is moving
+	further into, used when the sphere starts touching solid.
+
+	Touching a portal of the group is not a hit, the group on the
+	other side is walked from there instead.
+===================================================================*/
+
+#define BSP_SWEEP_GROUPS	(8)		// groups one move can pass through
+#define BSP_SWEEP_PORTALS	(4)		// portals touched in one group
+#define BSP_SWEEP_PORTAL_TOLERANCE	(0.1F)
+
+typedef struct BSP_SWEEP
+{
+	BSP_FLATNODE	*	nodes;
+	BSP_PORTAL_GROUP *	portals;
+	VECTOR				start;
+	VECTOR				end;
+	float				radius;
+	float				time;		// first contact so far
+	int					plane;		// plane touched then
+	BSP_FLATNODE	*	plane_nodes;
+	int					num_portals;
+	int					portal[ BSP_SWEEP_PORTALS ];
+	float				portal_time[ BSP_SWEEP_PORTALS ];
+} BSP_SWEEP;
+
+static void SweepSolid( BSP_SWEEP *s, float t, int entry, int into )
+{
+	BSP_FLATNODE *n;
+	BSP_PORTAL *bp;
+	int plane;
+	int j, k;
+	float d;
+	VECTOR c, q;
+
+	plane = ( entry ) ? entry : into;
+	if ( !plane || t >= s->time )
+		return;
+
+	n = &s->nodes[ abs( plane ) - 1 ];
+
+	// the point of the plane the sphere is over
+	c.x = s->start.x + ( s->end.x - s->start.x ) * t;
+	c.y = s->start.y + ( s->end.y - s->start.y ) * t;
+	c.z = s->start.z + ( s->end.z - s->start.z ) * t;
+	d = POINT_TO_PLANE( &c, n );
+	q.x = c.x - n->Normal.x * d;
+	q.y = c.y - n->Normal.y * d;
+	q.z = c.z - n->Normal.z * d;
+
+	for ( j = 0; j < s->portals->portals; j++ )
 	{
-		if ( side )
-			return false;
-		return true;
+		bp = &s->portals->portal[ j ];
+		if ( fabs( DotProduct( &bp->normal, &n->Normal ) ) < 0.99F )
+			continue;
+		if ( fabs( DotProduct( &bp->normal, &q ) + bp->offset ) > BSP_SWEEP_PORTAL_TOLERANCE )
+			continue;
+		if ( !PISDist( &q, &bp->bsp ) )
+			continue;
+
+		for ( k = 0; k < s->num_portals; k++ )
+		{
+			if ( s->portal[ k ] == j )
+				break;
+		}
+		if ( k == s->num_portals )
+		{
+			if ( k == BSP_SWEEP_PORTALS )
+				return;
+			s->portal[ k ] = j;
+			s->portal_time[ k ] = t;
+			s->num_portals++;
+		}
+		else if ( t < s->portal_time[ k ] )
+		{
+			s->portal_time[ k ] = t;
+		}
+		return;
 	}
-	return FindCollision( far_node_ptr, &intersection_point, end_point_ptr );
-}
 
+	s->time = t;
+	s->plane = plane;
+	s->plane_nodes = s->nodes;
+}
 
+static void SweepNode( BSP_SWEEP *s, u_int16_t node, float t0, float t1, int entry, int into )
+{
+	BSP_FLATNODE *n;
+	float ds, dd, d0, d1;
+	float ta, tb;
+	int plane;
+
+	if ( t1 > s->time )
+		t1 = s->time;
+	if ( t0 > t1 )
+		return;
+
+	n = &s->nodes[ node ];
+	plane = node + 1;
+	ds = POINT_TO_PLANE( &s->start, n );
+	dd = POINT_TO_PLANE( &s->end, n ) - ds;
+	d0 = ds + dd * t0;
+	d1 = ds + dd * t1;
+
+	if ( d0 >= s->radius && d1 >= s->radius )
+	{
+		if ( n->Front )
+			SweepNode( s, n->Front, t0, t1, entry, into );
+		return;
+	}
 
+	if ( d0 <= -s->radius && d1 <= -s->radius )
+	{
+		if ( n->Back )
+			SweepNode( s, n->Back, t0, t1, entry, into );
+		else
+			SweepSolid( s, t0, entry, into );
+		return;
+	}
 
+	if ( dd < 0.0F )
+	{
+		// heading behind the plane, in front until the sphere is all behind it
+		tb = ( -s->radius - ds ) / dd;
+		if ( n->Front )
+			SweepNode( s, n->Front, t0, ( tb < t1 ) ? tb : t1, entry, into );
+
+		// and behind from when it first reaches past the plane
+		ta = ( s->radius - ds ) / dd;
+		if ( ta > t0 )
+		{
+			t0 = ta;
+			entry = plane;
+		}
+		else
+		{
+			into = plane;
+		}
+		if ( t0 > t1 )
+			return;
+		if ( n->Back )
+			SweepNode( s, n->Back, t0, t1, entry, into );
+		else
+			SweepSolid( s, t0, entry, into );
+	}
+	else if ( dd > 0.0F )
+	{
+		// heading in front of the plane, behind until the sphere is all in front
+		ta = ( s->radius - ds ) / dd;
+		if ( n->Back )
+			SweepNode( s, n->Back, t0, ( ta < t1 ) ? ta : t1, entry, into );
+		else
+			SweepSolid( s, t0, entry, into );
+
+		tb = ( -s->radius - ds ) / dd;
+		if ( tb > t0 )
+		{
+			t0 = tb;
+			entry = -plane;
+		}
+		else
+		{
+			into = -plane;
+		}
+		if ( t0 > t1 )
+			return;
+		if ( n->Front )
+			SweepNode( s, n->Front, t0, t1, entry, into );
+	}
+	else
+	{
+		// moving along the plane within the radius of it, both sides the whole way
+		if ( n->Front )
+			SweepNode( s, n->Front, t0, t1, entry, into );
+		if ( n->Back )
+			SweepNode( s, n->Back, t0, t1, entry, into );
+		else
+			SweepSolid( s, t0, entry, into );
+	}
+}
 
 /*===================================================================
-	Procedure	:		Define if a point is inside or outside
-	Input		:		VECTOR * Pos , Node *node
-	Output		:		bool
+	Procedure	:		Sweep a sphere through the groups it passes into
+	Input		:		BSP_HEADER * Bsp_Header
+						VECTOR * Start Position
+						u_int16_t group
+						VECTOR * Move
+						float Radius
+						float * Impact Time ( TBFI ) fraction of the move
+						VECTOR * Impact Normal ( TBFI ) away from the solid
+	Output		:		bool true if the sphere touched solid
 ===================================================================*/
-
-bool PISDistRecursive( VECTOR *Pos, BSP_NODE *node)
+bool SphereCollide( BSP_HEADER *Bsp_Header, VECTOR *StartPos, u_int16_t group, VECTOR *Move, float Radius, float *ImpactTime, VECTOR *ImpactNormal )
 {
-	float d;
+	BSP_SWEEP	s;
+	BSP_TREE *	tree;
+	BSP_PORTAL *bp;
+	u_int16_t	groups[ BSP_SWEEP_GROUPS ];
+	u_int16_t	from[ BSP_SWEEP_GROUPS ];
+	float		start[ BSP_SWEEP_GROUPS ];
+	int			num_groups;
+	int			i, j, k;
+	BSP_FLATNODE *n;
+
+	if ( !Bsp_Header->State || !Bsp_Header->NumGroups )
+		return false;
 
-start:
-	// go down the BSP tree
-	d = node->Normal.x * Pos->x + node->Normal.y * Pos->y + node->Normal.z * Pos->z + node->Offset;
-	if ( d > TOLER  )
-	{ // definitely in front of plane
-	 	if ( node = node->Front )
-	 	{
-	 		goto start;
-	 	}
-	 	else
-	 	{
-	 		return true;
-	 	}
-	}
-	if ( d < -TOLER )
-	{ // definitely behind plane
-		if ( node = node->Back )
+	s.start = *StartPos;
+	s.end.x = StartPos->x + Move->x;
+	s.end.y = StartPos->y + Move->y;
+	s.end.z = StartPos->z + Move->z;
+	s.radius = Radius;
+	s.time = 1.0F;
+	s.plane = 0;
+	s.plane_nodes = NULL;
+
+	groups[ 0 ] = group;
+	from[ 0 ] = (u_int16_t) -1;
+	start[ 0 ] = 0.0F;
+	num_groups = 1;
+
+	for ( i = 0; i < num_groups; i++ )
+	{
+		if ( start[ i ] >= s.time )
+			continue;
+
+		tree = &Bsp_Header->Bsp_Tree[ groups[ i ] % Bsp_Header->NumGroups ];
+		if ( !tree->Flat )
+			continue;
+
+		s.nodes = tree->Flat;
+		s.portals = &Bsp_Portal_Header.group[ groups[ i ] ];
+		s.num_portals = 0;
+		SweepNode( &s, 0, start[ i ], 1.0F, 0, 0 );
+
+		for ( j = 0; j < s.num_portals; j++ )
 		{
-			goto start;
+			bp = &s.portals->portal[ s.portal[ j ] ];
+			if ( s.portal_time[ j ] >= s.time || bp->group == from[ i ] )
+				continue;
+			for ( k = 0; k < num_groups; k++ )
+			{
+				if ( groups[ k ] == bp->group )
+					break;
+			}
+			if ( k < num_groups || num_groups == BSP_SWEEP_GROUPS )
+				continue;
+			groups[ num_groups ] = bp->group;
+			from[ num_groups ] = groups[ i ];
+			start[ num_groups ] = s.portal_time[ j ];
+			num_groups++;
 		}
-		OldCollideNode = node;
+	}
+
+	if ( !s.plane )
 		return false;
+
+	n = &s.plane_nodes[ abs( s.plane ) - 1 ];
+	*ImpactTime = s.time;
+	if ( s.plane > 0 )
+	{
+		*ImpactNormal = n->Normal;
 	}
-	// somewhere in between plane +/- TOLER (tricky case)
-	if ( !node->Front || PISDistRecursive( Pos, node->Front ) )
-		return true;
-	if ( node->Back && PISDistRecursive( Pos, node->Back ) )
-		return true;
-	return false;
+	else
+	{
+		ImpactNormal->x = -n->Normal.x;
+		ImpactNormal->y = -n->Normal.y;
+		ImpactNormal->z = -n->Normal.z;
+	}
+	return true;
 }
 
 
 
 bool PointInsideSkin( VECTOR *Pos, u_int16_t Group )
 {
+	u_int32_t key[ MEMO_KEY_WORDS ];
+	u_int32_t value[ MEMO_VALUE_WORDS ];
+
 	if( Bsp_Header[ 0 ].State )
 	{
-		return PISDistRecursive( Pos, Bsp_Header[0].Bsp_Tree[ Group % Bsp_Header[0].NumGroups ].Root );
+		// ships, cameras, sounds and lights all ask about the same positions
+		memset( key, 0, sizeof( key ) );
+		memcpy( &key[ 0 ], Pos, sizeof( VECTOR ) );
+		key[ 3 ] = Group;
+		if( memo_find( MEMO_PointInsideSkin, key, value ) )
+			return value[ 0 ] ? true : false;
+
+		memset( value, 0, sizeof( value ) );
+		value[ 0 ] = PISDist( Pos, &Bsp_Header[0].Bsp_Tree[ Group % Bsp_Header[0].NumGroups ] );
+		memo_store( MEMO_PointInsideSkin, key, value );
+		return value[ 0 ] ? true : false;
 	}
 	return !AmIOutsideGroup( &Mloadheader, Pos, Group );
  }
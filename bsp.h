@@ -36,10 +36,24 @@ struct	BSP_NODE * Front;
 struct	BSP_NODE * Back;
 }BSP_NODE;
  
+/*
+ * what the queries walk, the same nodes as Root packed depth first
+ * with the front child straight after its parent, node i here is
+ * Root + i
+ */
+typedef struct BSP_FLATNODE
+{
+	VECTOR		Normal;
+	float		Offset;
+	u_int16_t	Front;		// 0 if none, the root is never a child
+	u_int16_t	Back;
+}BSP_FLATNODE;
+
 typedef struct BSP_TREE
 {
    int	NumNodes;
    BSP_NODE * Root;
+   BSP_FLATNODE * Flat;
 }BSP_TREE;
 
 typedef struct BSP_HEADER
@@ -87,8 +101,11 @@ void Bspfree( void );
 bool Bspload( char * Filename,  BSP_HEADER *Bsp_Header );
 bool InBSPGroup( u_int16_t group, VECTOR *pos );
 bool RayCollide( BSP_HEADER *Bsp_Header, VECTOR *StartPos, VECTOR *Dir, VECTOR *ImpactPoint, VECTOR *ImpactNormal, float *ImpactOffset ,u_int16_t group );
+bool RayCollideTree( BSP_TREE *tree, VECTOR *StartPos, VECTOR *Dir, VECTOR *ImpactPoint, VECTOR *ImpactNormal, float *ImpactOffset );
 
 bool PointInSpaceRecursive( VECTOR *Pos );
+bool PISDist( VECTOR *Pos, BSP_TREE *tree );
+bool SphereCollide( BSP_HEADER *Bsp_Header, VECTOR *StartPos, u_int16_t group, VECTOR *Move, float Radius, float *ImpactTime, VECTOR *ImpactNormal );
 
 bool PointInsideSkin( VECTOR *Pos, u_int16_t Group );
 #endif	// BSP_INCLUDED
@@ -32,6 +32,7 @@ struct _VISGROUP
 	int			group;
 	int			visible;
 	EXTENT		extent;
+	float		near_z;			// nearest projected depth of any portal on the way in
 	render_viewport_t viewport;
 	RENDERMATRIX	projection;
 	VISGROUP	*next_visible;
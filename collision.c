@@ -26,6 +26,7 @@
 #include "secondary.h"
 #include "restart.h"
 #include "util.h"
+#include "memo.h"
 
 //#undef COLLISION_FUDGE
 //#define COLLISION_FUDGE	(0.065F)
@@ -48,7 +49,6 @@
 #define OUTSIDE_GROUP_TOLERANCE		(25.0F)
 
 
-extern bool PISDistRecursive( VECTOR *Pos, BSP_NODE *node);
 extern void ObjForceExternalOneOff( OBJECT *Obj, VECTOR *force );
 
 extern	float	MaxMoveSpeed;
@@ -79,7 +79,7 @@ extern	BGOBJECT	*	FirstBGObjectUsed;
 extern	BGOBJECT		BGObjects[ MAXBGOBJECTS ];
 
 extern	LINE			Lines[ MAXLINES ];
-extern	ENEMY			Enemies[ MAXENEMIES ];
+extern	ENEMY			*	Enemies;
 
 extern	MCLOADHEADER	MCloadheadert0;					//  0 thickness collision map...
 extern	MCLOADHEADER	MCloadheader;					//  ship collision map...
@@ -88,6 +88,9 @@ extern	u_int16_t			IsGroupVisible[MAXGROUPS];
 extern bool	DebugInfo;
 int no_collision = 0;
 int outside_group = 0;
+#ifdef SWEPT_SPHERE_COLLISION
+bool SweptSphereCollision = true;
+#endif
 
 	DWORD GroupPolyCol_timeMax = 0;
 
@@ -127,6 +130,25 @@ bool CheckRestartPointCol( u_int16_t Group, float Distance, VECTOR * ImpactPoint
 bool CheckEnemyPolyCol( u_int16_t Group, float Distance, VECTOR * ImpactPoint,
 					  int collided, VECTOR * New_Pos, NORMAL * FaceNormal, BGOBJECT ** BGObject );
 
+#ifdef BSP_ONLY
+// what a ray needs about the group it is in, looked up once per run of rays
+typedef struct BGCOLGROUP{
+	u_int16_t			group;
+	BSP_TREE		*	tree;		// NULL if the model has no bsp
+	BSP_PORTAL_GROUP *	portals;	// the ways out of it
+}BGCOLGROUP;
+
+static void BGColGroup( MCLOADHEADER *c, u_int16_t group, BGCOLGROUP *g );
+static bool BackgroundCollideGroup( MCLOADHEADER *c, MLOADHEADER *m, BGCOLGROUP *first,
+					  VECTOR *StartPos, VECTOR *MoveOffset,
+					  VECTOR *EndPos, u_int16_t *EndGroup,
+					  NORMAL *FaceNormal, VECTOR *NewTarget, bool BGCol, BGOBJECT ** BGObject );
+static BSP_TREE * GroupBspTree( MCLOADHEADER * MCloadheaderp, u_int16_t group );
+static bool GroupPolyCol( MCLOADHEADER * MCloadheaderp ,MLOADHEADER * Mloadheader , u_int16_t group , BSP_TREE * tree ,
+					 VECTOR * Pos, VECTOR * Dir  ,
+					 VECTOR * ImpactPoint , NORMAL  * FaceNormal , VECTOR * Pos_New, bool BGCol, BGOBJECT ** BGColObject );
+#endif
+
 /*===================================================================
 	Procedure	:		Load .mc File Collision file..
 	Input		:		char	*	Filename , MCLOADHEADER * MCloadheader
@@ -663,6 +685,35 @@ bool BackgroundCollide( MCLOADHEADER *c, MLOADHEADER *m,
 					  VECTOR *EndPos, u_int16_t *EndGroup,
 					  NORMAL *FaceNormal, VECTOR *NewTarget, bool BGCol, BGOBJECT ** BGObject )
 {
+	BGCOLGROUP first;
+
+	BGColGroup( c, StartGroup, &first );
+	return BackgroundCollideGroup( c, m, &first, StartPos, MoveOffset,
+								   EndPos, EndGroup, FaceNormal, NewTarget, BGCol, BGObject );
+}
+
+static void BGColGroup( MCLOADHEADER *c, u_int16_t group, BGCOLGROUP *g )
+{
+	g->group = group;
+	if( group == (u_int16_t) -1 )
+	{
+		g->tree = NULL;
+		g->portals = NULL;
+		return;
+	}
+	g->tree = GroupBspTree( c, group );
+	g->portals = &Bsp_Portal_Header.group[ group ];
+}
+
+// BackgroundCollide from first->group, whose tree and portals are already found
+static bool BackgroundCollideGroup( MCLOADHEADER *c, MLOADHEADER *m, BGCOLGROUP *first,
+					  VECTOR *StartPos, VECTOR *MoveOffset,
+					  VECTOR *EndPos, u_int16_t *EndGroup,
+					  NORMAL *FaceNormal, VECTOR *NewTarget, bool BGCol, BGOBJECT ** BGObject )
+{
+	BGCOLGROUP next;
+	BGCOLGROUP *cur = first;
+	u_int16_t StartGroup = first->group;
 	float poffset, pdist;
 	VECTOR ppos, pmove, epos, tpos;
 	NORMAL fnorm, pnorm; ZERO_STACK_MEM(pnorm);
@@ -685,11 +736,17 @@ bool BackgroundCollide( MCLOADHEADER *c, MLOADHEADER *m,
 	hit_any_portal = false;
 	do {
 		group = next_group;
+		if( group != cur->group )
+		{
+			BGColGroup( c, group, &next );
+			cur = &next;
+		}
 		hit_portal = false;
 		OldPMove = pmove;
 		OldPPos = ppos;
 		hit_bg = false;
-		if ( OneGroupPolyCol( c, m, group, &OldPPos, &OldPMove, &epos, &fnorm, &tpos, BGCol, BGObject ) )
+		if ( group != (u_int16_t) -1 &&
+			 GroupPolyCol( c, m, group, cur->tree, &OldPPos, &OldPMove, &epos, &fnorm, &tpos, BGCol, BGObject ) )
 		{
 			BSP_PORTAL_GROUP	*pg;
 			BSP_PORTAL			*bp;
@@ -701,7 +758,7 @@ bool BackgroundCollide( MCLOADHEADER *c, MLOADHEADER *m,
 			dv.z = epos.z - StartPos->z;
 			dist_bg = (float) sqrt( dv.x * dv.x + dv.y * dv.y + dv.z * dv.z );
 			
-			pg = &Bsp_Portal_Header.group[ group ];
+			pg = cur->portals;
 			for ( j = 0; j < pg->portals; j++ )
 			{
 				bp = &pg->portal[ j ];
@@ -710,7 +767,7 @@ bool BackgroundCollide( MCLOADHEADER *c, MLOADHEADER *m,
 					d = epos.x * bp->normal.x + epos.y * bp->normal.y + epos.z * bp->normal.z + bp->offset;
 					if ( fabs( d ) < POINT_ON_PORTAL_TOLERANCE )
 					{
-						if ( PISDistRecursive( &epos, bp->bsp.Root ) )
+						if ( PISDist( &epos, &bp->bsp ) )
 						{
 							hit_portal = true;
 							next_group = bp->group;
@@ -857,7 +914,7 @@ bool BackgroundCollide( MCLOADHEADER *c, MLOADHEADER *m,
 						d = epos.x * bp->normal.x + epos.y * bp->normal.y + epos.z * bp->normal.z + bp->offset;
 						if ( fabs( d ) < POINT_ON_PORTAL_TOLERANCE )
 						{
-							if ( PISDistRecursive( &epos, bp->bsp.Root ) )
+							if ( PISDist( &epos, &bp->bsp ) )
 							{
 								hit_portal = true;
 								next_group = bp->group;
@@ -968,6 +1025,168 @@ bool BackgroundCollide( MCLOADHEADER *c, MLOADHEADER *m,
 #endif // !BSP_ONLY
 
 
+/*
+ * BackgroundCollideBatch
+ *
+ * Description
+ *	runs a set of background queries together, grouped by the group they
+ *	start in so each group's bsp tree and portal list are looked up once
+ *	for the run of queries starting there and walked while they are still
+ *	in the cache
+ *	queries with BGCol set see the bgobjects and enemies as they are when
+ *	the batch is run, the rest only the background itself
+ *
+ * Inputs
+ *	c			=	background collision model
+ *	m			=	background display model
+ *	Queries		=	StartPos, StartGroup, MoveOffset and BGCol of each query
+ *	NumQueries	=	number of queries
+ *
+ * Outputs
+ *	Queries		=	Hit and the outputs of BackgroundCollide for each query
+ */
+static int *		BGColOrder = NULL;
+static int			BGColOrderSize = 0;
+
+void BackgroundCollideBatch( MCLOADHEADER *c, MLOADHEADER *m, BGCOLQUERY *Queries, int NumQueries )
+{
+	int			count[ MAXGROUPS + 1 ];
+	int			start[ MAXGROUPS + 1 ];
+	int			i, g, total;
+	int		*	order;
+	BGCOLQUERY	*q;
+#ifdef BSP_ONLY
+	BGCOLGROUP	run;
+#endif
+
+	if( NumQueries <= 0 )
+		return;
+
+	order = BGColOrder;
+	if( NumQueries > BGColOrderSize )
+	{
+		order = (int *) realloc( BGColOrder, NumQueries * sizeof( int ) );
+		if( order )
+		{
+			BGColOrder = order;
+			BGColOrderSize = NumQueries;
+		}
+	}
+
+	// counting sort on the start group, anything outside every group goes
+	// last, without the room to sort they are run in the order given
+	if( order )
+	{
+		memset( count, 0, sizeof( count ) );
+		for( i = 0; i < NumQueries; i++ )
+		{
+			g = ( Queries[ i ].StartGroup < MAXGROUPS ) ? Queries[ i ].StartGroup : MAXGROUPS;
+			count[ g ]++;
+		}
+		total = 0;
+		for( g = 0; g <= MAXGROUPS; g++ )
+		{
+			start[ g ] = total;
+			total += count[ g ];
+		}
+		for( i = 0; i < NumQueries; i++ )
+		{
+			g = ( Queries[ i ].StartGroup < MAXGROUPS ) ? Queries[ i ].StartGroup : MAXGROUPS;
+			order[ start[ g ]++ ] = i;
+		}
+	}
+
+	for( i = 0; i < NumQueries; i++ )
+	{
+		q = &Queries[ order ? order[ i ] : i ];
+		q->BGObject = NULL;
+#ifdef BSP_ONLY
+		if( !i || q->StartGroup != run.group )
+			BGColGroup( c, q->StartGroup, &run );
+		q->Hit = BackgroundCollideGroup( c, m, &run, &q->StartPos, &q->MoveOffset,
+										&q->EndPos, &q->EndGroup, &q->FaceNormal, &q->NewTarget, q->BGCol, &q->BGObject );
+#else
+		q->Hit = BackgroundCollide( c, m, &q->StartPos, q->StartGroup, &q->MoveOffset,
+								   &q->EndPos, &q->EndGroup, &q->FaceNormal, &q->NewTarget, q->BGCol, &q->BGObject );
+#endif
+	}
+}
+
+
+/*
+ * BackgroundSphereCollide
+ *
+ * Description
+ *	checks for background collisions of a sphere moving between two positions,
+ *	one sweep through the collision tree of each group it passes into and one
+ *	through the background objects and enemies instead of a ray per feeler
+ *
+ * Inputs
+ *	StartPos	=	start position of the centre
+ *	StartGroup	=	group start position is in
+ *	MoveOffset	=	movement offset
+ *	Radius		=	radius of the sphere
+ *	BGCol		=	BGObject Collision wanted
+ *
+ * Outputs
+ *	ImpactTime	=	fraction of the move made before touching (if collided at all)
+ *	ImpactPoint	=	point on the surface the sphere touches (if collided at all)
+ *	FaceNormal	=	normal of the surface, facing the sphere (if collided at all)
+ *	BGObject	=	background object touched, NULL if none
+ *
+ * Returns
+ *	true if collided with background, false if no collision
+ */
+bool BackgroundSphereCollide( VECTOR *StartPos, u_int16_t StartGroup, VECTOR *MoveOffset, float Radius,
+							  float *ImpactTime, VECTOR *ImpactPoint, NORMAL *FaceNormal, bool BGCol, BGOBJECT ** BGObject )
+{
+	VECTOR	normal;
+	VECTOR	centre;
+	VECTOR	pos_new;
+	VECTOR	dv;
+	NORMAL	bg_normal;
+	float	time = 1.0F;
+	float	move_dist;
+	bool	hit;
+
+	if( BGObject )
+		*BGObject = NULL;
+
+	hit = SphereCollide( &Bsp_Header[ 0 ], StartPos, StartGroup, MoveOffset, Radius, &time, &normal );
+	if( hit )
+	{
+		FaceNormal->nx = normal.x;
+		FaceNormal->ny = normal.y;
+		FaceNormal->nz = normal.z;
+	}
+
+	if( BGCol )
+	{
+		move_dist = VectorLength( MoveOffset );
+		if( OneGroupBGObjectCol( time * move_dist, (int16_t) hit, StartGroup, StartPos, MoveOffset,
+								 &centre, &bg_normal, &pos_new, BGObject, Radius ) )
+		{
+			// the objects' planes are pushed out by the radius too, so this is where the centre stops
+			dv.x = centre.x - StartPos->x;
+			dv.y = centre.y - StartPos->y;
+			dv.z = centre.z - StartPos->z;
+			time = ( move_dist > 0.0F ) ? ( VectorLength( &dv ) / move_dist ) : 0.0F;
+			*FaceNormal = bg_normal;
+			hit = true;
+		}
+	}
+
+	if( !hit )
+		return false;
+
+	*ImpactTime = time;
+	ImpactPoint->x = StartPos->x + MoveOffset->x * time - FaceNormal->nx * Radius;
+	ImpactPoint->y = StartPos->y + MoveOffset->y * time - FaceNormal->ny * Radius;
+	ImpactPoint->z = StartPos->z + MoveOffset->z * time - FaceNormal->nz * Radius;
+	return true;
+}
+
+
 /*
  * BackgroundCollideOneGroup
  *
@@ -1032,7 +1251,7 @@ bool BackgroundCollideOneGroup( MCLOADHEADER *c, MLOADHEADER *m,
 				d = epos.x * bp->normal.x + epos.y * bp->normal.y + epos.z * bp->normal.z + bp->offset;
 				if ( fabs( d ) < POINT_ON_PORTAL_TOLERANCE )
 				{
-					if ( PISDistRecursive( &epos, bp->bsp.Root ) )
+					if ( PISDist( &epos, &bp->bsp ) )
 					{
 						hit_portal = true;
 						next_group = bp->group;
@@ -1157,7 +1376,7 @@ bool BackgroundCollideOneGroup( MCLOADHEADER *c, MLOADHEADER *m,
 					d = epos.x * bp->normal.x + epos.y * bp->normal.y + epos.z * bp->normal.z + bp->offset;
 					if ( fabs( d ) < POINT_ON_PORTAL_TOLERANCE )
 					{
-						if ( PISDistRecursive( &epos, bp->bsp.Root ) )
+						if ( PISDist( &epos, &bp->bsp ) )
 						{
 							hit_portal = true;
 							next_group = bp->group;
@@ -1250,10 +1469,10 @@ bool BackgroundCollideOneGroup( MCLOADHEADER *c, MLOADHEADER *m,
 #endif // BSP_ONLY
 
 /*
- * MoveGroup
+ * WalkGroups
  *
  * Description
- *	checks for portal collisions of a point moving between two positions
+ *	follows a point moving between two positions through the portals it crosses
  *
  * Inputs
  *	m			=	background display model
@@ -1267,7 +1486,7 @@ bool BackgroundCollideOneGroup( MCLOADHEADER *c, MLOADHEADER *m,
  * Returns
  *	EndGroup	=	group final position is in
  */
-u_int16_t MoveGroup( MLOADHEADER *m, VECTOR *StartPos, u_int16_t StartGroup, VECTOR *MoveOffset )
+static u_int16_t WalkGroups( MLOADHEADER *m, VECTOR *StartPos, u_int16_t StartGroup, VECTOR *MoveOffset )
 #ifdef BSP_ONLY
 {
 	VECTOR ppos, pmove, epos;
@@ -1350,6 +1569,52 @@ u_int16_t MoveGroup( MLOADHEADER *m, VECTOR *StartPos, u_int16_t StartGroup, VEC
 #endif // ! BSP_ONLY
 
 
+/*
+ * MoveGroup
+ *
+ * Description
+ *	checks for portal collisions of a point moving between two positions,
+ *	the same move asked about twice in a frame is only walked once
+ *
+ * Inputs
+ *	m			=	background display model
+ *	StartPos	=	start position
+ *	StartGroup	=	group start position is in
+ *	MoveOffset	=	movement offset
+ *
+ * Outputs
+ *	None
+ *
+ * Returns
+ *	EndGroup	=	group final position is in
+ */
+u_int16_t MoveGroup( MLOADHEADER *m, VECTOR *StartPos, u_int16_t StartGroup, VECTOR *MoveOffset )
+{
+	u_int32_t key[ MEMO_KEY_WORDS ];
+	u_int32_t value[ MEMO_VALUE_WORDS ];
+
+	// only the level's own answers are remembered
+	if( m != &Mloadheader )
+		return WalkGroups( m, StartPos, StartGroup, MoveOffset );
+
+	memset( key, 0, sizeof( key ) );
+	memcpy( &key[ 0 ], StartPos, sizeof( VECTOR ) );
+	key[ 3 ] = StartGroup;
+	memcpy( &key[ 4 ], MoveOffset, sizeof( VECTOR ) );
+	if( memo_find( MEMO_MoveGroup, key, value ) )
+	{
+		// callers read this straight after
+		outside_group = (int) value[ 1 ];
+		return (u_int16_t) value[ 0 ];
+	}
+
+	value[ 0 ] = WalkGroups( m, StartPos, StartGroup, MoveOffset );
+	value[ 1 ] = (u_int32_t) outside_group;
+	memo_store( MEMO_MoveGroup, key, value );
+	return (u_int16_t) value[ 0 ];
+}
+
+
 /*===================================================================
 	Procedure	:	Does the collision between a specified group
 	Input		:	MCLOADHEADER *
@@ -1363,10 +1628,42 @@ u_int16_t MoveGroup( MLOADHEADER *m, VECTOR *StartPos, u_int16_t StartGroup, VEC
 				:	bool	BGCol
   Output		:	bool
 ===================================================================*/
+#ifdef BSP_ONLY
 bool OneGroupPolyCol( MCLOADHEADER * MCloadheaderp ,MLOADHEADER * Mloadheader , u_int16_t group ,
 					 VECTOR * Pos, VECTOR * Dir  ,
 					 VECTOR * ImpactPoint , NORMAL  * FaceNormal , VECTOR * Pos_New, bool BGCol, BGOBJECT ** BGColObject )
-#ifdef BSP_ONLY
+{
+	if( group == (u_int16_t) -1)
+		return false;
+
+	return GroupPolyCol( MCloadheaderp, Mloadheader, group, GroupBspTree( MCloadheaderp, group ),
+						 Pos, Dir, ImpactPoint, FaceNormal, Pos_New, BGCol, BGColObject );
+}
+
+/*===================================================================
+	Procedure	:	Which bsp tree the rays for a group go down
+	Input		:	MCLOADHEADER *
+				:	u_int16_t group
+  Output		:	BSP_TREE * ( NULL if there is none for the model )
+===================================================================*/
+static BSP_TREE * GroupBspTree( MCLOADHEADER * MCloadheaderp, u_int16_t group )
+{
+	if( (MCloadheaderp == &MCloadheadert0) && Bsp_Header[ 0 ].State )
+		return &Bsp_Header[ 0 ].Bsp_Tree[ group % Bsp_Header[ 0 ].NumGroups ];
+	if( (MCloadheaderp == &MCloadheader) && Bsp_Header[ 1 ].State )
+		return &Bsp_Header[ 1 ].Bsp_Tree[ group % Bsp_Header[ 1 ].NumGroups ];
+	return NULL;
+}
+
+/*===================================================================
+	Procedure	:	OneGroupPolyCol with the group's tree already found
+	Input		:	as OneGroupPolyCol
+				:	BSP_TREE * tree ( from GroupBspTree )
+  Output		:	bool
+===================================================================*/
+static bool GroupPolyCol( MCLOADHEADER * MCloadheaderp ,MLOADHEADER * Mloadheader , u_int16_t group , BSP_TREE * tree ,
+					 VECTOR * Pos, VECTOR * Dir  ,
+					 VECTOR * ImpactPoint , NORMAL  * FaceNormal , VECTOR * Pos_New, bool BGCol, BGOBJECT ** BGColObject )
 {
 #ifdef POLYGONAL_COLLISIONS
 	MCFACE	*	FacePnt;
@@ -1384,9 +1681,6 @@ bool OneGroupPolyCol( MCLOADHEADER * MCloadheaderp ,MLOADHEADER * Mloadheader ,
 	VECTOR		ImpactNormal;
 	float		ImpactOffset;
 	MCFACE		BSPFace; ZERO_STACK_MEM(BSPFace);
-	
-	if( group == (u_int16_t) -1)
-		return false;
 
 	Origin.x = Pos->x;
 	Origin.y = Pos->y;
@@ -1395,30 +1689,16 @@ bool OneGroupPolyCol( MCLOADHEADER * MCloadheaderp ,MLOADHEADER * Mloadheader ,
 	ODir.y = Dir->y;
 	ODir.z = Dir->z;
 
-	if( (MCloadheaderp == &MCloadheadert0) && Bsp_Header[ 0 ].State )
+	if( tree )
 	{
 		CollisionRadius = 0.0F;
-		ImpactPoint->x = 0.0F;
-		ImpactPoint->y = 0.0F;
-		ImpactPoint->z = 0.0F;
-		collided = RayCollide( &Bsp_Header[ 0 ], &Origin, &ODir, ImpactPoint, &ImpactNormal, &ImpactOffset , group );
-		if ( collided )
+		if( MCloadheaderp == &MCloadheadert0 )
 		{
-			e.x = ImpactPoint->x - Pos->x;
-			e.y = ImpactPoint->y - Pos->y;
-			e.z = ImpactPoint->z - Pos->z;
-			Distance = VectorLength( &e );
-			BSPFace.nx = ImpactNormal.x;
-			BSPFace.ny = ImpactNormal.y;
-			BSPFace.nz = ImpactNormal.z;
-			BSPFace.D = ImpactOffset;
-			CollFace = &BSPFace;
+			ImpactPoint->x = 0.0F;
+			ImpactPoint->y = 0.0F;
+			ImpactPoint->z = 0.0F;
 		}
-	}
-	else if( (MCloadheaderp == &MCloadheader) && Bsp_Header[ 1 ].State )
-	{
-		CollisionRadius = 0.0F;
-		collided = RayCollide( &Bsp_Header[ 1 ], &Origin, &ODir, ImpactPoint, &ImpactNormal, &ImpactOffset , group );
+		collided = RayCollideTree( tree, &Origin, &ODir, ImpactPoint, &ImpactNormal, &ImpactOffset );
 		if ( collided )
 		{
 			e.x = ImpactPoint->x - Pos->x;
@@ -1582,6 +1862,9 @@ bool OneGroupPolyCol( MCLOADHEADER * MCloadheaderp ,MLOADHEADER * Mloadheader ,
 	return(true);
 }
 #else // !BSP_ONLY
+bool OneGroupPolyCol( MCLOADHEADER * MCloadheaderp ,MLOADHEADER * Mloadheader , u_int16_t group ,
+					 VECTOR * Pos, VECTOR * Dir  ,
+					 VECTOR * ImpactPoint , NORMAL  * FaceNormal , VECTOR * Pos_New, bool BGCol, BGOBJECT ** BGColObject )
 {
 	MCFACE	*	FacePnt;
 	MCFACE	*	CollFace;
@@ -1826,7 +2109,7 @@ bool OneGroupPortalCol( MLOADHEADER * Mloadheader , u_int16_t group ,
 		res = ColRayPlaneIntersect( &bp->normal, bp->offset );
 		if( res == true )
 		{
-			if ( PISDistRecursive( &IPoint, bp->bsp.Root ) )
+			if ( PISDist( &IPoint, &bp->bsp ) )
 			{
 				if ( flag == 0 )
 				{
@@ -1893,7 +2176,7 @@ bool OneGroupPortalCol( MLOADHEADER * Mloadheader , u_int16_t group ,
 			res = ColRayPlaneIntersect( &bp->normal, bp->offset );
 			if( res == true )
 			{
-				if ( PISDistRecursive( &IPoint, bp->bsp.Root ) )
+				if ( PISDist( &IPoint, &bp->bsp ) )
 				{
 					if ( flag == 0 )
 					{
@@ -3088,6 +3371,75 @@ bool ObjectCollide( OBJECT *Obj, VECTOR *Move_Off, float radius, BGOBJECT **BGOb
 #define IMPACT_OFFSET					(0.1F)
 #define FEELER_LENGTH_TO_RADIUS_RATIO	(1.25F)
 
+// where each feeler starts and ends across the sphere, in units of its
+// radius along the slide right and up of the move, QCollide uses the first
+// MAX_QFEELER_RAYS
+static struct
+{
+	struct {
+		float dx, dy;
+	} start, end;
+} FeelerOffset[ MAX_FEELER_RAYS ] =
+{
+	{ 0.0F, 0.0F,  0.0F, 0.0F },
+	{ 0.0F, 0.0F,  1.0F, 1.0F },
+	{ 0.0F, 0.0F,  1.0F,-1.0F },
+	{ 0.0F, 0.0F, -1.0F,-1.0F },
+	{ 0.0F, 0.0F, -1.0F, 1.0F },
+	{ 0.0F, 1.0F,  0.0F,-1.0F },
+	{ 0.0F,-1.0F,  0.0F, 1.0F },
+	{ 1.0F, 0.0F, -1.0F, 0.0F },
+	{-1.0F, 0.0F,  1.0F, 0.0F },
+};
+
+/*===================================================================
+	Procedure	:	Fire the feeler rays of a sphere, all from the group
+				:	it is in so they go through the background as one batch
+	Input		:	VECTOR * StartPos ( centre of the sphere )
+				:	u_int16_t Group
+				:	VECTOR * Move_Dir ( normalised )
+				:	VECTOR * Up, Right ( across the move )
+				:	float MoveDist
+				:	float radius
+				:	int NumFeelers
+				:	bool BGCol
+	Output		:	BGCOLQUERY * Feelers ( the answer for each ray )
+===================================================================*/
+static void FeelerRays( VECTOR *StartPos, u_int16_t Group, VECTOR *Move_Dir, VECTOR *Up, VECTOR *Right,
+						float MoveDist, float radius, int NumFeelers, bool BGCol, BGCOLQUERY *Feelers )
+{
+	int f;
+	float dx0, dy0;
+	float dx1, dy1;
+	float FeelerLength = FEELER_LENGTH_TO_RADIUS_RATIO * radius;
+	BGCOLQUERY *q;
+
+	for ( f = 0; f < NumFeelers; f++ )
+	{
+		q = &Feelers[ f ];
+		dx0 = FeelerOffset[ f ].start.dx;
+		dy0 = FeelerOffset[ f ].start.dy;
+		dx1 = FeelerOffset[ f ].end.dx;
+		dy1 = FeelerOffset[ f ].end.dy;
+		q->StartPos.x = radius * ( dx0 * Right->x + dy0 * Up->x );
+		q->StartPos.y = radius * ( dx0 * Right->y + dy0 * Up->y );
+		q->StartPos.z = radius * ( dx0 * Right->z + dy0 * Up->z );
+		q->StartPos.x += StartPos->x;
+		q->StartPos.y += StartPos->y;
+		q->StartPos.z += StartPos->z;
+		q->StartGroup = Group;
+		q->MoveOffset = *Move_Dir;
+		q->MoveOffset.x *= ( MoveDist + FeelerLength );
+		q->MoveOffset.y *= ( MoveDist + FeelerLength );
+		q->MoveOffset.z *= ( MoveDist + FeelerLength );
+		q->MoveOffset.x += radius * ( dx1 * Right->x + dy1 * Up->x );
+		q->MoveOffset.y += radius * ( dx1 * Right->y + dy1 * Up->y );
+		q->MoveOffset.z += radius * ( dx1 * Right->z + dy1 * Up->z );
+		q->BGCol = BGCol;
+	}
+	BackgroundCollideBatch( &MCloadheadert0, &Mloadheader, Feelers, NumFeelers );
+}
+
 
 bool ObjectCollide( OBJECT *Obj, VECTOR *Move_Off, float radius, BGOBJECT **BGObject )
 {
@@ -3095,26 +3447,7 @@ bool ObjectCollide( OBJECT *Obj, VECTOR *Move_Off, float radius, BGOBJECT **BGOb
 	QUAT MoveQuat;
 	MATRIX MoveMat;
 	int f;
-	float dx0, dy0;
-	float dx1, dy1;
 	VECTOR Feeler;
-	static struct
-	{
-		struct {
-			float dx, dy;
-		} start, end;
-	} FeelerOffset[ MAX_FEELER_RAYS ] =
-	{
-		{ 0.0F, 0.0F,  0.0F, 0.0F },
-		{ 0.0F, 0.0F,  1.0F, 1.0F },
-		{ 0.0F, 0.0F,  1.0F,-1.0F },
-		{ 0.0F, 0.0F, -1.0F,-1.0F },
-		{ 0.0F, 0.0F, -1.0F, 1.0F },
-		{ 0.0F, 1.0F,  0.0F,-1.0F },
-		{ 0.0F,-1.0F,  0.0F, 1.0F },
-		{ 1.0F, 0.0F, -1.0F, 0.0F },
-		{-1.0F, 0.0F,  1.0F, 0.0F },
-	};
 	VECTOR FeelerImpactPoint;
 	u_int16_t FeelerImpactGroup;
 	NORMAL FeelerFaceNormal;
@@ -3130,14 +3463,15 @@ bool ObjectCollide( OBJECT *Obj, VECTOR *Move_Off, float radius, BGOBJECT **BGOb
 	float FeelerDist;
 	VECTOR FeelerEndPoint;
 	float Num, Div;
-	VECTOR FeelerStart;
-	u_int16_t FeelerGroup;
 	NORMAL ImpactNormal;
 	float ImpactPlane;
-	float FeelerLength = FEELER_LENGTH_TO_RADIUS_RATIO * radius;
 	VECTOR StartPos;
 	VECTOR Pos_New; ZERO_STACK_MEM(Pos_New);
 	bool hit;
+	bool FeelerHit;
+	float FeelerTime;
+	int NumFeelers = MAX_FEELER_RAYS;
+	BGCOLQUERY Feelers[ MAX_FEELER_RAYS ];
 	VECTOR ImpactPoint;
 	
 	hit = false;
@@ -3153,33 +3487,35 @@ bool ObjectCollide( OBJECT *Obj, VECTOR *Move_Off, float radius, BGOBJECT **BGOb
 	ImpactPoint.x = StartPos.x + Move_Off->x;
 	ImpactPoint.y = StartPos.y + Move_Off->y;
 	ImpactPoint.z = StartPos.z + Move_Off->z;
-	for ( f = 0; f < MAX_FEELER_RAYS; f++ )
+#ifdef SWEPT_SPHERE_COLLISION
+	// one sweep of the whole sphere, a little past the end so it keeps its distance
+	if ( SweptSphereCollision && Bsp_Header[ 0 ].State )
+		NumFeelers = 1;
+#endif
+	if ( NumFeelers > 1 )
+		FeelerRays( &StartPos, Obj->Group, &Move_Dir, &Up, &Right, MoveDist, radius, NumFeelers, NoBGObject, Feelers );
+	for ( f = 0; f < NumFeelers; f++ )
 	{
-		dx0 = FeelerOffset[ f ].start.dx;
-		dy0 = FeelerOffset[ f ].start.dy;
-		dx1 = FeelerOffset[ f ].end.dx;
-		dy1 = FeelerOffset[ f ].end.dy;
-		FeelerStart.x = radius * ( dx0 * Right.x + dy0 * Up.x );
-		FeelerStart.y = radius * ( dx0 * Right.y + dy0 * Up.y );
-		FeelerStart.z = radius * ( dx0 * Right.z + dy0 * Up.z );
-#if 0
-		FeelerGroup = MoveGroup( &Mloadheader, &StartPos, Obj->Group, &FeelerStart );
-#else
-		FeelerGroup = Obj->Group;
+#ifdef SWEPT_SPHERE_COLLISION
+		if ( NumFeelers == 1 )
+		{
+			Feeler.x = Move_Dir.x * ( MoveDist + IMPACT_OFFSET );
+			Feeler.y = Move_Dir.y * ( MoveDist + IMPACT_OFFSET );
+			Feeler.z = Move_Dir.z * ( MoveDist + IMPACT_OFFSET );
+			FeelerHit = BackgroundSphereCollide( &StartPos, Obj->Group, &Feeler, radius, &FeelerTime,
+				&FeelerImpactPoint, &FeelerFaceNormal, NoBGObject, ( BGObject ) ? &FeelerBGObject : NULL );
+		}
+		else
 #endif
-		FeelerStart.x += StartPos.x;
-		FeelerStart.y += StartPos.y;
-		FeelerStart.z += StartPos.z;
-		Feeler = Move_Dir;
-		Feeler.x *= ( MoveDist + FeelerLength );
-		Feeler.y *= ( MoveDist + FeelerLength );
-		Feeler.z *= ( MoveDist + FeelerLength );
-		Feeler.x += radius * ( dx1 * Right.x + dy1 * Up.x );
-		Feeler.y += radius * ( dx1 * Right.y + dy1 * Up.y );
-		Feeler.z += radius * ( dx1 * Right.z + dy1 * Up.z );
-		if ( BackgroundCollide( &MCloadheadert0, &Mloadheader,
-			&FeelerStart, FeelerGroup, &Feeler,
-			&FeelerImpactPoint , &FeelerImpactGroup, &FeelerFaceNormal, &FeelerPos_New, NoBGObject, ( BGObject ) ? &FeelerBGObject : NULL ) )
+		{
+			FeelerHit = Feelers[ f ].Hit;
+			FeelerImpactPoint = Feelers[ f ].EndPos;
+			FeelerImpactGroup = Feelers[ f ].EndGroup;
+			FeelerFaceNormal = Feelers[ f ].FaceNormal;
+			FeelerPos_New = Feelers[ f ].NewTarget;
+			FeelerBGObject = Feelers[ f ].BGObject;
+		}
+		if ( FeelerHit )
 		{
 			FeelerPlane = -DotProduct( (VECTOR *)&FeelerFaceNormal, &FeelerImpactPoint ) - radius;
 			Div = DotProduct( &Move_Dir , (VECTOR *)&FeelerFaceNormal );
@@ -3328,26 +3664,7 @@ bool ObjectCollideOnly( OBJECT *Obj, VECTOR *Move_Off, float radius, VECTOR *Tar
 	QUAT MoveQuat;
 	MATRIX MoveMat;
 	int f;
-	float dx0, dy0;
-	float dx1, dy1;
 	VECTOR Feeler;
-	static struct
-	{
-		struct {
-			float dx, dy;
-		} start, end;
-	} FeelerOffset[ MAX_FEELER_RAYS ] =
-	{
-		{ 0.0F, 0.0F,  0.0F, 0.0F },
-		{ 0.0F, 0.0F,  1.0F, 1.0F },
-		{ 0.0F, 0.0F,  1.0F,-1.0F },
-		{ 0.0F, 0.0F, -1.0F,-1.0F },
-		{ 0.0F, 0.0F, -1.0F, 1.0F },
-		{ 0.0F, 1.0F,  0.0F,-1.0F },
-		{ 0.0F,-1.0F,  0.0F, 1.0F },
-		{ 1.0F, 0.0F, -1.0F, 0.0F },
-		{-1.0F, 0.0F,  1.0F, 0.0F },
-	};
 	VECTOR FeelerImpactPoint;
 	u_int16_t FeelerImpactGroup;
 	NORMAL FeelerFaceNormal;
@@ -3361,14 +3678,15 @@ bool ObjectCollideOnly( OBJECT *Obj, VECTOR *Move_Off, float radius, VECTOR *Tar
 	float FeelerDist;
 	VECTOR FeelerEndPoint;
 	float Num, Div;
-	VECTOR FeelerStart;
-	u_int16_t FeelerGroup;
 	NORMAL ImpactNormal;
 	float ImpactPlane;
-	float FeelerLength = FEELER_LENGTH_TO_RADIUS_RATIO * radius;
 	VECTOR StartPos;
 	VECTOR Pos_New; ZERO_STACK_MEM(Pos_New);
 	bool hit;
+	bool FeelerHit;
+	float FeelerTime;
+	int NumFeelers = MAX_FEELER_RAYS;
+	BGCOLQUERY Feelers[ MAX_FEELER_RAYS ];
 	VECTOR ImpactPoint;
 	
 	hit = false;
@@ -3384,33 +3702,35 @@ bool ObjectCollideOnly( OBJECT *Obj, VECTOR *Move_Off, float radius, VECTOR *Tar
 	ImpactPoint.x = StartPos.x + Move_Off->x;
 	ImpactPoint.y = StartPos.y + Move_Off->y;
 	ImpactPoint.z = StartPos.z + Move_Off->z;
-	for ( f = 0; f < MAX_FEELER_RAYS; f++ )
+#ifdef SWEPT_SPHERE_COLLISION
+	// one sweep of the whole sphere, a little past the end so it keeps its distance
+	if ( SweptSphereCollision && Bsp_Header[ 0 ].State )
+		NumFeelers = 1;
+#endif
+	if ( NumFeelers > 1 )
+		FeelerRays( &StartPos, Obj->Group, &Move_Dir, &Up, &Right, MoveDist, radius, NumFeelers, true, Feelers );
+	for ( f = 0; f < NumFeelers; f++ )
 	{
-		dx0 = FeelerOffset[ f ].start.dx;
-		dy0 = FeelerOffset[ f ].start.dy;
-		dx1 = FeelerOffset[ f ].end.dx;
-		dy1 = FeelerOffset[ f ].end.dy;
-		FeelerStart.x = radius * ( dx0 * Right.x + dy0 * Up.x );
-		FeelerStart.y = radius * ( dx0 * Right.y + dy0 * Up.y );
-		FeelerStart.z = radius * ( dx0 * Right.z + dy0 * Up.z );
-#if 0
-		FeelerGroup = MoveGroup( &Mloadheader, &StartPos, Obj->Group, &FeelerStart );
-#else
-		FeelerGroup = Obj->Group;
+#ifdef SWEPT_SPHERE_COLLISION
+		if ( NumFeelers == 1 )
+		{
+			Feeler.x = Move_Dir.x * ( MoveDist + IMPACT_OFFSET );
+			Feeler.y = Move_Dir.y * ( MoveDist + IMPACT_OFFSET );
+			Feeler.z = Move_Dir.z * ( MoveDist + IMPACT_OFFSET );
+			FeelerHit = BackgroundSphereCollide( &StartPos, Obj->Group, &Feeler, radius, &FeelerTime,
+				&FeelerImpactPoint, &FeelerFaceNormal, true, ( BGObject ) ? &FeelerBGObject : NULL );
+		}
+		else
 #endif
-		FeelerStart.x += StartPos.x;
-		FeelerStart.y += StartPos.y;
-		FeelerStart.z += StartPos.z;
-		Feeler = Move_Dir;
-		Feeler.x *= ( MoveDist + FeelerLength );
-		Feeler.y *= ( MoveDist + FeelerLength );
-		Feeler.z *= ( MoveDist + FeelerLength );
-		Feeler.x += radius * ( dx1 * Right.x + dy1 * Up.x );
-		Feeler.y += radius * ( dx1 * Right.y + dy1 * Up.y );
-		Feeler.z += radius * ( dx1 * Right.z + dy1 * Up.z );
-		if ( BackgroundCollide( &MCloadheadert0, &Mloadheader,
-			&FeelerStart, FeelerGroup, &Feeler,
-			&FeelerImpactPoint , &FeelerImpactGroup, &FeelerFaceNormal, &FeelerPos_New, true, ( BGObject ) ? &FeelerBGObject : NULL ) )
+		{
+			FeelerHit = Feelers[ f ].Hit;
+			FeelerImpactPoint = Feelers[ f ].EndPos;
+			FeelerImpactGroup = Feelers[ f ].EndGroup;
+			FeelerFaceNormal = Feelers[ f ].FaceNormal;
+			FeelerPos_New = Feelers[ f ].NewTarget;
+			FeelerBGObject = Feelers[ f ].BGObject;
+		}
+		if ( FeelerHit )
 		{
 			FeelerPlane = -DotProduct( (VECTOR *)&FeelerFaceNormal, &FeelerImpactPoint ) - radius;
 			Div = DotProduct( &Move_Dir , (VECTOR *)&FeelerFaceNormal );
@@ -3477,22 +3797,7 @@ bool QCollide( VECTOR *Start_Pos, u_int16_t Start_Group, VECTOR *Move_Off, float
 	QUAT MoveQuat;
 	MATRIX MoveMat;
 	int f;
-	float dx0, dy0;
-	float dx1, dy1;
 	VECTOR Feeler;
-	static struct
-	{
-		struct {
-			float dx, dy;
-		} start, end;
-	} FeelerOffset[ MAX_QFEELER_RAYS ] =
-	{
-		{ 0.0F, 0.0F,  0.0F, 0.0F },
-		{ 0.0F, 0.0F,  1.0F, 1.0F },
-		{ 0.0F, 0.0F,  1.0F,-1.0F },
-		{ 0.0F, 0.0F, -1.0F,-1.0F },
-		{ 0.0F, 0.0F, -1.0F, 1.0F },
-	};
 	VECTOR FeelerImpactPoint;
 	u_int16_t FeelerImpactGroup;
 	NORMAL FeelerFaceNormal;
@@ -3506,12 +3811,13 @@ bool QCollide( VECTOR *Start_Pos, u_int16_t Start_Group, VECTOR *Move_Off, float
 	float FeelerDist;
 	VECTOR FeelerEndPoint;
 	float Num, Div;
-	VECTOR FeelerStart;
-	u_int16_t FeelerGroup;
 	NORMAL ImpactNormal; ZERO_STACK_MEM(ImpactNormal);
-	float FeelerLength = FEELER_LENGTH_TO_RADIUS_RATIO * radius;
 	VECTOR StartPos;
 	bool hit;
+	bool FeelerHit;
+	float FeelerTime;
+	int NumFeelers = MAX_QFEELER_RAYS;
+	BGCOLQUERY Feelers[ MAX_QFEELER_RAYS ];
 	VECTOR ImpactPoint;
 	
 	hit = false;
@@ -3528,33 +3834,34 @@ bool QCollide( VECTOR *Start_Pos, u_int16_t Start_Group, VECTOR *Move_Off, float
 	ImpactPoint.y = StartPos.y + Move_Off->y;
 	ImpactPoint.z = StartPos.z + Move_Off->z;
 	Move = *Move_Off;
-	for ( f = 0; f < MAX_QFEELER_RAYS; f++ )
+#ifdef SWEPT_SPHERE_COLLISION
+	// one sweep of the whole sphere, a little past the end so it keeps its distance
+	if ( SweptSphereCollision && Bsp_Header[ 0 ].State )
+		NumFeelers = 1;
+#endif
+	if ( NumFeelers > 1 )
+		FeelerRays( &StartPos, Start_Group, &Move_Dir, &Up, &Right, MoveDist, radius, NumFeelers, true, Feelers );
+	for ( f = 0; f < NumFeelers; f++ )
 	{
-		dx0 = FeelerOffset[ f ].start.dx;
-		dy0 = FeelerOffset[ f ].start.dy;
-		dx1 = FeelerOffset[ f ].end.dx;
-		dy1 = FeelerOffset[ f ].end.dy;
-		FeelerStart.x = radius * ( dx0 * Right.x + dy0 * Up.x );
-		FeelerStart.y = radius * ( dx0 * Right.y + dy0 * Up.y );
-		FeelerStart.z = radius * ( dx0 * Right.z + dy0 * Up.z );
-#if 0
-		FeelerGroup = MoveGroup( &Mloadheader, &StartPos, Start_Group, &FeelerStart );
-#else
-		FeelerGroup = Start_Group;
+#ifdef SWEPT_SPHERE_COLLISION
+		if ( NumFeelers == 1 )
+		{
+			Feeler.x = Move_Dir.x * ( MoveDist + IMPACT_OFFSET );
+			Feeler.y = Move_Dir.y * ( MoveDist + IMPACT_OFFSET );
+			Feeler.z = Move_Dir.z * ( MoveDist + IMPACT_OFFSET );
+			FeelerHit = BackgroundSphereCollide( &StartPos, Start_Group, &Feeler, radius, &FeelerTime,
+				&FeelerImpactPoint, &FeelerFaceNormal, true, NULL );
+		}
+		else
 #endif
-		FeelerStart.x += StartPos.x;
-		FeelerStart.y += StartPos.y;
-		FeelerStart.z += StartPos.z;
-		Feeler = Move_Dir;
-		Feeler.x *= ( MoveDist + FeelerLength );
-		Feeler.y *= ( MoveDist + FeelerLength );
-		Feeler.z *= ( MoveDist + FeelerLength );
-		Feeler.x += radius * ( dx1 * Right.x + dy1 * Up.x );
-		Feeler.y += radius * ( dx1 * Right.y + dy1 * Up.y );
-		Feeler.z += radius * ( dx1 * Right.z + dy1 * Up.z );
-		if ( BackgroundCollide( &MCloadheadert0, &Mloadheader,
-			&FeelerStart, FeelerGroup, &Feeler,
-			&FeelerImpactPoint , &FeelerImpactGroup, &FeelerFaceNormal, &FeelerPos_New, true, NULL ) )
+		{
+			FeelerHit = Feelers[ f ].Hit;
+			FeelerImpactPoint = Feelers[ f ].EndPos;
+			FeelerImpactGroup = Feelers[ f ].EndGroup;
+			FeelerFaceNormal = Feelers[ f ].FaceNormal;
+			FeelerPos_New = Feelers[ f ].NewTarget;
+		}
+		if ( FeelerHit )
 		{
 			FeelerPlane = -DotProduct( (VECTOR *)&FeelerFaceNormal, &FeelerImpactPoint ) - radius;
 			Div = DotProduct( &Move_Dir , (VECTOR *)&FeelerFaceNormal );
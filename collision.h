@@ -27,6 +27,10 @@
 #define MULTI_RAY_COLLISION
 //#undef MULTI_RAY_COLLISION
 
+// ObjectCollide and friends sweep the whole sphere once rather than casting feeler rays
+#define SWEPT_SPHERE_COLLISION
+//#undef SWEPT_SPHERE_COLLISION
+
 #define MAXCOLGROUPS MAXGROUPS
 //#define COLLISION_FUDGE (0.001F)
 #define SCALE_FUDGE (1.015F)
@@ -38,6 +42,23 @@
 
 
 
+/*
+ * one background query of a batch, the start, move and BGCol are filled
+ * in by the caller and the rest by BackgroundCollideBatch
+ */
+typedef struct BGCOLQUERY{
+	VECTOR		StartPos;
+	u_int16_t	StartGroup;
+	VECTOR		MoveOffset;
+	bool		BGCol;
+	bool		Hit;
+	VECTOR		EndPos;
+	u_int16_t	EndGroup;
+	NORMAL		FaceNormal;
+	VECTOR		NewTarget;
+	BGOBJECT *	BGObject;
+}BGCOLQUERY;
+
 typedef struct MCLOADHEADER{
 	int		state;
 	char * Buffer;
@@ -47,6 +68,14 @@ typedef struct MCLOADHEADER{
 }MCLOADHEADER;
 
 
+/*
+ * global vars
+ */
+#ifdef SWEPT_SPHERE_COLLISION
+// false falls back on the feeler rays, so the two can be timed against each other
+extern bool SweptSphereCollision;
+#endif
+
 
 /*
  * fn prototypes
@@ -65,6 +94,9 @@ bool BackgroundCollideOneGroup( MCLOADHEADER *c, MLOADHEADER *m,
 					  VECTOR *StartPos, u_int16_t StartGroup, VECTOR *MoveOffset, 
 					  VECTOR *EndPos, u_int16_t *EndGroup,
 					  NORMAL *FaceNormal, VECTOR *NewTarget, bool BGCol, BGOBJECT ** BGObject );
+void BackgroundCollideBatch( MCLOADHEADER *c, MLOADHEADER *m, BGCOLQUERY *Queries, int NumQueries );
+bool BackgroundSphereCollide( VECTOR *StartPos, u_int16_t StartGroup, VECTOR *MoveOffset, float Radius,
+							  float *ImpactTime, VECTOR *ImpactPoint, NORMAL *FaceNormal, bool BGCol, BGOBJECT ** BGObject );
 u_int16_t MoveGroup( MLOADHEADER *m, VECTOR *StartPos, u_int16_t StartGroup, VECTOR *MoveOffset );
 bool OneGroupPolyCol( MCLOADHEADER * MCloadheader ,MLOADHEADER * Mloadheader , u_int16_t group ,
 					VECTOR * Pos, VECTOR * Dir  ,
@@ -35,6 +35,7 @@
 #include "title.h"
 #include "util.h"
 #include "oct2.h"
+#include "pool.h"
 
 #ifdef OPT_ON
 #pragma optimize( "gty", on )
@@ -48,7 +49,7 @@ extern	MCLOADHEADER	MCloadheader;
 extern	MCLOADHEADER	MCloadheadert0;
 extern	XLIGHT			XLights[ MAXXLIGHTS ];
 extern	FMPOLY			FmPolys[ MAXNUMOF2DPOLYS ];
-extern	MODEL			Models[ MAXNUMOFMODELS ];
+extern	MODEL			*	Models;
 extern	float			framelag;
 extern	MATRIX			MATRIX_Identity;
 extern	int16_t			LevelNum;
@@ -446,11 +447,15 @@ GUNTYPE	GunTypes[] = {
 
 	int16_t		NumInitEnemies;
 	int16_t		NumKilledEnemies = 0;
-	ENEMY		Enemies[ MAXENEMIES ];
+	ENEMY		*	Enemies;
 	ENEMY	*	EnemyGroups[ MAXGROUPS ];
 	u_int16_t		NumEnemiesPerGroup[ MAXGROUPS ];
 	ENEMY	*	FirstEnemyUsed = NULL;
-	ENEMY	*	FirstEnemyFree = NULL;
+	pool_t		EnemyPool;
+	grid_t		EnemyGrid;
+static	ENEMY	**	EnemyGridList = NULL;				// used list in order, as put in the grid
+static	int			EnemyGridListSize = 0;
+static	u_int16_t	*	EnemyNearItems = NULL;				// room for every enemy in the grid
 
 ANIM_SEQ	PulseTurretSeqs[] = {
 	{ 0.0F * ANIM_SECOND, 0.0F * ANIM_SECOND },	// Closed
@@ -3900,6 +3905,25 @@ float ObjectAutoLevelRot( OBJECT * Object, float autolevel_rate )
 }
 
 	
+/*===================================================================
+	Procedure	:	Initialise one Enemy, also called as the pool grows
+	Input		:	u_int16_t	Enemy Index
+	Output		:	nothing
+===================================================================*/
+static void InitEnemy( u_int16_t i )
+{
+	memset( &Enemies[ i ], 0, sizeof( ENEMY ) );
+
+	Enemies[ i ].Used = false;
+	Enemies[ i ].NextUsed = NULL;
+	Enemies[ i ].PrevUsed = NULL;
+
+	Enemies[ i ].NextInGroup = NULL;
+	Enemies[ i ].PrevInGroup = NULL;
+	Enemies[ i ].Index = i;
+	Enemies[ i ].Object.Type = OBJECT_TYPE_ENEMY;
+}
+
 /*===================================================================
 	Procedure	:	Initialise all Enemies
 	Input		:	nothing
@@ -3907,31 +3931,11 @@ float ObjectAutoLevelRot( OBJECT * Object, float autolevel_rate )
 ===================================================================*/
 void InitEnemies( void )
 {
-	u_int16_t	i;
-
 	SetupEnemyGroups();
 
 	FirstEnemyUsed = NULL;
-	FirstEnemyFree = &Enemies[ 0 ];
-
-	for( i = 0; i < MAXENEMIES; i++ )
-	{
-		memset( &Enemies[ i ], 0, sizeof( ENEMY ) );
-
-		Enemies[ i ].Used = false;
-		Enemies[ i ].NextUsed = NULL;
-		Enemies[ i ].PrevUsed = NULL;
-		Enemies[ i ].NextFree = &Enemies[ i + 1 ];
-		Enemies[ i ].PrevFree = &Enemies[ i - 1 ];
-
-		Enemies[ i ].NextInGroup = NULL;
-		Enemies[ i ].PrevInGroup = NULL;
-		Enemies[ i ].Index = i;
-		Enemies[ i ].Object.Type = OBJECT_TYPE_ENEMY;
-	}
-
-	Enemies[ 0 ].PrevFree = NULL;
-	Enemies[ MAXENEMIES - 1 ].NextFree = NULL;
+	grid_invalidate( &EnemyGrid );
+	pool_init_table( &EnemyPool, "enemies", (void **) &Enemies, sizeof( ENEMY ), MAXENEMIES, InitEnemy );
 }
 
 /*===================================================================
@@ -3941,25 +3945,23 @@ void InitEnemies( void )
 ===================================================================*/
 ENEMY * FindFreeEnemy( void )
 {
-	ENEMY * Object;
+	ENEMY * Object = NULL;
+	u_int16_t i;
 
-	Object = FirstEnemyFree;
+	i = pool_alloc( &EnemyPool );
 
-	if( Object )
+	if( i != POOL_NONE )
 	{
+		Object = &Enemies[ i ];
+
 		if( Object->Used )
 		{
 			// This enemy has been used before....
 			Msg( "An enemy has been allocated more than once\n" );
+			pool_free( &EnemyPool, i );
 			return NULL;
 		}
 
-		FirstEnemyFree = Object->NextFree;
-		if( FirstEnemyFree != NULL )
-		{
-			FirstEnemyFree->PrevFree = NULL;
-		}
-
 		if( FirstEnemyUsed != NULL )
 		{
 			FirstEnemyUsed->PrevUsed = Object;
@@ -3973,6 +3975,7 @@ ENEMY * FindFreeEnemy( void )
 		Object->PrevUsed = NULL;
 		FirstEnemyUsed = Object;
 		Object->Used = true;
+		grid_invalidate( &EnemyGrid );
 
 	}
 
@@ -4000,6 +4003,7 @@ void KillUsedEnemy( ENEMY * Object )
 
 	if( Object )
 	{
+		grid_invalidate( &EnemyGrid );
 
 		if( !Object->Used )
 		{
@@ -4102,11 +4106,6 @@ void KillUsedEnemy( ENEMY * Object )
 			}
 		}
 
-		if( FirstEnemyFree != NULL )
-		{
-			FirstEnemyFree->PrevFree = Object;
-		}
-
 		if( Object->ModelIndex != (u_int16_t) -1 )
 		{
 			KillUsedModel( Object->ModelIndex );
@@ -4123,9 +4122,7 @@ void KillUsedEnemy( ENEMY * Object )
 			}
 		}
 
-		Object->NextFree = FirstEnemyFree;
-		Object->PrevFree = NULL;
-		FirstEnemyFree = Object;
+		pool_free( &EnemyPool, Object->Index );
 		Object->Used = false;
 
 	}
@@ -4143,6 +4140,8 @@ void ReleaseAllEnemies( void )
 	ENEMY	*	PrevObject;
 	ENEMY	*	NextUsedObject;
 
+	grid_invalidate( &EnemyGrid );
+
 	Object = FirstEnemyUsed;
 
 	while( Object != NULL )
@@ -4184,11 +4183,6 @@ void ReleaseAllEnemies( void )
 			}
 		}
 
-		if( FirstEnemyFree != NULL )
-		{
-			FirstEnemyFree->PrevFree = Object;
-		}
-
 		if( Object->ModelIndex != (u_int16_t) -1 )
 		{
 			KillUsedModel( Object->ModelIndex );
@@ -4205,9 +4199,7 @@ void ReleaseAllEnemies( void )
 			}
 		}
 
-		Object->NextFree = FirstEnemyFree;
-		Object->PrevFree = NULL;
-		FirstEnemyFree = Object;
+		pool_free( &EnemyPool, Object->Index );
 
 		Object = NextUsedObject;
 	}
@@ -5713,6 +5705,81 @@ void DisableEnemy( ENEMY * Enemy )
 	}
 }
 
+/*===================================================================
+	Procedure	:	Put every used enemy in the grid once they have
+				:	all moved for the frame, the grid goes invalid
+				:	as soon as one is added or killed
+	Input		:	nothing
+	Output		:	nothing
+===================================================================*/
+void BuildEnemyGrid( void )
+{
+	ENEMY	*	Enemy;
+	ENEMY	**	List;
+	u_int16_t *	Items;
+	int			Count;
+
+	grid_clear( &EnemyGrid );
+
+	for( Count = 0, Enemy = FirstEnemyUsed; Enemy != NULL; Count++, Enemy = Enemy->NextUsed )
+	{
+		if( Count == EnemyGridListSize )
+		{
+			List = (ENEMY **) realloc( EnemyGridList, ( EnemyGridListSize + MAXENEMIES ) * sizeof( ENEMY * ) );
+			if( !List )
+			{
+				grid_invalidate( &EnemyGrid );
+				return;
+			}
+			EnemyGridList = List;
+			Items = (u_int16_t *) realloc( EnemyNearItems, ( EnemyGridListSize + MAXENEMIES ) * sizeof( u_int16_t ) );
+			if( !Items )
+			{
+				grid_invalidate( &EnemyGrid );
+				return;
+			}
+			EnemyNearItems = Items;
+			EnemyGridListSize += MAXENEMIES;
+		}
+
+		EnemyGridList[ Count ] = Enemy;
+		if( !grid_add( &EnemyGrid, (u_int16_t) Count, &Enemy->Object.Pos, EnemyTypes[ Enemy->Type ].Radius ) )
+			return;
+	}
+}
+
+/*===================================================================
+	Procedure	:	First enemy that could be within a distance of
+				:	a point, in the same order as the used list,
+				:	every used enemy if the grid can't say
+	Input		:	ENEMY_NEAR	*	Walk state
+				:	VECTOR		*	Pos
+				:	float			Distance
+	Output		:	ENEMY		*	Enemy ( NULL if none )
+===================================================================*/
+ENEMY * FirstEnemyNear( ENEMY_NEAR * Near, VECTOR * Pos, float Radius )
+{
+	Near->Items = EnemyNearItems;
+	Near->Num = grid_query( &EnemyGrid, Pos, Radius, Near->Items, EnemyGridListSize );
+	Near->Next = 0;
+
+	if( Near->Num < 0 )
+		return FirstEnemyUsed;
+
+	return NextEnemyNear( Near, NULL );
+}
+
+ENEMY * NextEnemyNear( ENEMY_NEAR * Near, ENEMY * Enemy )
+{
+	if( Near->Num < 0 )
+		return Enemy->NextUsed;
+
+	if( Near->Next >= Near->Num )
+		return NULL;
+
+	return EnemyGridList[ Near->Items[ Near->Next++ ] ];
+}
+
 /*===================================================================
 	Procedure	:	Check if hit Enemy
 	Input		:	u_int16_t		OwnerType
@@ -5741,17 +5808,18 @@ ENEMY * CheckHitEnemy( u_int16_t OwnerType, u_int16_t Owner, VECTOR * Pos, VECTO
 	float		ColRadius = 0.0f;
 	ENEMY	*	Enemy;
 	ENEMY	*	NextEnemy;
+	ENEMY_NEAR	Near;
 
 //	return( NULL );
 
 	ClosestEnemy = NULL;
 	ClosestLength = *Dist;
 
-	Enemy = FirstEnemyUsed;
+	Enemy = FirstEnemyNear( &Near, Pos, DirLength + WeaponRadius );
 
 	while( Enemy != NULL )
 	{
-		NextEnemy = Enemy->NextUsed;
+		NextEnemy = NextEnemyNear( &Near, Enemy );
 
 		if( !( ( OwnerType == OWNER_ENEMY ) && ( Owner == Enemy->Index ) ) )
 		{
@@ -8812,9 +8880,9 @@ bool Enemy_Save( FILE * fp )
 	fwrite( &e, sizeof( e ), 1, fp );
 
 	e = -1;
-	if( Enemy = FirstEnemyFree )
+	if( EnemyPool.num_free )
 	{
-		e = Enemy->Index;
+		e = pool_free_slot( &EnemyPool, 0 );
 	}
 	fwrite( &e, sizeof( e ), 1, fp );
 
@@ -8907,17 +8975,8 @@ bool Enemy_Save( FILE * fp )
 		}
 		fwrite( &e, sizeof( e ), 1, fp );
 		e = -1;
-		if( Enemy = Enemies[i].PrevFree )
-		{
-			e = Enemy->Index;
-		}
-		fwrite( &e, sizeof( e ), 1, fp );
-		e = -1;
-		if( Enemy = Enemies[i].NextFree )
-		{
-			e = Enemy->Index;
-		}
-		fwrite( &e, sizeof( e ), 1, fp );
+		fwrite( &e, sizeof( e ), 1, fp );	// was PrevFree
+		fwrite( &e, sizeof( e ), 1, fp );	// was NextFree
 		e = -1;
 		if( Enemy = Enemies[i].NextInGroup )
 		{
@@ -9001,11 +9060,13 @@ bool Enemy_Load( FILE * fp )
 	int i;
 	int e;
 	int16_t		TempNumInitEnemies;
+	ENEMY * Enemy;
 
 
 	fread( &TempNumInitEnemies, sizeof( TempNumInitEnemies ), 1, fp );
 
-	if( NumInitEnemies != TempNumInitEnemies )
+	if( ( NumInitEnemies != TempNumInitEnemies ) ||
+		( NumInitEnemies && !pool_fit( &EnemyPool, (u_int16_t) ( NumInitEnemies - 1 ) ) ) )
 	{
 		fclose(fp);
 		return false;
@@ -9029,13 +9090,7 @@ bool Enemy_Load( FILE * fp )
 	}else{
 		FirstEnemyUsed = &Enemies[e];
 	}
-	fread( &e, sizeof( e ), 1, fp );
-	if( e == -1 )
-	{
-		FirstEnemyFree = NULL;
-	}else{
-		FirstEnemyFree = &Enemies[e];
-	}
+	fread( &e, sizeof( e ), 1, fp );	// first free, the pool is rebuilt below
 
 	fread( &FleshMorphTimer, sizeof( FleshMorphTimer ), 1, fp );
 	
@@ -9131,20 +9186,8 @@ bool Enemy_Load( FILE * fp )
 
 
 
-		fread( &e, sizeof( e ), 1, fp );
-		if( e == -1 )
-		{
-			Enemies[i].PrevFree = NULL;
-		}else{
-			Enemies[i].PrevFree = &Enemies[e];
-		}
-		fread( &e, sizeof( e ), 1, fp );
-		if( e == -1 )
-		{
-			Enemies[i].NextFree = NULL;
-		}else{
-			Enemies[i].NextFree = &Enemies[e];
-		}
+		fread( &e, sizeof( e ), 1, fp );	// was PrevFree
+		fread( &e, sizeof( e ), 1, fp );	// was NextFree
 
 		fread( &e, sizeof( e ), 1, fp );
 		if( e == -1 )
@@ -9234,6 +9277,12 @@ bool Enemy_Load( FILE * fp )
 			AddEnemyToGroup( &Enemies[i] , Enemies[i].Object.Group );
 		}
 	}
+
+	pool_clear( &EnemyPool );
+	for( Enemy = FirstEnemyUsed; Enemy != NULL; Enemy = Enemy->NextUsed )
+		pool_mark( &EnemyPool, Enemy->Index );
+	pool_rebuild( &EnemyPool );
+
 	return true;
 }
 
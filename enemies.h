@@ -8,6 +8,7 @@
 #include "main.h"
 #include "node.h"
 #include "triggers.h"
+#include "grid.h"
 
 /*===================================================================
 	Defines
@@ -79,8 +80,6 @@ typedef struct ENEMY {
 
 	struct	ENEMY	*	PrevUsed;
 	struct	ENEMY	*	NextUsed;
-	struct	ENEMY	*	PrevFree;
-	struct	ENEMY	*	NextFree;
 
 	struct	ENEMY	*	NextInGroup;// Next in same group ....
 	struct	ENEMY	*	PrevInGroup;// Previous in same group ....
@@ -340,6 +339,13 @@ enum
 #define	MAXENEMIES				256
 #define	MAX_ENEMY_TYPES			56
 
+// enemies that could be near a point, walked with FirstEnemyNear / NextEnemyNear
+typedef struct ENEMY_NEAR {
+	int			Num;					// -1 walks every used enemy
+	int			Next;
+	u_int16_t *	Items;					// places in the used list, shared so one walk at a time
+} ENEMY_NEAR;
+
 #define	YES_STEALTH_MODE		true
 #define	NO_STEALTH_MODE			false
 
@@ -372,6 +378,10 @@ void EnableEnemy( u_int16_t EnemyIndex );
 void DisableEnemy( ENEMY * Enemy );
 ENEMY * CheckHitEnemy( u_int16_t OwnerType, u_int16_t Owner, VECTOR * Pos, VECTOR * Dir, VECTOR * UpDir, float DirLength, VECTOR * Int_Point,
 						VECTOR * Int_Point2, float * Dist, float WeaponRadius, u_int16_t ColType );
+extern grid_t EnemyGrid;
+void BuildEnemyGrid( void );
+ENEMY * FirstEnemyNear( ENEMY_NEAR * Near, VECTOR * Pos, float Radius );
+ENEMY * NextEnemyNear( ENEMY_NEAR * Near, ENEMY * Enemy );
 void SetCurAnimSeq( int16_t Seq, OBJECT * Object );
 bool GetLastCompDispMatrix( OBJECT * Object, MATRIX * Matrix, MATRIX * TMatrix, VECTOR * FirePos, int16_t BaseIndex );
 void SetTurretVector( OBJECT * Object, VECTOR * Vector, int16_t BaseIndex );
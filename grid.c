@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <math.h>
+#include "main.h"
+#include "util.h"
+#include "grid.h"
+
+#define GRID_GROW	(64)	// entries added each time the grid runs out
+
+// a little over the exact bound so rounding never loses an item on a cell edge
+#define GRID_SLACK	(1.0F)
+
+static int32_t grid_cell( float v )
+{
+	return (int32_t) floorf( v * ( 1.0F / GRID_CELL ) );
+}
+
+static u_int16_t grid_hash( int32_t x, int32_t y, int32_t z )
+{
+	return (u_int16_t) ( ( (u_int32_t) x * 73856093U ^ (u_int32_t) y * 19349663U ^ (u_int32_t) z * 83492791U ) & ( GRID_BUCKETS - 1 ) );
+}
+
+/*===================================================================
+	Procedure	:	Empty a grid ready to be filled, it is valid
+				:	from now until grid_invalidate
+===================================================================*/
+void grid_clear( grid_t * grid )
+{
+	int i;
+
+	for( i = 0; i < GRID_BUCKETS; i++ )
+		grid->buckets[ i ] = GRID_NONE;
+
+	grid->num = 0;
+	grid->reach = 0.0F;
+	grid->valid = true;
+}
+
+/*===================================================================
+	Procedure	:	Put an item in the cell its position is in
+	Input		:	grid_t * , item , position , how far the item
+				:	reaches past its position
+	Output		:	bool false if out of memory, the grid is then
+				:	left invalid
+===================================================================*/
+bool grid_add( grid_t * grid, u_int16_t item, VECTOR * pos, float radius )
+{
+	GRID_ENTRY * entry;
+	GRID_ENTRY * entries;
+	u_int16_t b;
+
+	if( !grid->valid )
+		return false;
+
+	if( grid->num == grid->max )
+	{
+		if( grid->max > 0xffff - GRID_GROW - 1 )
+		{
+			grid->valid = false;
+			return false;
+		}
+		entries = (GRID_ENTRY *) realloc( grid->entries, ( grid->max + GRID_GROW ) * sizeof( GRID_ENTRY ) );
+		if( !entries )
+		{
+			Msg( "grid: failed to grow to %d entries\n", grid->max + GRID_GROW );
+			grid->valid = false;
+			return false;
+		}
+		grid->entries = entries;
+		grid->max += GRID_GROW;
+	}
+
+	entry = &grid->entries[ grid->num ];
+	entry->item = item;
+	entry->x = grid_cell( pos->x );
+	entry->y = grid_cell( pos->y );
+	entry->z = grid_cell( pos->z );
+
+	b = grid_hash( entry->x, entry->y, entry->z );
+	entry->next = grid->buckets[ b ];
+	grid->buckets[ b ] = grid->num++;
+
+	if( radius > grid->reach )
+		grid->reach = radius;
+
+	return true;
+}
+
+/*===================================================================
+	Procedure	:	Find every item that could touch a sphere
+	Input		:	grid_t * , center , radius , where to put the
+				:	items , room for items
+	Output		:	int number of items sorted lowest first, -1 if
+				:	the caller has to walk its whole table
+===================================================================*/
+int grid_query( grid_t * grid, VECTOR * pos, float radius, u_int16_t * items, int max )
+{
+	GRID_ENTRY * entry;
+	int32_t x0, y0, z0, x1, y1, z1;
+	int32_t x, y, z;
+	u_int16_t e, item;
+	int num = 0;
+	int i, j;
+
+	if( !grid->valid )
+		return -1;
+
+	radius += grid->reach + GRID_SLACK;
+
+	x0 = grid_cell( pos->x - radius );	x1 = grid_cell( pos->x + radius );
+	y0 = grid_cell( pos->y - radius );	y1 = grid_cell( pos->y + radius );
+	z0 = grid_cell( pos->z - radius );	z1 = grid_cell( pos->z + radius );
+
+	if( ( (int64_t) ( x1 - x0 + 1 ) * ( y1 - y0 + 1 ) * ( z1 - z0 + 1 ) ) > GRID_MAX_CELLS )
+		return -1;
+
+	for( z = z0; z <= z1; z++ )
+	for( y = y0; y <= y1; y++ )
+	for( x = x0; x <= x1; x++ )
+	{
+		for( e = grid->buckets[ grid_hash( x, y, z ) ]; e != GRID_NONE; e = entry->next )
+		{
+			entry = &grid->entries[ e ];
+			if( entry->x != x || entry->y != y || entry->z != z )
+				continue;
+			if( num == max )
+				return -1;
+			items[ num++ ] = entry->item;
+		}
+	}
+
+	// each item is in one cell so there are no repeats, only the order to fix
+	for( i = 1; i < num; i++ )
+	{
+		item = items[ i ];
+		for( j = i; j > 0 && items[ j - 1 ] > item; j-- )
+			items[ j ] = items[ j - 1 ];
+		items[ j ] = item;
+	}
+
+	return num;
+}
+
+void grid_invalidate( grid_t * grid )
+{
+	grid->valid = false;
+}
+
+void grid_release( grid_t * grid )
+{
+	if( grid->entries )
+		free( grid->entries );
+	grid->entries = NULL;
+	grid->num = 0;
+	grid->max = 0;
+	grid->valid = false;
+}
@@ -0,0 +1,68 @@
+#ifndef GRID_INCLUDED
+#define GRID_INCLUDED
+
+/*
+
+	description:
+
+			a uniform grid over world space, hashed so it needs no
+			bounds, that finds the entities near a point without
+			walking a whole table
+
+	filled once the entities have stopped moving for the frame:
+
+			grid_clear( &ShipGrid );
+			grid_add( &ShipGrid, i, &Ships[ i ].Object.Pos, SHIP_RADIUS );
+
+	items are small numbers the owner picks ( table index, order
+	in a used list ... ) and radius is how far the item reaches
+	past its position
+
+	everything that could be touched by a sphere:
+
+			n = grid_query( &ShipGrid, Pos, Radius, items, MAX_PLAYERS );
+
+	items comes back sorted lowest first so callers keep the order
+	of the loop they replace, n is -1 when the grid is not valid,
+	the sphere covers too many cells or more than max items were
+	found, the caller then falls back to walking its whole table
+
+	once anything in the grid moves or goes away:
+
+			grid_invalidate( &ShipGrid );
+
+	callers still do their own exact tests on what comes back, the
+	grid only leaves out what cannot possibly be hit
+
+*/
+
+#include "main.h"
+#include "new3d.h"
+
+#define GRID_CELL		( 4096.0F * GLOBAL_SCALE )	// edge of a cell
+#define GRID_BUCKETS	(256)						// must be a power of two
+#define GRID_MAX_CELLS	(64)						// bigger queries walk the table instead
+#define GRID_NONE		((u_int16_t) -1)
+
+typedef struct {
+	u_int16_t	item;
+	u_int16_t	next;		// next entry in the same bucket
+	int32_t		x, y, z;	// cell
+} GRID_ENTRY;
+
+typedef struct {
+	bool			valid;
+	u_int16_t		num;						// entries
+	u_int16_t		max;						// entries there is room for
+	float			reach;						// furthest any item reaches past its position
+	GRID_ENTRY	*	entries;
+	u_int16_t		buckets[ GRID_BUCKETS ];	// first entry in each bucket
+} grid_t;
+
+void	grid_clear		( grid_t * grid );
+bool	grid_add		( grid_t * grid, u_int16_t item, VECTOR * pos, float radius );
+int		grid_query		( grid_t * grid, VECTOR * pos, float radius, u_int16_t * items, int max );
+void	grid_invalidate	( grid_t * grid );
+void	grid_release	( grid_t * grid );
+
+#endif
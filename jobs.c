@@ -0,0 +1,194 @@
+#include <SDL.h>
+#include "main.h"
+#include "util.h"
+#include "jobs.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static SDL_Thread *	jobs_thread[ JOBS_MAX_THREADS ];
+static int			jobs_num_threads = 0;
+
+// everything below is only touched with jobs_lock held
+static SDL_mutex *	jobs_lock = NULL;
+static SDL_cond *	jobs_start = NULL;		// a new batch, or time to stop
+static SDL_cond *	jobs_done = NULL;		// the last job of the batch finished
+
+static jobs_fn_t	jobs_fn;
+static void *		jobs_data;
+static int			jobs_count = 0;
+static int			jobs_next = 0;			// next job to hand out
+static int			jobs_running = 0;		// handed out but not finished
+static u_int32_t	jobs_batch = 0;			// bumped by every jobs_run
+static bool			jobs_quit = false;
+
+static int jobs_cpus( void )
+{
+#if SDL_VERSION_ATLEAST(2,0,0)
+	return SDL_GetCPUCount();
+#elif defined( WIN32 )
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	return (int) info.dwNumberOfProcessors;
+#else
+	return (int) sysconf( _SC_NPROCESSORS_ONLN );
+#endif
+}
+
+// take jobs until none are left, called and returns with jobs_lock held
+static void jobs_work( void )
+{
+	int i;
+
+	while( jobs_next < jobs_count )
+	{
+		i = jobs_next++;
+		jobs_running++;
+		SDL_UnlockMutex( jobs_lock );
+
+		jobs_fn( jobs_data, i );
+
+		SDL_LockMutex( jobs_lock );
+		jobs_running--;
+	}
+
+	if( !jobs_running )
+		SDL_CondBroadcast( jobs_done );
+}
+
+static int jobs_worker( void * unused )
+{
+	u_int32_t batch = 0;
+
+	(void) unused;
+
+	SDL_LockMutex( jobs_lock );
+	for(;;)
+	{
+		while( !jobs_quit && batch == jobs_batch )
+			SDL_CondWait( jobs_start, jobs_lock );
+		if( jobs_quit )
+			break;
+		batch = jobs_batch;
+		jobs_work();
+	}
+	SDL_UnlockMutex( jobs_lock );
+
+	return 0;
+}
+
+/*===================================================================
+	Procedure	:	Start the worker threads
+	Input		:	int number of threads , -1 for one less than
+				:	the number of cpus
+	Output		:	bool false if there are no workers, jobs_run
+				:	still works but on the calling thread only
+===================================================================*/
+bool jobs_init( int threads )
+{
+	if( threads < 0 )
+		threads = jobs_cpus() - 1;
+	if( threads > JOBS_MAX_THREADS )
+		threads = JOBS_MAX_THREADS;
+
+	if( jobs_num_threads || threads <= 0 )
+	{
+		DebugPrintf( "jobs: %d worker threads\n", jobs_num_threads );
+		return jobs_num_threads > 0;
+	}
+
+	jobs_lock = SDL_CreateMutex();
+	jobs_start = SDL_CreateCond();
+	jobs_done = SDL_CreateCond();
+	if( !jobs_lock || !jobs_start || !jobs_done )
+	{
+		jobs_shutdown();
+		DebugPrintf( "jobs: could not create the locks, no worker threads\n" );
+		return false;
+	}
+
+	jobs_quit = false;
+	while( jobs_num_threads < threads )
+	{
+#if SDL_VERSION_ATLEAST(2,0,0)
+		jobs_thread[ jobs_num_threads ] = SDL_CreateThread( jobs_worker, "jobs", NULL );
+#else
+		jobs_thread[ jobs_num_threads ] = SDL_CreateThread( jobs_worker, NULL );
+#endif
+		if( !jobs_thread[ jobs_num_threads ] )
+			break;
+		jobs_num_threads++;
+	}
+
+	DebugPrintf( "jobs: %d worker threads\n", jobs_num_threads );
+	return jobs_num_threads > 0;
+}
+
+/*===================================================================
+	Procedure	:	Run a batch of jobs on the workers and this
+				:	thread, returns once every one has finished
+	Input		:	jobs_fn_t , data passed to every job , count
+	Output		:	nothing
+===================================================================*/
+void jobs_run( jobs_fn_t fn, void * data, int count )
+{
+	int i;
+
+	if( !jobs_num_threads || count < 2 )
+	{
+		for( i = 0; i < count; i++ )
+			fn( data, i );
+		return;
+	}
+
+	SDL_LockMutex( jobs_lock );
+
+	jobs_fn = fn;
+	jobs_data = data;
+	jobs_count = count;
+	jobs_next = 0;
+	jobs_running = 0;
+	jobs_batch++;
+	SDL_CondBroadcast( jobs_start );
+
+	jobs_work();
+	while( jobs_next < jobs_count || jobs_running )
+		SDL_CondWait( jobs_done, jobs_lock );
+
+	SDL_UnlockMutex( jobs_lock );
+}
+
+void jobs_shutdown( void )
+{
+	int i;
+
+	if( jobs_num_threads )
+	{
+		SDL_LockMutex( jobs_lock );
+		jobs_quit = true;
+		SDL_CondBroadcast( jobs_start );
+		SDL_UnlockMutex( jobs_lock );
+
+		for( i = 0; i < jobs_num_threads; i++ )
+			SDL_WaitThread( jobs_thread[ i ], NULL );
+		jobs_num_threads = 0;
+	}
+
+	if( jobs_done )
+		SDL_DestroyCond( jobs_done );
+	if( jobs_start )
+		SDL_DestroyCond( jobs_start );
+	if( jobs_lock )
+		SDL_DestroyMutex( jobs_lock );
+	jobs_done = NULL;
+	jobs_start = NULL;
+	jobs_lock = NULL;
+}
+
+int jobs_threads( void )
+{
+	return jobs_num_threads;
+}
@@ -0,0 +1,45 @@
+#ifndef JOBS_INCLUDED
+#define JOBS_INCLUDED
+
+/*
+
+	description:
+
+			a few worker threads that share out a batch of jobs that
+			do not depend on each other, the thread handing out the
+			batch works on it too and the batch is finished when
+			jobs_run returns
+
+	once at startup, after the command line:
+
+			jobs_init( threads );		// -1 for one less than the cpus
+
+	a batch, fn( data, i ) for every i below count, in any order and
+	on any thread:
+
+			jobs_run( fn, data, count );
+
+	a job must not call the renderer, lua, the memo tables or anything
+	else that is not safe to use from two threads, and must not write
+	anything another job of the same batch reads
+
+	at quit:
+
+			jobs_shutdown();
+
+	with no worker threads jobs_run simply runs the batch in order
+
+*/
+
+#include "main.h"
+
+#define JOBS_MAX_THREADS	(8)
+
+typedef void ( *jobs_fn_t )( void * data, int i );
+
+bool	jobs_init		( int threads );
+void	jobs_run		( jobs_fn_t fn, void * data, int count );
+void	jobs_shutdown	( void );
+int		jobs_threads	( void );
+
+#endif
@@ -17,6 +17,11 @@
 #include "text.h"
 #include "main.h"
 #include "util.h"
+#include "pool.h"
+#include "memo.h"
+#include "vlight.h"
+#include "arena.h"
+#include "jobs.h"
 
 #ifdef OPT_ON
 #pragma optimize( "gty", on )
@@ -64,9 +69,11 @@ COLOR GroupColours[ 8 ] = {
 };
 
 XLIGHT * FirstLightVisible = NULL;
+static u_int16_t LightListGroup = (u_int16_t) -1;	// camera group FirstLightVisible was built for
+static u_int32_t LightListGeneration = 0;			// bumped every time FirstLightVisible is built again
 XLIGHT	XLights[MAXXLIGHTS];
 u_int16_t	FirstXLightUsed;
-u_int16_t	FirstXLightFree;
+pool_t		XLightPool;
 
 WORD	status;		
 DWORD	chop_status;		
@@ -107,16 +114,14 @@ void	InitXLights()
 {
 	u_int16_t	i;
 	FirstXLightUsed = (u_int16_t) -1;
-	FirstXLightFree = 0;
+	pool_init( &XLightPool, "xlights", MAXXLIGHTS );
 	for( i = 0 ; i < MAXXLIGHTS ; i++ )
 	{
 		XLights[i].Index = i;
-		XLights[i].Next = i + 1;
+		XLights[i].Next = (u_int16_t) -1;
 		XLights[i].Prev = (u_int16_t) -1;
 		XLights[i].Type = POINT_LIGHT;
 	}
-
-	XLights[MAXXLIGHTS-1].Next = (u_int16_t) -1;
 }
 /*===================================================================
 	Procedure	:	Find a free light and move it from the free list to
@@ -128,18 +133,18 @@ u_int16_t	FindFreeXLight()
 {
 	u_int16_t i;
 
-	i = FirstXLightFree;
+	i = pool_alloc( &XLightPool );
 	
-	if ( i == (u_int16_t) -1)
+	if ( i == POOL_NONE )
 		return i;
  
+	XLights[i].Next = (u_int16_t) -1;
 	XLights[i].Prev = FirstXLightUsed;
 	if ( FirstXLightUsed != (u_int16_t) -1)
 	{
 		XLights[FirstXLightUsed].Next = i;
 	}
 	FirstXLightUsed = i;
-	FirstXLightFree = XLights[i].Next;
 	XLights[i].Type = POINT_LIGHT;
 	XLights[i].Visible = true;
 
@@ -169,8 +174,8 @@ void	KillUsedXLight( u_int16_t light )
 		XLights[its_next].Prev = its_prev;
 
 	XLights[light].Prev = (u_int16_t) -1;
-	XLights[light].Next = FirstXLightFree;
-	FirstXLightFree	= light;
+	XLights[light].Next = (u_int16_t) -1;
+	pool_free( &XLightPool, light );
 }
 
 
@@ -226,22 +231,698 @@ void SetLightDie ( u_int16_t light )
 	XLights[light].b = 0.0F;
 }
 /*===================================================================
-	Procedure	:	Xlight 1 Group Only...
+	Incremental group lighting...
+
+	static level geometry only needs its colours redone where a light
+	has appeared, gone or changed since the group was last lit.  each
+	group remembers the lights it was lit with, the cells those lights
+	reach are put back to the base colours and only those cells are
+	lit again.  water, whiteout and plane rgb redo everything.
+===================================================================*/
+#define	MAXLITLIGHTS	(32)				// more than this and the group is just relit
+
+typedef struct LITLIGHT {
+	u_int16_t	light;						// index in XLights
+	u_int32_t	signature;					// hash of everything the colours depend on
+	VECTOR		Pos;
+	float		Size;
+} LITLIGHT;
+
+typedef struct LITGROUP {
+	bool		valid;						// colours are the base ones plus these lights
+	int			num_lights;
+	LITLIGHT	lights[ MAXLITLIGHTS ];
+} LITGROUP;
+
+static LITGROUP	LitGroups[ MAXGROUPS ];
+
+// one group being lit, mapped on the main thread and lit on any
+typedef struct LIGHTJOB {
+	MLOADHEADER *	Mloadheader;
+	u_int16_t	group;
+	int			num_lights;							// -1 when it is not lit incrementally
+	LITLIGHT	lights[ MAXLITLIGHTS ];				// found by FindGroupLights
+	LPLVERTEX	verts[ MAXEXECBUFSPERGROUP ];		// mapped, NULL where nothing has to change
+	u_int8_t *	dirty[ MAXEXECBUFSPERGROUP ];		// one bit per cell to light again, NULL for all of them
+} LIGHTJOB;
+
+/*===================================================================
+	Procedure	:	Forget how every group was lit, its vertex
+				:	buffers have just been filled from the level
 	Input		:	nothing
 	Output		:	nothing
 ===================================================================*/
-float	cral = 0.0F;
+void ResetGroupLighting( void )
+{
+	int group;
 
+	for( group = 0 ; group < MAXGROUPS ; group++ )
+		LitGroups[ group ].valid = false;
+}
 
-bool	XLight1Group( MLOADHEADER * Mloadheader, u_int16_t group )
+static u_int32_t LightSignature( XLIGHT * XLightPnt )
+{
+	float	f[ 12 ];
+	u_int8_t * p;
+	u_int32_t h;
+	u_int32_t i;
+
+	f[ 0 ] = (float) XLightPnt->Type;
+	f[ 1 ] = XLightPnt->r;
+	f[ 2 ] = XLightPnt->g;
+	f[ 3 ] = XLightPnt->b;
+	f[ 4 ] = XLightPnt->Size;
+	f[ 5 ] = XLightPnt->CosArc;
+	f[ 6 ] = XLightPnt->Pos.x;
+	f[ 7 ] = XLightPnt->Pos.y;
+	f[ 8 ] = XLightPnt->Pos.z;
+	f[ 9 ] = XLightPnt->Dir.x;
+	f[ 10 ] = XLightPnt->Dir.y;
+	f[ 11 ] = XLightPnt->Dir.z;
+
+	h = 2166136261U;
+	p = (u_int8_t *) f;
+	for( i = 0 ; i < sizeof( f ) ; i++ )
+		h = ( h ^ p[ i ] ) * 16777619U;
+	return h;
+}
+
+/*===================================================================
+	Procedure	:	Find the lights XLight1Group will add to a group
+	Input		:	MLOADHEADER * , group , room for MAXLITLIGHTS
+	Output		:	int number of lights found , -1 if too many
+===================================================================*/
+static int FindGroupLights( MLOADHEADER * Mloadheader, u_int16_t group, LITLIGHT * NewLights )
 {
 	XLIGHT * XLightPnt;
+	LVLGROUP * Group;
+	float	Size;
+	int		num;
+
+	Group = &Mloadheader->Group[ group ];
+	num = 0;
+	for( XLightPnt = FirstLightVisible ; XLightPnt ; XLightPnt = XLightPnt->NextVisible )
+	{
+		if( !GroupsAreVisible( group, XLightPnt->Group ) )
+			continue;
+		Size = XLightPnt->Size;
+		if( fabs( XLightPnt->Pos.x - Group->center.x ) > Group->half_size.x + Size ||
+			fabs( XLightPnt->Pos.y - Group->center.y ) > Group->half_size.y + Size ||
+			fabs( XLightPnt->Pos.z - Group->center.z ) > Group->half_size.z + Size )
+			continue;
+		if( num == MAXLITLIGHTS )
+			return -1;
+		NewLights[ num ].light = XLightPnt->Index;
+		NewLights[ num ].signature = LightSignature( XLightPnt );
+		NewLights[ num ].Pos = XLightPnt->Pos;
+		NewLights[ num ].Size = Size;
+		num++;
+	}
+	return num;
+}
+
+// mark the cells of an execbuf a light of this size at this position reaches
+static void MarkLightCells( LVLGROUP * Group, int execbuf, float CellSize, VECTOR * Pos, float Size, u_int8_t * ChangedCells )
+{
+	int		x, y, z;
+	int		min_x, min_y, min_z;
+	int		max_x, max_y, max_z;
+	int		Cell;
+
+	min_x = (int) floor( ( Pos->x - Group->cell_origin[ execbuf ].x - Size ) * CellSize );
+	min_y = (int) floor( ( Pos->y - Group->cell_origin[ execbuf ].y - Size ) * CellSize );
+	min_z = (int) floor( ( Pos->z - Group->cell_origin[ execbuf ].z - Size ) * CellSize );
+	max_x = (int) floor( ( Pos->x - Group->cell_origin[ execbuf ].x + Size ) * CellSize );
+	max_y = (int) floor( ( Pos->y - Group->cell_origin[ execbuf ].y + Size ) * CellSize );
+	max_z = (int) floor( ( Pos->z - Group->cell_origin[ execbuf ].z + Size ) * CellSize );
+
+	// same clamping XLight1Group does, so the same cells get lit
+	min_x = ( min_x < 0 ) ? 0 : ( ( min_x >= Group->xcells[ execbuf ] ) ? Group->xcells[ execbuf ] - 1 : min_x );
+	min_y = ( min_y < 0 ) ? 0 : ( ( min_y >= Group->ycells[ execbuf ] ) ? Group->ycells[ execbuf ] - 1 : min_y );
+	min_z = ( min_z < 0 ) ? 0 : ( ( min_z >= Group->zcells[ execbuf ] ) ? Group->zcells[ execbuf ] - 1 : min_z );
+	max_x = ( max_x < 0 ) ? 0 : ( ( max_x >= Group->xcells[ execbuf ] ) ? Group->xcells[ execbuf ] - 1 : max_x );
+	max_y = ( max_y < 0 ) ? 0 : ( ( max_y >= Group->ycells[ execbuf ] ) ? Group->ycells[ execbuf ] - 1 : max_y );
+	max_z = ( max_z < 0 ) ? 0 : ( ( max_z >= Group->zcells[ execbuf ] ) ? Group->zcells[ execbuf ] - 1 : max_z );
+
+	for( z = min_z ; z <= max_z ; z++ )
+	{
+		for( y = min_y ; y <= max_y ; y++ )
+		{
+			Cell = min_x + Group->xcells[ execbuf ] * ( y + Group->ycells[ execbuf ] * z );
+			for( x = min_x ; x <= max_x ; x++, Cell++ )
+				ChangedCells[ Cell >> 3 ] |= 1 << ( Cell & 7 );
+		}
+	}
+}
+
+/*===================================================================
+	Procedure	:	Mark the cells of an execbuf whose lighting is
+				:	different from the last time the group was lit
+	Input		:	MLOADHEADER * , group , execbuf , lights found by
+				:	FindGroupLights , one bit per cell to fill in
+	Output		:	bool true if any cell has to be lit again
+===================================================================*/
+static bool MarkChangedCells( MLOADHEADER * Mloadheader, u_int16_t group, int execbuf,
+							  LITLIGHT * NewLights, int num_lights, u_int8_t * ChangedCells )
+{
+	LVLGROUP * Group;
+	LITGROUP * Lit;
+	bool	changed;
+	int		i, j;
+
+	Group = &Mloadheader->Group[ group ];
+	Lit = &LitGroups[ group ];
+	memset( ChangedCells, 0, ( Group->numofcells[ execbuf ] + 7 ) >> 3 );
+	changed = false;
+
+	// lights that have moved, changed or just arrived
+	for( i = 0 ; i < num_lights ; i++ )
+	{
+		for( j = 0 ; j < Lit->num_lights ; j++ )
+		{
+			if( Lit->lights[ j ].light == NewLights[ i ].light && Lit->lights[ j ].signature == NewLights[ i ].signature )
+				break;
+		}
+		if( j == Lit->num_lights )
+		{
+			MarkLightCells( Group, execbuf, Mloadheader->CellSize, &NewLights[ i ].Pos, NewLights[ i ].Size, ChangedCells );
+			changed = true;
+		}
+	}
+
+	// and where they, or lights that have gone, were before
+	for( j = 0 ; j < Lit->num_lights ; j++ )
+	{
+		for( i = 0 ; i < num_lights ; i++ )
+		{
+			if( Lit->lights[ j ].light == NewLights[ i ].light && Lit->lights[ j ].signature == NewLights[ i ].signature )
+				break;
+		}
+		if( i == num_lights )
+		{
+			MarkLightCells( Group, execbuf, Mloadheader->CellSize, &Lit->lights[ j ].Pos, Lit->lights[ j ].Size, ChangedCells );
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+static bool PolyAnimChanged( LVLGROUP * Group, int execbuf )
+{
+	POLYANIM * PolyAnim;
+	int i;
+
+	PolyAnim = Group->polyanim[ execbuf ];
+	for( i = 0 ; i < Group->num_animating_polys[ execbuf ] ; i++, PolyAnim++ )
+	{
+		if( PolyAnim->currentframe != PolyAnim->newframe )
+			return true;
+	}
+	return false;
+}
+
+// put the cells about to be lit again back to their base colours
+static void RestoreChangedCells( LVLGROUP * Group, int execbuf, LPLVERTEX lpPointer, u_int8_t * ChangedCells )
+{
+	VERTEXCELL * VertexCellPnt;
+	u_int16_t * VertexIndexPnt;
+	LPLVERTEX	lpOriginal;
+	int		Cell;
+	int		vert;
+
+	VertexCellPnt = Group->vertex_cell_pnt[ execbuf ];
+	lpOriginal = Group->originalVerts[ execbuf ];
+	for( Cell = 0 ; Cell < Group->numofcells[ execbuf ] ; Cell++ )
+	{
+		if( !( ChangedCells[ Cell >> 3 ] & ( 1 << ( Cell & 7 ) ) ) )
+			continue;
+		VertexIndexPnt = Group->vertex_index_pnt[ execbuf ] + VertexCellPnt[ Cell ].start_vert_in_cell;
+		for( vert = VertexCellPnt[ Cell ].num_verts_in_cell ; vert-- ; VertexIndexPnt++ )
+			lpPointer[ *VertexIndexPnt ].color = lpOriginal[ *VertexIndexPnt ].color;
+	}
+}
+
+// every camera this frame that sees the group with the same lights gets the same colours,
+// keyed on the list itself as a camera in between may have lit the group with another one
+static void GroupLitKey( u_int16_t group, u_int32_t * key )
+{
+	memset( key, 0, MEMO_KEY_WORDS * sizeof( u_int32_t ) );
+	key[ 0 ] = group;
+	key[ 1 ] = LightListGeneration;
+}
+
+static bool GroupAlreadyLit( u_int16_t group )
+{
+	u_int32_t key[ MEMO_KEY_WORDS ];
+	u_int32_t value[ MEMO_VALUE_WORDS ];
+
+	GroupLitKey( group, key );
+	return memo_find( MEMO_XLight1Group, key, value );
+}
+
+static bool UnmapGroupLighting( LIGHTJOB * Job )
+{
+	LVLGROUP * Group;
+	bool	ok;
+	int		execbuf;
+
+	Group = &Job->Mloadheader->Group[ Job->group ];
+	ok = true;
+	for( execbuf = 0 ; execbuf < Group->num_execbufs ; execbuf++ )
+	{
+		if( !Job->verts[ execbuf ] )
+			continue;
+		if( !FSUnlockVertexBuffer( (RENDEROBJECT*) &Group->renderObject[ execbuf ] ) )
+			ok = false;
+		Job->verts[ execbuf ] = NULL;
+	}
+	return ok;
+}
+
+/*===================================================================
+	Procedure	:	Map the vertex buffers of a group that need new
+				:	colours, has to be on the thread the renderer
+				:	runs on
+	Input		:	MLOADHEADER * , group , LIGHTJOB * to fill in
+	Output		:	bool false if a buffer would not map
+===================================================================*/
+static bool MapGroupLighting( MLOADHEADER * Mloadheader, u_int16_t group, LIGHTJOB * Job )
+{
+	LVLGROUP * Group;
+	bool	incremental;
+	int		execbuf;
+
+	Group = &Mloadheader->Group[ group ];
+	Job->Mloadheader = Mloadheader;
+	Job->group = group;
+	memset( Job->verts, 0, sizeof( Job->verts ) );
+	memset( Job->dirty, 0, sizeof( Job->dirty ) );
+
+	// plain lighting can be redone just where it changed, the effects change everywhere
+	Job->num_lights = -1;
+	if( GroupWaterInfo[group] == WATERSTATE_NOWATER && !ShowPlaneRGB && WhiteOut == 0.0F )
+		Job->num_lights = FindGroupLights( Mloadheader, group, Job->lights );
+	incremental = ( Job->num_lights >= 0 && LitGroups[ group ].valid );
+	LitGroups[ group ].valid = false;	// until every execbuf is done
+
+	for( execbuf = 0 ; execbuf < Group->num_execbufs ; execbuf++ )
+	{
+		if( incremental )
+		{
+			// without the room the whole execbuf is simply lit again
+			Job->dirty[ execbuf ] = (u_int8_t *) arena_alloc( &FrameArena, ( Group->numofcells[ execbuf ] + 7 ) >> 3 );
+			if( Job->dirty[ execbuf ] &&
+				!MarkChangedCells( Mloadheader, group, execbuf, Job->lights, Job->num_lights, Job->dirty[ execbuf ] ) &&
+				!PolyAnimChanged( Group, execbuf ) )
+				continue;	// nothing to upload
+		}
+
+		if( !FSLockVertexBuffer( (RENDEROBJECT*) &Group->renderObject[ execbuf ], &Job->verts[ execbuf ] ) )
+		{
+			Job->verts[ execbuf ] = NULL;
+			UnmapGroupLighting( Job );
+			return false;
+		}
+	}
+	return true;
+}
+
+/*===================================================================
+	Procedure	:	Unmap a group lit by LightGroup and remember
+				:	what it is lit with now
+	Input		:	LIGHTJOB *
+	Output		:	bool false if a buffer would not unmap
+===================================================================*/
+static bool UnmapLitGroup( LIGHTJOB * Job )
+{
+	u_int32_t key[ MEMO_KEY_WORDS ];
+	u_int32_t value[ MEMO_VALUE_WORDS ];
+	u_int16_t group;
+
+	if( !UnmapGroupLighting( Job ) )
+		return false;
+
+	group = Job->group;
+	LitGroups[ group ].valid = ( Job->num_lights >= 0 );
+	if( Job->num_lights >= 0 )
+	{
+		LitGroups[ group ].num_lights = Job->num_lights;
+		memcpy( LitGroups[ group ].lights, Job->lights, Job->num_lights * sizeof( LITLIGHT ) );
+	}
+
+	GroupLitKey( group, key );
+	memset( value, 0, sizeof( value ) );
+	memo_store( MEMO_XLight1Group, key, value );
+
+	return true;
+}
+
+#ifdef VLIGHT_LIGHTING
+/*===================================================================
+		Vertex light kernels...
+===================================================================*/
+static float *	ModelRows = NULL;		// x, y then z of the model execbuf being lit
+static u_int32_t	ModelRowsSize = 0;	// floats
+
+static void SetVLight( VLIGHT * Light, XLIGHT * XLightPnt )
+{
+	Light->spot = ( XLightPnt->Type == SPOT_LIGHT );
+	Light->x = XLightPnt->Pos.x;
+	Light->y = XLightPnt->Pos.y;
+	Light->z = XLightPnt->Pos.z;
+	Light->size = XLightPnt->Size;
+	Light->r = XLightPnt->r;
+	Light->g = XLightPnt->g;
+	Light->b = XLightPnt->b;
+	Light->dirx = XLightPnt->Dir.x;
+	Light->diry = XLightPnt->Dir.y;
+	Light->dirz = XLightPnt->Dir.z;
+	Light->cos_arc = XLightPnt->CosArc;
+}
+
+// every vertex moved into the world once, not once for each light that reaches it
+static float * TransformModelRows( LPLVERTEX lpPointer, int num, MATRIX * Matrix, u_int32_t * pitch )
+{
+	VECTOR	Temp;
+	float *	rows;
+	int		vert;
+
+	*pitch = num + VLIGHT_PAD;
+	if( 3 * *pitch > ModelRowsSize )
+	{
+		rows = (float *) realloc( ModelRows, 3 * *pitch * sizeof( float ) );
+		if( !rows )
+			return NULL;
+		ModelRows = rows;
+		ModelRowsSize = 3 * *pitch;
+		memset( ModelRows, 0, ModelRowsSize * sizeof( float ) );
+	}
+
+	for( vert = 0 ; vert < num ; vert++ )
+	{
+		ApplyMatrix( Matrix, (VECTOR*) &lpPointer[ vert ], &Temp );
+		ModelRows[ vert ] = Temp.x;
+		ModelRows[ *pitch + vert ] = Temp.y;
+		ModelRows[ 2 * *pitch + vert ] = Temp.z;
+	}
+
+	return ModelRows;
+}
+#endif
+
+/*===================================================================
+	Procedure	:	Light a run of vertices one at a time, the loops
+				:	XLight1Group used before the vlight kernels and
+				:	what bench_light checks every kernel against
+	Input		:	XLIGHT *, LPLVERTEX, u_int16_t * index, int count
+	Output		:	nothing
+===================================================================*/
+void XLightVertsScalar( XLIGHT * XLightPnt, LPLVERTEX lpPointer, u_int16_t * VertexIndexPnt, int vert )
+{
+	LPLVERTEX	lpLVERTEX;
+	COLOR col;
 	float	blf;
 	float	glf;
 	float	rlf;
+	float	distance;
+	float	Size,OSize;
+	float	SizeX2;
+	float	x,y,z;
+	float	Posx,Posy,Posz;
+	float	Dirx = 0.0f, Diry = 0.0f, Dirz = 0.0f;
+	float	Cosa,CosArc = 0.0f;
+	float	rlen;
+	float	intense;
+	u_int32_t	tempiR;
+	u_int32_t	tempiG;
+	u_int32_t	tempiB;
+	u_int32_t	tempiA;
+	u_int32_t inc;
+	u_int32_t carry;
+	u_int32_t clamp;
+
+	Posx = XLightPnt->Pos.x;
+	Posy = XLightPnt->Pos.y;
+	Posz = XLightPnt->Pos.z;
+	OSize  = XLightPnt->Size;
+
+	SizeX2 = OSize * OSize;
+	Size = 1 / SizeX2;
+	rlf	= XLightPnt->r; 
+	glf	= XLightPnt->g; 
+	blf	= XLightPnt->b;
+
+	/* bjd curr driver = 0 use to be software mode
+	if(!render_info.CurrDriver ) // is it ramp mode..
+	{
+		rlf = ( rlf+glf+blf ) * 0.33333F;
+		glf = rlf;
+		blf = glf;
+	}
+	*/
+
+	if( XLightPnt->Type == SPOT_LIGHT )
+	{
+		Dirx = XLightPnt->Dir.x;
+		Diry = XLightPnt->Dir.y;
+		Dirz = XLightPnt->Dir.z;
+		CosArc = XLightPnt->CosArc;
+	}
+
+	switch( XLightPnt->Type )
+	{
+	case POINT_LIGHT:
+#ifdef	USEASM
+		start_chop();
+#endif	//USEASM
+		while( vert-- )
+		{
+//											NumOfVertsConsidered++;
+			lpLVERTEX = lpPointer + *VertexIndexPnt++;
+			/* find the distance from vert to light */
+			x = lpLVERTEX->x;
+			y = lpLVERTEX->y;
+			z = lpLVERTEX->z;
+			x -= Posx;
+			y -= Posy;
+			z -= Posz;
+			
+			
+			distance = (x*x) + (y*y) + (z*z);
+//											distance = 0.0F;			
+			if ( distance <  SizeX2  )					// float
+			{
+				//											NumOfVertsTouched++;
+				distance = 1.0F - ( distance * Size );	// float
+#ifdef	USEASM
+__asm
+{
+#if 1		
+						fld		rlf				;float load rlf
+						fmul	distance		;float mul distance 2
+						fld		blf				;float load blf
+						fmul	distance		;float mul distance	1
+						fld		glf				;float load glf
+						fmul	distance		;float mul distance	0
+						fxch	st(2)
+						fistp	tempiR			;float int store tempiR
+						fxch	st(1)
+						fistp	tempiG			;float int store tempiG
+						fxch	st(0)
+						fistp	tempiB			;float int store tempiG
+			
+ 												mov	esi , [lpLVERTEX];set up the pointer
+				mov	ecx , [esi+16]		;int ecx = col   get the color
+
+				mov edi , ecx			; edi = col..
+				and ecx , 0x00ffffff	; and out the alpha
+				and edi , 0xff000000	; keep the alpha for later
+				
+				mov ebx , tempiR		;move the red into inc
+				mov edx , ecx			;edx = col
+				shl ebx , 8				;shift it up 8 bits
+				or  ebx , tempiG		;or in the green
+				shl ebx , 8				;shift it up 8 bits
+				or  ebx , tempiB		;or in the Blue
+			
+			
+#else		
+			
+			
+						fld rlf					;float load rlf        
+						fmul distance			;float mul distance    
+ 												mov	esi , [lpLVERTEX];set up the pointer
+						fistp tempiR			;float int store tempiR
+				mov	ecx , [esi+16]		;int ecx = col   get the color
+						fld glf					;float load glf
+						fmul distance			;float mul distance
+
+				mov edi , ecx			; edi = col..
+				and ecx , 0x00ffffff	; and out the alpha
+				and edi , 0xff000000	; keep the alpha for later
+
+				mov ebx , tempiR		;move the red into inc
+						fistp	tempiG			;float int store tempiG
+				shl ebx , 8				;shift it up 8 bits
+						fld blf					;float load blf
+						fmul distance			;float mul distance
+				or  ebx , tempiG		;or in the green
+				mov edx , ecx			;edx = col
+						fistp	tempiB			;float int store tempiG
+				shl ebx , 8				;shift it up 8 bits
+				or  ebx , tempiB		;or in the Blue
+#endif
+				add ecx , ebx			;ecx = col + inc
+				xor edx , ebx			;edx = col ^ inc
+				xor edx , ecx			;edx = ( col + inc ) ^ ( col ^ inc )
+				and edx	, 0x01010100	;edx = carry = ( ( col + inc ) ^ ( col ^ inc ) ) & 0x01010100
+				mov eax , edx			;eax = carry
+				shr	edx , 8				;edx = ( carry >> 8 )
+				sub eax , edx			;eax = clamp = carry - ( carry >> 8 )
+				sub ecx , edx			;ecx = (col + inc) - carry
+				or  ecx , eax			;col = ecx | clamp
+			
+				or  ecx , edi			; or back in the alpha..
+
+				mov [esi+16] , ecx		;int put the color back
+				// carry = ( ( col + inc ) ^ ( col ^ inc ) ) & 0x01010100;
+				// clamp = carry - ( carry >> 8 );
+				// col = ( col + inc - carry ) | clamp;
+			}
+
+#else	//USEASM
+
+
+				col = lpLVERTEX->color;
+#ifdef TESTING_SUBTRACTIVE
+				tempiA = col & 0xff000000;
+				// for subtraction, simply add the negative
+				tempiR = ( (int) -( rlf * distance ) ) & 0xFF;
+				tempiG = ( (int) -( glf * distance ) ) & 0xFF;
+				tempiB = ( (int) -( blf * distance ) ) & 0xFF;
+				// so far so much nearly the same...
+				inc = ( tempiR << 16 ) + ( tempiG << 8 ) + tempiB;
+				carry = ( ( col + inc ) ^ ( col ^ inc ) ) & 0x01010100;
+				col = col + inc - carry;
+				// set the carry also for those channels where we are subtracting 0 (this seems wrong!)
+				// where 0 components are detected by inverting the inc
+				// adding 1, and checking the carry out
+				inc = inc ^ 0x00FFFFFF;
+				carry |= ( ( inc + 0x00010101) ^ ( inc ^ 0x00010101 ) ) & 0x01010100;
+				// ...and now it's nearly the same as for additive saturation
+				clamp = carry - ( carry >> 8 );
+				col = ( col & clamp ) & 0x00ffffff;
+				col |= tempiA;
+#else
+				tempiA = col & 0xff000000;
+				tempiR = (int) ( rlf * distance );
+				tempiG = (int) ( glf * distance );
+				tempiB = (int) ( blf * distance );
+				inc = ( tempiR << 16 ) + ( tempiG << 8 ) + tempiB;
+				carry = ( ( col + inc ) ^ ( col ^ inc ) ) & 0x01010100;
+				clamp = carry - ( carry >> 8 );
+				col = ( ( col + inc - carry ) | clamp) & 0x00ffffff;
+				col |= tempiA;
+#endif
+			
+				lpLVERTEX->color = col;
+#endif	//USEASM
+			}
+		}
+#ifdef USEASM
+		end_chop();
+#endif
+		break;
+	case SPOT_LIGHT:
+		while( vert-- )
+		{
+//											NumOfVertsConsidered++;
+//											lpLVERTEX = ((LPLVERTEX ) lpPointer) + *VertexIndexPnt++;
+			lpLVERTEX = lpPointer + *VertexIndexPnt++;
+			/* find the distance from vert to light */
+			x = lpLVERTEX->x - Posx;
+			y = lpLVERTEX->y - Posy;
+			z = lpLVERTEX->z - Posz;
+			//distance = (float) sqrt( (x*x) + (y*y) + (z*z)); 
+			distance = (x*x) + (y*y) + (z*z); 
+					
+			if ( distance <  SizeX2  )
+			{
+//												NumOfVertsTouched++;
+							
+				if( distance > 0.0F )
+				{
+					distance = (float) sqrt( distance );
+					rlen = 1.0F / distance;
+					x *= rlen;
+					y *= rlen;
+					z *= rlen;
+				}
+				Cosa = ( ( x*Dirx ) + ( y*Diry ) + ( z*Dirz ) );
+				
+				if( distance > 0.5F * OSize )
+				{
+					if ( Cosa > CosArc )
+					{
+						// Lights Are Go....
+						intense = ( ( OSize - distance ) / ( 0.75F * OSize ) ) * ( ( Cosa - CosArc ) / ( 1.0F - CosArc ) );
+					}else{
+						continue;
+					}
+				}else if ( distance > MIN_LIGHT_SIZE ) {
+					float cosarc2;
+					
+					cosarc2 = CosArc * ( 1.0F - ( ( OSize * 0.5F - distance ) / ( OSize * 0.5F - MIN_LIGHT_SIZE ) ) );
+					if ( Cosa > cosarc2 )
+					{
+						intense = ( ( OSize - distance ) / ( OSize - MIN_LIGHT_SIZE ) ) * ( ( Cosa - cosarc2 ) / ( 1.0F - cosarc2 ) );
+					}else{
+						continue;
+					}
+				}else {
+					if ( Cosa > 0.0F )
+					{
+						intense = 1.0F;
+					}else{
+						intense = 1.0F + Cosa;
+					}
+				}
+				
+				col =  lpLVERTEX->color;				// int
+				tempiA = col & 0xff000000;
+				tempiR = (int) ( rlf * intense );
+				tempiG = (int) ( glf * intense );
+				tempiB = (int) ( blf * intense );
+				inc = ( tempiR << 16 ) + ( tempiG << 8 ) + tempiB;
+				carry = ( ( col + inc ) ^ ( col ^ inc ) ) & 0x01010100;
+				clamp = carry - ( carry >> 8 );
+				col = ( ( col + inc - carry ) | clamp) & 0x00ffffff;
+				col |= tempiA;
+				lpLVERTEX->color = col;
+			}
+		}
+		break;
+	}
+}
+
+/*===================================================================
+	Procedure	:	Work out the colours of the mapped execbufs of
+				:	a group, nothing it touches is used by another
+				:	group so any number can be lit at once
+	Input		:	LIGHTJOB *
+	Output		:	nothing
+===================================================================*/
+float	cral = 0.0F;
+
+
+static void LightGroup( LIGHTJOB * Job )
+{
+	MLOADHEADER * Mloadheader = Job->Mloadheader;
+	u_int16_t group = Job->group;
+	XLIGHT * XLightPnt;
 	VECTOR	Temp;
 	VECTOR	CellIndex;
-	float	distance;
 	int		execbuf;
 	int		vert;
     LPLVERTEX	lpPointer = NULL;
@@ -249,7 +930,6 @@ bool	XLight1Group( MLOADHEADER * Mloadheader, u_int16_t group )
 	LPLVERTEX	lpLVERTEX2 = NULL;
 	COLOR col;
 	VERTEXCELL * VertexCellPnt;
-	u_int16_t * VertexIndexPnt;
 	u_int16_t * OrgVertexIndexPnt;
 	int	Cell;
 	int	CellIndex_x;
@@ -265,71 +945,43 @@ bool	XLight1Group( MLOADHEADER * Mloadheader, u_int16_t group )
 	int		NumOfyCells;
 	int		NumOfzCells;
 	float	CellSize;
-	float	Size,OSize;
-	float	SizeX2;
+	float	OSize;
 	float	x,y,z;
 	float	Posx,Posy,Posz;
-	float	Dirx = 0.0f, Diry = 0.0f, Dirz = 0.0f;
-	float	Cosa,CosArc = 0.0f;
-	float	rlen;
-	float	intense;
-	u_int32_t	tempiR;
-	u_int32_t	tempiG;
-	u_int32_t	tempiB;
-	u_int32_t	tempiA;
 	float	centerx;  
 	float	centery;  
 	float	centerz;  
 	float	half_sizex;
 	float	half_sizey;
 	float	half_sizez;
-	u_int32_t inc;
-	u_int32_t carry;
-	u_int32_t clamp;
 	u_int32_t r,g,b,intWhiteOut;
 	POLYANIM * PolyAnim;
 	int i,e;
 	u_int32_t * u_int32Pnt;
 	TANIMUV * TanimUV;
 	float	intensity;
-
-#ifdef NEW_LIGHTING
-	render_lighting_enabled = 1;
-	render_lighting_point_lights_only = 0;
-	
-	if( WhiteOut != 0.0f )
-		render_lighting_env_whiteout = (int) WhiteOut;
-	
-	if(GroupWaterInfo[group] != WATERSTATE_NOWATER)
-	{
-		render_lighting_env_water = 1;
-		if( GroupWaterInfo[group] != WATERSTATE_ALLWATER )
-		{
-			render_lighting_env_water = 2;
-			render_lighting_env_water_level = GroupWaterLevel[group];
-		}
-		render_lighting_env_water_red = GroupWaterIntensity_Red[group];
-		render_lighting_env_water_green = GroupWaterIntensity_Green[group];
-		render_lighting_env_water_blue= GroupWaterIntensity_Blue[group];
-	}
-	return true;
+	u_int8_t * Dirty;
+#ifdef VLIGHT_LIGHTING
+	VLIGHT	Light;
+	float *	Rows;
+	u_int32_t	Pitch;
 #endif
 
+
 	intWhiteOut = (int)WhiteOut;
 	if( intWhiteOut >= 256 )
 	{
 		intWhiteOut = (256 - (intWhiteOut-256) );
 	}
 
-	
 	CellSize = Mloadheader->CellSize;
 	execbuf = Mloadheader->Group[group].num_execbufs;
 	while( execbuf--)
 	{
-		if (!(FSLockVertexBuffer((RENDEROBJECT*)&Mloadheader->Group[group].renderObject[execbuf], &lpPointer)))
-		{
-			return false;
-		}	
+		lpPointer = Job->verts[ execbuf ];
+		if( !lpPointer )
+			continue;	// nothing to upload
+		Dirty = Job->dirty[ execbuf ];
 
 //		lpPointer = (LPLVERTEX) debDesc.lpData;
 
@@ -372,6 +1024,11 @@ bool	XLight1Group( MLOADHEADER * Mloadheader, u_int16_t group )
 		
 		
 		lpLVERTEX = lpPointer;
+		if( Dirty )
+		{
+			RestoreChangedCells( &Mloadheader->Group[group], execbuf, lpPointer, Dirty );
+		}
+		else
 		{
 			lpLVERTEX2 = Mloadheader->Group[group].originalVerts[execbuf];
 			
@@ -558,30 +1215,6 @@ clear:					mov		eax, [esi]
 						 (Temp.y <= ( half_sizey + OSize ) ) &&
 						 (Temp.z <= ( half_sizez + OSize ) ) )
 					{
-						SizeX2 = OSize * OSize;
-						Size = 1 / SizeX2;
-						rlf	= XLightPnt->r; 
-						glf	= XLightPnt->g; 
-						blf	= XLightPnt->b;
-
-						/* bjd curr driver = 0 use to be software mode
-						if(!render_info.CurrDriver ) // is it ramp mode..
-						{
-							rlf = ( rlf+glf+blf ) * 0.33333F;
-							glf = rlf;
-							blf = glf;
-						}
-						*/
-
-						if( XLightPnt->Type == SPOT_LIGHT )
-						{
-							Dirx = XLightPnt->Dir.x;
-							Diry = XLightPnt->Dir.y;
-							Dirz = XLightPnt->Dir.z;
-							CosArc = XLightPnt->CosArc;
-						}
-				
-					
 						CellIndex.x = Posx - Mloadheader->Group[group].cell_origin[execbuf].x;
 						CellIndex.y = Posy - Mloadheader->Group[group].cell_origin[execbuf].y;
 						CellIndex.z = Posz - Mloadheader->Group[group].cell_origin[execbuf].z;
@@ -637,277 +1270,146 @@ clear:					mov		eax, [esi]
 								CellRange_z = NumOfzCells-1;
 						}
 					
-						switch( XLightPnt->Type )
+#ifdef VLIGHT_LIGHTING
+						SetVLight( &Light, XLightPnt );
+						Rows = Mloadheader->Group[group].vertex_rows[execbuf];
+						Pitch = Mloadheader->Group[group].num_vertex_indices[execbuf] + VLIGHT_PAD;
+#endif	//VLIGHT_LIGHTING
+						Cellz = CellIndex_z;
+						while( Cellz <= CellRange_z )
 						{
-						case POINT_LIGHT:
-							Cellz = CellIndex_z;
-#ifdef	USEASM
-							start_chop();
-#endif	//USEASM
-			
-							while( Cellz <= CellRange_z )
-							{			   
-								Celly = CellIndex_y;
-								while( Celly <= CellRange_y )
-								{
-									Cell = ( CellIndex_x + NumOfxCells *
-										   ( Celly + NumOfyCells *
-										     Cellz ) );
-									Cellx = CellRange_x - CellIndex_x + 1;
-									
-									while( Cellx-- )
-									{
-										VertexIndexPnt = OrgVertexIndexPnt+VertexCellPnt[Cell].start_vert_in_cell;
-										vert = VertexCellPnt[Cell].num_verts_in_cell;
-			
-										while( vert-- )
-										{
-//											NumOfVertsConsidered++;
-											lpLVERTEX = lpPointer + *VertexIndexPnt++;
-											/* find the distance from vert to light */
-											x = lpLVERTEX->x;
-											y = lpLVERTEX->y;
-											z = lpLVERTEX->z;
-											x -= Posx;
-											y -= Posy;
-											z -= Posz;
-			
-			
-											distance = (x*x) + (y*y) + (z*z);
-//											distance = 0.0F;			
-											if ( distance <  SizeX2  )					// float
-											{
-												//											NumOfVertsTouched++;
-												distance = 1.0F - ( distance * Size );	// float
-#ifdef	USEASM
-__asm
-{
-#if 1		
-														fld		rlf				;float load rlf
-														fmul	distance		;float mul distance 2
-														fld		blf				;float load blf
-														fmul	distance		;float mul distance	1
-														fld		glf				;float load glf
-														fmul	distance		;float mul distance	0
-														fxch	st(2)
-														fistp	tempiR			;float int store tempiR
-														fxch	st(1)
-														fistp	tempiG			;float int store tempiG
-														fxch	st(0)
-														fistp	tempiB			;float int store tempiG
-			
- 												mov	esi , [lpLVERTEX];set up the pointer
-												mov	ecx , [esi+16]		;int ecx = col   get the color
-
-												mov edi , ecx			; edi = col..
-												and ecx , 0x00ffffff	; and out the alpha
-												and edi , 0xff000000	; keep the alpha for later
-												
-												mov ebx , tempiR		;move the red into inc
-												mov edx , ecx			;edx = col
-												shl ebx , 8				;shift it up 8 bits
-												or  ebx , tempiG		;or in the green
-												shl ebx , 8				;shift it up 8 bits
-												or  ebx , tempiB		;or in the Blue
-			
-			
-#else		
-			
-			
-														fld rlf					;float load rlf        
-														fmul distance			;float mul distance    
- 												mov	esi , [lpLVERTEX];set up the pointer
-														fistp tempiR			;float int store tempiR
-												mov	ecx , [esi+16]		;int ecx = col   get the color
-														fld glf					;float load glf
-														fmul distance			;float mul distance
-
-												mov edi , ecx			; edi = col..
-												and ecx , 0x00ffffff	; and out the alpha
-												and edi , 0xff000000	; keep the alpha for later
-
-												mov ebx , tempiR		;move the red into inc
-														fistp	tempiG			;float int store tempiG
-												shl ebx , 8				;shift it up 8 bits
-														fld blf					;float load blf
-														fmul distance			;float mul distance
-												or  ebx , tempiG		;or in the green
-												mov edx , ecx			;edx = col
-														fistp	tempiB			;float int store tempiG
-												shl ebx , 8				;shift it up 8 bits
-												or  ebx , tempiB		;or in the Blue
-#endif
-												add ecx , ebx			;ecx = col + inc
-												xor edx , ebx			;edx = col ^ inc
-												xor edx , ecx			;edx = ( col + inc ) ^ ( col ^ inc )
-												and edx	, 0x01010100	;edx = carry = ( ( col + inc ) ^ ( col ^ inc ) ) & 0x01010100
-												mov eax , edx			;eax = carry
-												shr	edx , 8				;edx = ( carry >> 8 )
-												sub eax , edx			;eax = clamp = carry - ( carry >> 8 )
-												sub ecx , edx			;ecx = (col + inc) - carry
-												or  ecx , eax			;col = ecx | clamp
-			
-												or  ecx , edi			; or back in the alpha..
-
-												mov [esi+16] , ecx		;int put the color back
-												// carry = ( ( col + inc ) ^ ( col ^ inc ) ) & 0x01010100;
-												// clamp = carry - ( carry >> 8 );
-												// col = ( col + inc - carry ) | clamp;
-											}
-
-#else	//USEASM
-
-
-												col = lpLVERTEX->color;
-#ifdef TESTING_SUBTRACTIVE
-												tempiA = col & 0xff000000;
-												// for subtraction, simply add the negative
-												tempiR = ( (int) -( rlf * distance ) ) & 0xFF;
-												tempiG = ( (int) -( glf * distance ) ) & 0xFF;
-												tempiB = ( (int) -( blf * distance ) ) & 0xFF;
-												// so far so much nearly the same...
-												inc = ( tempiR << 16 ) + ( tempiG << 8 ) + tempiB;
-												carry = ( ( col + inc ) ^ ( col ^ inc ) ) & 0x01010100;
-												col = col + inc - carry;
-												// set the carry also for those channels where we are subtracting 0 (this seems wrong!)
-												// where 0 components are detected by inverting the inc
-												// adding 1, and checking the carry out
-												inc = inc ^ 0x00FFFFFF;
-												carry |= ( ( inc + 0x00010101) ^ ( inc ^ 0x00010101 ) ) & 0x01010100;
-												// ...and now it's nearly the same as for additive saturation
-												clamp = carry - ( carry >> 8 );
-												col = ( col & clamp ) & 0x00ffffff;
-												col |= tempiA;
-#else
-												tempiA = col & 0xff000000;
-												tempiR = (int) ( rlf * distance );
-												tempiG = (int) ( glf * distance );
-												tempiB = (int) ( blf * distance );
-												inc = ( tempiR << 16 ) + ( tempiG << 8 ) + tempiB;
-												carry = ( ( col + inc ) ^ ( col ^ inc ) ) & 0x01010100;
-												clamp = carry - ( carry >> 8 );
-												col = ( ( col + inc - carry ) | clamp) & 0x00ffffff;
-												col |= tempiA;
-#endif
-			
-												lpLVERTEX->color = col;
-#endif	//USEASM
-											}
-										}
-			
-										Cell++;
-									}
-									Celly++;
-								}
-								Cellz++;
-							}
-#ifdef USEASM
-							end_chop();
-#endif		
-							break;
-						case SPOT_LIGHT:
-							Cellz = CellIndex_z;
-							while( Cellz <= CellRange_z )
+							Celly = CellIndex_y;
+							while( Celly <= CellRange_y )
 							{
-								Celly = CellIndex_y;
-								while( Celly <= CellRange_y )
+								Cell = ( CellIndex_x + NumOfxCells *
+									   ( Celly + NumOfyCells *
+									     Cellz ) );
+								Cellx = CellRange_x - CellIndex_x + 1;
+
+								while( Cellx-- )
 								{
-									Cell = (u_int16_t) ( CellIndex_x + NumOfxCells *
-										            ( Celly + NumOfyCells *
-										              Cellz ) );
-									Cellx = CellRange_x - CellIndex_x + 1;
-									
-									while( Cellx-- )
+									if( !Dirty || ( Dirty[ Cell >> 3 ] & ( 1 << ( Cell & 7 ) ) ) )
 									{
-										VertexIndexPnt = OrgVertexIndexPnt+VertexCellPnt[Cell].start_vert_in_cell;
-										vert = VertexCellPnt[Cell].num_verts_in_cell;
-										while( vert-- )
-										{
-//											NumOfVertsConsidered++;
-//											lpLVERTEX = ((LPLVERTEX ) lpPointer) + *VertexIndexPnt++;
-											lpLVERTEX = lpPointer + *VertexIndexPnt++;
-											/* find the distance from vert to light */
-											x = lpLVERTEX->x - Posx;
-											y = lpLVERTEX->y - Posy;
-											z = lpLVERTEX->z - Posz;
-											//distance = (float) sqrt( (x*x) + (y*y) + (z*z)); 
-											distance = (x*x) + (y*y) + (z*z); 
-					
-											if ( distance <  SizeX2  )
-											{
-//												NumOfVertsTouched++;
-							
-												if( distance > 0.0F )
-												{
-													distance = (float) sqrt( distance );
-													rlen = 1.0F / distance;
-													x *= rlen;
-													y *= rlen;
-													z *= rlen;
-												}
-												Cosa = ( ( x*Dirx ) + ( y*Diry ) + ( z*Dirz ) );
-												
-												if( distance > 0.5F * OSize )
-												{
-													if ( Cosa > CosArc )
-													{
-														// Lights Are Go....
-														intense = ( ( OSize - distance ) / ( 0.75F * OSize ) ) * ( ( Cosa - CosArc ) / ( 1.0F - CosArc ) );
-													}else{
-														continue;
-													}
-												}else if ( distance > MIN_LIGHT_SIZE ) {
-													float cosarc2;
-					
-													cosarc2 = CosArc * ( 1.0F - ( ( OSize * 0.5F - distance ) / ( OSize * 0.5F - MIN_LIGHT_SIZE ) ) );
-													if ( Cosa > cosarc2 )
-													{
-														intense = ( ( OSize - distance ) / ( OSize - MIN_LIGHT_SIZE ) ) * ( ( Cosa - cosarc2 ) / ( 1.0F - cosarc2 ) );
-													}else{
-														continue;
-													}
-												}else {
-													if ( Cosa > 0.0F )
-													{
-														intense = 1.0F;
-													}else{
-														intense = 1.0F + Cosa;
-													}
-												}
-												
-												col =  lpLVERTEX->color;				// int
-												tempiA = col & 0xff000000;
-												tempiR = (int) ( rlf * intense );
-												tempiG = (int) ( glf * intense );
-												tempiB = (int) ( blf * intense );
-												inc = ( tempiR << 16 ) + ( tempiG << 8 ) + tempiB;
-												carry = ( ( col + inc ) ^ ( col ^ inc ) ) & 0x01010100;
-												clamp = carry - ( carry >> 8 );
-												col = ( ( col + inc - carry ) | clamp) & 0x00ffffff;
-												col |= tempiA;
-												lpLVERTEX->color = col;
-											}
-										}
-										Cell++;
+										vert = VertexCellPnt[Cell].start_vert_in_cell;
+#ifdef VLIGHT_LIGHTING
+										vlight_add( &Light, &Rows[ vert ], &Rows[ Pitch + vert ], &Rows[ 2 * Pitch + vert ],
+													&OrgVertexIndexPnt[ vert ], lpPointer, VertexCellPnt[Cell].num_verts_in_cell );
+#else	//VLIGHT_LIGHTING
+										XLightVertsScalar( XLightPnt, lpPointer, &OrgVertexIndexPnt[ vert ], VertexCellPnt[Cell].num_verts_in_cell );
+#endif	//VLIGHT_LIGHTING
 									}
-									Celly++;
+									Cell++;
 								}
-								Cellz++;
+								Celly++;
 							}
-							break;
-					
+							Cellz++;
 						}
 					}
 				}
 				XLightPnt = XLightPnt->NextVisible;
 			}
 		}
-		/*	unlock the execute buffer	*/
-		if(!FSUnlockVertexBuffer((RENDEROBJECT*)&Mloadheader->Group[group].renderObject[execbuf]))
-			return false;
 	}
+}
+
+static void LightGroupJob( void * data, int i )
+{
+	LightGroup( &( (LIGHTJOB *) data )[ i ] );
+}
+
+/*===================================================================
+	Procedure	:	Xlight 1 Group Only...
+	Input		:	MLOADHEADER * , group
+	Output		:	bool false if a vertex buffer would not map
+===================================================================*/
+bool	XLight1Group( MLOADHEADER * Mloadheader, u_int16_t group )
+{
+	LIGHTJOB Job;
+
+#ifdef NEW_LIGHTING
+	render_lighting_enabled = 1;
+	render_lighting_point_lights_only = 0;
+	
+	if( WhiteOut != 0.0f )
+		render_lighting_env_whiteout = (int) WhiteOut;
 	
+	if(GroupWaterInfo[group] != WATERSTATE_NOWATER)
+	{
+		render_lighting_env_water = 1;
+		if( GroupWaterInfo[group] != WATERSTATE_ALLWATER )
+		{
+			render_lighting_env_water = 2;
+			render_lighting_env_water_level = GroupWaterLevel[group];
+		}
+		render_lighting_env_water_red = GroupWaterIntensity_Red[group];
+		render_lighting_env_water_green = GroupWaterIntensity_Green[group];
+		render_lighting_env_water_blue= GroupWaterIntensity_Blue[group];
+	}
 	return true;
+#endif
+
+	if( GroupAlreadyLit( group ) )
+		return true;
+
+	if( !MapGroupLighting( Mloadheader, group, &Job ) )
+		return false;
+	LightGroup( &Job );
+	return UnmapLitGroup( &Job );
+}
+
+/*===================================================================
+	Procedure	:	Light every group the camera can see before any
+				:	of them is drawn, the buffers are mapped here
+				:	and the colours worked out on the job threads,
+				:	groups that would not map with the others are
+				:	then lit one at a time
+	Input		:	MLOADHEADER * , number of groups , the groups
+	Output		:	bool false if a vertex buffer would not map
+				:	even on its own
+===================================================================*/
+bool	XLightVisibleGroups( MLOADHEADER * Mloadheader, u_int16_t num, u_int16_t * groups )
+{
+	LIGHTJOB * Jobs;
+	int		num_jobs;
+	int		i, j;
+	bool	ok;
+
+#ifdef NEW_LIGHTING
+	// XLight1Group sets the lights up for each group as it is drawn
+	return true;
+#endif
+
+	// without the room XLight1Group lights them one at a time as they are drawn
+	Jobs = (LIGHTJOB *) arena_alloc( &FrameArena, num * sizeof( LIGHTJOB ) );
+	if( !Jobs )
+		return true;
+
+	num_jobs = 0;
+	for( i = 0 ; i < num ; i++ )
+	{
+		if( GroupAlreadyLit( groups[ i ] ) )
+			continue;
+		if( !MapGroupLighting( Mloadheader, groups[ i ], &Jobs[ num_jobs ] ) )
+			break;
+		num_jobs++;
+	}
+
+	jobs_run( LightGroupJob, Jobs, num_jobs );
+
+	ok = true;
+	for( j = 0 ; j < num_jobs ; j++ )
+	{
+		if( !UnmapLitGroup( &Jobs[ j ] ) )
+			ok = false;
+	}
+
+	// the rest with only one group's buffers mapped at a time
+	for( ; i < num ; i++ )
+	{
+		if( !XLight1Group( Mloadheader, groups[ i ] ) )
+			ok = false;
+	}
+	return ok;
 }
 
 
@@ -921,7 +1423,6 @@ bool	XLightMxloadHeader( MXLOADHEADER * MXloadheader , VECTOR * Pos , float Radi
 {
 	XLIGHT * XLightPnt;
 	VECTOR	Temp;
-	float	distance;
 	int		group;
 	int		execbuf;
 	int		vert;
@@ -929,11 +1430,18 @@ bool	XLightMxloadHeader( MXLOADHEADER * MXloadheader , VECTOR * Pos , float Radi
 
 	LPLVERTEX	lpLVERTEX = NULL;
 	LPLVERTEX	lpLVERTEX2 = NULL;
+	float	OSize;
+	float	Posx,Posy,Posz;
+#ifdef VLIGHT_LIGHTING
+	VLIGHT	Light;
+	float *	Rows;
+	u_int32_t	Pitch = 0;
+#else	//VLIGHT_LIGHTING
+	float	distance;
 	COLOR col;
-	float	Size,OSize;
+	float	Size;
 	float	SizeX2;
 	float	x,y,z;
-	float	Posx,Posy,Posz;
 	float	Dirx = 0.0f, Diry = 0.0f, Dirz = 0.0f;
 	float	Cosa,CosArc = 0.0f;
 	float	rlen;
@@ -948,6 +1456,7 @@ bool	XLightMxloadHeader( MXLOADHEADER * MXloadheader , VECTOR * Pos , float Radi
 	float	blf;
 	float	glf;
 	float	rlf;
+#endif	//VLIGHT_LIGHTING
 
 #ifdef NEW_LIGHTING
 	render_lighting_enabled = 1;
@@ -981,6 +1490,9 @@ bool	XLightMxloadHeader( MXLOADHEADER * MXloadheader , VECTOR * Pos , float Radi
 			}
 		
 
+#ifdef VLIGHT_LIGHTING
+			Rows = NULL;
+#endif
 			XLightPnt = FirstLightVisible;
 			while( XLightPnt )
 			{
@@ -1001,6 +1513,20 @@ bool	XLightMxloadHeader( MXLOADHEADER * MXloadheader , VECTOR * Pos , float Radi
 						 (Temp.y <= ( Radius + OSize ) ) &&
 						 (Temp.z <= ( Radius + OSize ) ) )
 					{
+#ifdef VLIGHT_LIGHTING
+						vert = MXloadheader->Group[group].num_verts_per_execbuf[execbuf];
+						if( !Rows )
+						{
+							Rows = TransformModelRows( lpPointer, vert, Matrix, &Pitch );
+							if( !Rows )
+							{
+								FSUnlockVertexBuffer(&MXloadheader->Group[group].renderObject[execbuf]);
+								return false;
+							}
+						}
+						SetVLight( &Light, XLightPnt );
+						vlight_add( &Light, Rows, &Rows[ Pitch ], &Rows[ 2 * Pitch ], NULL, lpPointer, vert );
+#else	//VLIGHT_LIGHTING
 						SizeX2 = OSize * OSize;
 						Size = 1 / SizeX2;
 						rlf	= XLightPnt->r; 
@@ -1128,6 +1654,7 @@ PLOP:
 							}
 							break;
 						}
+#endif	//VLIGHT_LIGHTING
 					}
 				}
 				XLightPnt = XLightPnt->NextVisible;
@@ -1153,7 +1680,6 @@ bool	XLightMxaloadHeader( MXALOADHEADER * MXloadheader , VECTOR * Pos , float Ra
 {
 	XLIGHT * XLightPnt;
 	VECTOR	Temp;
-	float	distance;
 	int		group;
 	int		execbuf;
 	int		vert;
@@ -1161,11 +1687,18 @@ bool	XLightMxaloadHeader( MXALOADHEADER * MXloadheader , VECTOR * Pos , float Ra
 
 	LPLVERTEX	lpLVERTEX = NULL;
 	LPLVERTEX	lpLVERTEX2 = NULL;
+	float	OSize;
+	float	Posx,Posy,Posz;
+#ifdef VLIGHT_LIGHTING
+	VLIGHT	Light;
+	float *	Rows;
+	u_int32_t	Pitch = 0;
+#else	//VLIGHT_LIGHTING
+	float	distance;
 	COLOR col;
-	float	Size,OSize;
+	float	Size;
 	float	SizeX2;
 	float	x,y,z;
-	float	Posx,Posy,Posz;
 	float	Dirx = 0.0f, Diry = 0.0f, Dirz = 0.0f;
 	float	Cosa,CosArc = 0.0f;
 	float	rlen;
@@ -1180,6 +1713,7 @@ bool	XLightMxaloadHeader( MXALOADHEADER * MXloadheader , VECTOR * Pos , float Ra
 	float	blf;
 	float	glf;
 	float	rlf;
+#endif	//VLIGHT_LIGHTING
 
 #ifdef NEW_LIGHTING
 	render_lighting_enabled = 1;
@@ -1210,6 +1744,9 @@ bool	XLightMxaloadHeader( MXALOADHEADER * MXloadheader , VECTOR * Pos , float Ra
 			}
 		
 
+#ifdef VLIGHT_LIGHTING
+			Rows = NULL;
+#endif
 			XLightPnt = FirstLightVisible;
 			while( XLightPnt )
 			{
@@ -1230,6 +1767,20 @@ bool	XLightMxaloadHeader( MXALOADHEADER * MXloadheader , VECTOR * Pos , float Ra
 						 (Temp.y <= ( Radius + OSize ) ) &&
 						 (Temp.z <= ( Radius + OSize ) ) )
 					{
+#ifdef VLIGHT_LIGHTING
+						vert = MXloadheader->Group[group].num_verts_per_execbuf[execbuf];
+						if( !Rows )
+						{
+							Rows = TransformModelRows( lpPointer, vert, Matrix, &Pitch );
+							if( !Rows )
+							{
+								FSUnlockVertexBuffer(&MXloadheader->Group[group].renderObject[execbuf]);
+								return false;
+							}
+						}
+						SetVLight( &Light, XLightPnt );
+						vlight_add( &Light, Rows, &Rows[ Pitch ], &Rows[ 2 * Pitch ], NULL, lpPointer, vert );
+#else	//VLIGHT_LIGHTING
 						SizeX2 = OSize * OSize;
 						Size = 1 / SizeX2;
 						rlf	= XLightPnt->r; 
@@ -1357,6 +1908,7 @@ PLOP2:
 							}
 							break;
 						}
+#endif	//VLIGHT_LIGHTING
 					}
 				}
 				XLightPnt = XLightPnt->NextVisible;
@@ -1467,6 +2019,16 @@ void BuildVisibleLightList( u_int16_t Group )
 {
 	int		light;
 	XLIGHT * XLightPnt;
+	u_int32_t key[ MEMO_KEY_WORDS ];
+	u_int32_t value[ MEMO_VALUE_WORDS ];
+
+	// lights only move between frames, so a camera in the same group gets the same list
+	memset( key, 0, sizeof( key ) );
+	key[ 0 ] = Group;
+	if( Group == LightListGroup && memo_find( MEMO_LightList, key, value ) )
+		return;
+	LightListGroup = Group;
+	LightListGeneration++;
 
 	light = FirstXLightUsed;
 	FirstLightVisible = NULL;
@@ -1482,6 +2044,9 @@ void BuildVisibleLightList( u_int16_t Group )
 		}
 		light = XLights[light].Prev;
 	}
+
+	memset( value, 0, sizeof( value ) );
+	memo_store( MEMO_LightList, key, value );
 }
 
 /*===================================================================
@@ -1493,11 +2058,13 @@ FILE * SaveXLights( FILE * fp )
 {
 	int		i;
 	u_int16_t	TempIndex = (u_int16_t) -1;
+	u_int16_t	FirstFree;
 
 	if( fp )
 	{
+		FirstFree = pool_free_slot( &XLightPool, 0 );
 		fwrite( &FirstXLightUsed, sizeof( u_int16_t ), 1, fp );
-		fwrite( &FirstXLightFree, sizeof( u_int16_t ), 1, fp );
+		fwrite( &FirstFree, sizeof( u_int16_t ), 1, fp );
 		if( FirstLightVisible  ) fwrite( &FirstLightVisible->Index, sizeof( u_int16_t ), 1, fp );
 		else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
 		
@@ -1537,10 +2104,12 @@ FILE * LoadXLights( FILE * fp )
 	if( fp )
 	{
 		fread( &FirstXLightUsed, sizeof( u_int16_t ), 1, fp );
-		fread( &FirstXLightFree, sizeof( u_int16_t ), 1, fp );
+		fread( &TempIndex, sizeof( u_int16_t ), 1, fp );	// first free, the pool is rebuilt below
 		fread( &TempIndex, sizeof( u_int16_t ), 1, fp );
 		if( TempIndex != (u_int16_t) -1 ) FirstLightVisible = &XLights[ TempIndex ];
 		else FirstLightVisible = NULL;
+		LightListGroup = (u_int16_t) -1;
+		LightListGeneration++;
 		
 		for( i = 0; i < MAXXLIGHTS; i++ )
 		{
@@ -1561,6 +2130,11 @@ FILE * LoadXLights( FILE * fp )
 			if( TempIndex != (u_int16_t) -1 ) XLights[ i ].NextVisible = &XLights[ TempIndex ];
 			else XLights[ i ].NextVisible = NULL;
 		}
+
+		pool_clear( &XLightPool );
+		for( i = FirstXLightUsed; i != (u_int16_t) -1; i = XLights[ i ].Prev )
+			pool_mark( &XLightPool, (u_int16_t) i );
+		pool_rebuild( &XLightPool );
 	}
 
 	return( fp );
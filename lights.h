@@ -30,6 +30,10 @@
 #define	SPOT_LIGHT	1
  
 #define MIN_LIGHT_SIZE	( 1536.0F * GLOBAL_SCALE )
+
+// level and model vertices are lit a step of vertices at a time by the vlight kernels
+#define VLIGHT_LIGHTING
+//#undef VLIGHT_LIGHTING
  
 /*
  * structures
@@ -65,9 +69,12 @@ void	KillUsedXLight(u_int16_t);
 
 void	SetLightDie ( u_int16_t light );
 bool	XLight1Group( MLOADHEADER * Mloadheader, u_int16_t group );
+bool	XLightVisibleGroups( MLOADHEADER * Mloadheader, u_int16_t num, u_int16_t * groups );
+void	ResetGroupLighting( void );
 
 bool	XLightMxloadHeader( MXLOADHEADER * MXloadheader , VECTOR * Pos , float Radius , MATRIX * Matrix );
 bool	XLightMxaloadHeader( MXALOADHEADER * MXAloadheader , VECTOR * Pos , float Radius , MATRIX * Matrix );
+void	XLightVertsScalar( XLIGHT * XLightPnt, LPLVERTEX lpPointer, u_int16_t * VertexIndexPnt, int vert );
 
 
 void	CreateCellColours( MLOADHEADER * Mloadheader );
@@ -12,6 +12,7 @@
 #include "networking.h"
 #include "lines.h"
 #include "camera.h"
+#include "pool.h"
 
 extern	CAMERA	CurrentCamera;
 extern	bool	DebugInfo;
@@ -21,7 +22,7 @@ extern	bool	DebugInfo;
 ===================================================================*/
 LINE	Lines[ MAXLINES ];
 u_int16_t	FirstLineUsed;
-u_int16_t	FirstLineFree;
+pool_t		LinePool;
 
 /*===================================================================
 	Procedure	:	Init Line Structures and Execute buffer
@@ -33,7 +34,7 @@ void InitLines( void )
 	int i;
 
 	FirstLineUsed = (u_int16_t) -1;
-	FirstLineFree = 0;
+	pool_init( &LinePool, "lines", MAXLINES );
 	
 	for( i=0; i < MAXLINES; i++ )
 	{
@@ -49,10 +50,9 @@ void InitLines( void )
 		Lines[i].EndCol.R = 0;
 		Lines[i].EndCol.G = 0;
 		Lines[i].EndCol.B = 0;
-		Lines[i].Next = i + 1;
+		Lines[i].Next = (u_int16_t) -1;
 		Lines[i].Prev = (u_int16_t) -1;
 	}
-	Lines[ MAXLINES-1 ].Next = (u_int16_t) -1;
 }
 
 /*===================================================================
@@ -65,9 +65,10 @@ u_int16_t FindFreeLine( void )
 {
 	u_int16_t i;
 
-	i = FirstLineFree;
-	if( i == (u_int16_t) -1 ) return i;
+	i = pool_alloc( &LinePool );
+	if( i == POOL_NONE ) return i;
  
+	Lines[i].Next = (u_int16_t) -1;
 	Lines[i].Prev = FirstLineUsed;
 
 	if ( FirstLineUsed != (u_int16_t) -1)
@@ -76,7 +77,6 @@ u_int16_t FindFreeLine( void )
 	}
 
 	FirstLineUsed = i;
-	FirstLineFree = Lines[i].Next;
 
 	return i ;
 }
@@ -100,8 +100,8 @@ void KillUsedLine( u_int16_t i )
 	if( its_next != (u_int16_t) -1 ) Lines[ its_next ].Prev = its_prev;
 
 	Lines[i].Prev = (u_int16_t) -1;
-	Lines[i].Next = FirstLineFree;
-	FirstLineFree	= i;
+	Lines[i].Next = (u_int16_t) -1;
+	pool_free( &LinePool, i );
 }
 
 /*===================================================================
@@ -124,7 +124,8 @@ bool LinesDispGroup( u_int16_t Group, /*LPDIRECT3DEXECUTEBUFFER ExecBuffer*/REND
 		return false; // don't display lines if not debugging
 	}
 
-	renderObject->numTextureGroups = 0;
+	if( !RESET_TEXTURE_GROUPS( renderObject ) )
+		return false;
 
 	if( *StartLine != (u_int16_t) -1 )
 	{
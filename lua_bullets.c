@@ -26,9 +26,18 @@
 #include "secondary.h"
 #include "lua_vecmat.h"
 #include "lua_weapons.h"
+#include "pool.h"
 
-extern PRIMARYWEAPONBULLET PrimBulls[MAXPRIMARYWEAPONBULLETS];
-extern SECONDARYWEAPONBULLET SecBulls[MAXSECONDARYWEAPONBULLETS];
+extern PRIMARYWEAPONBULLET * PrimBulls;
+extern SECONDARYWEAPONBULLET * SecBulls;
+extern pool_t PrimBullPool;
+extern pool_t SecBullPool;
+
+/* the tables grow, so every slot their pools can grow to gets an entry
+ * and slots that don't exist yet read as nil, the pools have to be set
+ * up before luaopen_bullets */
+#define PRIMBULL_SLOTS (PrimBullPool.ceiling)
+#define SECBULL_SLOTS (SecBullPool.ceiling)
 
 static void pushprimbull(lua_State *L, u_int16_t index)
 {
@@ -95,6 +104,8 @@ static int luaprimbull_index(lua_State *L)
 	const char *name;
 	int *id;
 	int bullidx = *((int *) luaL_checkudata(L, 1, "PRIMARYWEAPONBULLETIDX"));
+	if (bullidx >= PrimBullPool.size)
+		return 0;
 	bullet = &PrimBulls[bullidx];
 	name = luaL_checkstring(L, 2);
 	/*if (!strcmp(name, "table")) -- TODO
@@ -193,6 +204,8 @@ static int luasecbull_index(lua_State *L)
 	const char *name;
 	int *id;
 	int bullidx = *((int *) luaL_checkudata(L, 1, "SECONDARYWEAPONBULLETIDX"));
+	if (bullidx >= SecBullPool.size)
+		return 0;
 	bullet = &SecBulls[bullidx];
 	name = luaL_checkstring(L, 2);
 	/*if (!strcmp(name, "table")) -- TODO
@@ -202,7 +215,7 @@ static int luasecbull_index(lua_State *L)
 	}
 	else*/ if (!strcmp(name, "index") || !strcmp(name, "Index"))
 	{
-		lua_pushinteger(L, bullidx + 1 + MAXPRIMARYWEAPONBULLETS);
+		lua_pushinteger(L, bullidx + 1 + PRIMBULL_SLOTS);
 		return 1;
 	}
 	else if (!strcmp(name, "category"))
@@ -366,16 +379,16 @@ int luaopen_bullets(lua_State *L)
 	luaL_newmetatable(L, "SECONDARYWEAPONBULLETIDX");
 	luaL_register(L, NULL, secbullmt);
 	lua_pop(L, 1);
-	lua_createtable(L, MAXPRIMARYWEAPONBULLETS + MAXSECONDARYWEAPONBULLETS, 0);
-	for (i=0; i<MAXPRIMARYWEAPONBULLETS; i++)
+	lua_createtable(L, PRIMBULL_SLOTS + SECBULL_SLOTS, 0);
+	for (i=0; i<PRIMBULL_SLOTS; i++)
 	{
 		lua_pushinteger(L, i+1);
 		pushprimbull(L, i);
 		lua_settable(L, -3);
 	}
-	for (i=0; i<MAXSECONDARYWEAPONBULLETS; i++)
+	for (i=0; i<SECBULL_SLOTS; i++)
 	{
-		lua_pushinteger(L, i+1 + MAXPRIMARYWEAPONBULLETS);
+		lua_pushinteger(L, i+1 + PRIMBULL_SLOTS);
 		pushsecbull(L, i);
 		lua_settable(L, -3);
 	}
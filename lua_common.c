@@ -34,6 +34,7 @@
 #include "luasocket.h"
 #include "mime.h"
 #include "main.h"
+#include "perf.h"
 
 lua_State *L1;
 
@@ -74,11 +75,52 @@ static int lua_touch_file(lua_State *state)
 	return 0; // number of results
 }
 
+// perf_overlay() toggles, perf_overlay(bool) sets, returns new state
+static int lua_perf_overlay(lua_State *state)
+{
+	if (lua_isnoneornil(state,1))
+		ShowPerfOverlay = !ShowPerfOverlay;
+	else
+		ShowPerfOverlay = lua_toboolean(state,1);
+	lua_pushboolean(state, ShowPerfOverlay);
+	return 1; // number of results
+}
+
+// returns p50, p99 and worst frame time in milliseconds
+static int lua_perf_stats(lua_State *state)
+{
+	lua_pushnumber(state, perf_percentile(50.0F) / 1000.0);
+	lua_pushnumber(state, perf_percentile(99.0F) / 1000.0);
+	lua_pushnumber(state, perf_worst() / 1000.0);
+	return 3; // number of results
+}
+
+#ifdef DEBUG_ON
+
+extern size_t MemUsed;
+extern int BlocksUsed;
+
+// mem_dump([max_sites]) logs the biggest allocation sites, returns bytes and blocks live
+static int lua_mem_dump(lua_State *state)
+{
+	XMem_Dump( (int) luaL_optinteger(state, 1, 20) );
+	lua_pushnumber(state, (lua_Number) MemUsed);
+	lua_pushinteger(state, BlocksUsed);
+	return 2; // number of results
+}
+
+#endif
+
 static int lua_register_funcs(void)
 {
 	lua_register(L1,"touch_file",lua_touch_file);
 	lua_register(L1,"debug",lua_debug_str);
 	lua_register(L1,"alert",lua_alert);
+	lua_register(L1,"perf_overlay",lua_perf_overlay);
+	lua_register(L1,"perf_stats",lua_perf_stats);
+#ifdef DEBUG_ON
+	lua_register(L1,"mem_dump",lua_mem_dump);
+#endif
 	return 0;
 }
 
@@ -2,8 +2,15 @@
 #include <lua.h>
 #include <lauxlib.h>
 #include "enemies.h"
+#include "pool.h"
 
-extern ENEMY Enemies[MAXENEMIES];
+extern ENEMY * Enemies;
+extern pool_t EnemyPool;
+
+/* the table grows, so every slot its pool can grow to gets an entry
+ * and slots that don't exist yet read as nil, the pool has to be set
+ * up before luaopen_enemies */
+#define ENEMY_SLOTS (EnemyPool.ceiling)
 
 static void pushenemy(lua_State *L, int index)
 {
@@ -34,6 +41,8 @@ static int luaenem_index(lua_State *L)
 	const char *name;
 	void **objptr;
 	int enemyidx = *((int *) luaL_checkudata(L, 1, "ENEMYIDX"));
+	if (enemyidx >= EnemyPool.size)
+		return 0;
 	enemy = &Enemies[enemyidx];
 	name = luaL_checkstring(L, 2);
 	if (!strcmp(name, "index"))
@@ -105,8 +114,8 @@ int luaopen_enemies(lua_State *L)
 	luaL_newmetatable(L, "ENEMYIDX");
 	luaL_register(L, NULL, enemymt);
 	lua_pop(L, 1);
-	lua_createtable(L, MAXENEMIES, 0);
-	for (i=0; i<MAXENEMIES; i++)
+	lua_createtable(L, ENEMY_SLOTS, 0);
+	for (i=0; i<ENEMY_SLOTS; i++)
 	{
 		lua_pushinteger(L, i+1);
 		pushenemy(L, i);
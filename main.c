@@ -14,6 +14,9 @@
 #include <SDL.h>
 #include "input.h"
 #include "sound.h"
+#include "perf.h"
+#include "vlight.h"
+#include "jobs.h"
 
 #ifndef WIN32
 #include <unistd.h>
@@ -32,6 +35,7 @@ bool ShowFrameRate = false;
 bool ShowInfo = false;
 
 int cliSleep = 0;
+int cliThreads = -1;
 
 render_info_t render_info;
 
@@ -291,6 +295,9 @@ static bool ParseCommandLine(char* lpCmdLine)
 			// sleep time for every loop
 			else if ( sscanf( option, "sleep:%d", &cliSleep )){}
 
+			// worker threads for the lighting, 0 lights everything on the main thread
+			else if ( sscanf( option, "threads:%d", &cliThreads )){}
+
 			// select the pilot
 			else if ( sscanf( option , "pilot:%s", config_name )){}
 
@@ -382,6 +389,9 @@ void CleanUpAndPostQuit(void)
 
 #endif
 
+	// stop the worker threads
+	jobs_shutdown();
+
 	// should come last
 	SDL_Quit();
 }
@@ -466,6 +476,9 @@ static bool AppInit( char * lpCmdLine )
 	if(missing_folders())
 		return false;
 
+	// pick the vertex light kernel for this cpu
+	vlight_init();
+
 	// startup lua
 	if( lua_init() != 0 )
 		return false;
@@ -480,6 +493,9 @@ static bool AppInit( char * lpCmdLine )
 	if(!ParseCommandLine(lpCmdLine))
 		return false;
 
+	// start the worker threads
+	jobs_init( cliThreads );
+
 	//
 	// create and show the window
 	//
@@ -564,11 +580,13 @@ static bool RenderLoop()
 #endif
 		{
 			// this is the actual call to render a frame...
+			perf_zone_begin( PERF_ZONE_Flip );
 			if (!render_flip(&render_info))
 			{
 				Msg("RenderLoop: render_flip() failed\n");
 				return false;
 			}
+			perf_zone_end( PERF_ZONE_Flip );
 		}
 	}
 
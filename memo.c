@@ -0,0 +1,122 @@
+#include <string.h>
+#include "main.h"
+#include "memo.h"
+
+typedef struct {
+	u_int32_t	stamp;		// answers from any other stamp are stale
+	u_int32_t	key[ MEMO_KEY_WORDS ];
+	u_int32_t	value[ MEMO_VALUE_WORDS ];
+} MEMO_ENTRY;
+
+static MEMO_ENTRY	memo_table[ MEMO_MAX_KINDS ][ MEMO_SLOTS ];
+
+// 0 is what an empty slot holds so it is never a live stamp
+static u_int32_t	memo_stamp = 1;
+
+static memo_stats_t	memo_current[ MEMO_MAX_KINDS ];
+static memo_stats_t	memo_last[ MEMO_MAX_KINDS ];
+static memo_stats_t	memo_total[ MEMO_MAX_KINDS ];
+
+static const char * memo_names[ MEMO_MAX_KINDS ] = {
+	"SKIN",
+	"MOVEGROUP",
+	"LIGHT",
+	"LIGHTLIST",
+};
+
+static void memo_next_stamp( void )
+{
+	memo_stamp++;
+	if( !memo_stamp )
+	{
+		memset( memo_table, 0, sizeof( memo_table ) );
+		memo_stamp = 1;
+	}
+}
+
+static u_int32_t memo_slot( u_int32_t * key )
+{
+	u_int32_t h = 2166136261U;
+	int i;
+
+	for( i = 0; i < MEMO_KEY_WORDS; i++ )
+		h = ( h ^ key[ i ] ) * 16777619U;
+
+	return ( h ^ ( h >> 15 ) ) & ( MEMO_SLOTS - 1 );
+}
+
+/*===================================================================
+	Procedure	:	Start a new frame, nothing found last frame is
+				:	found again and the counters move on
+===================================================================*/
+void memo_frame( void )
+{
+	int i;
+
+	for( i = 0; i < MEMO_MAX_KINDS; i++ )
+	{
+		memo_last[ i ] = memo_current[ i ];
+		memo_total[ i ].lookups += memo_current[ i ].lookups;
+		memo_total[ i ].hits += memo_current[ i ].hits;
+		memo_current[ i ].lookups = 0;
+		memo_current[ i ].hits = 0;
+	}
+
+	memo_next_stamp();
+}
+
+void memo_invalidate( void )
+{
+	memo_next_stamp();
+}
+
+/*===================================================================
+	Procedure	:	Look for an answer already worked out this frame
+	Input		:	kind of query , MEMO_KEY_WORDS of key , room for
+				:	MEMO_VALUE_WORDS of answer
+	Output		:	bool true if the answer was found
+===================================================================*/
+bool memo_find( memo_kind_t kind, u_int32_t * key, u_int32_t * value )
+{
+	MEMO_ENTRY * e = &memo_table[ kind ][ memo_slot( key ) ];
+
+	memo_current[ kind ].lookups++;
+
+	if( e->stamp != memo_stamp || memcmp( e->key, key, sizeof( e->key ) ) )
+		return false;
+
+	memcpy( value, e->value, sizeof( e->value ) );
+	memo_current[ kind ].hits++;
+	return true;
+}
+
+void memo_store( memo_kind_t kind, u_int32_t * key, u_int32_t * value )
+{
+	MEMO_ENTRY * e = &memo_table[ kind ][ memo_slot( key ) ];
+
+	e->stamp = memo_stamp;
+	memcpy( e->key, key, sizeof( e->key ) );
+	memcpy( e->value, value, sizeof( e->value ) );
+}
+
+/*===================================================================
+	Procedure	:	Get the lookup and hit counts of a kind of query
+	Input		:	kind of query , where to put the counts for the
+				:	last whole frame , and since the game started
+				:	( either can be NULL )
+===================================================================*/
+void memo_stats( memo_kind_t kind, memo_stats_t * last_frame, memo_stats_t * total )
+{
+	if( last_frame )
+		*last_frame = memo_last[ kind ];
+	if( total )
+	{
+		total->lookups = memo_total[ kind ].lookups + memo_current[ kind ].lookups;
+		total->hits = memo_total[ kind ].hits + memo_current[ kind ].hits;
+	}
+}
+
+const char * memo_name( memo_kind_t kind )
+{
+	return memo_names[ kind ];
+}
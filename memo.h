@@ -0,0 +1,65 @@
+#ifndef MEMO_INCLUDED
+#define MEMO_INCLUDED
+
+/*
+
+	description:
+
+			remembers the answers to the group queries made this frame
+			so the same ship, camera, sound and light positions only
+			walk the bsp trees and portals once, and the work each
+			camera does on the lights is only done for the first
+
+	once at the start of every frame, forgets last frame:
+
+			memo_frame();
+
+	when the level geometry is loaded or freed:
+
+			memo_invalidate();
+
+	inside a query, the key is every argument the answer depends on:
+
+			memcpy( &key[ 0 ], pos, sizeof( VECTOR ) );
+			key[ 3 ] = group;
+			if( memo_find( MEMO_PointInsideSkin, key, value ) )
+				return value[ 0 ];
+			... work out the answer ...
+			memo_store( MEMO_PointInsideSkin, key, value );
+
+	unused key words must be zero, keys have to match exactly to hit
+	so a position that is only close never gets its neighbour's
+	answer, right next to a wall the two can differ
+
+	each kind of query has its own direct mapped table, a new answer
+	simply replaces whatever was in its slot
+
+*/
+
+#include "main.h"
+
+#define MEMO_KEY_WORDS		(8)
+#define MEMO_VALUE_WORDS	(2)
+#define MEMO_SLOTS			(512)	// per kind, must be a power of two
+
+typedef enum {
+	MEMO_PointInsideSkin,	// pos, group
+	MEMO_MoveGroup,			// start pos, start group, move
+	MEMO_XLight1Group,		// group, generation of the light list it was lit with
+	MEMO_LightList,			// group the light list was built for
+	MEMO_MAX_KINDS
+} memo_kind_t;
+
+typedef struct {
+	u_int32_t	lookups;
+	u_int32_t	hits;
+} memo_stats_t;
+
+void		memo_frame		( void );
+void		memo_invalidate	( void );
+bool		memo_find		( memo_kind_t kind, u_int32_t * key, u_int32_t * value );
+void		memo_store		( memo_kind_t kind, u_int32_t * key, u_int32_t * value );
+void		memo_stats		( memo_kind_t kind, memo_stats_t * last_frame, memo_stats_t * total );
+const char *memo_name		( memo_kind_t kind );
+
+#endif
@@ -107,6 +107,9 @@ num_start_points : u_int16_t
 #include "util.h"
 #include "oct2.h"
 #include "render.h"
+#include "arena.h"
+#include "memo.h"
+#include "vlight.h"
 
 /*===================================================================
 		Externals...	
@@ -123,6 +126,7 @@ extern	u_int32_t	AnimOncePerFrame;	// used for stuff that is displayed more than
 bool FindGroupConnections( MLOADHEADER *m );
 bool ReadGroupConnections( MLOADHEADER *m, char **pbuf );
 void FreeGroupConnections( void );
+bool PvsInit( MLOADHEADER *m, char *lname );
 void ReadSoundInfo( MLOADHEADER *m, char **pbuf );
 
 /*===================================================================
@@ -171,7 +175,7 @@ static bool read_visible( MLOADHEADER * Mloadheader, VISTREE *v, u_int16_t group
 			v->num_visible = *ptr++;
 			if ( v->num_visible )
 			{
-				v->visible = (VISTREE *) calloc( v->num_visible, sizeof( VISTREE ) );
+				v->visible = (VISTREE *) arena_calloc( &LevelArena, v->num_visible, sizeof( VISTREE ) );
 				if ( v->visible )
 				{
 					for ( vnum = 0; vnum < v->num_visible; vnum++ )
@@ -302,13 +306,59 @@ FixUV_Anim( POLYANIM *PolyAnim, LPLVERTEX Vert, LPLVERTEX Orig_Vert )
 	}
 }
 
+#ifdef VLIGHT_LIGHTING
+/*===================================================================
+	Procedure	:		Copy the vertices of an execbuf into rows in
+				:		cell order for the vlight kernels
+	Input		:		LVLGROUP * , int execbuf
+	Output		:		bool false if out of memory
+===================================================================*/
+static bool BuildVertexRows( LVLGROUP * Group, int execbuf )
+{
+	u_int32_t num = Group->num_vertex_indices[ execbuf ];
+	u_int32_t pitch = num + VLIGHT_PAD;
+	LPLVERTEX verts = Group->originalVerts[ execbuf ];
+	u_int16_t * index = Group->vertex_index_pnt[ execbuf ];
+	float * rows;
+	u_int32_t i;
+
+	rows = (float *) arena_alloc( &LevelArena, 3 * pitch * sizeof( float ) );
+	Group->vertex_rows[ execbuf ] = rows;
+	if( !rows )
+		return false;
+
+	memset( rows, 0, 3 * pitch * sizeof( float ) );
+	for( i = 0; i < num; i++ )
+	{
+		rows[ i ] = verts[ index[ i ] ].x;
+		rows[ pitch + i ] = verts[ index[ i ] ].y;
+		rows[ 2 * pitch + i ] = verts[ index[ i ] ].z;
+	}
+
+	return true;
+}
+#endif
+
+static bool MloadLevel( char * Filename, MLOADHEADER * Mloadheader );
 
 /*===================================================================
 	Procedure	:		Load .Mxv File
 	Input		:		char	*	Filename , MLOADHEADER *
-	Output		:		Nothing
+	Output		:		bool
 ===================================================================*/
 bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
+{
+	if( MloadLevel( Filename, Mloadheader ) )
+		return true;
+
+	// whatever went into the level arena before the failure goes,
+	// the file buffer PreMload put there first goes with it
+	arena_reset( &LevelArena );
+	Mloadheader->Buffer = NULL;
+	return false;
+}
+
+static bool MloadLevel( char * Filename, MLOADHEADER * Mloadheader  )
 {
 	char		*	FileNamePnt;
 	char		*	Buffer;
@@ -493,7 +543,7 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 			}
 
 			/* bjd - allows us to retrieve copies of the original vertices in the new format! */
-			Mloadheader->Group[group].originalVerts[execbuf] = malloc(sizeof(LVERTEX) * num_vertices);
+			Mloadheader->Group[group].originalVerts[execbuf] = arena_alloc( &LevelArena, sizeof(LVERTEX) * num_vertices );
 			memmove(Mloadheader->Group[group].originalVerts[execbuf], &lpLVERTEX[0], sizeof(LVERTEX) * num_vertices);//memcpy
 	
 			Buffer = (char *) lpLVERTEX2;
@@ -548,6 +598,12 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 				return false;
 			}
 
+			if (!FSReserveTextureGroups((RENDEROBJECT*)&Mloadheader->Group[group].renderObject[execbuf], num_triangle_groups))
+			{
+				Msg( "Mload() failed to allocate texture groups %s\n", Filename );
+				return false;
+			}
+
 			ibIndex = 0;
 			indexOffset = 0;
 			
@@ -620,10 +676,7 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 				Mloadheader->Group[group].renderObject[execbuf].textureGroups[i].texture = Tloadheader.lpTexture[Mloadheader->TloadIndex[tpage]];
 				Mloadheader->Group[group].renderObject[execbuf].textureGroups[i].colourkey = Tloadheader.ColourKey[Mloadheader->TloadIndex[tpage]];
 
-				{
-					LEVELRENDEROBJECT * obj = &(Mloadheader->Group[group].renderObject[execbuf]);
-					INCREASE_TEXTURE_GROUPS( obj );
-				}
+				Mloadheader->Group[group].renderObject[execbuf].numTextureGroups++;
 			}
 
 			Mloadheader->Group[group].polyanim[execbuf] = NULL;
@@ -698,7 +751,7 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 				return false;    
 			}
 			
-			Mloadheader->Group[group].Portal = (PORTAL*) malloc( Mloadheader->Group[group].num_portals * sizeof(PORTAL) );
+			Mloadheader->Group[group].Portal = (PORTAL*) arena_alloc( &LevelArena, Mloadheader->Group[group].num_portals * sizeof(PORTAL) );
 			
 			for( portal = 0 ; portal < Mloadheader->Group[group].num_portals ; portal ++ )
 			{
@@ -796,7 +849,7 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 				if ( Mloadheader->Group[group].Portal[portal].visible.num_visible > 0 )
 				{
 					Mloadheader->Group[group].Portal[portal].visible.visible =
-						(VISTREE *) calloc( Mloadheader->Group[group].Portal[portal].visible.num_visible, sizeof( VISTREE ) );
+						(VISTREE *) arena_calloc( &LevelArena, Mloadheader->Group[group].Portal[portal].visible.num_visible, sizeof( VISTREE ) );
 					if ( !Mloadheader->Group[group].Portal[portal].visible.visible )
 					{
 						Msg( "Mload : no visible portal\n" );
@@ -865,7 +918,7 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 
 #if MXV_VERSION_NUMBER >= 2
 					if ( !execbuf )
-						Mloadheader->Group[group].colour_cell_pnt[0] = (COLOR*) malloc( Mloadheader->Group[group].numofcells[execbuf] * sizeof(COLOR) );
+						Mloadheader->Group[group].colour_cell_pnt[0] = (COLOR*) arena_alloc( &LevelArena, Mloadheader->Group[group].numofcells[execbuf] * sizeof(COLOR) );
 					else
 						Mloadheader->Group[group].colour_cell_pnt[execbuf] = NULL;
 					if( !Mloadheader->Group[group].colour_cell_pnt[0] )
@@ -874,7 +927,7 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 						return false;
 					}
 #else
-					Mloadheader->Group[group].colour_cell_pnt[execbuf] = (COLOR*) malloc( Mloadheader->Group[group].numofcells[execbuf] * sizeof(COLOR) );
+					Mloadheader->Group[group].colour_cell_pnt[execbuf] = (COLOR*) arena_alloc( &LevelArena, Mloadheader->Group[group].numofcells[execbuf] * sizeof(COLOR) );
 					if( !Mloadheader->Group[group].colour_cell_pnt[execbuf] )
 					{
 						Msg( "Mload : Couldnt allocate enough memory for the cell colour info\n" );
@@ -887,6 +940,14 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 
 					Uint16Pnt += Mloadheader->Group[group].num_vertex_indices[execbuf];
 
+#ifdef VLIGHT_LIGHTING
+					if( !BuildVertexRows( &Mloadheader->Group[group], execbuf ) )
+					{
+						Msg( "Mload : Couldnt allocate enough memory for the vertex light rows\n" );
+						return false;
+					}
+#endif
+
 					VertexCellPnt  = (VERTEXCELL * ) Uint16Pnt;
 
 					Mloadheader->Group[group].vertex_cell_pnt[execbuf] = VertexCellPnt;
@@ -988,7 +1049,7 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 			frames = *Uint16Pnt++;
 			maxloops = *Uint16Pnt++;
 			animsize = *Uint16Pnt++;
-			Mloadheader->AnimData.AnimSeq[i] = (u_int16_t *) malloc( animsize * sizeof( u_int16_t ) );
+			Mloadheader->AnimData.AnimSeq[i] = (u_int16_t *) arena_alloc( &LevelArena, animsize * sizeof( u_int16_t ) );
 			Uint16Pnt2 = Mloadheader->AnimData.AnimSeq[i];
 			for( e = 0 ; e < animsize ; e++ )
 			{
@@ -1007,7 +1068,7 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 				Buffer = ( char * ) Uint16Pnt;
 				if( Mloadheader->Group[group].num_animating_polys[execbuf] != 0 )
 				{
-					Mloadheader->Group[group].polyanim[execbuf] = malloc( Mloadheader->Group[group].num_animating_polys[execbuf] * sizeof( POLYANIM ) );
+					Mloadheader->Group[group].polyanim[execbuf] = arena_alloc( &LevelArena, Mloadheader->Group[group].num_animating_polys[execbuf] * sizeof( POLYANIM ) );
 		
 		
 					PolyAnim = Mloadheader->Group[group].polyanim[execbuf];
@@ -1058,13 +1119,13 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 						PolyAnim->vert = NULL;
 						PolyAnim->UVs = NULL;
 						
-						PolyAnim->vert = (int *) malloc( vertices * sizeof(int) );
+						PolyAnim->vert = (int *) arena_alloc( &LevelArena, vertices * sizeof(int) );
 						if( !PolyAnim->vert)
 						{
 							Msg( "Mload : PolyAnim vert is null\n" );
 							return false;
 						}
-						PolyAnim->UVs  = (TANIMUV *) malloc( vertices * frames * sizeof(TANIMUV) );
+						PolyAnim->UVs  = (TANIMUV *) arena_alloc( &LevelArena, vertices * frames * sizeof(TANIMUV) );
 						if( !PolyAnim->UVs)
 						{
 							Msg( "Mload : PolyAnim uv is null\n" );
@@ -1144,7 +1205,7 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 	if( *Uint16Pnt++)
 	{
 		Mloadheader->AnimData.num_animating_polys = *Uint16Pnt++;
-		Mloadheader->AnimData.TAnimInfoIndex = ( TEXTUREANIMINFOINDEX * ) malloc( Mloadheader->AnimData.num_animating_polys * sizeof(TEXTUREANIMINFOINDEX) );
+		Mloadheader->AnimData.TAnimInfoIndex = ( TEXTUREANIMINFOINDEX * ) arena_alloc( &LevelArena, Mloadheader->AnimData.num_animating_polys * sizeof(TEXTUREANIMINFOINDEX) );
 	   
 		TAnimInfoIndexPnt = Mloadheader->AnimData.TAnimInfoIndex;
 		if( !TAnimInfoIndexPnt )
@@ -1184,6 +1245,12 @@ bool Mload( char * Filename, MLOADHEADER * Mloadheader  )
 		return false;
 #endif
 
+	if ( !PvsInit( Mloadheader, Filename ) )
+		return false;
+
+	// vertex buffers hold the base colours again
+	ResetGroupLighting();
+
 	return( true );
 }
 
@@ -1250,22 +1317,6 @@ bool ExecuteSingleGroupMloadHeader( MLOADHEADER * Mloadheader, u_int16_t group
 }
 
 
-void ReleaseVisible( VISTREE *v )
-{
-	int i;
-
-	if ( v->visible )
-	{
-		for ( i = 0; i < v->num_visible; i++ )
-		{
-			ReleaseVisible( &v->visible[ i ] );
-		}
-		free( v->visible );
-		v->visible = NULL;
-	}
-}
-
-
 /*
  * ReleaseMloadheader
  * Release Execute buffers
@@ -1273,9 +1324,8 @@ void ReleaseVisible( VISTREE *v )
 void
 ReleaseMloadheader( MLOADHEADER * Mloadheader )
 {
-    int i,e;
+    int i;
     int group;
-	POLYANIM * PolyAnim;
 
 	if ( !Mloadheader->state )
 	{
@@ -1287,67 +1337,19 @@ ReleaseMloadheader( MLOADHEADER * Mloadheader )
 
     	for (group = 0; group < Mloadheader->num_groups; group++)
 	{
-		for ( i = 0; i < Mloadheader->Group[ group ].num_portals; i++ )
-		{
-			ReleaseVisible( &Mloadheader->Group[ group ].Portal[ i ].visible );
-		}
-
-		free( Mloadheader->Group[group].Portal );
-
 		for (i = 0; i < Mloadheader->Group[group].num_execbufs; i++)
 		{
 			FSReleaseRenderObject((RENDEROBJECT*)&(Mloadheader->Group[group].renderObject[i]));
-
-			if ( Mloadheader->Group[group].colour_cell_pnt[i] )
-				free( Mloadheader->Group[group].colour_cell_pnt[i] );
-			Mloadheader->Group[group].colour_cell_pnt[i] = NULL;
-
-			PolyAnim = Mloadheader->Group[group].polyanim[i];
-			
-			for( e = 0 ; e < Mloadheader->Group[group].num_animating_polys[i] ; e++ )
-			{	
-			   	if( PolyAnim )
-			   	{
-			   		if( PolyAnim->vert )
-			   		{
-			   			free( PolyAnim->vert );
-			   			PolyAnim->vert = NULL;
-			   		}
-			   		if( PolyAnim->UVs )
-			   		{
-			   			free( PolyAnim->UVs );
-			   			PolyAnim->UVs = NULL;
-			   		}
-			   	}
-				PolyAnim++;
-			}
-
-			if (Mloadheader->Group[group].polyanim[i])
-		   		free(Mloadheader->Group[group].polyanim[i]);
-			
-			Mloadheader->Group[group].polyanim[i] = NULL;
 		}
 	}
 
-	for( i = 0 ; i < Mloadheader->AnimData.num_animations ; i++ )
-	{
-		free(Mloadheader->AnimData.AnimSeq[i]);
-		Mloadheader->AnimData.AnimSeq[i] = NULL;
-	}
-
-	if( Mloadheader->AnimData.TAnimInfoIndex )
-	{
-		free(Mloadheader->AnimData.TAnimInfoIndex);
-		Mloadheader->AnimData.TAnimInfoIndex = NULL;
-	}
-	
-	if ( Mloadheader->OrgAddr )
-	{
-		free( Mloadheader->OrgAddr );
-		Mloadheader->OrgAddr = NULL;
-	}
-
+	// portals, vis trees, cell colours, poly anims, anim sequences
+	// and the file buffer all live in the level arena
 	memset( Mloadheader, 0, sizeof(MLOADHEADER) );
+	arena_release( &LevelArena );
+
+	// MoveGroup answers were worked out through these portals
+	memo_invalidate();
 
 	Mloadheader->state = false;
 }
@@ -1431,7 +1433,7 @@ bool PreMload( char * Filename, MLOADHEADER * Mloadheader  )
 		return false;
 	}
 
-	Buffer = calloc( 1, File_Size + sizeof( int ) );
+	Buffer = arena_calloc( &LevelArena, 1, File_Size + sizeof( int ) );
 
 	if( Buffer == NULL )
 	{
@@ -1449,6 +1451,10 @@ bool PreMload( char * Filename, MLOADHEADER * Mloadheader  )
 
 	Mloadheader->OrgAddr = Buffer;
 
+	Mloadheader->FileHash = 2166136261U;
+	for( i = 0; i < Read_Size; i++ )
+		Mloadheader->FileHash = ( Mloadheader->FileHash ^ (u_int8_t) Buffer[ i ] ) * 16777619U;
+
 #ifdef UNSCRAMBLE
 	if ( strcasecmp( Filename, "data\\levels\\accworld\\accworld.mxv" ) &&
 		 strcasecmp( Filename, "data\\levels\\probeworld\\probeworld.mxv" ) )
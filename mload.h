@@ -112,6 +112,7 @@ struct VISTREE
 	PORTAL *portal;
 	u_int16_t group;
 	u_int16_t num_visible;
+	bool culled;				// no camera in the tree's group can see down this portal chain
 	VISTREE *visible;
 };
 
@@ -190,6 +191,7 @@ typedef struct LVLGROUP{
 	u_int16_t	num_vertex_indices[MAXEXECBUFSPERGROUP];
 	u_int16_t * vertex_index_pnt[MAXEXECBUFSPERGROUP];
 	VERTEXCELL * vertex_cell_pnt[MAXEXECBUFSPERGROUP];
+	float * vertex_rows[MAXEXECBUFSPERGROUP];	// x, y then z of each vertex_index_pnt entry, num_vertex_indices + VLIGHT_PAD apart
 	COLOR * colour_cell_pnt[MAXEXECBUFSPERGROUP];
 
 	u_int16_t	num_animating_polys[MAXEXECBUFSPERGROUP];
@@ -212,6 +214,7 @@ typedef struct MLOADHEADER{
     char                ImageFile[MAXTPAGESPERMLOAD][32];	// Texture Files....
 	float				CellSize;
 	ANIMDATA			AnimData;
+	u_int32_t			FileHash;							// fnv-1a of the .mxv as read, keys the .pvs cache
 }MLOADHEADER;
 
 
@@ -31,6 +31,7 @@
 #include "controls.h"
 #include "local.h"
 #include "util.h"
+#include "pool.h"
 #include "oct2.h"
 
 #ifdef OPT_ON
@@ -63,7 +64,7 @@ extern	VECTOR			SlideLeft;
 extern	VECTOR			SlideRight;
 
 extern	u_int16_t			FirstSecBullUsed;
-extern	SECONDARYWEAPONBULLET SecBulls[MAXSECONDARYWEAPONBULLETS];
+extern	SECONDARYWEAPONBULLET * SecBulls;
 extern	int16_t			SecondaryAmmo[ MAXSECONDARYWEAPONS ];
 extern	int16_t			SecAmmoUsed[ MAXSECONDARYWEAPONS ];
 
@@ -71,7 +72,6 @@ extern	MATRIX			MATRIX_Identity;
 
 extern	XLIGHT			XLights[ MAXXLIGHTS ];
 extern	u_int16_t			FirstXLightUsed;
-extern	u_int16_t			FirstXLightFree;
 extern	PICKUP			Pickups[ MAXPICKUPS ];
 
 extern	int16_t			NumPickupsPerGroup[ MAXGROUPS ];
@@ -80,9 +80,9 @@ extern	float			SoundInfo[MAXGROUPS][MAXGROUPS];
 extern	ENEMY	*		FirstEnemyUsed;
 extern	LINE			Lines[ MAXLINES ];
 extern	FMPOLY			FmPolys[MAXNUMOF2DPOLYS];
-extern	POLY			Polys[MAXPOLYS];
+extern	POLY			*	Polys;
 extern	FRAME_INFO	*	Flare_Header;
-extern	PRIMARYWEAPONBULLET	PrimBulls[MAXPRIMARYWEAPONBULLETS];
+extern	PRIMARYWEAPONBULLET	*	PrimBulls;
 extern	u_int16_t			GlobalPrimBullsID;
 extern	u_int16_t			GlobalSecBullsID;
 extern	int16_t			BikeModels[ MAXBIKETYPES ];
@@ -93,7 +93,7 @@ extern	int32_t			ColPerspective;
 extern	bool			TeamGame;
 extern	BYTE			TeamNumber[MAX_PLAYERS];
 extern bool BikeExpanded;
-extern	ENEMY			Enemies[ MAXENEMIES ];
+extern	ENEMY			*	Enemies;
 extern	BIKEINFO		BikeCompFiles[ MAXBIKETYPES ];
 extern	bool			BikeExhausts;
 extern	int16_t			CameraRendering;
@@ -122,9 +122,9 @@ void UpdateTracker( void );
 void CreateTracker( void );
 u_int16_t	Tracker = (u_int16_t) -1;
 u_int16_t	TrackerTarget = (u_int16_t) -1;
-MODEL	Models[MAXNUMOFMODELS];
+MODEL	*	Models;
 u_int16_t	FirstModelUsed;
-u_int16_t	FirstModelFree;
+pool_t		ModelPool;
 int16_t	NextNewModel = -1;
 bool	ShowBoundingBoxes = false;
 
@@ -727,32 +727,36 @@ MODELNAME	SplashModelNames[ MAXMODELHEADERS ] ={
 
 
 /*===================================================================
-*		Set up 2d exec buff etc...
+	Procedure	:	Init one model, also called as the pool grows
+	Input		:	u_int16_t	Model Index
+	Output		:	Nothing
 ===================================================================*/
-void OnceOnlyInitModel( void )
+static void InitModelSlot( u_int16_t i )
 {
-	int i;
 	int	Count;
 
-	FirstModelUsed = (u_int16_t) -1;
-	FirstModelFree = 0;
-	
-	for( i=0;i<MAXNUMOFMODELS;i++)
-	{
-		memset( &Models[i], 0, sizeof( MODEL ) );
-		Models[i].Func = MODFUNC_Nothing;
-		Models[i].LifeCount = -1.0F;
-		Models[i].Scale = 1.0F;
-		Models[i].Visible = true;
-		Models[i].TimeInterval = (float) 1;
+	memset( &Models[i], 0, sizeof( MODEL ) );
+	Models[i].Func = MODFUNC_Nothing;
+	Models[i].LifeCount = -1.0F;
+	Models[i].Scale = 1.0F;
+	Models[i].Visible = true;
+	Models[i].TimeInterval = (float) 1;
 
-		for( Count = 0; Count < 12; Count++ ) Models[i].TempLines[ Count ] = (u_int16_t) -1;
+	for( Count = 0; Count < 12; Count++ ) Models[i].TempLines[ Count ] = (u_int16_t) -1;
 
-		Models[i].Next = i + 1;
-		Models[i].Prev = (u_int16_t) -1;
-	}
+	Models[i].Next = (u_int16_t) -1;
+	Models[i].Prev = (u_int16_t) -1;
+}
 
-	Models[MAXNUMOFMODELS-1].Next = (u_int16_t) -1;
+/*===================================================================
+*		Set up 2d exec buff etc...
+===================================================================*/
+void OnceOnlyInitModel( void )
+{
+	int i;
+
+	FirstModelUsed = (u_int16_t) -1;
+	pool_init_table( &ModelPool, "models", (void **) &Models, sizeof( MODEL ), MAXNUMOFMODELS, InitModelSlot );
 
 	NextNewModel = MODEL_ExtraModels;
 
@@ -918,11 +922,12 @@ u_int16_t	FindFreeModel()
 	CheckModelLinkList();
 #endif
 
-	i = FirstModelFree;
+	i = pool_alloc( &ModelPool );
 	
-	if ( i == (u_int16_t) -1)
+	if ( i == POOL_NONE )
 		return i;
  
+	Models[i].Next = (u_int16_t) -1;
 	Models[i].Prev = FirstModelUsed;
 	if ( FirstModelUsed != (u_int16_t) -1)
 	{
@@ -942,7 +947,6 @@ u_int16_t	FindFreeModel()
 	Models[i].Blue = 255;
 
 	FirstModelUsed = i;
-	FirstModelFree = Models[i].Next;
 
 #ifdef DEBUG_ON
 	CheckModelLinkList();
@@ -991,10 +995,10 @@ void	KillUsedModel( u_int16_t i )
 
 	Models[i].Func = MODFUNC_Nothing;
 	Models[i].Prev = (u_int16_t) -1;
-	Models[i].Next = FirstModelFree;
+	Models[i].Next = (u_int16_t) -1;
 	Models[i].LifeCount = -1.0F;
 	Models[i].Scale = 1.0F;
-	FirstModelFree	= i;
+	pool_free( &ModelPool, i );
 
 #ifdef DEBUG_ON
 	CheckModelLinkList();
@@ -4721,14 +4725,20 @@ void MissileShockWave( VECTOR * Pos, float Radius, u_int16_t Owner, float Center
 	char		tempstr[256];
 	ENEMY	*	Enemy;
 	ENEMY	*	NextEnemy;
+	u_int16_t		Near[ MAX_PLAYERS ];
+	int			NumNear, n;
 
 	switch( ColPerspective )
 	{
 		case COLPERS_Forsaken:
 			if( Owner == WhoIAm )
 			{
-				for( Count = 0; Count < MAX_PLAYERS; Count++ )
+				NumNear = ShipsNear( Pos, Radius, Near );
+
+				for( n = 0; n < NumNear; n++ )
 				{
+					Count = Near[ n ];
+
 					if( ( Ships[ Count ].enable ) && ( Ships[ Count ].Object.Mode != LIMBO_MODE ) )
 					{
 						if( !SoundInfo[ Ships[ Count ].Object.Group ][ Group ] )
@@ -6100,11 +6110,13 @@ u_int32_t EngineCode( u_int16_t OwnerType, u_int16_t OwnerID, u_int32_t SoundFX_
 FILE * SaveModels( FILE * fp )
 {
 	u_int16_t i;
+	u_int16_t FirstFree;
 
 	if( fp )
 	{
 		fwrite( &FirstModelUsed, sizeof( FirstModelUsed ), 1, fp );
-		fwrite( &FirstModelFree, sizeof( FirstModelFree ), 1, fp );
+		FirstFree = pool_free_slot( &ModelPool, 0 );
+		fwrite( &FirstFree, sizeof( FirstFree ), 1, fp );
 		
 		i = FirstModelUsed;
 
@@ -6156,13 +6168,7 @@ FILE * SaveModels( FILE * fp )
 			i = Models[ i ].Prev;
 		}
 
-		i = FirstModelFree;
-
-		while( i != (u_int16_t) -1 )
-		{
-			fwrite( &Models[ i ].Next, sizeof( u_int16_t ), 1, fp );
-			i = Models[ i ].Next;
-		}
+		pool_save_free( &ModelPool, fp );
 
 	}
 
@@ -6177,17 +6183,24 @@ FILE * SaveModels( FILE * fp )
 FILE * LoadModels( FILE * fp )
 {
 	u_int16_t	i;
-	int16_t	Count;
+	u_int16_t	FirstFree;
+	u_int16_t	NextFree;
 
 	if( fp )
 	{
 		fread( &FirstModelUsed, sizeof( FirstModelUsed ), 1, fp );
-		fread( &FirstModelFree, sizeof( FirstModelFree ), 1, fp );
+		fread( &FirstFree, sizeof( FirstFree ), 1, fp );
+		pool_clear( &ModelPool );
 		
 		i = FirstModelUsed;
 
 		while( i != (u_int16_t) -1 )
 		{
+			if( !pool_fit( &ModelPool, i ) )
+			{
+				fclose( fp );
+				return( NULL );
+			}
 			fread( &Models[ i ].Next, sizeof( u_int16_t ), 1, fp );
 			fread( &Models[ i ].Prev, sizeof( u_int16_t ), 1, fp );
 			fread( &Models[ i ].Type, sizeof( int16_t ), 1, fp );
@@ -6236,25 +6249,27 @@ FILE * LoadModels( FILE * fp )
 
 			ReinitSpotFXSFX( i );
 
+			pool_mark( &ModelPool, i );
 			i = Models[ i ].Prev;
 		}
 
-		i = FirstModelFree;
+		i = FirstFree;
 
 		while( i != (u_int16_t) -1 )
 		{
-			memset( &Models[ i ], 0, sizeof( MODEL ) );
-			Models[i].Func = MODFUNC_Nothing;
-			Models[i].LifeCount = -1.0F;
-			Models[i].Scale = 1.0F;
-			Models[i].Visible = true;
-			Models[i].TimeInterval = (float) 1;
-			for( Count = 0; Count < 12; Count++ ) Models[i].TempLines[ Count ] = (u_int16_t) -1;
-			Models[i].Prev = (u_int16_t) -1;
+			if( !pool_fit( &ModelPool, i ) )
+			{
+				fclose( fp );
+				return( NULL );
+			}
+			InitModelSlot( i );
 
-			fread( &Models[ i ].Next, sizeof( u_int16_t ), 1, fp );
-			i = Models[ i ].Next;
+			pool_load_free( &ModelPool, i );
+			fread( &NextFree, sizeof( u_int16_t ), 1, fp );
+			i = NextFree;
 		}
+
+		pool_rebuild( &ModelPool );
 	}
 
 	return( fp );
@@ -6431,34 +6446,27 @@ void CheckModelLinkList( void )
 
 
 	
-	i = 0;
-	Count = FirstModelFree;
-	while( ( Count != (u_int16_t)-1 ) && i < MAXNUMOFMODELS*2 )
-	{
-		Count = Models[Count].Next;
-		i++;
-	}
-	if( i == MAXNUMOFMODELS*2 )
+	if( ( ModelPool.used + ModelPool.num_free ) != ModelPool.size )
 	{
 		// oh shit
-        DebugPrintf( "Model Free link list Gone up its ass\n" );
-		i = 0;
+        DebugPrintf( "Model pool lost track of its free slots\n" );
 	}
 
 	i = 0;
 
 	Count = FirstModelUsed;
-	while( ( Count != (u_int16_t)-1 ) && i < MAXNUMOFMODELS*2 )
+	while( ( Count != (u_int16_t)-1 ) && i < ModelPool.size*2 )
 	{
-		if( Models[Count].Prev == Models[Count].Next )
+		if( ( Models[Count].Prev == Models[Count].Next && Models[Count].Prev != (u_int16_t)-1 ) ||
+			!POOL_IN_USE( &ModelPool, Count ) )
 		{
-			i = MAXNUMOFMODELS*2;
+			i = ModelPool.size*2;
 			break;
 		}
 		Count = Models[Count].Prev;
 		i++;
 	}
-	if( i == MAXNUMOFMODELS*2 )
+	if( i == ModelPool.size*2 )
 	{
 		// oh shit
         DebugPrintf( "Model Used link list Gone up its ass\n" );
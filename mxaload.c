@@ -344,6 +344,12 @@ bool Mxaload( char * Filename, MXALOADHEADER * Mxaloadheader, bool StoreTriangle
 				return false;
 			}
 
+			if (!FSReserveTextureGroups(&Mxaloadheader->Group[group].renderObject[execbuf], num_texture_groups))
+			{
+				Msg( "Mxaload() failed to allocate texture groups in %s\n", Filename );
+				return false;
+			}
+
 			ibIndex = 0;
 			indexOffset = 0;
 
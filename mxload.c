@@ -66,7 +66,7 @@ extern	DWORD				CurrentDestBlend;
 extern	DWORD				CurrentTextureBlend;
 
 extern	TLOADHEADER Tloadheader;
-extern	MODEL	Models[MAXNUMOFMODELS];
+extern	MODEL * Models;
 
 extern	bool	DrawPanel;
 extern	float	framelag;
@@ -383,6 +383,12 @@ bool Mxload( char * Filename, MXLOADHEADER * Mxloadheader , bool Panel, bool Sto
         return false;
       }
 
+			if (!FSReserveTextureGroups(&Mxloadheader->Group[group].renderObject[execbuf], num_texture_groups))
+			{
+				Msg( "Mxload() failed to allocate texture groups in %s\n", Filename );
+				return false;
+			}
+
 			ibIndex = 0;
 			indexOffset = 0;
 
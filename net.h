@@ -73,6 +73,7 @@ struct  _network_player_t {
 	unsigned long int packets_lost;
 	unsigned long int bw_in;
 	unsigned long int bw_out;
+	unsigned long int backlog; // reliable bytes sent but not yet acknowledged
 	network_player_t * prev;
 	network_player_t * next;
 	void* data; // internal use only
@@ -399,6 +399,7 @@ static void update_player( network_player_t* player )
 		//DebugPrintf("network extra: player %s (%d) packets lost has changed to %d\n",
 		//	player->name, PEER_ID(peer), player->packets_lost);
 	}
+	player->backlog = peer->reliableDataInTransit;
 }
 
 static void update_players( void )
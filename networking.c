@@ -275,7 +275,7 @@ void SfxForCollectPickup( u_int16_t Owner, u_int16_t ID );
 
 void CreateReGen( u_int16_t ship );
 bool InitLevels( char *levels_list );
-extern	MODEL	Models[MAXNUMOFMODELS];
+extern	MODEL * Models;
 
 bool	HostDuties = false;
 bool					IsHost = true;
@@ -340,7 +340,7 @@ extern	MLOADHEADER Mloadheader;
 extern	int16_t LevelNum;
 extern	float PowerLevel;
 extern	SECONDARYWEAPONATTRIB SecondaryWeaponAttribs[ TOTALSECONDARYWEAPONS ];
-extern	SECONDARYWEAPONBULLET SecBulls[MAXSECONDARYWEAPONBULLETS];
+extern	SECONDARYWEAPONBULLET * SecBulls;
 extern	SHIPCONTROL control;
 extern	char * Messages[];
 extern	int16_t	SelectedBike;
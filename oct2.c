@@ -58,6 +58,9 @@
 #include "render.h"
 #include "input.h"
 #include "oct2.h"
+#include "perf.h"
+#include "arena.h"
+#include "memo.h"
 
 #ifdef SHADOWTEST
 #include "triangles.h"
@@ -404,7 +407,7 @@ extern  int16_t     NumRegenPoints;
 extern  float PowerLevel;
 extern  float LaserTemperature;
 extern  float NitroFuel;
-extern  SECONDARYWEAPONBULLET SecBulls[MAXSECONDARYWEAPONBULLETS];
+extern  SECONDARYWEAPONBULLET * SecBulls;
 extern  ENEMY * TestEnemy;
 
 extern  char  biker_name[256];
@@ -468,6 +471,8 @@ u_int16_t  CameraMissile = (u_int16_t) -1;
 extern bool MissileCameraEnable;
 BYTE  TempMissileCam;
 
+static render_viewport_t StereoViewport; // viewport the left stereo eye found the visible groups in
+
 extern  REMOTECAMERA * ActiveRemoteCamera;
 
 bool
@@ -1038,6 +1043,10 @@ void ProcessGameKeys( void )
 		if ( input_buffer_find( SDLK_F2 ) )
 			ShowTrigZones = !ShowTrigZones;
 
+		// Ctrl + F8
+		if ( input_buffer_find( SDLK_F8 ) )
+			ShowPerfOverlay = !ShowPerfOverlay;
+
 #ifndef POLYGONAL_COLLISIONS
 #ifdef REMOTE_CAMERA_ENABLED
 		// Ctrl + F3
@@ -1955,6 +1964,7 @@ InitScene(void)
 {
   int i;
 
+  perf_reset();
   OnceOnlyInitModel();
   InitXLights();
   InitPrimBulls();
@@ -2222,6 +2232,10 @@ bool ChangeLevel( void )
 	//NumGoldBars = 0;
 
 	ReleaseLevel();
+#ifdef DEBUG_ON
+	// the old level is gone so whatever is still growing is a leak
+	XMem_LevelCheck();
+#endif
 	KillNodeCubeLines();
 	KillBoxLines();
 
@@ -2317,8 +2331,16 @@ bool RenderScene( void )
   if ( SeriousError )
     return false;
 
+  perf_frame();
+
+  // everything transient from the last frame goes
+  arena_reset( &FrameArena );
+  memo_frame();
+
   // This is where in game we are getting input data read
+  perf_zone_begin( PERF_ZONE_Input );
   ReadInput();
+  perf_zone_end( PERF_ZONE_Input );
 
   //if ( !Bsp_Identical( &Bsp_Header[ 0 ], &Bsp_Original ) )
   //  hr = 0;
@@ -2328,7 +2350,9 @@ bool RenderScene( void )
 
   if ( bSoundEnabled )
   {
+    perf_zone_begin( PERF_ZONE_Sound );
     CheckSBufferList();
+    perf_zone_end( PERF_ZONE_Sound );
   }
 
   switch( MyGameStatus )
@@ -2516,10 +2540,12 @@ bool RenderScene( void )
 
     if ( bSoundEnabled )
     {
+      perf_zone_begin( PERF_ZONE_Sound );
       ProcessLoopingSfx();
 #ifdef PLAYER_SPEECH_TAUNTS
       ProcessTaunt();
 #endif
+      perf_zone_end( PERF_ZONE_Sound );
     }
 
     LevelTimeTaken += timer_run( &level_timer );
@@ -3940,7 +3966,12 @@ void MainRoutines( void )
     DemoPlayingNetworkGameUpdate();
   }
 
+  perf_zone_begin( PERF_ZONE_Ships );
   ProcessShips();
+  perf_zone_end( PERF_ZONE_Ships );
+
+  // ships and enemies stay put from here until ProcessModels is done
+  BuildShipGrid();
 
 #ifdef SHADOWTEST
 //  CreateSpotLight( (u_int16_t) WhoIAm, SHIP_RADIUS, &Mloadheader );
@@ -3949,15 +3980,28 @@ void MainRoutines( void )
 
   FirePrimary();
   FireSecondary();
+  perf_zone_begin( PERF_ZONE_Enemies );
   ProcessEnemies();
+  perf_zone_end( PERF_ZONE_Enemies );
+  BuildEnemyGrid();
   ProcessSpotFX();
+  perf_zone_begin( PERF_ZONE_Primary );
   ProcessPrimaryBullets();
+  perf_zone_end( PERF_ZONE_Primary );
+  perf_zone_begin( PERF_ZONE_Secondary );
   ProcessSecondaryBullets();
+  perf_zone_end( PERF_ZONE_Secondary );
+  perf_zone_begin( PERF_ZONE_Pickups );
   if( !PlayDemo ) RegeneratePickups();
   ProcessPickups();
+  perf_zone_end( PERF_ZONE_Pickups );
   ProcessBGObjects( true );
   ProcessRestartPoints();
+  perf_zone_begin( PERF_ZONE_Models );
   ProcessModels();
+  perf_zone_end( PERF_ZONE_Models );
+  grid_invalidate( &ShipGrid );
+  grid_invalidate( &EnemyGrid );
   ProcessPolys();
   ProcessXLights( &Mloadheader );
   DoAfterBurnerEffects();
@@ -4453,7 +4497,9 @@ bool MainGame( void ) // bjd
   if( ActiveRemoteCamera || (MissileCameraActive && MissileCameraEnable) )
     AddIndirectVisible( (u_int16_t) ( ( ActiveRemoteCamera ) ? ActiveRemoteCamera->Group : SecBulls[ CameraMissile ].GroupImIn ) );
 
+  perf_zone_begin( PERF_ZONE_Sim );
   MainRoutines();
+  perf_zone_end( PERF_ZONE_Sim );
 
   if( MyGameStatus == STATUS_QuitCurrentGame )
     return true;
@@ -4464,8 +4510,13 @@ bool MainGame( void ) // bjd
   for( i = 0 ; i < MAX_SFX ; i++ )
     LastDistance[i] = 100000.0F;
 
+  perf_zone_begin( PERF_ZONE_Render );
   if(!MainGameRender())
+  {
+    perf_zone_end( PERF_ZONE_Render );
     return false;
+  }
+  perf_zone_end( PERF_ZONE_Render );
 
   MenuProcess(); // menu keys are processed here
   ProcessGameKeys(); // here is where we process F keys
@@ -4483,7 +4534,11 @@ bool MainGame( void ) // bjd
   CheckLevelEnd();
 
   if(!PlayDemo)
+  {
+    perf_zone_begin( PERF_ZONE_Net );
     NetworkGameUpdate();
+    perf_zone_end( PERF_ZONE_Net );
+  }
 
   return true;
 }
@@ -5029,13 +5084,33 @@ bool RenderCurrentCamera( void )
   // Ship Model Enable/Disable
   SetShipsVisibleFlag();
 
-  // find visible groups
-  FindVisible( &CurrentCamera, &Mloadheader );
+  // find visible groups, the right stereo eye uses what the left eye found
+  if( render_info.stereo_position == ST_RIGHT )
+  {
+    ReuseVisible( &CurrentCamera, (float) ( CurrentCamera.Viewport.X - StereoViewport.X ),
+                  (float) ( CurrentCamera.Viewport.Y - StereoViewport.Y ) );
+  }
+  else if( render_info.stereo_position == ST_LEFT )
+  {
+    FindVisibleShared( &CurrentCamera, &Mloadheader, render_info.stereo_eye_sep );
+    StereoViewport = CurrentCamera.Viewport;
+  }
+  else
+  {
+    FindVisible( &CurrentCamera, &Mloadheader );
+  }
 
   BuildVisibleLightList( CurrentCamera.GroupImIn );
-  
-  UpdateBGObjectsClipGroup( &CurrentCamera );
-  UpdateEnemiesClipGroup( &CurrentCamera );
+#ifdef NEW_LIGHTING
+  FSSetLights();
+#endif
+
+  // clip groups only depend on which groups are visible, not where on screen
+  if( render_info.stereo_position != ST_RIGHT )
+  {
+    UpdateBGObjectsClipGroup( &CurrentCamera );
+    UpdateEnemiesClipGroup( &CurrentCamera );
+  }
 
   /*
   if( CurrentCamera.GroupImIn != (u_int16_t) -1 )
@@ -5304,6 +5379,10 @@ bool Our_CalculateFrameRate(void)
 		CenterPrint4x5Text( (char *) &buf[0] , FontHeight, 2 );
 	}
 
+	// frame time graph, percentiles and entity counts
+	if( ShowPerfOverlay )
+		perf_overlay();
+
 	if( ShowInfo )
 	{
 
@@ -5313,7 +5392,9 @@ bool Our_CalculateFrameRate(void)
 		CenterPrint4x5Text( (char *) &buf[0], (FontHeight+3)*3, 2 );
 
 		// memory information
-		sprintf(&buf[0], "Mem %d",(int)MemUsed );
+		sprintf(&buf[0], "Mem %d - Level Arena %d of %d - Frame Arena %d peak %d",(int)MemUsed,
+			(int)LevelArena.used, (int)LevelArena.reserved,
+			(int)FrameArena.used, (int)FrameArena.peak );
 		CenterPrint4x5Text( (char *) &buf[0], (FontHeight+3)*4, 2 );
 
 		// show polygon information
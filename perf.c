@@ -0,0 +1,513 @@
+#include "main.h"
+#include <stdio.h>
+#include "new3d.h"
+#include "quat.h"
+#include "compobjects.h"
+#include "bgobjects.h"
+#include "object.h"
+#include "networking.h"
+#include "ships.h"
+#include "mload.h"
+#include "2dpolys.h"
+#include "polys.h"
+#include "lights.h"
+#include "primary.h"
+#include "secondary.h"
+#include "models.h"
+#include "enemies.h"
+#include "text.h"
+#include "render.h"
+#include "file.h"
+#include "util.h"
+#include "net.h"
+#include "oct2.h"
+#include "perf.h"
+#include "pool.h"
+#include "memo.h"
+
+#include <time.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+//
+// externals
+//
+
+extern pool_t				PrimBullPool;
+extern pool_t				SecBullPool;
+extern pool_t				ModelPool;
+extern pool_t				PolyPool;
+extern pool_t				FmPolyPool;
+extern pool_t				EnemyPool;
+extern pool_t				SpotFXPool;
+extern pool_t				PickupPool;
+extern pool_t				BGObjectPool;
+extern pool_t				XLightPool;
+extern pool_t				ScrPolyPool;
+extern pool_t				LinePool;
+extern u_int32_t			CurrentBytesPerSecRec;
+extern u_int32_t			CurrentBytesPerSecSent;
+extern BYTE					MyGameStatus;
+extern int16_t				LevelNum;
+
+extern int FontWidth;
+extern int FontHeight;
+extern render_info_t render_info;
+
+//
+// globals
+//
+
+static pool_t * pools[] = {
+	&PrimBullPool, &SecBullPool, &ModelPool, &PolyPool, &FmPolyPool, &EnemyPool,
+	&SpotFXPool, &PickupPool, &BGObjectPool, &XLightPool, &ScrPolyPool, &LinePool,
+};
+
+bool ShowPerfOverlay = false;
+int  HitchBudget = 50;
+
+static struct {
+	char * name;
+	bool   nested;	// already counted in an outer zone
+} zones[ PERF_MAX_ZONES ] = {
+	{ "input",		false },
+	{ "sound",		false },
+	{ "sim",		false },
+	{ "ships",		true  },
+	{ "enemies",	true  },
+	{ "primary",	true  },
+	{ "secondary",	true  },
+	{ "pickups",	true  },
+	{ "models",		true  },
+	{ "render",		false },
+	{ "net",		false },
+	{ "flip",		false },
+};
+
+//
+// histogram
+//
+// log-linear buckets: values below PERF_SUB_BUCKETS are exact, every power
+// of two above that is split into PERF_SUB_BUCKETS linear steps which keeps
+// the relative error of any reported percentile around 6%
+//
+
+#define PERF_SUB_BITS		(4)
+#define PERF_SUB_BUCKETS	(1<<PERF_SUB_BITS)
+#define PERF_MAGNITUDES		(25)							// up to 2^28 micros
+#define PERF_BUCKETS		(PERF_MAGNITUDES*PERF_SUB_BUCKETS)
+#define PERF_MAX_VALUE		((1<<(PERF_MAGNITUDES+PERF_SUB_BITS-1))-1)
+
+static u_int32_t		histogram[ PERF_BUCKETS ];
+
+static perf_sample_t	history[ PERF_HISTORY ];
+static int				history_next = 0;	// slot the next sample goes into
+static int				history_count = 0;	// number of valid slots
+
+static perf_sample_t	current;			// sample being built for this frame
+static u_int32_t		frame_start = 0;
+static u_int32_t		zone_start[ PERF_MAX_ZONES ];
+static bool				frame_in_game = false;
+
+// rolling averages the hitch detector compares against
+static float			frame_average = 0.0F;
+static float			zone_average[ PERF_MAX_ZONES ];
+
+static bool in_game( void )
+{
+	return MyGameStatus == STATUS_Normal || MyGameStatus == STATUS_SinglePlayer;
+}
+
+// microseconds from an arbitrary point, wraps every ~71 minutes
+// all users only ever look at differences so wrapping is harmless
+u_int32_t perf_micros( void )
+{
+#if defined(WIN32)
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER now;
+	if( !freq.QuadPart )
+		QueryPerformanceFrequency( &freq );
+	QueryPerformanceCounter( &now );
+	return (u_int32_t)( ( now.QuadPart * 1000000 ) / freq.QuadPart );
+#elif defined(MACOSX)
+	struct timeval tv;
+	gettimeofday( &tv, NULL );
+	return (u_int32_t)( tv.tv_sec * 1000000 + tv.tv_usec );
+#else
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (u_int32_t)( ts.tv_sec * 1000000 + ts.tv_nsec / 1000 );
+#endif
+}
+
+static int bucket_index( u_int32_t value )
+{
+	int msb = 0;
+	int shift;
+
+	if( value > PERF_MAX_VALUE )
+		value = PERF_MAX_VALUE;
+
+	if( value < PERF_SUB_BUCKETS )
+		return (int) value;
+
+	while( value >> (msb+1) )
+		msb++;
+
+	shift = msb - PERF_SUB_BITS;
+	return ( shift + 1 ) * PERF_SUB_BUCKETS + (int)( ( value >> shift ) - PERF_SUB_BUCKETS );
+}
+
+// highest value that falls into the bucket
+static u_int32_t bucket_value( int index )
+{
+	int magnitude = index / PERF_SUB_BUCKETS;
+	int sub = index % PERF_SUB_BUCKETS;
+
+	if( !magnitude )
+		return (u_int32_t) sub;
+
+	return ( (u_int32_t)( PERF_SUB_BUCKETS + sub + 1 ) << ( magnitude - 1 ) ) - 1;
+}
+
+void perf_reset( void )
+{
+	ZERO_STACK_MEM(histogram);
+	ZERO_STACK_MEM(history);
+	ZERO_STACK_MEM(current);
+	ZERO_STACK_MEM(zone_start);
+	ZERO_STACK_MEM(zone_average);
+	history_next = 0;
+	history_count = 0;
+	frame_start = 0;
+	frame_average = 0.0F;
+}
+
+static void perf_add( perf_sample_t * sample )
+{
+	// oldest sample drops out of the window
+	if( history_count == PERF_HISTORY )
+		histogram[ bucket_index( history[ history_next ].frame ) ]--;
+	else
+		history_count++;
+
+	history[ history_next ] = *sample;
+	histogram[ bucket_index( sample->frame ) ]++;
+
+	history_next = ( history_next + 1 ) & ( PERF_HISTORY - 1 );
+}
+
+static void perf_average( perf_sample_t * sample )
+{
+	int i;
+	frame_average += ( sample->frame - frame_average ) / PERF_AVERAGE_FRAMES;
+	for( i = 0; i < PERF_MAX_ZONES; i++ )
+		zone_average[ i ] += ( sample->zone[ i ] - zone_average[ i ] ) / PERF_AVERAGE_FRAMES;
+}
+
+//
+// hitch log
+//
+
+static void hitch_log_name( char * buf, size_t size, int n )
+{
+	if( n )
+		snprintf( buf, size, "Logs\\hitch.%d.txt", n );
+	else
+		snprintf( buf, size, "Logs\\hitch.txt" );
+}
+
+// hitch.txt -> hitch.1.txt -> hitch.2.txt ... oldest is dropped
+static void hitch_log_rotate( void )
+{
+	int n;
+	char from[256], to[256];
+
+	for( n = PERF_HITCH_LOGS - 1; n > 0; n-- )
+	{
+		hitch_log_name( to, sizeof(to), n );
+		hitch_log_name( from, sizeof(from), n - 1 );
+		if( !File_Exists( from ) )
+			continue;
+		if( File_Exists( to ) )
+			delete_file( to );
+		// convert_path returns a static buffer so copy it out first
+		strncpy( to, convert_path( to ), sizeof(to) );
+		strncpy( from, convert_path( from ), sizeof(from) );
+		rename( from, to );
+	}
+}
+
+static int network_backlog( void )
+{
+	int backlog = 0;
+	network_player_t * player;
+	for( player = network_players.first; player; player = player->next )
+		backlog += (int) player->backlog;
+	return backlog;
+}
+
+static void perf_hitch( perf_sample_t * sample )
+{
+	int i;
+	FILE * fp;
+	char name[256];
+	time_t now;
+	char stamp[64];
+	perf_counts_t counts;
+
+	hitch_log_name( name, sizeof(name), 0 );
+	if( Get_File_Size( name ) >= PERF_HITCH_LOG_SIZE )
+		hitch_log_rotate();
+
+	fp = file_open( name, "a" );
+	if( !fp )
+		return;
+
+	now = time( NULL );
+	strftime( stamp, sizeof(stamp), "%m-%d-%y %H:%M:%S", localtime( &now ) );
+
+	fprintf( fp, "%s hitch %.1f ms (budget %d ms, average %.1f ms) level %s\n",
+		stamp, sample->frame / 1000.0F, HitchBudget, frame_average / 1000.0F,
+		( LevelNum >= 0 ) ? ShortLevelNames[ LevelNum ] : "none" );
+
+	// zones that ran over their rolling average by a real amount
+	for( i = 0; i < PERF_MAX_ZONES; i++ )
+	{
+		float over = sample->zone[ i ] - zone_average[ i ];
+		if( over < 1000.0F || sample->zone[ i ] < zone_average[ i ] * 1.5F )
+			continue;
+		fprintf( fp, "  zone %-10s %7.1f ms average %6.1f ms (+%.1f)\n",
+			zones[ i ].name, sample->zone[ i ] / 1000.0F,
+			zone_average[ i ] / 1000.0F, over / 1000.0F );
+	}
+
+	perf_counts( &counts );
+	fprintf( fp, "  entities prim %d sec %d models %d polys %d fmpolys %d enemies %d\n",
+		counts.prim_bulls, counts.sec_bulls, counts.models,
+		counts.polys, counts.fm_polys, counts.enemies );
+
+	// tables that have turned allocations away since they were last set up
+	for( i = 0; i < (int)( sizeof(pools) / sizeof(pools[0]) ); i++ )
+	{
+		if( pools[ i ]->exhausted )
+			fprintf( fp, "  pool %-10s full, %d allocations refused (high water %d of %d)\n",
+				pools[ i ]->name, (int) pools[ i ]->exhausted,
+				pools[ i ]->high_water, pools[ i ]->size );
+	}
+
+	fprintf( fp, "  network in %d out %d bytes/sec backlog %d bytes\n",
+		(int) CurrentBytesPerSecRec, (int) CurrentBytesPerSecSent, network_backlog() );
+
+	fclose( fp );
+
+	DebugPrintf( "perf: %.1f ms hitch logged to %s\n", sample->frame / 1000.0F, name );
+}
+
+// closes the previous frame and starts timing a new one
+void perf_frame( void )
+{
+	u_int32_t now = perf_micros();
+
+	// first call has nothing to close
+	if( frame_start )
+	{
+		current.frame = now - frame_start;
+
+		// only in game frames count, level loads are expected to be slow
+		// and averages need a few frames before they mean anything
+		if( HitchBudget > 0 &&
+			current.frame > (u_int32_t) HitchBudget * 1000 &&
+			frame_in_game && in_game() &&
+			history_count >= PERF_AVERAGE_FRAMES )
+			perf_hitch( &current );
+
+		perf_average( &current );
+		perf_add( &current );
+	}
+
+	frame_start = now;
+	frame_in_game = in_game();
+	ZERO_STACK_MEM(current);
+}
+
+void perf_zone_begin( perf_zone_t zone )
+{
+	zone_start[ zone ] = perf_micros();
+}
+
+void perf_zone_end( perf_zone_t zone )
+{
+	current.zone[ zone ] += perf_micros() - zone_start[ zone ];
+}
+
+// 0 is the last completed frame
+const perf_sample_t * perf_sample( int ago )
+{
+	if( ago < 0 || ago >= history_count )
+		return NULL;
+	return &history[ ( history_next - 1 - ago ) & ( PERF_HISTORY - 1 ) ];
+}
+
+// frame time in micros that percent (0-100) of the recorded frames stay under
+u_int32_t perf_percentile( float percent )
+{
+	int i;
+	u_int32_t seen = 0;
+	u_int32_t wanted;
+
+	if( !history_count )
+		return 0;
+
+	wanted = (u_int32_t)( ( percent / 100.0F ) * history_count + 0.5F );
+	if( wanted < 1 )
+		wanted = 1;
+
+	for( i = 0; i < PERF_BUCKETS; i++ )
+	{
+		seen += histogram[ i ];
+		if( seen >= wanted )
+			return bucket_value( i );
+	}
+	return PERF_MAX_VALUE;
+}
+
+u_int32_t perf_worst( void )
+{
+	int i;
+	u_int32_t worst = 0;
+	for( i = 0; i < history_count; i++ )
+		if( history[ i ].frame > worst )
+			worst = history[ i ].frame;
+	return worst;
+}
+
+// the pools are rebuilt by save game loads so their counts stay right
+void perf_counts( perf_counts_t * counts )
+{
+	counts->prim_bulls = PrimBullPool.used;
+	counts->sec_bulls = SecBullPool.used;
+	counts->models = ModelPool.used;
+	counts->polys = PolyPool.used;
+	counts->fm_polys = FmPolyPool.used;
+	counts->enemies = EnemyPool.used;
+}
+
+//
+// overlay
+//
+
+#define GRAPH_COLUMNS	(64)
+#define GRAPH_ROWS		(8)
+#define GRAPH_AVERAGE	(32)	// frames averaged for the zone split
+
+static float ms( u_int32_t micros )
+{
+	return (float) micros / 1000.0F;
+}
+
+static void perf_graph( int x, int y )
+{
+	int i, row, colour;
+	u_int32_t top = PERF_BUDGET_MICROS * 2;
+	const perf_sample_t * sample;
+
+	// newest frame on the right
+	for( i = 0; i < GRAPH_COLUMNS; i++ )
+	{
+		sample = perf_sample( GRAPH_COLUMNS - 1 - i );
+		if( !sample )
+			continue;
+
+		if( sample->frame > PERF_BUDGET_MICROS * 2 )
+			colour = RED;
+		else if( sample->frame > PERF_BUDGET_MICROS )
+			colour = YELLOW;
+		else
+			colour = GREEN;
+
+		row = (int)( ( (float) sample->frame / (float) top ) * GRAPH_ROWS );
+		if( row >= GRAPH_ROWS )
+			row = GRAPH_ROWS - 1;
+
+		Print4x5Text( "*", x + i * FontWidth, y + ( GRAPH_ROWS - 1 - row ) * FontHeight, colour );
+	}
+
+	// budget line
+	Print4x5Text( "-", x + GRAPH_COLUMNS * FontWidth, y + ( GRAPH_ROWS - 1 - GRAPH_ROWS / 2 ) * FontHeight, GRAY );
+}
+
+void perf_overlay( void )
+{
+	char buf[256];
+	int i, n, x, y;
+	u_int32_t frame = 0;
+	u_int32_t zone[ PERF_MAX_ZONES ];
+	u_int32_t other;
+	perf_counts_t counts;
+	memo_stats_t memo;
+	const perf_sample_t * sample;
+
+	if( !history_count )
+		return;
+
+	// average the zone split so the numbers are readable
+	ZERO_STACK_MEM(zone);
+	for( n = 0; n < GRAPH_AVERAGE && ( sample = perf_sample( n ) ); n++ )
+	{
+		frame += sample->frame;
+		for( i = 0; i < PERF_MAX_ZONES; i++ )
+			zone[ i ] += sample->zone[ i ];
+	}
+	frame /= n;
+	for( i = 0; i < PERF_MAX_ZONES; i++ )
+		zone[ i ] /= n;
+	other = 0;
+	for( i = 0; i < PERF_MAX_ZONES; i++ )
+		if( !zones[ i ].nested )
+			other += zone[ i ];
+	other = ( frame > other ) ? frame - other : 0;
+
+	perf_counts( &counts );
+
+	x = FontWidth;
+	y = render_info.window_size.cy / 3;
+
+	sprintf( buf, "FRAME %.1f MS P50 %.1f P99 %.1f WORST %.1f",
+		ms( frame ), ms( perf_percentile( 50.0F ) ), ms( perf_percentile( 99.0F ) ), ms( perf_worst() ) );
+	Print4x5Text( buf, x, y, WHITE );
+	y += FontHeight + 3;
+
+	sprintf( buf, "SIM %.1f RENDER %.1f NET %.1f FLIP %.1f OTHER %.1f MS",
+		ms( zone[ PERF_ZONE_Sim ] ), ms( zone[ PERF_ZONE_Render ] ), ms( zone[ PERF_ZONE_Net ] ),
+		ms( zone[ PERF_ZONE_Flip ] ), ms( other ) );
+	Print4x5Text( buf, x, y, GRAY );
+	y += FontHeight + 3;
+
+	sprintf( buf, "NET IN %d OUT %d BYTES/SEC",
+		(int) CurrentBytesPerSecRec, (int) CurrentBytesPerSecSent );
+	Print4x5Text( buf, x, y, GRAY );
+	y += FontHeight + 3;
+
+	sprintf( buf, "PRIM %d SEC %d MODELS %d POLYS %d FMPOLYS %d ENEMIES %d",
+		counts.prim_bulls, counts.sec_bulls, counts.models, counts.polys, counts.fm_polys, counts.enemies );
+	Print4x5Text( buf, x, y, GRAY );
+	y += FontHeight + 3;
+
+	// hit rate of the per frame group query answers
+	strcpy( buf, "MEMO" );
+	for( i = 0; i < MEMO_MAX_KINDS; i++ )
+	{
+		memo_stats( (memo_kind_t) i, &memo, NULL );
+		sprintf( buf + strlen( buf ), " %s %d%% OF %d", memo_name( (memo_kind_t) i ),
+			memo.lookups ? (int) ( ( 100.0F * memo.hits ) / memo.lookups ) : 0, (int) memo.lookups );
+	}
+	Print4x5Text( buf, x, y, GRAY );
+	y += FontHeight + 3;
+
+	perf_graph( x, y );
+}
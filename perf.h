@@ -0,0 +1,100 @@
+#ifndef PERF_INCLUDED
+#define PERF_INCLUDED
+
+/*
+
+	description:
+
+			frame time history and per zone timings used by the
+			in game performance overlay
+
+	at every level start ( InitScene ), so the history and averages
+	only ever describe the level being played:
+
+			perf_reset();
+
+	once per frame:
+
+			perf_frame();
+
+	timing a zone inside the frame:
+
+			perf_zone_begin( PERF_ZONE_Sim );
+			MainRoutines();
+			perf_zone_end( PERF_ZONE_Sim );
+
+	percentiles are taken from a log-linear (hdr style) histogram
+	which always describes the last PERF_HISTORY frames
+
+	hitches:
+
+			any in game frame longer than HitchBudget ms is written to
+			Logs/hitch.txt with every zone that ran over its rolling
+			average, the live entity counts and the network backlog
+
+*/
+
+#include "main.h"
+
+// number of frames kept in the ring buffer (must be a power of two)
+#define PERF_HISTORY		(512)
+
+// frame time budget used to colour the overlay graph (60 fps)
+#define PERF_BUDGET_MICROS	(16667)
+
+// frames it takes the rolling zone averages to settle
+#define PERF_AVERAGE_FRAMES	(32)
+
+// hitch log is rotated into hitch.1.txt ... once it gets this big
+#define PERF_HITCH_LOG_SIZE	(256*1024)
+#define PERF_HITCH_LOGS		(3)
+
+// zones are flat, nested zones (ships inside sim...) are
+// marked in perf.c so they are not counted twice
+typedef enum {
+	PERF_ZONE_Input,		// ReadInput
+	PERF_ZONE_Sound,		// CheckSBufferList, ProcessLoopingSfx
+	PERF_ZONE_Sim,			// MainRoutines
+	PERF_ZONE_Ships,		//   ProcessShips
+	PERF_ZONE_Enemies,		//   ProcessEnemies
+	PERF_ZONE_Primary,		//   ProcessPrimaryBullets
+	PERF_ZONE_Secondary,	//   ProcessSecondaryBullets
+	PERF_ZONE_Pickups,		//   ProcessPickups
+	PERF_ZONE_Models,		//   ProcessModels
+	PERF_ZONE_Render,		// MainGameRender
+	PERF_ZONE_Net,			// NetworkGameUpdate
+	PERF_ZONE_Flip,			// render_flip
+	PERF_MAX_ZONES
+} perf_zone_t;
+
+typedef struct {
+	u_int32_t frame;					// microseconds from frame start to next frame start
+	u_int32_t zone[ PERF_MAX_ZONES ];	// microseconds spent inside each zone
+} perf_sample_t;
+
+typedef struct {
+	int prim_bulls;
+	int sec_bulls;
+	int models;
+	int polys;
+	int fm_polys;
+	int enemies;
+} perf_counts_t;
+
+extern bool ShowPerfOverlay;
+extern int  HitchBudget;		// ms, 0 turns the hitch log off
+
+u_int32_t perf_micros			( void );
+void      perf_reset			( void );
+void      perf_frame			( void );
+void      perf_zone_begin		( perf_zone_t zone );
+void      perf_zone_end			( perf_zone_t zone );
+
+const perf_sample_t * perf_sample ( int ago );
+u_int32_t perf_percentile		( float percent );
+u_int32_t perf_worst			( void );
+void      perf_counts			( perf_counts_t * counts );
+
+void      perf_overlay			( void );
+
+#endif
@@ -40,6 +40,7 @@
 #include "goal.h"
 #include "local.h"
 #include "util.h"
+#include "pool.h"
 
 #ifdef OPT_ON
 #pragma optimize( "gty", on )
@@ -80,7 +81,7 @@ extern	VECTOR			SlideLeft;
 extern	VECTOR			SlideRight;
 extern	XLIGHT			XLights[ MAXXLIGHTS ];
 extern	FMPOLY			FmPolys[ MAXNUMOF2DPOLYS ];
-extern	MODEL			Models[ MAXNUMOFMODELS ];
+extern	MODEL			*	Models;
 extern	float			framelag;
 extern	BYTE			WhoIAm;
 extern	LINE			Lines[ MAXLINES ];
@@ -153,7 +154,7 @@ extern	float			LevelTimeTaken;
 extern	u_int16_t			Seed1;
 extern	u_int16_t			Seed2;
 extern	u_int16_t			FirstSecBullUsed;
-extern	SECONDARYWEAPONBULLET SecBulls[MAXSECONDARYWEAPONBULLETS];
+extern	SECONDARYWEAPONBULLET * SecBulls;
 extern	MODELNAME		ModelNames[MAXMODELHEADERS];
 
 extern bool	NeedFlagAtHome;
@@ -182,7 +183,7 @@ PICKUP			Pickups[ MAXPICKUPS ];
 PICKUP			PickupsCopy[ MAX_PLAYERS ][ MAXPICKUPS ];
 REGENPOINT	*	RegenSlotsCopy[ MAX_PLAYERS ];
 u_int16_t			FirstPickupUsed;
-u_int16_t			FirstPickupFree;
+pool_t				PickupPool;
 char			UserMessage[ 256 ];
 int16_t			NumStealths = 0;
 int16_t			NumInvuls = 0;
@@ -828,7 +829,7 @@ void InitPickups( void )
 	InitFailedKillSlots();
 
 	FirstPickupUsed = (u_int16_t) -1;
-	FirstPickupFree = 0;
+	pool_init( &PickupPool, "pickups", MAXPICKUPS );
 
 	SetupPickupGroups();
 	ClearPickupsGot();
@@ -836,7 +837,7 @@ void InitPickups( void )
 	for( i = 0; i < MAXPICKUPS; i++ )
 	{
 		memset( &Pickups[ i ], 0, sizeof( PICKUP ) );
-		Pickups[ i ].Next = i + 1;
+		Pickups[ i ].Next = (u_int16_t) -1;
 		Pickups[ i ].Prev = (u_int16_t) -1;
 
 		Pickups[ i ].NextInGroup = NULL;
@@ -858,7 +859,6 @@ void InitPickups( void )
 		QuatFrom2Vectors( &Pickups[ i ].DirQuat, &Forward, &Pickups[ i ].DirVector );
 		QuatToMatrix( &Pickups[ i ].DirQuat, &Pickups[ i ].Mat );
 	}
-	Pickups[ MAXPICKUPS-1 ].Next = (u_int16_t) -1;
 }
 
 #if 0
@@ -2354,10 +2354,11 @@ u_int16_t FindFreePickup( void )
 {
 	u_int16_t i;
 
-	i = FirstPickupFree;
+	i = pool_alloc( &PickupPool );
 	
-	if ( i == (u_int16_t) -1 ) return i;
+	if ( i == POOL_NONE ) return i;
  
+	Pickups[i].Next = (u_int16_t) -1;
 	Pickups[i].Prev = FirstPickupUsed;
 	if( FirstPickupUsed != (u_int16_t) -1)
 	{
@@ -2367,7 +2368,6 @@ u_int16_t FindFreePickup( void )
 	Pickups[i].CouldNotPickup = false;
 
 	FirstPickupUsed = i;
-	FirstPickupFree = Pickups[ i ].Next;
 	return i ;
 }
 
@@ -2450,8 +2450,8 @@ void KillUsedPickup( u_int16_t i )
 
 	Pickups[ i ].Type = (u_int16_t) -1;
 	Pickups[ i ].Prev = (u_int16_t) -1;
-	Pickups[ i ].Next = FirstPickupFree;
-	FirstPickupFree	= i;
+	Pickups[ i ].Next = (u_int16_t) -1;
+	pool_free( &PickupPool, i );
 
 	RemovePickupFromGroup( i, Pickups[ i ].Group );
 }
@@ -4452,9 +4452,7 @@ u_int16_t FindClosestPickup( void )
 	float	ClosestDist = 0.0f;
 	float	Dist;
 
-	i = FirstPickupUsed;
-
-	while( i != (u_int16_t) -1 )
+	for( i = pool_first( &PickupPool ); i != POOL_NONE; i = pool_next( &PickupPool, i ) )
 	{
 		DistVector.x = ( Pickups[ i ].Pos.x - Ships[ WhoIAm ].Object.Pos.x );
 		DistVector.y = ( Pickups[ i ].Pos.y - Ships[ WhoIAm ].Object.Pos.y );
@@ -4474,8 +4472,6 @@ u_int16_t FindClosestPickup( void )
 			ClosestDist = Dist;
 			ClosestPickup = i;
 		}
-
-		i = Pickups[ i ].Prev;							/* Next Pickup */
 	}																				
 
 	return( ClosestPickup );
@@ -4807,6 +4803,7 @@ FILE * SaveAllPickups( FILE * fp )
 {
 	u_int16_t	i;
 	u_int16_t	TempIndex = (u_int16_t) -1; 
+	u_int16_t	FirstFree;
 
 	if( fp )
 	{
@@ -4840,7 +4837,8 @@ FILE * SaveAllPickups( FILE * fp )
 		fwrite( &PickupInvulnerability, sizeof( bool ), 1, fp );
 		fwrite( &NumGoldBars, sizeof( int16_t ), 1, fp );
 		fwrite( &FirstPickupUsed, sizeof( u_int16_t ), 1, fp );
-		fwrite( &FirstPickupFree, sizeof( u_int16_t ), 1, fp );
+		FirstFree = pool_free_slot( &PickupPool, 0 );
+		fwrite( &FirstFree, sizeof( u_int16_t ), 1, fp );
 		fwrite( &NumRegenPoints, sizeof( int16_t ), 1, fp );
 		fwrite( &CrystalsFound, sizeof( CrystalsFound ), 1, fp );
 
@@ -4909,13 +4907,7 @@ FILE * SaveAllPickups( FILE * fp )
 			i = Pickups[ i ].Prev;
 		}
 
-		i = FirstPickupFree;
-
-		while( i != (u_int16_t) -1 )
-		{
-			fwrite( &Pickups[ i ].Next, sizeof( u_int16_t ), 1, fp );
-			i = Pickups[ i ].Next;
-		}
+		pool_save_free( &PickupPool, fp );
 	}
 
 	return( fp );
@@ -4930,6 +4922,8 @@ FILE * LoadAllPickups( FILE * fp )
 {
 	u_int16_t	i;
 	u_int16_t	TempIndex;
+	u_int16_t	FirstFree;
+	u_int16_t	NextFree;
 
 	if( fp )
 	{
@@ -4964,7 +4958,8 @@ FILE * LoadAllPickups( FILE * fp )
 		fread( &PickupInvulnerability, sizeof( bool ), 1, fp );
 		fread( &NumGoldBars, sizeof( int16_t ), 1, fp );
 		fread( &FirstPickupUsed, sizeof( u_int16_t ), 1, fp );
-		fread( &FirstPickupFree, sizeof( u_int16_t ), 1, fp );
+		fread( &FirstFree, sizeof( u_int16_t ), 1, fp );
+		pool_clear( &PickupPool );
 		fread( &NumRegenPoints, sizeof( int16_t ), 1, fp );
 		fread( &CrystalsFound, sizeof( CrystalsFound ), 1, fp );
 
@@ -5034,14 +5029,16 @@ FILE * LoadAllPickups( FILE * fp )
 			fread( &Pickups[ i ].ColPoint, sizeof( VERT ), 1, fp );
 			fread( &Pickups[ i ].ColPointNormal, sizeof( NORMAL ), 1, fp );
 			fread( &Pickups[ i ].CouldNotPickup, sizeof( bool ), 1, fp );
+			pool_mark( &PickupPool, i );
 			i = Pickups[ i ].Prev;
 		}
 
-		i = FirstPickupFree;
+		i = FirstFree;
 
 		while( i != (u_int16_t) -1 )
 		{
 			memset( &Pickups[ i ], 0, sizeof( PICKUP ) );
+			Pickups[ i ].Next = (u_int16_t) -1;
 			Pickups[ i ].Prev = (u_int16_t) -1;
 			Pickups[ i ].NextInGroup = NULL;
 			Pickups[ i ].PrevInGroup = NULL;
@@ -5061,9 +5058,12 @@ FILE * LoadAllPickups( FILE * fp )
 			QuatFrom2Vectors( &Pickups[ i ].DirQuat, &Forward, &Pickups[ i ].DirVector );
 			QuatToMatrix( &Pickups[ i ].DirQuat, &Pickups[ i ].Mat );
 
-			fread( &Pickups[ i ].Next, sizeof( u_int16_t ), 1, fp );
-			i = Pickups[ i ].Next;
+			pool_load_free( &PickupPool, i );
+			fread( &NextFree, sizeof( u_int16_t ), 1, fp );
+			i = NextFree;
 		}
+
+		pool_rebuild( &PickupPool );
 	}
 
 	return( fp );
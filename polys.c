@@ -18,6 +18,7 @@
 #include "secondary.h"
 #include "main.h"
 #include "util.h"
+#include "pool.h"
 
 #ifdef OPT_ON
 #pragma optimize( "gty", on )
@@ -52,12 +53,29 @@ extern	BYTE			GameStatus[MAX_PLAYERS];
 /*===================================================================
 	Globals
 ===================================================================*/
-POLY		Polys[ MAXPOLYS ];
+POLY		*	Polys;
 u_int16_t		FirstPolyUsed;
-u_int16_t		FirstPolyFree;
+pool_t			PolyPool;
 u_int32_t		TotalPolysInUse = 0;
 TPAGEINFO	PolyTPages[ MAXTPAGESPERTLOAD + 1 ];
 
+/*===================================================================
+	Procedure	:	Init one poly, also called as the pool grows
+	Input		:	u_int16_t	Poly Index
+	Output		:	Nothing
+===================================================================*/
+static void InitPoly( u_int16_t i )
+{
+	memset( &Polys[ i ], 0, sizeof( POLY ) );
+	Polys[i].Next = (u_int16_t) -1;
+	Polys[i].Prev = (u_int16_t) -1;
+
+	Polys[i].NextInTPage = (u_int16_t) -1;
+	Polys[i].PrevInTPage = (u_int16_t) -1;
+
+	Polys[i].Frm_Info = NULL;
+}
+
 /*===================================================================
 	Procedure	:	Init poly structures
 	Input		:	Nothing
@@ -65,23 +83,8 @@ TPAGEINFO	PolyTPages[ MAXTPAGESPERTLOAD + 1 ];
 ===================================================================*/
 void InitPolys( void )
 {
-	int i;
-
 	FirstPolyUsed = (u_int16_t) -1;
-	FirstPolyFree = 0;
-	
-	for( i = 0; i < MAXPOLYS; i++ )
-	{
-		memset( &Polys[ i ], 0, sizeof( POLY ) );
-		Polys[i].Next = i + 1;
-		Polys[i].Prev = (u_int16_t) -1;
-
-		Polys[i].NextInTPage = (u_int16_t) -1;
-		Polys[i].PrevInTPage = (u_int16_t) -1;
-
-		Polys[i].Frm_Info = NULL;
-	}
-	Polys[ MAXPOLYS - 1 ].Next = (u_int16_t) -1;
+	pool_init_table( &PolyPool, "polys", (void **) &Polys, sizeof( POLY ), MAXPOLYS, InitPoly );
 
 	InitPolyTPages();
 }
@@ -96,15 +99,15 @@ u_int16_t FindFreePoly( void )
 {
 	u_int16_t i;
 
-	i = FirstPolyFree;
-	if( i == (u_int16_t) -1 ) return i;
+	i = pool_alloc( &PolyPool );
+	if( i == POOL_NONE ) return i;
  
+	Polys[ i ].Next = (u_int16_t) -1;
 	Polys[ i ].Prev = FirstPolyUsed;
 
 	if( FirstPolyUsed != (u_int16_t) -1) Polys[ FirstPolyUsed ].Next = i;
 
 	FirstPolyUsed = i;
-	FirstPolyFree = Polys[i].Next;
 
 	TotalPolysInUse++;
 
@@ -133,9 +136,9 @@ void KillUsedPoly( u_int16_t i )
 	RemovePolyFromTPage( i, GetTPage( *Polys[i].Frm_Info, 0 ) );
 
 	Polys[ i ].Prev = (u_int16_t) -1;
-	Polys[ i ].Next = FirstPolyFree;
+	Polys[ i ].Next = (u_int16_t) -1;
 	Polys[ i ].Frm_Info = NULL;
-	FirstPolyFree = i;
+	pool_free( &PolyPool, i );
 }
 
 /*===================================================================
@@ -703,7 +706,8 @@ bool PolyDispGroupClipped( u_int16_t Group, /*LPDIRECT3DEXECUTEBUFFER ExecBuffer
 
 	if( !TotalVerts ) return( false );
 
-	renderObject->numTextureGroups = 0;
+	if( !RESET_TEXTURE_GROUPS( renderObject ) )
+		return false;
 
 /*===================================================================
 		Lock Exec Buffer and get ready to fill in...
@@ -936,7 +940,8 @@ bool PolyDispGroupUnclipped( RENDEROBJECT *renderObject, int16_t * TPage, u_int1
 
 	if( !TotalVerts ) return( false );
 
-	renderObject->numTextureGroups = 0;
+	if( !RESET_TEXTURE_GROUPS( renderObject ) )
+		return false;
 
 	if (!(FSLockVertexBuffer(renderObject, &lpBufStart)))
 	{
@@ -1217,7 +1222,8 @@ bool SolidPolyDispGroupClipped( u_int16_t Group, /*LPDIRECT3DEXECUTEBUFFER ExecB
 
 	if( !TotalVerts ) return( false );
 
-	renderObject->numTextureGroups = 0;
+	if( !RESET_TEXTURE_GROUPS( renderObject ) )
+		return false;
 
 /*===================================================================
 		Lock Exec Buffer and get ready to fill in...
@@ -1450,7 +1456,8 @@ bool SolidPolyDispGroupUnclipped( RENDEROBJECT *renderObject, int16_t * TPage, u
 
 	if( !TotalVerts ) return( false );
 
-	renderObject->numTextureGroups = 0;
+	if( !RESET_TEXTURE_GROUPS( renderObject ) )
+		return false;
 
 /*===================================================================
 		Lock Exec Buffer and get ready to fill in...
@@ -1622,13 +1629,15 @@ bool SolidPolyDispGroupUnclipped( RENDEROBJECT *renderObject, int16_t * TPage, u
 FILE * SavePolys( FILE * fp )
 {
 	u_int16_t	i;
+	u_int16_t	FirstFree;
 	int16_t	Frm_Info_Index;
 
 	if( fp )
 	{
+		FirstFree = pool_free_slot( &PolyPool, 0 );
 		fwrite( &TotalPolysInUse, sizeof( u_int32_t ),1 ,fp );
 		fwrite( &FirstPolyUsed, sizeof( FirstPolyUsed ), 1, fp );
-		fwrite( &FirstPolyFree, sizeof( FirstPolyFree ), 1, fp );
+		fwrite( &FirstFree, sizeof( FirstFree ), 1, fp );
 		
 		for( i = 0; i < ( MAXTPAGESPERTLOAD + 1 ); i++ )
 		{
@@ -1670,13 +1679,7 @@ FILE * SavePolys( FILE * fp )
 			i = Polys[ i ].Prev;
 		}
 
-		i = FirstPolyFree;
-
-		while( i != (u_int16_t) -1 )
-		{
-			fwrite( &Polys[ i ].Next, sizeof( u_int16_t ), 1, fp );
-			i = Polys[ i ].Next;
-		}
+		pool_save_free( &PolyPool, fp );
 	}
 
 	return( fp );
@@ -1690,13 +1693,16 @@ FILE * SavePolys( FILE * fp )
 FILE * LoadPolys( FILE * fp )
 {
 	u_int16_t	i;
+	u_int16_t	FirstFree;
+	u_int16_t	NextFree;
 	int16_t	Frm_Info_Index;
 
 	if( fp )
 	{
 		fread( &TotalPolysInUse, sizeof( u_int32_t ),1 ,fp );
 		fread( &FirstPolyUsed, sizeof( FirstPolyUsed ), 1, fp );
-		fread( &FirstPolyFree, sizeof( FirstPolyFree ), 1, fp );
+		fread( &FirstFree, sizeof( FirstFree ), 1, fp );
+		pool_clear( &PolyPool );
 		
 		for( i = 0; i < ( MAXTPAGESPERTLOAD + 1 ); i++ )
 		{
@@ -1707,6 +1713,11 @@ FILE * LoadPolys( FILE * fp )
 
 		while( i != (u_int16_t) -1 )
 		{
+			if( !pool_fit( &PolyPool, i ) )
+			{
+				fclose( fp );
+				return( NULL );
+			}
 			fread( &Polys[ i ].Next, sizeof( u_int16_t ), 1, fp );
 			fread( &Polys[ i ].Prev, sizeof( u_int16_t ), 1, fp );
 			fread( &Polys[ i ].NextInTPage, sizeof( u_int16_t ), 1, fp );
@@ -1736,22 +1747,27 @@ FILE * LoadPolys( FILE * fp )
 			Polys[ i ].Qlerp.crnt = &Polys[ i ].Quat;
 			fread( &Polys[ i ].Quat, sizeof( QUAT ), 1, fp );
 			fread( &Polys[ i ].Ship, sizeof( u_int16_t ), 1, fp );
+			pool_mark( &PolyPool, i );
 			i = Polys[ i ].Prev;
 		}
 
-		i = FirstPolyFree;
+		i = FirstFree;
 
 		while( i != (u_int16_t) -1 )
 		{
-			memset( &Polys[ i ], 0, sizeof( POLY ) );
-			Polys[i].Prev = (u_int16_t) -1;
-			Polys[i].NextInTPage = (u_int16_t) -1;
-			Polys[i].PrevInTPage = (u_int16_t) -1;
-			Polys[i].Frm_Info = NULL;
+			if( !pool_fit( &PolyPool, i ) )
+			{
+				fclose( fp );
+				return( NULL );
+			}
+			InitPoly( i );
 
-			fread( &Polys[ i ].Next, sizeof( u_int16_t ), 1, fp );
-			i = Polys[ i ].Next;
+			pool_load_free( &PolyPool, i );
+			fread( &NextFree, sizeof( u_int16_t ), 1, fp );
+			i = NextFree;
 		}
+
+		pool_rebuild( &PolyPool );
 	}
 
 	return( fp );
@@ -0,0 +1,440 @@
+#include <stdio.h>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#include "main.h"
+#include "util.h"
+#include "pool.h"
+
+#define POOL_WORDS( SIZE )	( ( (SIZE) + 31 ) >> 5 )
+
+// tables are backed in steps of this many bytes, a multiple of any page size we run on
+#define POOL_COMMIT			( 64 * 1024 )
+#define POOL_ROUND( BYTES )	( ( (BYTES) + POOL_COMMIT - 1 ) & ~( (size_t) POOL_COMMIT - 1 ) )
+
+int PoolGrowth = 4;
+
+/*===================================================================
+	Address space for a table is reserved once at its largest size
+	and only backed by memory as the table grows, so it never moves
+===================================================================*/
+static void * vm_reserve( size_t bytes )
+{
+#ifdef WIN32
+	return VirtualAlloc( NULL, bytes, MEM_RESERVE, PAGE_NOACCESS );
+#else
+	void * p = mmap( NULL, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	return ( p == MAP_FAILED ) ? NULL : p;
+#endif
+}
+
+static bool vm_commit( void * p, size_t bytes )
+{
+#ifdef WIN32
+	return VirtualAlloc( p, bytes, MEM_COMMIT, PAGE_READWRITE ) != NULL;
+#else
+	return mprotect( p, bytes, PROT_READ | PROT_WRITE ) == 0;
+#endif
+}
+
+static void vm_release( void * p, size_t bytes )
+{
+#ifdef WIN32
+	VirtualFree( p, 0, MEM_RELEASE );
+#else
+	munmap( p, bytes );
+#endif
+}
+
+/*===================================================================
+	Procedure	:	Set up a pool, can be called again to reset it
+	Input		:	pool_t * , name for the log , number of slots
+	Output		:	bool false if out of memory
+===================================================================*/
+bool pool_init( pool_t * pool, char * name, u_int16_t size )
+{
+	if( pool->free && pool->size != size )
+		pool_release( pool );
+
+	pool->name = name;
+
+	if( !pool->free )
+	{
+		pool->free = (u_int16_t *) malloc( size * sizeof( u_int16_t ) );
+		pool->bits = (u_int32_t *) malloc( POOL_WORDS( size ) * sizeof( u_int32_t ) );
+		if( !pool->free || !pool->bits )
+		{
+			Msg( "pool %s: failed to allocate %d slots\n", name, size );
+			pool_release( pool );
+			return false;
+		}
+		pool->size = size;
+		pool->limit = size;
+		pool->ceiling = size;
+	}
+
+	pool->high_water = 0;
+	pool->exhausted = 0;
+	pool_reset( pool );
+
+	return true;
+}
+
+/*===================================================================
+	Procedure	:	Set up a pool that owns its table, can be called
+				:	again to reset it, a table that has grown keeps
+				:	its size
+	Input		:	pool_t * , name for the log , where to put the
+				:	table , bytes per slot , starting number of
+				:	slots , called for every slot when it is added
+				:	or reset
+	Output		:	bool false if out of memory
+===================================================================*/
+bool pool_init_table( pool_t * pool, char * name, void ** table, size_t item_size, u_int16_t size, void (*init_slot)( u_int16_t i ) )
+{
+	u_int32_t ceiling;
+	u_int32_t limit;
+	u_int16_t i;
+
+	ceiling = (u_int32_t) size * POOL_MAX_GROWTH;
+	if( ceiling > 0xfffe )
+		ceiling = 0xfffe;
+
+	if( pool->table && ( pool->item_size != item_size || pool->ceiling != ceiling ) )
+		pool_release( pool );
+
+	pool->name = name;
+	pool->init_slot = init_slot;
+
+	if( !pool->table )
+	{
+		pool->item_size = item_size;
+		pool->ceiling = (u_int16_t) ceiling;
+		pool->committed = 0;
+		pool->size = 0;
+		pool->table = (char *) vm_reserve( POOL_ROUND( ceiling * item_size ) );
+		pool->free = (u_int16_t *) malloc( ceiling * sizeof( u_int16_t ) );
+		pool->bits = (u_int32_t *) calloc( POOL_WORDS( ceiling ), sizeof( u_int32_t ) );
+		if( !pool->table || !pool->free || !pool->bits )
+		{
+			Msg( "pool %s: failed to reserve %d slots\n", name, ceiling );
+			pool_release( pool );
+			*table = NULL;
+			return false;
+		}
+	}
+
+	if( pool->size < size )
+	{
+		if( !vm_commit( pool->table, POOL_ROUND( size * item_size ) ) )
+		{
+			Msg( "pool %s: failed to allocate %d slots\n", name, size );
+			pool_release( pool );
+			*table = NULL;
+			return false;
+		}
+		pool->committed = POOL_ROUND( size * item_size );
+		pool->size = size;
+	}
+
+	limit = (u_int32_t) size * ( ( PoolGrowth < 1 ) ? 1 : PoolGrowth );
+	if( limit > ceiling )
+		limit = ceiling;
+	if( limit < pool->size )
+		limit = pool->size;
+	pool->limit = (u_int16_t) limit;
+
+	pool->high_water = 0;
+	pool->exhausted = 0;
+	pool_reset( pool );
+
+	// the owner's table pointer has to be set before init_slot uses it
+	*table = pool->table;
+
+	if( init_slot )
+		for( i = 0; i < pool->size; i++ )
+			init_slot( i );
+
+	return true;
+}
+
+/*===================================================================
+	Procedure	:	Add POOL_CHUNK slots to a table the pool owns
+	Output		:	bool false if the table is at its limit
+===================================================================*/
+bool pool_grow( pool_t * pool )
+{
+	u_int32_t size;
+	size_t bytes;
+	int i;
+
+	if( !pool->table || pool->size >= pool->limit )
+		return false;
+
+	size = pool->size + POOL_CHUNK;
+	if( size > pool->limit )
+		size = pool->limit;
+
+	bytes = POOL_ROUND( size * pool->item_size );
+	if( bytes > pool->committed )
+	{
+		if( !vm_commit( pool->table + pool->committed, bytes - pool->committed ) )
+		{
+			Msg( "pool %s: failed to grow to %d slots\n", pool->name, size );
+			pool->limit = pool->size;
+			return false;
+		}
+		pool->committed = bytes;
+	}
+
+	// new slots go on the free stack lowest on top
+	for( i = size - 1; i >= pool->size; i-- )
+	{
+		pool->bits[ i >> 5 ] &= ~( 1U << ( i & 31 ) );
+		pool->free[ pool->num_free++ ] = (u_int16_t) i;
+		if( pool->init_slot )
+			pool->init_slot( (u_int16_t) i );
+	}
+
+	DebugPrintf( "pool %s: grown from %d to %d slots\n", pool->name, pool->size, size );
+	pool->size = (u_int16_t) size;
+
+	return true;
+}
+
+/*===================================================================
+	Procedure	:	Grow a table until slot i exists
+	Output		:	bool false if slot i is past the limit
+===================================================================*/
+bool pool_fit( pool_t * pool, u_int16_t i )
+{
+	while( i >= pool->size )
+	{
+		if( !pool_grow( pool ) )
+			return false;
+	}
+	return true;
+}
+
+void pool_release( pool_t * pool )
+{
+	if( pool->table )
+		vm_release( pool->table, POOL_ROUND( pool->ceiling * pool->item_size ) );
+	if( pool->free )
+		free( pool->free );
+	if( pool->bits )
+		free( pool->bits );
+	pool->table = NULL;
+	pool->free = NULL;
+	pool->bits = NULL;
+	pool->size = 0;
+	pool->limit = 0;
+	pool->ceiling = 0;
+	pool->committed = 0;
+	pool->used = 0;
+	pool->num_free = 0;
+}
+
+/*===================================================================
+	Procedure	:	Free every slot, slot 0 is handed out first
+===================================================================*/
+void pool_reset( pool_t * pool )
+{
+	pool_clear( pool );
+	pool_rebuild( pool );
+}
+
+u_int16_t pool_alloc( pool_t * pool )
+{
+	u_int16_t i;
+
+	if( !pool->num_free && !pool_grow( pool ) )
+	{
+		// only log the first time so a big fight doesn't flood the log
+		if( !pool->exhausted++ )
+			DebugPrintf( "pool %s: all %d slots in use\n", pool->name, pool->size );
+		return POOL_NONE;
+	}
+
+	i = pool->free[ --pool->num_free ];
+	pool->bits[ i >> 5 ] |= ( 1U << ( i & 31 ) );
+
+	pool->used++;
+	if( pool->used > pool->high_water )
+		pool->high_water = pool->used;
+
+	return i;
+}
+
+void pool_free( pool_t * pool, u_int16_t i )
+{
+	if( i >= pool->size || !POOL_IN_USE( pool, i ) )
+	{
+		DebugPrintf( "pool %s: slot %d freed but not in use\n", pool->name, i );
+		return;
+	}
+
+	pool->bits[ i >> 5 ] &= ~( 1U << ( i & 31 ) );
+	pool->free[ pool->num_free++ ] = i;
+	pool->used--;
+}
+
+/*===================================================================
+	Procedure	:	Find the next used slot at or after i
+===================================================================*/
+static u_int16_t pool_scan( pool_t * pool, u_int32_t i )
+{
+	u_int32_t word, bits;
+
+	if( i >= pool->size )
+		return POOL_NONE;
+
+	word = i >> 5;
+	bits = pool->bits[ word ] & ( 0xffffffffU << ( i & 31 ) );
+
+	while( !bits )
+	{
+		if( ++word >= (u_int32_t) POOL_WORDS( pool->size ) )
+			return POOL_NONE;
+		bits = pool->bits[ word ];
+	}
+
+	// lowest set bit
+	i = word << 5;
+	while( !( bits & 1 ) )
+	{
+		bits >>= 1;
+		i++;
+	}
+
+	return ( i < pool->size ) ? (u_int16_t) i : POOL_NONE;
+}
+
+u_int16_t pool_first( pool_t * pool )
+{
+	return pool_scan( pool, 0 );
+}
+
+u_int16_t pool_next( pool_t * pool, u_int16_t i )
+{
+	return pool_scan( pool, (u_int32_t) i + 1 );
+}
+
+/*===================================================================
+	Procedure	:	Which slot will be handed out n allocations from now
+				:	( save games still store the free list )
+===================================================================*/
+u_int16_t pool_free_slot( pool_t * pool, int n )
+{
+	if( n < 0 || n >= pool->num_free )
+		return POOL_NONE;
+	return pool->free[ pool->num_free - 1 - n ];
+}
+
+/*===================================================================
+	Procedure	:	Write the free slots as the chain of next free
+				:	indices the old free lists saved
+	Input		:	pool_t * , FILE *
+	Output		:	FILE *
+===================================================================*/
+FILE * pool_save_free( pool_t * pool, FILE * fp )
+{
+	u_int16_t next;
+	int n;
+
+	for( n = 0; n < pool->num_free; n++ )
+	{
+		next = pool_free_slot( pool, n + 1 );
+		fwrite( &next, sizeof( u_int16_t ), 1, fp );
+	}
+
+	return fp;
+}
+
+void pool_clear( pool_t * pool )
+{
+	memset( pool->bits, 0, POOL_WORDS( pool->size ) * sizeof( u_int32_t ) );
+	pool->used = 0;
+	pool->num_free = 0;
+}
+
+void pool_mark( pool_t * pool, u_int16_t i )
+{
+	if( i >= pool->size || POOL_IN_USE( pool, i ) )
+		return;
+
+	pool->bits[ i >> 5 ] |= ( 1U << ( i & 31 ) );
+	pool->used++;
+	if( pool->used > pool->high_water )
+		pool->high_water = pool->used;
+}
+
+/*===================================================================
+	Procedure	:	Note a slot the save game had free, in the order
+				:	it will be handed out
+	Input		:	pool_t * , u_int16_t
+===================================================================*/
+void pool_load_free( pool_t * pool, u_int16_t i )
+{
+	if( i >= pool->size || pool->num_free >= pool->size )
+		return;
+
+	pool->free[ pool->num_free++ ] = i;
+}
+
+/*===================================================================
+	Procedure	:	Put every unmarked slot back on the free stack,
+				:	the slots from pool_load_free on top in their
+				:	saved order and the rest below them lowest on top
+===================================================================*/
+void pool_rebuild( pool_t * pool )
+{
+	u_int16_t i;
+	int loaded;
+	int rest;
+	int n;
+
+	// drop used or repeated slots from the saved order, borrowing
+	// the used bit to spot repeats
+	loaded = 0;
+	for( n = 0; n < pool->num_free; n++ )
+	{
+		i = pool->free[ n ];
+		if( POOL_IN_USE( pool, i ) )
+			continue;
+		pool->bits[ i >> 5 ] |= ( 1U << ( i & 31 ) );
+		pool->free[ loaded++ ] = i;
+	}
+
+	// the first saved slot goes on top
+	for( n = 0; n < loaded / 2; n++ )
+	{
+		i = pool->free[ n ];
+		pool->free[ n ] = pool->free[ loaded - 1 - n ];
+		pool->free[ loaded - 1 - n ] = i;
+	}
+
+	rest = pool->size - pool->used - loaded;
+	if( rest < 0 )
+		rest = 0;
+	if( rest )
+	{
+		memmove( &pool->free[ rest ], &pool->free[ 0 ], loaded * sizeof( u_int16_t ) );
+
+		n = 0;
+		for( i = pool->size; i-- > 0; )
+		{
+			if( !POOL_IN_USE( pool, i ) )
+				pool->free[ n++ ] = i;
+		}
+	}
+
+	for( n = 0; n < loaded; n++ )
+	{
+		i = pool->free[ rest + n ];
+		pool->bits[ i >> 5 ] &= ~( 1U << ( i & 31 ) );
+	}
+	pool->num_free = (u_int16_t) ( rest + loaded );
+}
@@ -0,0 +1,98 @@
+#ifndef POOL_INCLUDED
+#define POOL_INCLUDED
+
+/*
+
+	description:
+
+			hands out slot numbers for a table of entities
+			( bullets, models, polys ... ) and keeps an occupancy
+			bit per slot
+
+	setup for a table that stays with its owner:
+
+			pool_init( &LinePool, "lines", MAXLINES );
+
+	or for a table the pool owns and can grow, the table never moves
+	so indices and pointers into it stay good:
+
+			pool_init_table( &PolyPool, "polys", (void **) &Polys, sizeof( POLY ), MAXPOLYS, InitPoly );
+
+	a growable table starts at the given size and adds POOL_CHUNK slots
+	whenever it runs out, up to PoolGrowth times the starting size,
+	init_slot is called for every slot added
+
+	allocating and freeing:
+
+			i = pool_alloc( &PolyPool );	// POOL_NONE when full
+			pool_free( &PolyPool, i );
+
+	walking the live slots in index order:
+
+			for( i = pool_first( &PolyPool ); i != POOL_NONE; i = pool_next( &PolyPool, i ) )
+
+	save games write the free slots in the order they will be handed out:
+
+			pool_save_free( &PolyPool, fp );
+
+	and rebuild the pool from what was loaded:
+
+			pool_clear( &PolyPool );
+			pool_fit( &PolyPool, i );		// before touching a saved slot, grows the table to fit it
+			pool_mark( &PolyPool, i );		// for every slot loaded as used
+			pool_load_free( &PolyPool, i );	// for every saved free slot, in saved order
+			pool_rebuild( &PolyPool );
+
+	slots are handed out lowest first after a reset and the most
+	recently freed first after that, same as the old free lists
+
+*/
+
+#include <stdio.h>
+#include "main.h"
+
+#define POOL_NONE	((u_int16_t) -1)
+
+#define POOL_MAX_GROWTH	(8)		// address space is reserved for this many times the starting size
+#define POOL_CHUNK		(64)	// slots added each time a table grows
+
+// how many times its starting size a table may grow to ( 1 keeps the old fixed sizes )
+extern int PoolGrowth;
+
+typedef struct {
+	char *		name;
+	u_int16_t	size;			// slots in the table
+	u_int16_t	limit;			// most slots the table may grow to
+	u_int16_t	ceiling;		// slots the free stack and bits have room for
+	u_int16_t	used;			// slots handed out
+	u_int16_t	high_water;		// most slots in use at once
+	u_int32_t	exhausted;		// allocations refused because the table was full
+	u_int16_t	num_free;		// entries on the free stack
+	u_int16_t *	free;			// free slots, the next one to hand out on top
+	u_int32_t *	bits;			// one bit per slot, set while in use
+	size_t		item_size;		// bytes per slot of a table the pool owns
+	size_t		committed;		// bytes of the table backed by memory
+	char *		table;			// table the pool owns, NULL if it stays with its owner
+	void		(*init_slot)( u_int16_t i );
+} pool_t;
+
+#define POOL_IN_USE( POOL, I )	( ( (POOL)->bits[ (I) >> 5 ] >> ( (I) & 31 ) ) & 1 )
+
+bool		pool_init		( pool_t * pool, char * name, u_int16_t size );
+bool		pool_init_table	( pool_t * pool, char * name, void ** table, size_t item_size, u_int16_t size, void (*init_slot)( u_int16_t i ) );
+bool		pool_grow		( pool_t * pool );
+bool		pool_fit		( pool_t * pool, u_int16_t i );
+void		pool_release	( pool_t * pool );
+void		pool_reset		( pool_t * pool );
+u_int16_t	pool_alloc		( pool_t * pool );
+void		pool_free		( pool_t * pool, u_int16_t i );
+u_int16_t	pool_first		( pool_t * pool );
+u_int16_t	pool_next		( pool_t * pool, u_int16_t i );
+u_int16_t	pool_free_slot	( pool_t * pool, int n );
+FILE *		pool_save_free	( pool_t * pool, FILE * fp );
+void		pool_clear		( pool_t * pool );
+void		pool_mark		( pool_t * pool, u_int16_t i );
+void		pool_load_free	( pool_t * pool, u_int16_t i );
+void		pool_rebuild	( pool_t * pool );
+
+#endif
@@ -39,6 +39,7 @@
 #include "ai.h"
 #include "water.h"
 #include "util.h"
+#include "pool.h"
 
 #ifdef SHADOWTEST
 #include "shadows.h"
@@ -73,14 +74,15 @@ extern	MCLOADHEADER	MCloadheader;
 extern	MCLOADHEADER	MCloadheadert0;
 extern	XLIGHT			XLights[MAXXLIGHTS];
 extern	FMPOLY			FmPolys[MAXNUMOF2DPOLYS];
-extern	POLY			Polys[MAXPOLYS];
+extern	POLY			*	Polys;
 extern	LINE			Lines[ MAXLINES ];
 extern	float			framelag;
 extern	BYTE			WhoIAm;
-extern	MODEL			Models[ MAXNUMOFMODELS ];
+extern	MODEL			*	Models;
 extern	RENDERMATRIX		identity;
 extern	u_int16_t			FirstSecBullUsed;
-extern	SECONDARYWEAPONBULLET SecBulls[MAXSECONDARYWEAPONBULLETS];
+extern	SECONDARYWEAPONBULLET * SecBulls;
+extern	pool_t			SecBullPool;
 extern	int16_t			SecondaryWeaponsGot[ MAXSECONDARYWEAPONS ];
 extern	VECTOR			ShieldVerts[ 4 ];
 extern	int16_t			SecondaryAmmo[ MAXSECONDARYWEAPONS ];
@@ -123,7 +125,7 @@ extern	int16_t			NumInvuls;
 extern	COMP_OBJ	*	ColChild;
 extern	MODELNAME		ModelNames[MAXMODELHEADERS];
 extern	float			SoundInfo[MAXGROUPS][MAXGROUPS];
-extern	ENEMY			Enemies[ MAXENEMIES ];
+extern	ENEMY			*	Enemies;
 extern	ENEMY_TYPES		EnemyTypes[ MAX_ENEMY_TYPES ];
 extern	int16_t			NumSecBullsPerGroup[ MAXGROUPS ];
 extern	SECONDARYWEAPONBULLET *	SecBullGroups[ MAXGROUPS ];
@@ -186,9 +188,9 @@ extern	int16_t	TargetingWeaponCheat;
 
 float	NmeDamageModifier = 0.75F;
 
-PRIMARYWEAPONBULLET	PrimBulls[MAXPRIMARYWEAPONBULLETS];
+PRIMARYWEAPONBULLET	*	PrimBulls;
 u_int16_t	FirstPrimBullUsed;
-u_int16_t	FirstPrimBullFree;
+pool_t		PrimBullPool;
 float	PrimaryFireDelay = 0.0F;
 float	OrbitFireDelay = 0.0F;
 float	LaserDiameter = ( 40.0F * GLOBAL_SCALE );
@@ -680,6 +682,33 @@ PRIMARYWEAPONATTRIB	PrimaryWeaponAttribs[ TOTALPRIMARYWEAPONS ] = {
 	},
 };
 
+/*===================================================================
+	Procedure	:	Init one PrimBull, also called as the pool grows
+	Input		:	u_int16_t	PrimBull Index
+	Output		:	nothing
+===================================================================*/
+static void InitPrimBull( u_int16_t i )
+{
+	memset( &PrimBulls[i], 0, sizeof( PRIMARYWEAPONBULLET ) );
+	PrimBulls[i].Used = false;
+	PrimBulls[i].Next = (u_int16_t) -1;
+	PrimBulls[i].Prev = (u_int16_t) -1;
+	PrimBulls[i].Type = (u_int16_t) -1;
+	PrimBulls[i].Owner = (u_int16_t) -1;
+	PrimBulls[i].GroupImIn = (u_int16_t) -1;
+	PrimBulls[i].fmpoly = (u_int16_t) -1;
+	PrimBulls[i].light = (u_int16_t) -1;
+	PrimBulls[i].line = (u_int16_t) -1;
+	PrimBulls[i].TimeInterval = (float) 1;
+}
+
+// wall queries of the bullets fired or turned since last tick, made
+// together before the bullets are processed and sized with the pool
+static BGCOLQUERY *	PrimCols = NULL;
+static u_int16_t *	PrimColOf = NULL;		// query for each bullet, -1 if none
+static int			PrimColsSize = 0;
+static int			NumPrimCols = 0;
+
 /*===================================================================
 	Procedure	:	Set up And Init all PrimBulls
 	Input		:	nothing
@@ -687,24 +716,9 @@ PRIMARYWEAPONATTRIB	PrimaryWeaponAttribs[ TOTALPRIMARYWEAPONS ] = {
 ===================================================================*/
 void	InitPrimBulls(void)
 {
-	u_int16_t	i;
 	FirstPrimBullUsed = (u_int16_t) -1;
-	FirstPrimBullFree = 0;
-	for( i = 0 ; i < MAXPRIMARYWEAPONBULLETS ; i++ )
-	{
-		memset( &PrimBulls[i], 0, sizeof( PRIMARYWEAPONBULLET ) );
-		PrimBulls[i].Used = false;
-		PrimBulls[i].Next = i + 1;
-		PrimBulls[i].Prev = (u_int16_t) -1;
-		PrimBulls[i].Type = (u_int16_t) -1;
-		PrimBulls[i].Owner = (u_int16_t) -1;
-		PrimBulls[i].GroupImIn = (u_int16_t) -1;
-		PrimBulls[i].fmpoly = (u_int16_t) -1;
-		PrimBulls[i].light = (u_int16_t) -1;
-		PrimBulls[i].line = (u_int16_t) -1;
-		PrimBulls[i].TimeInterval = (float) 1;
-	}
-	PrimBulls[MAXPRIMARYWEAPONBULLETS-1].Next = (u_int16_t) -1;
+	pool_init_table( &PrimBullPool, "primbulls", (void **) &PrimBulls,
+		sizeof( PRIMARYWEAPONBULLET ), MAXPRIMARYWEAPONBULLETS, InitPrimBull );
 
 	RestoreWeapons();
 	RestoreAmmo();
@@ -836,9 +850,9 @@ u_int16_t	FindFreePrimBull(void)
 {
 	u_int16_t i;
 
-	i = FirstPrimBullFree;
+	i = pool_alloc( &PrimBullPool );
 	
-	if ( i == (u_int16_t) -1)
+	if ( i == POOL_NONE )
 		return i;
  
 	if( PrimBulls[i].Used )
@@ -847,13 +861,13 @@ u_int16_t	FindFreePrimBull(void)
 		Msg( "%s Bullet has been Used more than once\n",DebugPrimStrings[PrimBulls[i].Type]  );
 	}
 
+	PrimBulls[i].Next = (u_int16_t) -1;
 	PrimBulls[i].Prev = FirstPrimBullUsed;
 	if ( FirstPrimBullUsed != (u_int16_t) -1)
 	{
 		PrimBulls[FirstPrimBullUsed].Next = i;
 	}
 	FirstPrimBullUsed = i;
-	FirstPrimBullFree = PrimBulls[i].Next;
 
 	PrimBulls[i].TimeInterval = (float) 1;
 	PrimBulls[i].TimeCount = 0.0F;
@@ -892,9 +906,13 @@ void	KillUsedPrimBull( u_int16_t i )
 		PrimBulls[its_next].Prev = its_prev;
 
 	PrimBulls[i].Prev = (u_int16_t) -1;
-	PrimBulls[i].Next = FirstPrimBullFree;
-	FirstPrimBullFree	= i;
+	PrimBulls[i].Next = (u_int16_t) -1;
+	pool_free( &PrimBullPool, i );
 	PrimBulls[i].Used = false;
+
+	// a bullet fired into this slot later in the tick makes its own query
+	if( i < PrimColsSize )
+		PrimColOf[ i ] = (u_int16_t) -1;
 }
 
 /*===================================================================
@@ -1585,6 +1603,66 @@ static int16_t	OnceOnlyFlag = 0;
 	}
 }
 
+/*===================================================================
+	Procedure	:	Find the wall every bullet fired or turned since
+				:	last tick will hit, as one batch
+	Input		:	nothing
+	Output		:	nothing
+===================================================================*/
+static void QueuePrimCols( void )
+{
+	u_int16_t		i;
+	int				k;
+	BGCOLQUERY	*	Cols;
+	u_int16_t	*	ColOf;
+
+	NumPrimCols = 0;
+
+	if( PrimBullPool.size > PrimColsSize )
+	{
+		Cols = (BGCOLQUERY *) realloc( PrimCols, PrimBullPool.size * sizeof( BGCOLQUERY ) );
+		if( Cols )
+			PrimCols = Cols;
+		ColOf = (u_int16_t *) realloc( PrimColOf, PrimBullPool.size * sizeof( u_int16_t ) );
+		if( ColOf )
+			PrimColOf = ColOf;
+		if( !Cols || !ColOf )
+			return;	// one at a time in the pass until there is room
+		for( k = PrimColsSize; k < PrimBullPool.size; k++ )
+			PrimColOf[ k ] = (u_int16_t) -1;
+		PrimColsSize = PrimBullPool.size;
+	}
+
+	for( i = FirstPrimBullUsed; i != (u_int16_t) -1; i = PrimBulls[ i ].Prev )
+	{
+		PrimColOf[ i ] = (u_int16_t) -1;
+
+		if( PrimBulls[ i ].ColFlag || PrimBulls[ i ].LifeCount <= 0.0F )
+			continue;
+
+		// lasers go back onto their gun in the pass before they look
+		switch( PrimBulls[ i ].Weapon )
+		{
+			case LASER:
+			case NME_LASER:
+			case NME_LIGHTNING:
+			case NME_POWERLASER:
+				continue;
+		}
+
+		PrimColOf[ i ] = (u_int16_t) NumPrimCols;
+		PrimCols[ NumPrimCols ].StartPos = PrimBulls[ i ].Pos;
+		PrimCols[ NumPrimCols ].StartGroup = PrimBulls[ i ].GroupImIn;
+		PrimCols[ NumPrimCols ].MoveOffset.x = ( PrimBulls[ i ].Dir.x * MaxColDistance );
+		PrimCols[ NumPrimCols ].MoveOffset.y = ( PrimBulls[ i ].Dir.y * MaxColDistance );
+		PrimCols[ NumPrimCols ].MoveOffset.z = ( PrimBulls[ i ].Dir.z * MaxColDistance );
+		PrimCols[ NumPrimCols ].BGCol = false;
+		NumPrimCols++;
+	}
+
+	BackgroundCollideBatch( &MCloadheadert0, &Mloadheader, PrimCols, NumPrimCols );
+}
+
 /*===================================================================
 	Procedure	:	Process Primary Bullets
 	Input		:	nothing
@@ -1636,9 +1714,13 @@ void ProcessPrimaryBullets( void )
 	PVSPOTFX	*	SpotFXPtr;
 	VECTOR			TrigPos;
 	float			NewFramelag = 0.0F;
+	BGCOLQUERY	*	Col;
+	bool			HitBG;
 
 	PyroCount += framelag;
 
+	QueuePrimCols();
+
 	i = FirstPrimBullUsed;
 	while( i != (u_int16_t) -1 )
 	{
@@ -1810,9 +1892,23 @@ void ProcessPrimaryBullets( void )
 				temp.y = ( PrimBulls[i].Dir.y * MaxColDistance);
 				temp.z = ( PrimBulls[i].Dir.z * MaxColDistance);
 
-				if( !BackgroundCollide( &MCloadheadert0, &Mloadheader, &PrimBulls[i].Pos,
-										PrimBulls[i].GroupImIn, &temp, (VECTOR *) &PrimBulls[i].ColPoint,
-										&PrimBulls[i].ColGroup, &PrimBulls[i].ColPointNormal, &TempVector, false, NULL ) )
+				if( i < PrimColsSize && PrimColOf[ i ] != (u_int16_t) -1 )
+				{
+					Col = &PrimCols[ PrimColOf[ i ] ];
+					PrimColOf[ i ] = (u_int16_t) -1;
+					PrimBulls[i].ColPoint = *(VERT *) &Col->EndPos;
+					PrimBulls[i].ColGroup = Col->EndGroup;
+					PrimBulls[i].ColPointNormal = Col->FaceNormal;
+					HitBG = Col->Hit;
+				}
+				else
+				{
+					HitBG = BackgroundCollide( &MCloadheadert0, &Mloadheader, &PrimBulls[i].Pos,
+											   PrimBulls[i].GroupImIn, &temp, (VECTOR *) &PrimBulls[i].ColPoint,
+											   &PrimBulls[i].ColGroup, &PrimBulls[i].ColPointNormal, &TempVector, false, NULL );
+				}
+
+				if( !HitBG )
 				{
 					DebugPrintf( "Primary weapon %d didn't collide with backgroup in group %d\n", PrimBulls[i].Weapon, PrimBulls[i].GroupImIn );
 					if( DebugInfo ) CreateDebugLine( &PrimBulls[i].Pos, &temp, PrimBulls[i].GroupImIn, 255, 64, 64 );
@@ -6837,12 +6933,18 @@ u_int16_t CheckHitShip( u_int16_t OwnerType, u_int16_t Owner, VECTOR * Pos, u_in
 	float		ClosestLength;
 	float		Cos;
 	float		ShipRadius = 0.0f;
+	u_int16_t		Near[ MAX_PLAYERS ];
+	int			NumNear, n;
 
 	ClosestShip = (u_int16_t) -1;
 	ClosestLength = *Dist;
 
-	for( Count = 0; Count < MAX_PLAYERS; Count++ )
+	NumNear = ShipsNear( Pos, DirLength + WeaponRadius, Near );
+
+	for( n = 0; n < NumNear; n++ )
 	{
+		Count = Near[ n ];
+
 		if ( (Ships[Count].enable ) && (Ships[Count].Object.Mode != LIMBO_MODE) && ((GameStatus[Count] == STATUS_Normal )||(GameStatus[Count] == STATUS_SinglePlayer ) ) && !( ( OwnerType == OWNER_SHIP ) && ( Count == Owner ) ) )
 		{
 			if( ( Ships[ Count ].Object.Mode == NORMAL_MODE ) || ( Ships[ Count ].Object.Mode == DEATH_MODE ) )
@@ -7025,7 +7127,7 @@ u_int16_t CheckHitSecondary( VECTOR * Pos, u_int16_t Group, VECTOR * Dir, VECTOR
 
 		while( SecBull )
 		{
-			if( DebugCount > MAXSECONDARYWEAPONBULLETS )
+			if( DebugCount > SecBullPool.size )
 			{
 				Msg( "CheckHitSecondary() Link list corrupt!!" );
 				return( (u_int16_t) -1 );
@@ -8945,6 +9047,7 @@ FILE * SavePrimBulls( FILE * fp )
 {
 	u_int16_t	i;
 	u_int16_t	TempIndex;
+	u_int16_t	FirstFree;
 
 	if( fp )
 	{
@@ -8954,7 +9057,8 @@ FILE * SavePrimBulls( FILE * fp )
 		}
 
 		fwrite( &FirstPrimBullUsed, sizeof( FirstPrimBullUsed ), 1, fp );
-		fwrite( &FirstPrimBullFree, sizeof( FirstPrimBullFree ), 1, fp );
+		FirstFree = pool_free_slot( &PrimBullPool, 0 );
+		fwrite( &FirstFree, sizeof( FirstFree ), 1, fp );
 		fwrite( &PrimaryFireDelay, sizeof( PrimaryFireDelay ), 1, fp );
 		fwrite( &OrbitFireDelay, sizeof( OrbitFireDelay ), 1, fp );
 		fwrite( &GeneralAmmo, sizeof( GeneralAmmo ), 1, fp );
@@ -9029,13 +9133,7 @@ FILE * SavePrimBulls( FILE * fp )
 			i = PrimBulls[ i ].Prev;
 		}
 
-		i = FirstPrimBullFree;
-
-		while( i != (u_int16_t) -1 )
-		{
-			fwrite( &PrimBulls[ i ].Next, sizeof( PrimBulls[ i ].Next ), 1, fp );
-			i = PrimBulls[ i ].Next;
-		}
+		pool_save_free( &PrimBullPool, fp );
 	}
 
 	return( fp );
@@ -9050,6 +9148,8 @@ FILE * LoadPrimBulls( FILE * fp )
 {
 	u_int16_t	i;
 	u_int16_t	TempIndex;
+	u_int16_t	FirstFree;
+	u_int16_t	NextFree;
 
 	if( fp )
 	{
@@ -9059,7 +9159,8 @@ FILE * LoadPrimBulls( FILE * fp )
 		}
 
 		fread( &FirstPrimBullUsed, sizeof( FirstPrimBullUsed ), 1, fp );
-		fread( &FirstPrimBullFree, sizeof( FirstPrimBullFree ), 1, fp );
+		fread( &FirstFree, sizeof( FirstFree ), 1, fp );
+		pool_clear( &PrimBullPool );
 		fread( &PrimaryFireDelay, sizeof( PrimaryFireDelay ), 1, fp );
 		fread( &OrbitFireDelay, sizeof( OrbitFireDelay ), 1, fp );
 		fread( &GeneralAmmo, sizeof( GeneralAmmo ), 1, fp );
@@ -9078,6 +9179,11 @@ FILE * LoadPrimBulls( FILE * fp )
 
 		while( i != (u_int16_t) -1 )
 		{
+			if( !pool_fit( &PrimBullPool, i ) )
+			{
+				fclose( fp );
+				return( NULL );
+			}
 			fread( &PrimBulls[ i ].Used, sizeof( bool ), 1, fp );
 			fread( &PrimBulls[ i ].Next, sizeof( u_int16_t ), 1, fp );
 			fread( &PrimBulls[ i ].Prev, sizeof( u_int16_t ), 1, fp );
@@ -9131,27 +9237,27 @@ FILE * LoadPrimBulls( FILE * fp )
 			fread( &PrimBulls[ i ].TimeCount, sizeof( float ), 1, fp );
 			fread( &PrimBulls[ i ].FirePoint, sizeof( int16_t ), 1, fp );
 			fread( &PrimBulls[ i ].SpotFX, sizeof( int16_t ), 1, fp );
+			pool_mark( &PrimBullPool, i );
 			i = PrimBulls[ i ].Prev;
 		}
 
-		i = FirstPrimBullFree;
+		i = FirstFree;
 
 		while( i != (u_int16_t) -1 )
 		{
-			memset( &PrimBulls[i], 0, sizeof( PRIMARYWEAPONBULLET ) );
-			PrimBulls[i].Used = false;
-			PrimBulls[i].Prev = (u_int16_t) -1;
-			PrimBulls[i].Type = (u_int16_t) -1;
-			PrimBulls[i].Owner = (u_int16_t) -1;
-			PrimBulls[i].GroupImIn = (u_int16_t) -1;
-			PrimBulls[i].fmpoly = (u_int16_t) -1;
-			PrimBulls[i].light = (u_int16_t) -1;
-			PrimBulls[i].line = (u_int16_t) -1;
-			PrimBulls[i].TimeInterval = (float) 1;
+			if( !pool_fit( &PrimBullPool, i ) )
+			{
+				fclose( fp );
+				return( NULL );
+			}
+			InitPrimBull( i );
 
-			fread( &PrimBulls[ i ].Next, sizeof( PrimBulls[ i ].Next ), 1, fp );
-			i = PrimBulls[ i ].Next;
+			pool_load_free( &PrimBullPool, i );
+			fread( &NextFree, sizeof( NextFree ), 1, fp );
+			i = NextFree;
 		}
+
+		pool_rebuild( &PrimBullPool );
 	}
 
 	return( fp );
@@ -108,13 +108,21 @@ bool FSClearBlack(void);
 bool FSClear(XYRECT * rect);
 bool FSClearDepth(XYRECT * rect);
 
-#define MAX_LEVEL_TEXTURE_GROUPS 8
+// texture groups are allocated to fit ( see FSReserveTextureGroups )
+// these two keep a spare slot so textureGroups[numTextureGroups]
+// can always be filled in before it is counted.
+// if the spare slot cannot be grown the group just filled in is not
+// counted, so the next one reuses its slot instead of running off the end.
+// RESET_TEXTURE_GROUPS is false when there is not even the first slot
 
-#define MAX_TEXTURE_GROUPS 600
+#define RESET_TEXTURE_GROUPS( group ) \
+	( (group)->numTextureGroups = 0, FSReserveTextureGroups( (group), 1 ) )
 
 #define INCREASE_TEXTURE_GROUPS( group ) \
-	assert( group->numTextureGroups < MAX_TEXTURE_GROUPS ); \
-	group->numTextureGroups++;
+	do { \
+		if( FSReserveTextureGroups( (group), (group)->numTextureGroups + 2 ) ) \
+			(group)->numTextureGroups++; \
+	} while (0)
 
 typedef void * LPTEXTURE;
 
@@ -148,18 +156,14 @@ typedef struct RENDEROBJECT
 	LPINDEXBUFFER	lpIndexBuffer;
 	bool			vbLocked;
 	int numTextureGroups;
-	TEXTUREGROUP textureGroups[MAX_TEXTURE_GROUPS];
+	int maxTextureGroups;			// room in textureGroups
+	TEXTUREGROUP * textureGroups;	// freed by FSReleaseRenderObject
+	u_int32_t		vertexArray;	// GL2/3 vertex array object, made on the first draw
+	u_int32_t		vertexArrayKey;	// program and layout it was built for, 0 to rebuild
 } RENDEROBJECT;
 
-typedef struct LEVELRENDEROBJECT
-{
-	LPVERTEXBUFFER	lpVertexBuffer;
-	LPARRAYBUFFER	lpNormalBuffer;
-	LPINDEXBUFFER	lpIndexBuffer;
-	bool			vbLocked;
-	int numTextureGroups;
-	TEXTUREGROUP textureGroups[MAX_LEVEL_TEXTURE_GROUPS];
-} LEVELRENDEROBJECT;
+// level groups used to have their own smaller fixed array
+typedef RENDEROBJECT LEVELRENDEROBJECT;
 
 typedef struct {
     union {
@@ -210,6 +214,9 @@ bool FSGetWorld(RENDERMATRIX *matrix);
 bool FSSetWorld( RENDERMATRIX *matrix );
 bool FSSetProjection( RENDERMATRIX *matrix );
 bool FSSetView( RENDERMATRIX *matrix );
+// NEW_LIGHTING shaders light with at most this many of the visible lights
+#define RENDER_MAX_LIGHTS (32)
+bool FSSetLights( void );
 
 bool FSCreateDynamicNormalBuffer(RENDEROBJECT *renderObject, int numNormals);
 bool FSCreateNormalBuffer(RENDEROBJECT *renderObject, int numNormals);
@@ -236,6 +243,7 @@ bool draw_object(RENDEROBJECT *renderObject);
 bool draw_2d_object(RENDEROBJECT *renderObject);
 
 void FSReleaseRenderObject(RENDEROBJECT *renderObject);
+bool FSReserveTextureGroups(RENDEROBJECT *renderObject, int count);
 
 #ifdef __cplusplus
 };
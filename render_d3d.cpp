@@ -7,6 +7,7 @@
 #include <windows.h>
 #include <windowsx.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <search.h>
 #include <d3d9.h>
@@ -1631,6 +1632,13 @@ void FSReleaseRenderObject(RENDEROBJECT *renderObject)
 			renderObject->textureGroups[i].texture = NULL;
 		}
 	}
+	renderObject->numTextureGroups = 0;
+	if (renderObject->textureGroups)
+	{
+		free(renderObject->textureGroups);
+		renderObject->textureGroups = NULL;
+	}
+	renderObject->maxTextureGroups = 0;
 }
 
 }; // end of c linkage (extern "C")
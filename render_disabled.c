@@ -60,6 +60,12 @@ void FSReleaseRenderObject(RENDEROBJECT *renderObject)
 		}
 	}
 	renderObject->numTextureGroups = 0;
+	if (renderObject->textureGroups)
+	{
+		free(renderObject->textureGroups);
+		renderObject->textureGroups = NULL;
+	}
+	renderObject->maxTextureGroups = 0;
 }
 
 bool FSBeginScene(){ return true; }
@@ -79,6 +85,7 @@ bool FSSetProjection( RENDERMATRIX *matrix ){return true;}
 bool FSSetView( RENDERMATRIX *matrix ){return true;}
 bool FSSetWorld( RENDERMATRIX *matrix ){return true;}
 bool FSGetWorld(RENDERMATRIX *matrix){return true;}
+bool FSSetLights( void ){return true;}
 bool FSUnlockIndexBuffer(RENDEROBJECT *renderObject){return true;}
 bool FSUnlockVertexBuffer(RENDEROBJECT *renderObject){return true;}
 bool FSUnlockNormalBuffer(RENDEROBJECT *renderObject){return true;}
@@ -64,45 +64,6 @@ static void set_color( COLOR c )
 	glColor4ubv((GLubyte*)&c);
 }
 
-int render_color_blend_red   = 0;
-int render_color_blend_green = 0;
-int render_color_blend_blue  = 0;
-
-int render_lighting_enabled = 0;
-int render_lighting_point_lights_only = 1;
-int render_lighting_use_only_light_color = 0;
-int render_lighting_use_only_light_color_and_blend = 0;
-
-int render_light_ambience = 0;
-int render_light_ambience_alpha = 255.0f;
-
-int render_lighting_env_water         = 0;
-int render_lighting_env_water_level   = 0;
-float render_lighting_env_water_red   = 0.0f;
-float render_lighting_env_water_green = 0.0f;
-float render_lighting_env_water_blue  = 0.0f;
-
-int render_lighting_env_whiteout = 0;
-
-void render_reset_lighting_variables( void )
-{
-	render_color_blend_red   = 0;
-	render_color_blend_green = 0;
-	render_color_blend_blue  = 0;
-	render_lighting_enabled = 0;
-	render_lighting_point_lights_only = 1;
-	render_lighting_use_only_light_color = 0;
-	render_lighting_use_only_light_color_and_blend = 0;
-	render_light_ambience = 0;
-	render_light_ambience_alpha = 255.0f;
-	render_lighting_env_water         = 0;
-	render_lighting_env_water_level   = 0;
-	render_lighting_env_water_red   = 0.0f;
-	render_lighting_env_water_green = 0.0f;
-	render_lighting_env_water_blue  = 0.0f;
-	render_lighting_env_whiteout = 0;
-}
-
 void do_water_effect( VECTOR * pos, COLOR * color )
 {
 	u_int32_t r,g,b;
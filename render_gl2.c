@@ -5,12 +5,14 @@ bool FSCreateVertexBuffer(RENDEROBJECT *renderObject, int numVertices)
 {
 	renderObject->lpVertexBuffer = create_buffer(
 		numVertices * sizeof(LVERTEX), GL_ARRAY_BUFFER, GL_STATIC_DRAW );
+	renderObject->vertexArrayKey = 0; // the vertex array points at the old buffer
 	return true;
 }
 bool FSCreateDynamicVertexBuffer(RENDEROBJECT *renderObject, int numVertices)
 {
 	renderObject->lpVertexBuffer = create_buffer( 
 		numVertices * sizeof(LVERTEX), GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW );
+	renderObject->vertexArrayKey = 0; // the vertex array points at the old buffer
 	return true;
 }
 
@@ -18,12 +20,14 @@ bool FSCreateNormalBuffer(RENDEROBJECT *renderObject, int numNormals)
 {
 	renderObject->lpNormalBuffer = create_buffer( 
 		numNormals * sizeof(NORMAL), GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW );
+	renderObject->vertexArrayKey = 0; // the vertex array points at the old buffer
 	return true;
 }
 bool FSCreateDynamicNormalBuffer(RENDEROBJECT *renderObject, int numNormals)
 {
 	renderObject->lpNormalBuffer = create_buffer( 
 		numNormals * sizeof(NORMAL), GL_ELEMENT_ARRAY_BUFFER, GL_DYNAMIC_DRAW );
+	renderObject->vertexArrayKey = 0; // the vertex array points at the old buffer
 	return true;
 }
 
@@ -31,12 +35,14 @@ bool FSCreateIndexBuffer(RENDEROBJECT *renderObject, int numIndices)
 {
 	renderObject->lpIndexBuffer = create_buffer( 
 		numIndices * 3 * sizeof(WORD), GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW );
+	renderObject->vertexArrayKey = 0; // the vertex array points at the old buffer
 	return true;
 }
 bool FSCreateDynamicIndexBuffer(RENDEROBJECT *renderObject, int numIndices)
 {
 	renderObject->lpIndexBuffer = create_buffer( 
 		numIndices * 3 * sizeof(WORD), GL_ELEMENT_ARRAY_BUFFER, GL_DYNAMIC_DRAW );
+	renderObject->vertexArrayKey = 0; // the vertex array points at the old buffer
 	return true;
 }
 
@@ -44,24 +50,25 @@ bool FSCreateDynamicIndexBuffer(RENDEROBJECT *renderObject, int numIndices)
 // buffer binding point ("target"), so we save the currently bound
 // buffer and restore it on unlock.
 //
-// There is still the restriction that only one buffer of a certain
-// type may be locked at the same time. If this is a problem then this
+// There is still the restriction that only one normal or index buffer
+// may be locked at the same time. If this is a problem then this
 // should be rewritten to use a locally malloc'ed buffer and update
 // the real buffer on unlock using glBufferSubData.
+//
+// Vertex buffers are only bound while they are being mapped or
+// unmapped, so any number of them can be mapped at once. The level
+// lighting maps every visible group before lighting them together.
 
 static GLuint old_array_buf = 0;
 static GLuint old_index_buf = 0;
 
 bool FSLockVertexBuffer(RENDEROBJECT *renderObject, LVERTEX **verts)
 {
-	if ( old_array_buf )
-	{
-		DebugPrintf( "Tried to lock more than one vertex buffer at once\n" );
-		return false;
-	}
-	glGetIntegerv( GL_ARRAY_BUFFER_BINDING, &old_array_buf );
+	GLint old_buf;
+	glGetIntegerv( GL_ARRAY_BUFFER_BINDING, &old_buf );
 	glBindBuffer( GL_ARRAY_BUFFER, (GLuint) renderObject->lpVertexBuffer );
 	*verts = (LVERTEX *) glMapBuffer( GL_ARRAY_BUFFER, GL_WRITE_ONLY );
+	glBindBuffer( GL_ARRAY_BUFFER, (GLuint) old_buf );
 	if(!*verts)
 	{
 		DebugPrintf("FSLockVertexBuffer: glMapBuffer returned NULL\n");
@@ -73,9 +80,12 @@ bool FSLockVertexBuffer(RENDEROBJECT *renderObject, LVERTEX **verts)
 
 bool FSUnlockVertexBuffer(RENDEROBJECT *renderObject)
 {
-	bool ret = ( glUnmapBuffer( GL_ARRAY_BUFFER ) == GL_TRUE );
-	glBindBuffer( GL_ARRAY_BUFFER, old_array_buf );
-	old_array_buf = 0;
+	GLint old_buf;
+	bool ret;
+	glGetIntegerv( GL_ARRAY_BUFFER_BINDING, &old_buf );
+	glBindBuffer( GL_ARRAY_BUFFER, (GLuint) renderObject->lpVertexBuffer );
+	ret = ( glUnmapBuffer( GL_ARRAY_BUFFER ) == GL_TRUE );
+	glBindBuffer( GL_ARRAY_BUFFER, (GLuint) old_buf );
 	CHECK_GL_ERRORS;
 	return ret;
 }
@@ -140,6 +150,7 @@ bool FSCreateDynamic2dVertexBuffer(RENDEROBJECT *renderObject, int numVertices)
 {
 	renderObject->lpVertexBuffer = create_buffer( 
 		numVertices * sizeof(TLVERTEX), GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW );
+	renderObject->vertexArrayKey = 0; // the vertex array points at the old buffer
 	return true;
 }
 
@@ -149,6 +160,8 @@ bool FSLockPretransformedVertexBuffer(RENDEROBJECT *renderObject, TLVERTEX **ver
 }
 
 /* Draw render object:
+ * - bind the buffers and their layout, a vertex array per object
+ *   when there are vertex arrays (see bind_render_object)
  * - if 2D (orthographic), set up appropriately:
  *   - orthographic projection matrix
  *   - ... plus scaling and translation for Y-flipping (T*S*P)
@@ -160,110 +173,41 @@ bool FSLockPretransformedVertexBuffer(RENDEROBJECT *renderObject, TLVERTEX **ver
  *   - if group->texture, enable texturing and bind
  *     renderObject->textureGroups[group].texture
  *   - draw group->numVerts elements starting at group->startVert
+ * uniform locations come from program_info and flags or textures
+ * that are already set are not sent again
  */
 
 bool draw_render_object( RENDEROBJECT *renderObject, int primitive_type, bool orthographic )
 {
-	static const struct
-	{
-		const char *name;
-		int components;
-		GLenum type;
-		GLboolean normalized;
-		int offset;
-	} normal_attr[] =
-	{
-		{ "pos",    3, GL_FLOAT,         GL_FALSE, 0  },
-		{ "vcolor", 4, GL_UNSIGNED_BYTE, GL_TRUE,  12 }, // 3*float
-		{ "vtexc",  2, GL_FLOAT,         GL_FALSE, 16 }, // 3*float + 1*COLOR
-		{ NULL,     0, 0,                0,        0  }
-	}, ortho_attr[] =
-	{
-		{ "tlpos",  4, GL_FLOAT,         GL_FALSE, 0 },
-		{ "vcolor", 4, GL_UNSIGNED_BYTE, GL_TRUE,  16 }, // 4*float
-		{ "vtexc",  2, GL_FLOAT,         GL_FALSE, 20 }, // 4*float + 1*COLOR
-		{ NULL,     0, 0,                0,        0  }
-	}, *attr;
-	//GLuint current_program;
-	GLuint u_ortho;
-	GLuint u_colorkey;
-	GLuint u_enabletex;
 	TEXTUREGROUP *group;
 	texture_t *texdata;
-	int loc;
 	int i;
 
-	glBindBuffer( GL_ARRAY_BUFFER, renderObject->lpVertexBuffer );
-
-	if ( renderObject->lpIndexBuffer )
-		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, renderObject->lpIndexBuffer );
-	else
-		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
-
-	//glGetIntegerv( GL_CURRENT_PROGRAM, &current_program );
-	// assert( current_program != 0 );
-
-	CHECK_GL_ERRORS;
-
-	// Tell OpenGL about the buffer data layout
-	// see the LVERTEX and TLVERTEX definitions inside include/new3d.h
-	attr = orthographic ? ortho_attr : normal_attr;
-	for ( i=0; attr[i].name; i++ )
-	{
-		loc = glGetAttribLocation( current_program, attr[i].name );
-		if (loc >= 0)
-		{
-			glVertexAttribPointer(
-				loc,
-				attr[i].components,
-				attr[i].type,
-				attr[i].normalized,
-				orthographic ? sizeof(TLVERTEX) : sizeof(LVERTEX),
-				attr[i].offset
-			);
-			glEnableVertexAttribArray( loc );
-		}
-	}
-
-	CHECK_GL_ERRORS;
-
-	// tell it about the normal buffer
-	if ( renderObject->lpNormalBuffer )
-	{
-		glBindBuffer( GL_ARRAY_BUFFER, renderObject->lpNormalBuffer );
-		loc = glGetAttribLocation( current_program, "vnormal" );
-		if (loc >= 0)
-		{
-			glVertexAttribPointer( loc, 3, GL_FLOAT, GL_FALSE, sizeof(NORMAL), 0 );
-			glEnableVertexAttribArray( loc );
-		}
-	}
-
-	CHECK_GL_ERRORS;
+	bind_render_object( renderObject, orthographic );
 
 	// Update and use the appropriate model/view/projection matrix
 	if ( orthographic )
-		ortho_update( current_program );
+		ortho_update();
 	else
-		mvp_update( current_program );
+	{
+		mvp_update();
+#ifdef NEW_LIGHTING
+		lighting_update();
+#endif
+	}
 
 	// This uniform tells the vertex shader which matrix to use
-	if ((u_ortho = glGetUniformLocation(current_program, "orthographic")) >= 0)
-		glUniform1i( u_ortho, orthographic ? GL_TRUE : GL_FALSE );
+	set_uniform_flag( program_info.orthographic, &program_info.last_orthographic, orthographic );
 
 	for ( i = 0; i < renderObject->numTextureGroups; i++ )
 	{
 		group = &renderObject->textureGroups[i];
-		if ( (u_colorkey = glGetUniformLocation(current_program, "colorkeying_enabled")) >= 0 )
-			glUniform1i( u_colorkey, group->colourkey ? GL_TRUE : GL_FALSE );
-		if ( (u_enabletex = glGetUniformLocation(current_program, "texturing_enabled")) >= 0 )
+		set_uniform_flag( program_info.colorkeying_enabled, &program_info.last_colorkeying_enabled, group->colourkey );
+		set_uniform_flag( program_info.texturing_enabled, &program_info.last_texturing_enabled, group->texture != NULL );
+		if ( group->texture )
 		{
-			glUniform1i( u_enabletex, group->texture ? GL_TRUE : GL_FALSE );
-			if ( group->texture )
-			{
-				texdata = (texture_t *) group->texture;
-				glBindTexture( GL_TEXTURE_2D, texdata->id );
-			}
+			texdata = (texture_t *) group->texture;
+			bind_texture( texdata->id );
 		}
 		glDrawElementsBaseVertex(
 			primitive_type,
@@ -276,19 +220,7 @@ bool draw_render_object( RENDEROBJECT *renderObject, int primitive_type, bool or
 
 	CHECK_GL_ERRORS;
 
-	for ( i=0; attr[i].name; i++ )
-	{
-		loc = glGetAttribLocation( current_program, attr[i].name );
-		if (loc >= 0)
-			glDisableVertexAttribArray( loc );
-	}
-
-	if ( renderObject->lpNormalBuffer )
-	{
-		loc = glGetAttribLocation( current_program, "vnormal" );
-		if (loc >= 0)
-			glDisableVertexAttribArray( loc );
-	}
+	unbind_render_object();
 
 	CHECK_GL_ERRORS;
 
@@ -1,5 +1,8 @@
 #ifdef GL
 #include "render_gl_shared.h"
+#include "new3d.h"
+#include "lights.h"
+#include "camera.h"
 
 // windows needs explicit retrieval of newer GL functions...
 /*
@@ -58,6 +61,48 @@ void render_mode_fill(void)
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 }
 
+// render time lighting (NEW_LIGHTING), GL1 lights each vertex
+// as it is sent with light_vert and GL2/3 do it in the vertex shader
+
+int render_color_blend_red   = 0;
+int render_color_blend_green = 0;
+int render_color_blend_blue  = 0;
+
+int render_lighting_enabled = 0;
+int render_lighting_point_lights_only = 1;
+int render_lighting_use_only_light_color = 0;
+int render_lighting_use_only_light_color_and_blend = 0;
+
+int render_light_ambience = 0;
+int render_light_ambience_alpha = 255.0f;
+
+int render_lighting_env_water         = 0;
+int render_lighting_env_water_level   = 0;
+float render_lighting_env_water_red   = 0.0f;
+float render_lighting_env_water_green = 0.0f;
+float render_lighting_env_water_blue  = 0.0f;
+
+int render_lighting_env_whiteout = 0;
+
+void render_reset_lighting_variables( void )
+{
+	render_color_blend_red   = 0;
+	render_color_blend_green = 0;
+	render_color_blend_blue  = 0;
+	render_lighting_enabled = 0;
+	render_lighting_point_lights_only = 1;
+	render_lighting_use_only_light_color = 0;
+	render_lighting_use_only_light_color_and_blend = 0;
+	render_light_ambience = 0;
+	render_light_ambience_alpha = 255.0f;
+	render_lighting_env_water         = 0;
+	render_lighting_env_water_level   = 0;
+	render_lighting_env_water_red   = 0.0f;
+	render_lighting_env_water_green = 0.0f;
+	render_lighting_env_water_blue  = 0.0f;
+	render_lighting_env_whiteout = 0;
+}
+
 // unused in opengl
 bool FSBeginScene(){ return true; }
 bool FSEndScene(){ return true; }
@@ -96,10 +141,15 @@ void build_gamma_table( double gamma )
 	}
 }
 
+GLuint bound_texture = 0;
+
 void release_texture( LPTEXTURE texture )
 {
 	if(!texture) return;
 	texture_t *texdata = (texture_t *) texture;
+	// deleting the bound texture binds 0 in its place
+	if ( texdata->id == bound_texture )
+		bound_texture = 0;
 	glDeleteTextures( 1, &texdata->id );
 	CHECK_GL_ERRORS;
 	free(texture);
@@ -164,6 +214,7 @@ static bool create_texture(LPTEXTURE *t, const char *path, u_int16_t *width, u_i
 		texdata = malloc(sizeof(texture_t));
 		glGenTextures(1, &texdata->id);
 		glBindTexture(GL_TEXTURE_2D, texdata->id);
+		bound_texture = texdata->id;
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.w, image.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data);
 		CHECK_GL_ERRORS;
 	}
@@ -172,6 +223,7 @@ static bool create_texture(LPTEXTURE *t, const char *path, u_int16_t *width, u_i
 	{
 		texdata = (texture_t *) *t;
 		glBindTexture(GL_TEXTURE_2D, texdata->id);
+		bound_texture = texdata->id;
 		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.w, image.h, GL_RGBA, GL_UNSIGNED_BYTE, image.data);
 		CHECK_GL_ERRORS;
 	}
@@ -279,6 +331,9 @@ static void print_info( void )
 	#define GLSL_VERT_OUT  "out"
 #endif
 
+// must match RENDER_MAX_LIGHTS
+#define GLSL_MAX_LIGHTS "32"
+
 static const char *default_vertex_shader =
 	"#version " GLSL_VERSION "\n"
 	"\n"
@@ -295,6 +350,107 @@ static const char *default_vertex_shader =
 	GLSL_VERT_OUT " vec4 color;\n"
 	GLSL_VERT_OUT " vec2 texc;\n"
 	"\n"
+#ifdef NEW_LIGHTING
+	"uniform mat4 world;\n"
+	"\n"
+	"uniform int lights;\n"
+	"uniform vec4 light_pos[" GLSL_MAX_LIGHTS "];   // xyz, size\n"
+	"uniform vec4 light_color[" GLSL_MAX_LIGHTS "]; // rgb, 1 for a spot light\n"
+	"uniform vec4 light_dir[" GLSL_MAX_LIGHTS "];   // xyz, cos arc\n"
+	"uniform float min_light_size;\n"
+	"\n"
+	"uniform bool lighting_enabled;\n"
+	"uniform bool point_lights_only;\n"
+	"uniform int light_mode;  // 0 mixed with the vertex, 1 light only, 2 light and blend\n"
+	"uniform vec4 ambience;\n"
+	"uniform vec3 color_blend;\n"
+	"uniform int water;       // 1 all water, 2 only below water_level\n"
+	"uniform float water_level;\n"
+	"uniform vec3 water_color;\n"
+	"uniform int whiteout;\n"
+	"uniform float seconds;\n"
+	"\n"
+	"// same as the effects in render_gl1.c\n"
+	"float ripple(vec3 p)\n"
+	"{\n"
+	"    vec3 a = mod(vec3(ivec3(p * 0.35)), 360.0) + seconds * 71.0;\n"
+	"    return (sin(radians(a.x)) + sin(radians(a.y)) + sin(radians(a.z))) * 127.0 * 0.3333333 + 128.0;\n"
+	"}\n"
+	"\n"
+	"// the same sums as vlight_add_c, colors are rgba 0-255\n"
+	"vec4 light_vert(vec3 p, vec4 c)\n"
+	"{\n"
+	"    vec4 l = vec4(0.0);\n"
+	"    vec3 ray;\n"
+	"    float r2, size, d, cosa, cosarc, cosarc2, intense;\n"
+	"    int i;\n"
+	"\n"
+	"    if (whiteout != 0)\n"
+	"    {\n"
+	"        c.r = min(floor(ripple(p)) + float(whiteout), 255.0);\n"
+	"        c.a = c.r;\n"
+	"    }\n"
+	"    else if (water != 0 && !(water == 2 && p.y >= water_level))\n"
+	"    {\n"
+	"        c.rgb = min(floor(floor(c.rgb * 0.25) + water_color * ripple(p)), 255.0);\n"
+	"    }\n"
+	"\n"
+	"    if (lighting_enabled)\n"
+	"    {\n"
+	"        l = ambience;\n"
+	"        for (i = 0; i < " GLSL_MAX_LIGHTS "; i++)\n"
+	"        {\n"
+	"            if (i >= lights)\n"
+	"                break;\n"
+	"            ray = p - light_pos[i].xyz;\n"
+	"            r2 = dot(ray, ray);\n"
+	"            size = light_pos[i].w;\n"
+	"            if (!(r2 < size * size))\n"
+	"                continue;\n"
+	"            if (point_lights_only || light_color[i].a == 0.0)\n"
+	"            {\n"
+	"                intense = 1.0 - r2 / (size * size);\n"
+	"            }\n"
+	"            else\n"
+	"            {\n"
+	"                d = sqrt(r2);\n"
+	"                if (d > 0.0)\n"
+	"                    ray /= d;\n"
+	"                cosa = dot(ray, light_dir[i].xyz);\n"
+	"                cosarc = light_dir[i].w;\n"
+	"                if (d > 0.5 * size)\n"
+	"                {\n"
+	"                    if (!(cosa > cosarc))\n"
+	"                        continue;\n"
+	"                    intense = ((size - d) / (0.75 * size)) * ((cosa - cosarc) / (1.0 - cosarc));\n"
+	"                }\n"
+	"                else if (d > min_light_size)\n"
+	"                {\n"
+	"                    cosarc2 = cosarc * (1.0 - ((size * 0.5 - d) / (size * 0.5 - min_light_size)));\n"
+	"                    if (!(cosa > cosarc2))\n"
+	"                        continue;\n"
+	"                    intense = ((size - d) / (size - min_light_size)) * ((cosa - cosarc2) / (1.0 - cosarc2));\n"
+	"                }\n"
+	"                else\n"
+	"                {\n"
+	"                    intense = (cosa > 0.0) ? 1.0 : 1.0 + cosa;\n"
+	"                }\n"
+	"            }\n"
+	"            l += vec4(floor(light_color[i].rgb * intense), 255.0 * intense);\n"
+	"        }\n"
+	"        l = min(l, 255.0);\n"
+	"    }\n"
+	"\n"
+	"    if (light_mode == 1)\n"
+	"        c = floor(l);\n"
+	"    else if (light_mode == 2)\n"
+	"        c = vec4(min(floor(l.rgb) + color_blend, 255.0), floor(l.a));\n"
+	"    else\n"
+	"        c.rgb = clamp(min(c.rgb + floor(l.rgb), 255.0) - color_blend, 0.0, 255.0);\n"
+	"    return c;\n"
+	"}\n"
+	"\n"
+#endif
 	"void main(void)\n"
 	"{\n"
 	"    if (orthographic)\n"
@@ -308,7 +464,14 @@ static const char *default_vertex_shader =
 	"    {\n"
 	"        gl_Position = mvp * vec4(pos, 1.0);\n"
 	"    }\n"
+#ifdef NEW_LIGHTING
+	"    if (orthographic)\n"
+	"        color = vcolor.bgra;\n"
+	"    else\n"
+	"        color = light_vert((world * vec4(pos, 1.0)).xyz, floor(vcolor.bgra * 255.0 + 0.5)) / 255.0;\n"
+#else
 	"    color = vcolor.bgra;\n"
+#endif
 	"    texc = vtexc;\n"
 	"}\n"
 ;
@@ -398,6 +561,51 @@ static GLuint new_shader( GLenum type, const char *src, char **log )
 	return shader;
 }
 
+program_info_t program_info;
+
+// GL3 core profile has no default vertex array, this one is bound
+// between draws so the buffer functions have somewhere to bind to
+static GLuint idle_vertex_array = 0;
+
+static void find_program_locations( void )
+{
+	program_info.pos                 = glGetAttribLocation( current_program, "pos" );
+	program_info.tlpos               = glGetAttribLocation( current_program, "tlpos" );
+	program_info.vcolor              = glGetAttribLocation( current_program, "vcolor" );
+	program_info.vtexc               = glGetAttribLocation( current_program, "vtexc" );
+	program_info.vnormal             = glGetAttribLocation( current_program, "vnormal" );
+	program_info.orthographic        = glGetUniformLocation( current_program, "orthographic" );
+	program_info.colorkeying_enabled = glGetUniformLocation( current_program, "colorkeying_enabled" );
+	program_info.texturing_enabled   = glGetUniformLocation( current_program, "texturing_enabled" );
+	program_info.mvp                 = glGetUniformLocation( current_program, "mvp" );
+	program_info.ortho_proj          = glGetUniformLocation( current_program, "ortho_proj" );
+	program_info.world               = glGetUniformLocation( current_program, "world" );
+#ifdef NEW_LIGHTING
+	program_info.lights              = glGetUniformLocation( current_program, "lights" );
+	program_info.light_pos           = glGetUniformLocation( current_program, "light_pos" );
+	program_info.light_color         = glGetUniformLocation( current_program, "light_color" );
+	program_info.light_dir           = glGetUniformLocation( current_program, "light_dir" );
+	program_info.min_light_size      = glGetUniformLocation( current_program, "min_light_size" );
+	program_info.lighting_enabled    = glGetUniformLocation( current_program, "lighting_enabled" );
+	program_info.point_lights_only   = glGetUniformLocation( current_program, "point_lights_only" );
+	program_info.light_mode          = glGetUniformLocation( current_program, "light_mode" );
+	program_info.ambience            = glGetUniformLocation( current_program, "ambience" );
+	program_info.color_blend         = glGetUniformLocation( current_program, "color_blend" );
+	program_info.water               = glGetUniformLocation( current_program, "water" );
+	program_info.water_level         = glGetUniformLocation( current_program, "water_level" );
+	program_info.water_color         = glGetUniformLocation( current_program, "water_color" );
+	program_info.whiteout            = glGetUniformLocation( current_program, "whiteout" );
+	program_info.seconds             = glGetUniformLocation( current_program, "seconds" );
+#endif
+	// a new program starts with every uniform at 0
+	program_info.last_orthographic = -1;
+	program_info.last_colorkeying_enabled = -1;
+	program_info.last_texturing_enabled = -1;
+	// vertex arrays hold attribute locations, the old ones are rebuilt
+	program_info.serial++;
+	CHECK_GL_ERRORS;
+}
+
 static bool update_shader_program( char **log )
 {
 	int link_ok;
@@ -439,6 +647,8 @@ static bool update_shader_program( char **log )
 	glUseProgram( current_program );
 	CHECK_GL_ERRORS;
 
+	find_program_locations();
+
 	if ( log )
 		*log = NULL;
 
@@ -500,6 +710,11 @@ static bool set_defaults( void )
 	glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
 #else
 	if(!set_default_shaders()) return false;
+	if( caps.vertex_arrays && !idle_vertex_array )
+	{
+		glGenVertexArrays( 1, &idle_vertex_array );
+		glBindVertexArray( idle_vertex_array );
+	}
 #endif
 	reset_cull();
 	reset_trans();
@@ -550,6 +765,18 @@ static void detect_caps( void )
 
 	DebugPrintf("render: anisotropic filtering support = %s\n",
 		caps.anisotropic?"true":"false");
+
+	// vertex array objects are core in GL3, GL2 needs the extension
+#if GL == 1
+	caps.vertex_arrays = false;
+#elif GL < 3
+	caps.vertex_arrays = strstr((char*)glGetString(GL_EXTENSIONS), "GL_ARB_vertex_array_object") != NULL;
+#else
+	caps.vertex_arrays = true;
+#endif
+
+	DebugPrintf("render: vertex array object support = %s\n",
+		caps.vertex_arrays?"true":"false");
 }
 
 bool render_init( render_info_t * info )
@@ -785,13 +1012,11 @@ bool FSSetViewPort(render_viewport_t *view)
 }
 
 #if GL > 1
-void ortho_update ( GLuint current_program )
+void ortho_update ( void )
 {
 	MATRIX m;
 	float left, right, bottom, top, near, far;
-	GLuint u_ortho_matrix;
-
-	if ( ortho_matrix_needs_update && ( u_ortho_matrix = glGetUniformLocation( current_program, "ortho_proj" ) ) >= 0 )
+	if ( ortho_matrix_needs_update && program_info.ortho_proj >= 0 )
 	{
 		left = 0.0f;
 		right = render_info.ThisMode.w;
@@ -809,7 +1034,7 @@ void ortho_update ( GLuint current_program )
 		m._24 = -(top+bottom)/(top-bottom) + 2.0f;
 		m._34 = -(far+near)/(far-near);
 		m._44 = 1.0f;
-		glUniformMatrix4fv( u_ortho_matrix, 1, GL_TRUE, &m );
+		glUniformMatrix4fv( program_info.ortho_proj, 1, GL_TRUE, &m );
 		CHECK_GL_ERRORS;
 		ortho_matrix_needs_update = false;
 	}
@@ -835,22 +1060,181 @@ bool mvp_needs_update;
 // See also: http://en.wikipedia.org/wiki/Transpose#Properties
 
 #if GL > 1
-void mvp_update( GLuint current_program )
+void mvp_update( void )
 {
 	MATRIX mvp;
-	GLuint u_mvp;
 
-	if ( mvp_needs_update && ( u_mvp = glGetUniformLocation( current_program, "mvp" ) ) >= 0 )
+	if ( mvp_needs_update && program_info.mvp >= 0 )
 	{
 		MatrixMultiply( &world_matrix, &view_matrix, &mvp );
 		MatrixMultiply( &mvp,          &proj_matrix, &mvp );
-		glUniformMatrix4fv( u_mvp, 1, GL_FALSE, &mvp );
+		glUniformMatrix4fv( program_info.mvp, 1, GL_FALSE, &mvp );
+#ifdef NEW_LIGHTING
+		// the lights are in world space
+		if ( program_info.world >= 0 )
+			glUniformMatrix4fv( program_info.world, 1, GL_FALSE, &world_matrix );
+#endif
 		CHECK_GL_ERRORS;
 		mvp_needs_update = false;
 	}
 }
 #endif
 
+#if GL > 1 && defined( NEW_LIGHTING )
+
+// The visible lights as the vertex shader wants them. FSSetLights
+// copies them once a camera has built its light list and the next
+// draw sends them, everything else the shader needs is set per draw
+// as the models change it between objects.
+
+extern XLIGHT * FirstLightVisible;
+extern CAMERA CurrentCamera;
+
+static int num_lights = 0;
+static GLfloat light_pos[ RENDER_MAX_LIGHTS ][ 4 ];
+static GLfloat light_color[ RENDER_MAX_LIGHTS ][ 4 ];
+static GLfloat light_dir[ RENDER_MAX_LIGHTS ][ 4 ];
+static bool lights_need_update = true;
+static u_int32_t lights_dropped = 0;
+
+// how far the camera is outside a light's reach, lower is nearer
+static float light_distance( XLIGHT * light )
+{
+	VECTOR d;
+
+	d.x = light->Pos.x - CurrentCamera.Pos.x;
+	d.y = light->Pos.y - CurrentCamera.Pos.y;
+	d.z = light->Pos.z - CurrentCamera.Pos.z;
+	return sqrtf( d.x * d.x + d.y * d.y + d.z * d.z ) - light->Size;
+}
+
+bool FSSetLights( void )
+{
+	XLIGHT * light;
+	XLIGHT * nearest[ RENDER_MAX_LIGHTS ];
+	float distance[ RENDER_MAX_LIGHTS ];
+	float dist;
+	int visible;
+	int i;
+
+	// keep the lights nearest the camera, sorted nearest first
+	num_lights = 0;
+	visible = 0;
+	for ( light = FirstLightVisible; light; light = light->NextVisible )
+	{
+		visible++;
+		dist = light_distance( light );
+		if ( num_lights == RENDER_MAX_LIGHTS )
+		{
+			if ( dist >= distance[ num_lights - 1 ] )
+				continue;
+			num_lights--;
+		}
+		for ( i = num_lights; i > 0 && distance[ i - 1 ] > dist; i-- )
+		{
+			nearest[ i ] = nearest[ i - 1 ];
+			distance[ i ] = distance[ i - 1 ];
+		}
+		nearest[ i ] = light;
+		distance[ i ] = dist;
+		num_lights++;
+	}
+
+	// only log the first time so a busy level doesn't flood the log
+	if ( visible > RENDER_MAX_LIGHTS && !lights_dropped++ )
+		DebugPrintf( "FSSetLights: %d lights visible, only the nearest %d are used\n", visible, RENDER_MAX_LIGHTS );
+
+	for ( i = 0; i < num_lights; i++ )
+	{
+		light = nearest[ i ];
+		light_pos[ i ][ 0 ] = light->Pos.x;
+		light_pos[ i ][ 1 ] = light->Pos.y;
+		light_pos[ i ][ 2 ] = light->Pos.z;
+		light_pos[ i ][ 3 ] = light->Size;
+		light_color[ i ][ 0 ] = light->r;
+		light_color[ i ][ 1 ] = light->g;
+		light_color[ i ][ 2 ] = light->b;
+		light_color[ i ][ 3 ] = ( light->Type == SPOT_LIGHT ) ? 1.0f : 0.0f;
+		light_dir[ i ][ 0 ] = light->Dir.x;
+		light_dir[ i ][ 1 ] = light->Dir.y;
+		light_dir[ i ][ 2 ] = light->Dir.z;
+		light_dir[ i ][ 3 ] = light->CosArc;
+	}
+	lights_need_update = true;
+	return true;
+}
+
+static void set_uniform1i( GLint loc, int i )
+{
+	if ( loc >= 0 )
+		glUniform1i( loc, i );
+}
+
+static void set_uniform1f( GLint loc, float f )
+{
+	if ( loc >= 0 )
+		glUniform1f( loc, f );
+}
+
+static void set_uniform3f( GLint loc, float x, float y, float z )
+{
+	if ( loc >= 0 )
+		glUniform3f( loc, x, y, z );
+}
+
+static void set_uniform4fv( GLint loc, int count, GLfloat * v )
+{
+	if ( loc >= 0 )
+		glUniform4fv( loc, count, v );
+}
+
+void lighting_update( void )
+{
+	GLfloat ambience[4];
+
+	if ( lights_need_update )
+	{
+		set_uniform1i( program_info.lights, num_lights );
+		if ( num_lights )
+		{
+			set_uniform4fv( program_info.light_pos, num_lights, &light_pos[0][0] );
+			set_uniform4fv( program_info.light_color, num_lights, &light_color[0][0] );
+			set_uniform4fv( program_info.light_dir, num_lights, &light_dir[0][0] );
+		}
+		set_uniform1f( program_info.min_light_size, MIN_LIGHT_SIZE );
+		lights_need_update = false;
+	}
+
+#ifdef LIGHT_EVERYTHING
+	set_uniform1i( program_info.lighting_enabled, GL_TRUE );
+#else
+	set_uniform1i( program_info.lighting_enabled, render_lighting_enabled ? GL_TRUE : GL_FALSE );
+#endif
+	set_uniform1i( program_info.point_lights_only, render_lighting_point_lights_only ? GL_TRUE : GL_FALSE );
+	set_uniform1i( program_info.light_mode,
+		render_lighting_use_only_light_color ? 1 :
+		render_lighting_use_only_light_color_and_blend ? 2 : 0 );
+	ambience[0] = ambience[1] = ambience[2] = (float) render_light_ambience;
+	ambience[3] = (float) render_light_ambience_alpha;
+	set_uniform4fv( program_info.ambience, 1, ambience );
+	set_uniform3f( program_info.color_blend,
+		(float) render_color_blend_red, (float) render_color_blend_green, (float) render_color_blend_blue );
+	set_uniform1i( program_info.water, render_lighting_env_water );
+	set_uniform1f( program_info.water_level, (float) render_lighting_env_water_level );
+	set_uniform3f( program_info.water_color,
+		render_lighting_env_water_red, render_lighting_env_water_green, render_lighting_env_water_blue );
+	set_uniform1i( program_info.whiteout, render_lighting_env_whiteout );
+	set_uniform1f( program_info.seconds, SDL_GetTicks() / 1000.0f );
+	CHECK_GL_ERRORS;
+}
+
+#else
+
+// GL1 reads FirstLightVisible itself as it lights each vertex
+bool FSSetLights( void ){ return true; }
+
+#endif
+
 static void reset_modelview( void )
 {
 #if GL == 1
@@ -924,6 +1308,122 @@ LPVERTEXBUFFER _create_buffer( int size, GLenum type, GLenum gettype, GLenum usa
 
 	return (LPVERTEXBUFFER) vbo;
 }
+
+// Per draw state is only sent when it changes, the thousands of small
+// polys, models and text objects each frame mostly share it.
+
+void set_uniform_flag( GLint loc, int * last, bool value )
+{
+	if ( loc < 0 || *last == (int) value )
+		return;
+	glUniform1i( loc, value ? GL_TRUE : GL_FALSE );
+	*last = (int) value;
+}
+
+void bind_texture( GLuint id )
+{
+	if ( id == bound_texture )
+		return;
+	glBindTexture( GL_TEXTURE_2D, id );
+	bound_texture = id;
+}
+
+static void vertex_attrib( GLint loc, int components, GLenum type, GLboolean normalized, int stride, int offset )
+{
+	if ( loc < 0 )
+		return;
+	glVertexAttribPointer( loc, components, type, normalized, stride, (const GLvoid *) (size_t) offset );
+	glEnableVertexAttribArray( loc );
+}
+
+static void disable_vertex_attribs( void )
+{
+	if ( program_info.pos >= 0 )     glDisableVertexAttribArray( program_info.pos );
+	if ( program_info.tlpos >= 0 )   glDisableVertexAttribArray( program_info.tlpos );
+	if ( program_info.vcolor >= 0 )  glDisableVertexAttribArray( program_info.vcolor );
+	if ( program_info.vtexc >= 0 )   glDisableVertexAttribArray( program_info.vtexc );
+	if ( program_info.vnormal >= 0 ) glDisableVertexAttribArray( program_info.vnormal );
+}
+
+// Tell OpenGL about the buffer data layout
+// see the LVERTEX and TLVERTEX definitions inside include/new3d.h
+static void specify_vertex_attribs( RENDEROBJECT *renderObject, bool orthographic )
+{
+	glBindBuffer( GL_ARRAY_BUFFER, (GLuint) renderObject->lpVertexBuffer );
+	if ( orthographic )
+	{
+		vertex_attrib( program_info.tlpos,  4, GL_FLOAT,         GL_FALSE, sizeof(TLVERTEX), 0  );
+		vertex_attrib( program_info.vcolor, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(TLVERTEX), 16 ); // 4*float
+		vertex_attrib( program_info.vtexc,  2, GL_FLOAT,         GL_FALSE, sizeof(TLVERTEX), 20 ); // 4*float + 1*COLOR
+	}
+	else
+	{
+		vertex_attrib( program_info.pos,    3, GL_FLOAT,         GL_FALSE, sizeof(LVERTEX),  0  );
+		vertex_attrib( program_info.vcolor, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(LVERTEX),  12 ); // 3*float
+		vertex_attrib( program_info.vtexc,  2, GL_FLOAT,         GL_FALSE, sizeof(LVERTEX),  16 ); // 3*float + 1*COLOR
+	}
+
+	// tell it about the normal buffer
+	if ( renderObject->lpNormalBuffer )
+	{
+		glBindBuffer( GL_ARRAY_BUFFER, (GLuint) renderObject->lpNormalBuffer );
+		vertex_attrib( program_info.vnormal, 3, GL_FLOAT, GL_FALSE, sizeof(NORMAL), 0 );
+	}
+
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, (GLuint) renderObject->lpIndexBuffer );
+	CHECK_GL_ERRORS;
+}
+
+// With vertex arrays each object keeps its layout in its own vertex
+// array, built on its first draw and again when the program or the
+// layout changes, FSCreate*Buffer clear vertexArrayKey when they
+// replace a buffer it refers to. Without them the layout is given
+// again on every draw.
+
+void bind_render_object( RENDEROBJECT *renderObject, bool orthographic )
+{
+	GLuint vao;
+	u_int32_t key = ( program_info.serial << 1 ) | ( orthographic ? 1 : 0 );
+
+	if ( !caps.vertex_arrays )
+	{
+		specify_vertex_attribs( renderObject, orthographic );
+		return;
+	}
+
+	if ( renderObject->vertexArray && renderObject->vertexArrayKey == key )
+	{
+		glBindVertexArray( (GLuint) renderObject->vertexArray );
+		return;
+	}
+
+	if ( !renderObject->vertexArray )
+	{
+		glGenVertexArrays( 1, &vao );
+		renderObject->vertexArray = vao;
+	}
+	glBindVertexArray( (GLuint) renderObject->vertexArray );
+	disable_vertex_attribs();
+	specify_vertex_attribs( renderObject, orthographic );
+	renderObject->vertexArrayKey = key;
+}
+
+void unbind_render_object( void )
+{
+	if ( caps.vertex_arrays )
+		glBindVertexArray( idle_vertex_array );
+	else
+		disable_vertex_attribs();
+}
+
+static void release_vertex_array( RENDEROBJECT *renderObject )
+{
+	GLuint vao = (GLuint) renderObject->vertexArray;
+	if ( vao )
+		glDeleteVertexArrays( 1, &vao );
+	renderObject->vertexArray = 0;
+	renderObject->vertexArrayKey = 0;
+}
 #endif
 
 bool draw_object(RENDEROBJECT *renderObject){return draw_render_object(renderObject,GL_TRIANGLES,false);}
@@ -939,6 +1439,9 @@ bool draw_line_object(RENDEROBJECT *renderObject){return draw_render_object(rend
 void FSReleaseRenderObject(RENDEROBJECT *renderObject)
 {
 	int i;
+#if GL > 1
+	release_vertex_array( renderObject );
+#endif
 	if (renderObject->lpVertexBuffer)
 	{
 		delete_buffer( &renderObject->lpVertexBuffer );
@@ -967,6 +1470,12 @@ void FSReleaseRenderObject(RENDEROBJECT *renderObject)
 		}
 	}
 	renderObject->numTextureGroups = 0;
+	if (renderObject->textureGroups)
+	{
+		free(renderObject->textureGroups);
+		renderObject->textureGroups = NULL;
+	}
+	renderObject->maxTextureGroups = 0;
 }
 
 #endif // GL
@@ -49,11 +49,14 @@ const char * render_error_description( int e );
 	} while (0)
 
 
-typedef struct { float anisotropic; } gl_caps_t;
+typedef struct { float anisotropic; bool vertex_arrays; } gl_caps_t;
 extern gl_caps_t caps;
 
 typedef struct { GLuint id; } texture_t; // Possibly later: GLuint bump_id;
 
+// the texture bound to GL_TEXTURE_2D, GL2/3 draws skip binding it again
+extern GLuint bound_texture;
+
 //
 // d3d stored the world/view matrixes
 // and then multiplied them together before rendering
@@ -69,12 +72,45 @@ extern MATRIX world_matrix;
 
 #if GL != 1
 
-void mvp_update( GLuint current_program );
+void ortho_update( void );
+void mvp_update( void );
+#ifdef NEW_LIGHTING
+void lighting_update( void );
+#endif
 
 extern GLuint vertex_shader;
 extern GLuint fragment_shader;
 extern GLuint current_program;
 
+// Where the current program keeps its inputs, looked up once when it
+// is linked instead of on every draw, -1 for one it does not use. The
+// last_* values are what the per draw flags were last set to, -1
+// until they are first sent.
+
+typedef struct
+{
+	GLint pos, tlpos, vcolor, vtexc, vnormal;
+	GLint orthographic, colorkeying_enabled, texturing_enabled;
+	GLint mvp, ortho_proj, world;
+#ifdef NEW_LIGHTING
+	GLint lights, light_pos, light_color, light_dir, min_light_size;
+	GLint lighting_enabled, point_lights_only, light_mode, ambience, color_blend;
+	GLint water, water_level, water_color, whiteout, seconds;
+#endif
+	int last_orthographic, last_colorkeying_enabled, last_texturing_enabled;
+	u_int32_t serial;	// bumped on every link
+} program_info_t;
+
+extern program_info_t program_info;
+
+void set_uniform_flag( GLint loc, int * last, bool value );
+void bind_texture( GLuint id );
+
+// binds the buffers of a render object with the attribute layout for
+// LVERTEX, or TLVERTEX when orthographic, and undoes it after the draw
+void bind_render_object( RENDEROBJECT *renderObject, bool orthographic );
+void unbind_render_object( void );
+
 LPVERTEXBUFFER _create_buffer( int size, GLenum type, GLenum gettype, GLenum usage );
 
 #define create_buffer( size, type, usage ) \
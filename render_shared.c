@@ -0,0 +1,29 @@
+/*
+  Render object helpers that do not depend on the backend,
+  everything here is built whichever render_* file is in use.
+*/
+#include "main.h"
+#include "util.h"
+#include "render.h"
+
+// grow the texture groups to hold at least count, never shrinks
+bool FSReserveTextureGroups(RENDEROBJECT *renderObject, int count)
+{
+	TEXTUREGROUP * groups;
+	int max;
+	if (count <= renderObject->maxTextureGroups)
+		return true;
+	max = renderObject->maxTextureGroups ? renderObject->maxTextureGroups * 2 : 4;
+	if (max < count)
+		max = count;
+	groups = (TEXTUREGROUP *) realloc(renderObject->textureGroups, max * sizeof(TEXTUREGROUP));
+	if (!groups)
+	{
+		Msg("FSReserveTextureGroups: failed to allocate %d texture groups\n", max);
+		return false;
+	}
+	memset(&groups[renderObject->maxTextureGroups], 0, (max - renderObject->maxTextureGroups) * sizeof(TEXTUREGROUP));
+	renderObject->textureGroups = groups;
+	renderObject->maxTextureGroups = max;
+	return true;
+}
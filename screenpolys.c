@@ -24,6 +24,7 @@
 #include "util.h"
 #include "timer.h"
 #include "oct2.h"
+#include "pool.h"
 
 #ifdef OPT_ON
 #pragma optimize( "gty", on )
@@ -66,10 +67,10 @@ extern	float			pixel_aspect_ratio;
 extern	DWORD			CurrentSrcBlend;
 extern	DWORD			CurrentDestBlend;
 extern	DWORD			CurrentTextureBlend;
-extern	SECONDARYWEAPONBULLET	SecBulls[MAXSECONDARYWEAPONBULLETS];
-extern	u_int16_t		FirstSecBullUsed;
+extern	SECONDARYWEAPONBULLET	*	SecBulls;
+extern	pool_t		SecBullPool;
 extern	int16_t			NumLevels;
-extern	MODEL		Models[ MAXNUMOFMODELS ];
+extern	MODEL		*	Models;
 extern	int				FontWidth;
 extern	int				FontHeight;
 extern	float			SoundInfo[MAXGROUPS][MAXGROUPS];
@@ -120,7 +121,7 @@ u_int16_t	FlashScreenPoly	= (u_int16_t) -1;
 u_int32_t	TotalScrPolysInUse = 0;
 SCRPOLY	ScrPolys[ MAXNUMOFSCRPOLYS ];
 u_int16_t	FirstScrPolyUsed;
-u_int16_t	FirstScrPolyFree;
+pool_t	ScrPolyPool;
 float	Countdown_Float = 3000.0F;	// 30 Seconds
 float	ZValue;
 float	RHWValue;
@@ -230,17 +231,15 @@ void InitScrPolys( void )
 	ClearCountdownBuffers();
 
 	FirstScrPolyUsed = (u_int16_t) -1;
-	FirstScrPolyFree = 0;
+	pool_init( &ScrPolyPool, "scrpolys", MAXNUMOFSCRPOLYS );
 	
 	for( i = 0; i < MAXNUMOFSCRPOLYS; i++ )
 	{
-		ScrPolys[i].Next = i + 1;
+		ScrPolys[i].Next = (u_int16_t) -1;
 		ScrPolys[i].Prev = (u_int16_t) -1;
 		InitScrPoly(i);
 	}
 
-	ScrPolys[ MAXNUMOFSCRPOLYS-1 ].Next = (u_int16_t) -1;
-
 	InitScrPolyTPages();
 
 	if( CountDownOn ) CreateCountdownDigits();
@@ -256,9 +255,10 @@ u_int16_t FindFreeScrPoly( void )
 {
 	u_int16_t i;
 
-	i = FirstScrPolyFree;
-	if( i == (u_int16_t) -1 ) return i;
+	i = pool_alloc( &ScrPolyPool );
+	if( i == POOL_NONE ) return i;
  
+	ScrPolys[i].Next = (u_int16_t) -1;
 	ScrPolys[i].Prev = FirstScrPolyUsed;
 							 
 	if ( FirstScrPolyUsed != (u_int16_t) -1)
@@ -267,7 +267,6 @@ u_int16_t FindFreeScrPoly( void )
 	}
 
 	FirstScrPolyUsed = i;
-	FirstScrPolyFree = ScrPolys[i].Next;
 
 	TotalScrPolysInUse++;
 
@@ -306,8 +305,8 @@ void KillUsedScrPoly( u_int16_t i )
 	}
 
 	ScrPolys[i].Prev = (u_int16_t) -1;
-	ScrPolys[i].Next = FirstScrPolyFree;
-	FirstScrPolyFree = i;
+	ScrPolys[i].Next = (u_int16_t) -1;
+	pool_free( &ScrPolyPool, i );
 
 	// cleanup the poly
 	// this is important other wise bugs will appear
@@ -928,15 +927,12 @@ void DoAllSecBullLensflare( void )
 {
 	u_int16_t	i;
 
-	i = FirstSecBullUsed;
-
-	while( i != (u_int16_t) -1 )
+	for( i = pool_first( &SecBullPool ); i != POOL_NONE; i = pool_next( &SecBullPool, i ) )
 	{
 		if( !SoundInfo[ SecBulls[i].GroupImIn ][ CurrentCamera.GroupImIn ] )
 		{
 			if( SecBulls[ i ].Lensflare ) SecBullLensflare( i );
 		}
-		i = SecBulls[ i ].Prev;											/* Next Missile */
 	}
 }
 
@@ -2195,7 +2191,8 @@ bool ScrPolyDispSolid( RENDEROBJECT *renderObject, int16_t * TPage, u_int16_t *
 
 	if( !TotalVerts ) return( false );
 
-	renderObject->numTextureGroups = 0;
+	if( !RESET_TEXTURE_GROUPS( renderObject ) )
+		return false;
 
 	ZValue = 1.0F;
 	RHWValue = ( 1.0F / ZValue );
@@ -2674,7 +2671,8 @@ bool ScrPolyDispNonSolid( RENDEROBJECT *renderObject, int16_t * TPage, u_int16_t
 
 	if( !TotalVerts ) return( false );
 
-	renderObject->numTextureGroups = 0;
+	if( !RESET_TEXTURE_GROUPS( renderObject ) )
+		return false;
 
 	ZValue = 1.0F;
 	RHWValue = ( 1.0F / ZValue );
@@ -36,6 +36,7 @@
 #include "water.h"
 #include "local.h"
 #include "util.h"
+#include "pool.h"
 #include "timer.h"
 
 #define	SCATTER_TEST	0
@@ -79,8 +80,8 @@ extern	MCLOADHEADER	MCloadheader;
 extern	MCLOADHEADER	MCloadheadert0;
 extern	XLIGHT			XLights[MAXXLIGHTS];
 extern	FMPOLY			FmPolys[MAXNUMOF2DPOLYS];
-extern	POLY			Polys[MAXPOLYS];
-extern	MODEL			Models[MAXNUMOFMODELS];
+extern	POLY			*	Polys;
+extern	MODEL			*	Models;
 extern	float			framelag;
 extern	BYTE			WhoIAm;
 extern	bool            bSoundEnabled;
@@ -134,7 +135,7 @@ extern	bool			PickupInvulnerability;
 extern	int16_t			NumInvuls;
 extern	float			SoundInfo[MAXGROUPS][MAXGROUPS];
 extern	ENEMY	*		FirstEnemyUsed;
-extern	ENEMY			Enemies[ MAXENEMIES ];
+extern	ENEMY			*	Enemies;
 extern	ENEMY_TYPES		EnemyTypes[ MAX_ENEMY_TYPES ];
 extern	int				no_collision;		// disables player ship-to-background collisions
 extern	int				outside_map;
@@ -242,10 +243,10 @@ ENTRY		EntryList[ MAX_ENTRYS ];
 ENTRY	*	FirstFree = &EntryList[ 0 ];
 ENTRY	*	FirstUsed = NULL;
 
-SECONDARYWEAPONBULLET	SecBulls[MAXSECONDARYWEAPONBULLETS];
+SECONDARYWEAPONBULLET	*	SecBulls;
 SHORTMINE	MinesCopy[ MAX_PLAYERS ][ MAXSECONDARYWEAPONBULLETS ];
 u_int16_t		FirstSecBullUsed;
-u_int16_t		FirstSecBullFree;
+pool_t			SecBullPool;
 float		SecondaryFireDelay = 0.0F;
 
 int16_t		SecondaryWeaponsGot[ MAXSECONDARYWEAPONS ];
@@ -847,6 +848,51 @@ SECONDARYWEAPONATTRIB	SecondaryWeaponAttribs[ TOTALSECONDARYWEAPONS ] = {
 	},
 };
 
+/*===================================================================
+	Procedure	:	Init one SecBull, also called as the pool grows
+	Input		:	u_int16_t	SecBull Index
+	Output		:	nothing
+===================================================================*/
+static void InitSecBull( u_int16_t i )
+{
+	SecBulls[ i ].Used = false;
+	SecBulls[ i ].Next = (u_int16_t) -1;
+	SecBulls[ i ].Prev = (u_int16_t) -1;
+	SecBulls[ i ].NextInGroup = NULL;
+	SecBulls[ i ].PrevInGroup = NULL;
+	SecBulls[ i ].State = MIS_STRAIGHT;
+	SecBulls[ i ].Flags = SECFLAGS_Nothing;
+	SecBulls[ i ].Index = i;
+	SecBulls[ i ].Type = (u_int16_t) -1;
+	SecBulls[ i ].SecType = SEC_MISSILE;
+	SecBulls[ i ].DropCount = 0.0F;
+	SecBulls[ i ].MoveType = MISMOVE_STRAIGHT;
+	SecBulls[ i ].Owner = (u_int16_t) -1;
+	SecBulls[ i ].LifeCount = 0.0F;
+	SecBulls[ i ].ColFlag = 0;
+	SecBulls[ i ].GroupImIn = (u_int16_t) -1;
+	SecBulls[ i ].ModelNum = (u_int16_t) -1;
+	SecBulls[ i ].ModelIndex = (u_int16_t) -1;
+	SecBulls[ i ].fmpoly = (u_int16_t) -1;
+	SecBulls[ i ].numfmpolys = 0;
+	SecBulls[ i ].poly = (u_int16_t) -1;
+	SecBulls[ i ].numpolys = 0;
+	SecBulls[ i ].light = (u_int16_t) -1;
+	SecBulls[ i ].Target = (u_int16_t) -1;
+	SecBulls[ i ].TargetType = (u_int16_t) -1;
+	SecBulls[ i ].SpeedWanted = 32.0F;
+	SecBulls[ i ].SpeedInc = 32.0F;
+	SecBulls[ i ].Speed = 32.0F;
+	SecBulls[ i ].TurnSpeed = 0.0F;
+	SecBulls[ i ].ViewCone = 0.0F;
+	SecBulls[ i ].DirVector = Forward;
+	SecBulls[ i ].UpVector = SlideUp;
+	SecBulls[ i ].DropVector = SlideDown;
+	SecBulls[ i ].NumOldPos = 0;
+	QuatFrom2Vectors( &SecBulls[ i ].DirQuat, &Forward, &SecBulls[ i ].DirVector );
+	QuatToMatrix( &SecBulls[ i ].DirQuat, &SecBulls[ i ].Mat );
+}
+
 /*===================================================================
 	Procedure	:	Set up And Init all SecBulls
 	Input		:	nothing
@@ -854,53 +900,12 @@ SECONDARYWEAPONATTRIB	SecondaryWeaponAttribs[ TOTALSECONDARYWEAPONS ] = {
 ===================================================================*/
 void	InitSecBulls(void)
 {
-	u_int16_t	i;
-
 	FirstSecBullUsed = (u_int16_t) -1;
-	FirstSecBullFree = 0;
 
 	SetupSecBullGroups();
 
-	for( i = 0 ; i < MAXSECONDARYWEAPONBULLETS ; i++ )
-	{
-		SecBulls[ i ].Used = false;
-		SecBulls[ i ].Next = i + 1;
-		SecBulls[ i ].Prev = (u_int16_t) -1;
-		SecBulls[ i ].NextInGroup = NULL;
-		SecBulls[ i ].PrevInGroup = NULL;
-		SecBulls[ i ].State = MIS_STRAIGHT;
-		SecBulls[ i ].Flags = SECFLAGS_Nothing;
-		SecBulls[ i ].Index = i;
-		SecBulls[ i ].Type = (u_int16_t) -1;
-		SecBulls[ i ].SecType = SEC_MISSILE;
-		SecBulls[ i ].DropCount = 0.0F;
-		SecBulls[ i ].MoveType = MISMOVE_STRAIGHT;
-		SecBulls[ i ].Owner = (u_int16_t) -1;
-		SecBulls[ i ].LifeCount = 0.0F;
-		SecBulls[ i ].ColFlag = 0;
-		SecBulls[ i ].GroupImIn = (u_int16_t) -1;
-		SecBulls[ i ].ModelNum = (u_int16_t) -1;
-		SecBulls[ i ].ModelIndex = (u_int16_t) -1;
-		SecBulls[ i ].fmpoly = (u_int16_t) -1;
-		SecBulls[ i ].numfmpolys = 0;
-		SecBulls[ i ].poly = (u_int16_t) -1;
-		SecBulls[ i ].numpolys = 0;
-		SecBulls[ i ].light = (u_int16_t) -1;
-		SecBulls[ i ].Target = (u_int16_t) -1;
-		SecBulls[ i ].TargetType = (u_int16_t) -1;
-		SecBulls[ i ].SpeedWanted = 32.0F;
-		SecBulls[ i ].SpeedInc = 32.0F;
-		SecBulls[ i ].Speed = 32.0F;
-		SecBulls[ i ].TurnSpeed = 0.0F;
-		SecBulls[ i ].ViewCone = 0.0F;
-		SecBulls[ i ].DirVector = Forward;
-		SecBulls[ i ].UpVector = SlideUp;
-		SecBulls[ i ].DropVector = SlideDown;
-		SecBulls[ i ].NumOldPos = 0;
-		QuatFrom2Vectors( &SecBulls[ i ].DirQuat, &Forward, &SecBulls[ i ].DirVector );
-		QuatToMatrix( &SecBulls[ i ].DirQuat, &SecBulls[ i ].Mat );
-	}
-	SecBulls[MAXSECONDARYWEAPONBULLETS-1].Next = (u_int16_t) -1;
+	pool_init_table( &SecBullPool, "secbulls", (void **) &SecBulls,
+		sizeof( SECONDARYWEAPONBULLET ), MAXSECONDARYWEAPONBULLETS, InitSecBull );
 }
 /*===================================================================
 	Procedure	:	Find a free SecBull and move it from the free list to
@@ -912,9 +917,9 @@ u_int16_t	FindFreeSecBull(void)
 {
 	u_int16_t i;
 
-	i = FirstSecBullFree;
+	i = pool_alloc( &SecBullPool );
 	
-	if ( i == (u_int16_t) -1)
+	if ( i == POOL_NONE )
 		return i;
 
 	if( SecBulls[i].Used )
@@ -924,13 +929,13 @@ u_int16_t	FindFreeSecBull(void)
 	}
 	
 	
+	SecBulls[i].Next = (u_int16_t) -1;
 	SecBulls[i].Prev = FirstSecBullUsed;
 	if ( FirstSecBullUsed != (u_int16_t) -1)
 	{
 		SecBulls[FirstSecBullUsed].Next = i;
 	}
 	FirstSecBullUsed = i;
-	FirstSecBullFree = SecBulls[i].Next;
 	SecBulls[i].Used = true;
 	return i ;
 }
@@ -966,8 +971,8 @@ void	KillUsedSecBull( u_int16_t i )
 		SecBulls[its_next].Prev = its_prev;
 
 	SecBulls[i].Prev = (u_int16_t) -1;
-	SecBulls[i].Next = FirstSecBullFree;
-	FirstSecBullFree	= i;
+	SecBulls[i].Next = (u_int16_t) -1;
+	pool_free( &SecBullPool, i );
 	SecBulls[i].Used = false;
 
 }
@@ -7796,7 +7801,8 @@ void CopyMines( u_int16_t Player )
 	{
 		Next = SecBulls[ i ].Prev;							/* Next Secondary Bullet */
 
-		if( SecBulls[ i ].SecType == SEC_MINE )
+		// the mine sync sections only cover the starting table size
+		if( ( SecBulls[ i ].SecType == SEC_MINE ) && ( Num < MAXSECONDARYWEAPONBULLETS ) )
 		{
 			MinesCopy[ Player ][ Num ].Owner	= SecBulls[ i ].Owner;
 			MinesCopy[ Player ][ Num ].Group	= SecBulls[ i ].GroupImIn;
@@ -8554,9 +8560,15 @@ bool CheckProximityToShips( VECTOR * Pos, u_int16_t Group, float Radius, u_int16
 	u_int16_t	EndGroup;
 	float	DistToShip;
 	VECTOR	DirVector;
+	u_int16_t	Near[ MAX_PLAYERS ];
+	int		NumNear, n;
 
-	for( Count = 0; Count < MAX_PLAYERS; Count++ )
+	NumNear = ShipsNear( Pos, Radius, Near );
+
+	for( n = 0; n < NumNear; n++ )
 	{
+		Count = Near[ n ];
+
 		if( !( ( OwnerType == OWNER_SHIP ) && ( Owner == Count ) ) )
    		{
 			if( (Ships[Count].enable ) && (Ships[Count].Object.Mode != LIMBO_MODE) && ((GameStatus[Count] == STATUS_Normal )||(GameStatus[Count] == STATUS_SinglePlayer ) ) )
@@ -8605,12 +8617,13 @@ bool CheckProximityToEnemies( VECTOR * Pos, u_int16_t Group, float Radius, u_int
 	float		DistToEnemy;
 	VECTOR		DirVector;
 	u_int16_t		TempEnemyIndex;
+	ENEMY_NEAR	Near;
 
-	Enemy = FirstEnemyUsed;
+	Enemy = FirstEnemyNear( &Near, Pos, Radius );
 
 	while( Enemy != NULL )
 	{
-		NextEnemy = Enemy->NextUsed;
+		NextEnemy = NextEnemyNear( &Near, Enemy );
 
 		if( !( ( OwnerType == OWNER_ENEMY ) && ( Owner == Enemy->Index ) ) )
 		{
@@ -8922,6 +8935,7 @@ FILE * SaveSecBulls( FILE * fp )
 {
 	u_int16_t	i;
 	u_int16_t	TempIndex = (u_int16_t) -1;
+	u_int16_t	FirstFree;
 
 	if( fp )
 	{
@@ -8946,7 +8960,8 @@ FILE * SaveSecBulls( FILE * fp )
 
 
 		fwrite( &FirstSecBullUsed, sizeof( FirstSecBullUsed ), 1, fp );
-		fwrite( &FirstSecBullFree, sizeof( FirstSecBullFree ), 1, fp );
+		FirstFree = pool_free_slot( &SecBullPool, 0 );
+		fwrite( &FirstFree, sizeof( FirstFree ), 1, fp );
 		fwrite( &SecondaryFireDelay, sizeof( SecondaryFireDelay ), 1, fp );
 		fwrite( &TargetComputerOn, sizeof( TargetComputerOn ), 1, fp );
 		fwrite( &ImTargeted, sizeof( ImTargeted ), 1, fp );
@@ -9029,13 +9044,7 @@ FILE * SaveSecBulls( FILE * fp )
 			i = SecBulls[ i ].Prev;
 		}
 
-		i = FirstSecBullFree;
-
-		while( i != (u_int16_t) -1 )
-		{
-			fwrite( &SecBulls[ i ].Next, sizeof( SecBulls[ i ].Next ), 1, fp );
-			i = SecBulls[ i ].Next;
-		}
+		pool_save_free( &SecBullPool, fp );
 	}
 
 	return( fp );
@@ -9050,6 +9059,8 @@ FILE * LoadSecBulls( FILE * fp )
 {
 	u_int16_t	i;
 	u_int16_t	TempIndex = (u_int16_t) -1;
+	u_int16_t	FirstFree;
+	u_int16_t	NextFree;
 
 	if( fp )
 	{
@@ -9075,7 +9086,8 @@ FILE * LoadSecBulls( FILE * fp )
 
 
 		fread( &FirstSecBullUsed, sizeof( FirstSecBullUsed ), 1, fp );
-		fread( &FirstSecBullFree, sizeof( FirstSecBullFree ), 1, fp );
+		fread( &FirstFree, sizeof( FirstFree ), 1, fp );
+		pool_clear( &SecBullPool );
 		fread( &SecondaryFireDelay, sizeof( SecondaryFireDelay ), 1, fp );
 		fread( &TargetComputerOn, sizeof( TargetComputerOn ), 1, fp );
 		fread( &ImTargeted, sizeof( ImTargeted ), 1, fp );
@@ -9086,6 +9098,11 @@ FILE * LoadSecBulls( FILE * fp )
 
 		while( i != (u_int16_t) -1 )
 		{
+			if( !pool_fit( &SecBullPool, i ) )
+			{
+				fclose( fp );
+				return( NULL );
+			}
 			fread( &SecBulls[ i ].Used, sizeof( bool ), 1, fp );
 			fread( &SecBulls[ i ].Next, sizeof( u_int16_t ), 1, fp );
 			fread( &SecBulls[ i ].Prev, sizeof( u_int16_t ), 1, fp );
@@ -9159,52 +9176,27 @@ FILE * LoadSecBulls( FILE * fp )
 			fread( &SecBulls[ i ].Interval, sizeof( float ), 1, fp );
 			fread( &SecBulls[ i ].Time, sizeof( float ), 1, fp );
 			fread( &SecBulls[ i ].OldPos[ 0 ], sizeof( SecBulls[ i ].OldPos ), 1, fp );
+			pool_mark( &SecBullPool, i );
 			i = SecBulls[ i ].Prev;
 		}
 
-		i = FirstSecBullFree;
+		i = FirstFree;
 
 		while( i != (u_int16_t) -1 )
 		{
-			SecBulls[ i ].Used = false;
-			SecBulls[ i ].Prev = (u_int16_t) -1;
-			SecBulls[ i ].NextInGroup = NULL;
-			SecBulls[ i ].PrevInGroup = NULL;
-			SecBulls[ i ].State = MIS_STRAIGHT;
-			SecBulls[ i ].Flags = SECFLAGS_Nothing;
-			SecBulls[ i ].Index = i;
-			SecBulls[ i ].Type = (u_int16_t) -1;
-			SecBulls[ i ].SecType = SEC_MISSILE;
-			SecBulls[ i ].DropCount = 0.0F;
-			SecBulls[ i ].MoveType = MISMOVE_STRAIGHT;
-			SecBulls[ i ].Owner = (u_int16_t) -1;
-			SecBulls[ i ].LifeCount = 0.0F;
-			SecBulls[ i ].ColFlag = 0;
-			SecBulls[ i ].GroupImIn = (u_int16_t) -1;
-			SecBulls[ i ].ModelNum = (u_int16_t) -1;
-			SecBulls[ i ].ModelIndex = (u_int16_t) -1;
-			SecBulls[ i ].fmpoly = (u_int16_t) -1;
-			SecBulls[ i ].numfmpolys = 0;
-			SecBulls[ i ].poly = (u_int16_t) -1;
-			SecBulls[ i ].numpolys = 0;
-			SecBulls[ i ].light = (u_int16_t) -1;
-			SecBulls[ i ].Target = (u_int16_t) -1;
-			SecBulls[ i ].TargetType = (u_int16_t) -1;
-			SecBulls[ i ].SpeedWanted = 32.0F;
-			SecBulls[ i ].SpeedInc = 32.0F;
-			SecBulls[ i ].Speed = 32.0F;
-			SecBulls[ i ].TurnSpeed = 0.0F;
-			SecBulls[ i ].ViewCone = 0.0F;
-			SecBulls[ i ].DirVector = Forward;
-			SecBulls[ i ].UpVector = SlideUp;
-			SecBulls[ i ].DropVector = SlideDown;
-			SecBulls[ i ].NumOldPos = 0;
-			QuatFrom2Vectors( &SecBulls[ i ].DirQuat, &Forward, &SecBulls[ i ].DirVector );
-			QuatToMatrix( &SecBulls[ i ].DirQuat, &SecBulls[ i ].Mat );
-
-			fread( &SecBulls[ i ].Next, sizeof( SecBulls[ i ].Next ), 1, fp );
-			i = SecBulls[ i ].Next;
+			if( !pool_fit( &SecBullPool, i ) )
+			{
+				fclose( fp );
+				return( NULL );
+			}
+			InitSecBull( i );
+
+			pool_load_free( &SecBullPool, i );
+			fread( &NextFree, sizeof( NextFree ), 1, fp );
+			i = NextFree;
 		}
+
+		pool_rebuild( &SecBullPool );
 	}
 
 	return( fp );
@@ -520,7 +520,7 @@ char *SfxFullPath[ MAX_SFX ][ MAX_SFX_VARIANTS ];
 /****************************************
 Externals
 *****************************************/
-extern 	ENEMY Enemies[];
+extern 	ENEMY * Enemies;
 extern SLIDER BikeCompSpeechSlider;
 extern SLIDER BikerSpeechSlider;
 extern USERCONFIG	*player_config;
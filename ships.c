@@ -90,6 +90,8 @@ u_int32_t TeamFlagMask[ MAX_TEAMS ] = {
 	SHIP_CarryingFlag4,
 };
 
+grid_t	ShipGrid;
+
 extern int GoalScore;
 extern int16_t PickupsGot[ MAXPICKUPTYPES ];
 extern int FlagsToGenerate;
@@ -688,6 +690,45 @@ bool SetUpShips()
 	return true;
 }
 
+/*===================================================================
+	Procedure	:	Put every ship in the grid once they have all
+				:	moved for the frame
+	Input		:	nothing
+	Output		:	nothing
+===================================================================*/
+void BuildShipGrid( void )
+{
+	u_int16_t	Count;
+
+	grid_clear( &ShipGrid );
+
+	for( Count = 0; Count < MAX_PLAYERS; Count++ )
+		grid_add( &ShipGrid, Count, &Ships[ Count ].Object.Pos, SHIP_RADIUS );
+}
+
+/*===================================================================
+	Procedure	:	Which ships could be within a distance of a
+				:	point, every ship if the grid can't say
+	Input		:	VECTOR	*	Pos
+				:	float		Distance
+				:	u_int16_t	*	Ships found ( room for MAX_PLAYERS )
+	Output		:	int			Number of ships, lowest first
+===================================================================*/
+int ShipsNear( VECTOR * Pos, float Radius, u_int16_t * Near )
+{
+	int		Num;
+
+	Num = grid_query( &ShipGrid, Pos, Radius, Near, MAX_PLAYERS );
+
+	if( Num < 0 )
+	{
+		for( Num = 0; Num < MAX_PLAYERS; Num++ )
+			Near[ Num ] = (u_int16_t) Num;
+	}
+
+	return Num;
+}
+
 #ifdef DEMO_SUPPORT
 static	LONGLONG	TempTime;
 static	LONGLONG	TempTime2;
@@ -2075,6 +2116,7 @@ void InitShipStartPos( int16_t i, int16_t pos )
 	float	autolevel;
 #endif
 	JustGenerated = true;
+	grid_invalidate( &ShipGrid );
 
 	if( (MyGameStatus==STATUS_SinglePlayer) || (MyGameStatus==STATUS_StartingSinglePlayer) )
 	{
@@ -2244,6 +2286,7 @@ bool GotoRoom( int16_t i, char *roomname )
 	Ships[i].Object.Pos.x = Start_Pos.x;
 	Ships[i].Object.Pos.y = Start_Pos.y;			
 	Ships[i].Object.Pos.z = Start_Pos.z;
+	grid_invalidate( &ShipGrid );
 	QuatToMatrix( &Ships[i].Object.Quat, &Ships[i].Object.Mat );
 	ApplyMatrix( &Ships[i].Object.Mat, &SlideUp, &Ship_Up );
 	CrossProduct( &Start_Dir, &Start_Up, &Start_Right );
@@ -22,8 +22,10 @@
 #include "sfx.h"
 #include "models.h"
 #include "mxload.h"
+#include "grid.h"
 
 extern bool SwitchedToWatchMode;
+extern grid_t ShipGrid;
 
 #define DEG2RAD(D)				((D) * PI / 180.0F)
 
@@ -73,6 +75,8 @@ typedef struct _BIKEMOD
 
 bool SetUpShips();
 bool ProcessShips();
+void BuildShipGrid( void );
+int ShipsNear( VECTOR * Pos, float Radius, u_int16_t * Near );
 void	InitShipsChangeLevel( MLOADHEADER * Mloadheader );
 bool	ENV( MXLOADHEADER * Mloadheader , MATRIX * Mat ,VECTOR * Pos);
 int16_t DoDamage( bool OverrideInvul );
@@ -13,6 +13,7 @@
 #include "primary.h"
 #include "skin.h"
 #include "util.h"
+#include "pool.h"
 
 #define USE_BSP_COLOURS
 
@@ -37,11 +38,12 @@ extern	bool		NodeCubeType;
 
 extern	int			Depth;
 extern	BSP_NODE *	BSP_Nodes[ 256 ];
+extern	pool_t		ModelPool;
 extern	bool		Inside;
 extern	float		CollisionRadius;
 extern	bool		ShowColZones;
 
-extern	MODEL		Models[MAXNUMOFMODELS];
+extern	MODEL		*	Models;
 extern	MATRIX		MATRIX_Identity;
 
 #define	BOXSIZE		96.0F
@@ -80,8 +82,9 @@ extern	MATRIX		MATRIX_Identity;
 	u_int16_t					NodeCubeLines[ MAXLINES ];
 
 	VECTOR					TempVerts[ 64 ];
-	u_int16_t					SphereZones[ MAXNUMOFMODELS ];
-	int16_t					NumSphereZones = 0;
+	u_int16_t				*	SphereZones = NULL;
+	int						SphereZonesSize = 0;
+	int						NumSphereZones = 0;
 
 
 /*===================================================================
@@ -618,7 +621,7 @@ void DisplayNewBSPNode( BSP_NODE * Node )
 ===================================================================*/
 void KillAllSphereZones( void )
 {
-	int16_t	Count;
+	int		Count;
 
 	for( Count = 0; Count < NumSphereZones; Count++ )
 	{
@@ -632,6 +635,34 @@ void KillAllSphereZones( void )
 	NumSphereZones = 0;
 }
 
+/*===================================================================
+	Procedure	:		Remember a model shown as a zone, every zone
+				:		holds a model so there is never more of them
+				:		than the model pool has slots
+	Input		:		u_int16_t			Model
+	Output		:		Nothing
+===================================================================*/
+static void AddSphereZone( u_int16_t Model )
+{
+	u_int16_t	*	Zones;
+
+	if( NumSphereZones == SphereZonesSize )
+	{
+		Zones = NULL;
+		if( ModelPool.size > SphereZonesSize )
+			Zones = (u_int16_t *) realloc( SphereZones, ModelPool.size * sizeof( u_int16_t ) );
+		if( !Zones )
+		{
+			KillUsedModel( Model );
+			return;
+		}
+		SphereZones = Zones;
+		SphereZonesSize = ModelPool.size;
+	}
+
+	SphereZones[ NumSphereZones++ ] = Model;
+}
+
 /*===================================================================
 	Procedure	:		Display sphere zone
 	Input		:		VECTOR		*	Pos
@@ -673,8 +704,7 @@ void DisplaySphereZone( VECTOR * Pos, float Radius, u_int16_t Group,
 		Models[ Model ].Blue = (int) Blue;
 		Models[ Model ].LifeCount = 1000000.0F;
 
-		SphereZones[ NumSphereZones ] = Model;
-		NumSphereZones++;
+		AddSphereZone( Model );
 	}
 }
 
@@ -715,8 +745,7 @@ void DisplayZoneDirection( VECTOR * Pos, VECTOR * Dir, u_int16_t Group )
 		Models[ Model ].Group = Group;
 		Models[ Model ].LifeCount = 1000000.0F;
 
-		SphereZones[ NumSphereZones ] = Model;
-		NumSphereZones++;
+		AddSphereZone( Model );
 	}
 }
 
@@ -758,8 +787,7 @@ void DisplayDirAndUp( VECTOR * Pos, VECTOR * Dir, VECTOR *Up, u_int16_t Group )
 		Models[ Model ].Group = Group;
 		Models[ Model ].LifeCount = 1000000.0F;
 
-		SphereZones[ NumSphereZones ] = Model;
-		NumSphereZones++;
+		AddSphereZone( Model );
 	}
 }
 
@@ -30,6 +30,7 @@
 
 #include "sfx.h"
 #include "util.h"
+#include "pool.h"
 
 /*===================================================================
 	External Variables
@@ -54,7 +55,7 @@ extern	VECTOR			SlideUp;
 extern	VECTOR			SlideDown;
 extern	VECTOR			SlideLeft;
 extern	VECTOR			SlideRight;
-extern	MODEL			Models[MAXNUMOFMODELS];
+extern	MODEL			*	Models;
 extern	MATRIX			MATRIX_Identity;
 extern	u_int16_t			IsGroupVisible[MAXGROUPS];
 extern	u_int16_t			GlobalPrimBullsID;
@@ -62,7 +63,7 @@ extern	u_int16_t			GlobalSecBullsID;
 extern	MLOADHEADER		Mloadheader;
 extern	MCLOADHEADER	MCloadheader;
 extern	MCLOADHEADER	MCloadheadert0;
-extern	ENEMY			Enemies[ MAXENEMIES ];
+extern	ENEMY			*	Enemies;
 
 /*===================================================================
 	Defines
@@ -73,11 +74,11 @@ extern	ENEMY			Enemies[ MAXENEMIES ];
 	Global Variables
 ===================================================================*/
 	int32_t		NumSpotFX;
-	SPOTFX		SpotFX[ MAXSPOTFX ];
+	SPOTFX		*	SpotFX;
 	SPOTFX	*	SpotFXGroups[ MAXGROUPS ];
 	u_int16_t		NumSpotFXPerGroup[ MAXGROUPS ];
 	SPOTFX	*	FirstSpotFXUsed = NULL;
-	SPOTFX	*	FirstSpotFXFree = NULL;
+	pool_t			SpotFXPool;
 
 /*===================================================================
 	Procedure	:	Load all SpotFX
@@ -128,7 +129,7 @@ bool LoadSpotFX( void )
 
 		fread( &NumSpotFX, sizeof( int32_t ), 1, fp );
 
-		if( NumSpotFX > MAXSPOTFX )
+		if( NumSpotFX > SpotFXPool.limit )
 		{
 			DebugPrintf( "Too many SpotFX (%d)\n", NumSpotFX );
 			fclose( fp );
@@ -571,6 +572,22 @@ void ProcessSpotFX( void )
 	}
 }
 
+/*===================================================================
+	Procedure	:	Init one SpotFX slot, also called as the pool grows
+	Input		:	u_int16_t	SpotFX Index
+	Output		:	nothing
+===================================================================*/
+static void InitSpotFXSlot( u_int16_t i )
+{
+	memset( &SpotFX[ i ], 0, sizeof( SPOTFX ) );
+
+	SpotFX[ i ].NextUsed = NULL;
+	SpotFX[ i ].PrevUsed = NULL;
+	SpotFX[ i ].NextInGroup = NULL;
+	SpotFX[ i ].PrevInGroup = NULL;
+	SpotFX[ i ].Index = i;
+}
+
 /*===================================================================
 	Procedure	:	Setup all SpotFX
 	Input		:	nothing
@@ -578,28 +595,10 @@ void ProcessSpotFX( void )
 ===================================================================*/
 void SetupSpotFX( void )
 {
-	u_int16_t	i;
-
 	SetupSpotFXGroups();
 
 	FirstSpotFXUsed = NULL;
-	FirstSpotFXFree = &SpotFX[ 0 ];
-
-	for( i = 0; i < MAXSPOTFX; i++ )
-	{
-		memset( &SpotFX[ i ], 0, sizeof( SPOTFX ) );
-
-		SpotFX[ i ].NextUsed = NULL;
-		SpotFX[ i ].PrevUsed = NULL;
-		SpotFX[ i ].NextFree = &SpotFX[ i + 1 ];
-		SpotFX[ i ].PrevFree = &SpotFX[ i - 1 ];
-		SpotFX[ i ].NextInGroup = NULL;
-		SpotFX[ i ].PrevInGroup = NULL;
-		SpotFX[ i ].Index = i;
-	}
-
-	SpotFX[ 0 ].PrevFree = NULL;
-	SpotFX[ MAXSPOTFX - 1 ].NextFree = NULL;
+	pool_init_table( &SpotFXPool, "spotfx", (void **) &SpotFX, sizeof( SPOTFX ), MAXSPOTFX, InitSpotFXSlot );
 }
 
 /*===================================================================
@@ -750,17 +749,14 @@ void DisableSpotFX( u_int16_t SpotFXIndex )
 ===================================================================*/
 SPOTFX * FindFreeSpotFX( void )
 {
-	SPOTFX * Object;
+	SPOTFX * Object = NULL;
+	u_int16_t i;
 
-	Object = FirstSpotFXFree;
+	i = pool_alloc( &SpotFXPool );
 
-	if( Object != NULL )
+	if( i != POOL_NONE )
 	{
-		FirstSpotFXFree = Object->NextFree;
-		if( FirstSpotFXFree != NULL )
-		{
-			FirstSpotFXFree->PrevFree = NULL;
-		}
+		Object = &SpotFX[ i ];
 
 		if( FirstSpotFXUsed != NULL )
 		{
@@ -820,14 +816,7 @@ void KillUsedSpotFX( SPOTFX * Object )
 			}
 		}
 
-		if( FirstSpotFXFree != NULL )
-		{
-			FirstSpotFXFree->PrevFree = Object;
-		}
-
-		Object->NextFree = FirstSpotFXFree;
-		Object->PrevFree = NULL;
-		FirstSpotFXFree = Object;
+		pool_free( &SpotFXPool, Object->Index );
 	}
 }
 
@@ -2425,6 +2414,7 @@ FILE * SaveAllSpotFX( FILE * fp )
 {
 	int		i;
 	u_int16_t	TempIndex = (u_int16_t) -1; 
+	u_int16_t	FirstFree;
 
 	if( fp )
 	{
@@ -2439,8 +2429,8 @@ FILE * SaveAllSpotFX( FILE * fp )
 
 		if( FirstSpotFXUsed != NULL ) fwrite( &FirstSpotFXUsed->Index, sizeof( u_int16_t ), 1, fp );
 		else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
-		if( FirstSpotFXFree != NULL ) fwrite( &FirstSpotFXFree->Index, sizeof( u_int16_t ), 1, fp );
-		else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
+		FirstFree = pool_free_slot( &SpotFXPool, 0 );
+		fwrite( &FirstFree, sizeof( u_int16_t ), 1, fp );
 
 		for( i = 0; i < NumSpotFX; i++ )
 		{
@@ -2474,10 +2464,8 @@ FILE * SaveAllSpotFX( FILE * fp )
 			else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
 			if( SpotFX[ i ].NextUsed != NULL ) fwrite( &SpotFX[ i ].NextUsed->Index, sizeof( u_int16_t ), 1, fp );
 			else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
-			if( SpotFX[ i ].PrevFree != NULL ) fwrite( &SpotFX[ i ].PrevFree->Index, sizeof( u_int16_t ), 1, fp );
-			else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
-			if( SpotFX[ i ].NextFree != NULL ) fwrite( &SpotFX[ i ].NextFree->Index, sizeof( u_int16_t ), 1, fp );
-			else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
+			fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );		// was PrevFree
+			fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );		// was NextFree
 			if( SpotFX[ i ].PrevInGroup != NULL ) fwrite( &SpotFX[ i ].PrevInGroup->Index, sizeof( u_int16_t ), 1, fp );
 			else fwrite( &TempIndex, sizeof( u_int16_t ), 1, fp );
 			if( SpotFX[ i ].NextInGroup != NULL ) fwrite( &SpotFX[ i ].NextInGroup->Index, sizeof( u_int16_t ), 1, fp );
@@ -2497,13 +2485,15 @@ FILE * LoadAllSpotFX( FILE * fp )
 {
 	int		i;
 	u_int16_t	TempIndex;
+	SPOTFX	*	Object;
 	int32_t	TempNumSpotFX;
 
 	if( fp )
 	{
 		fread( &TempNumSpotFX, sizeof( TempNumSpotFX ), 1, fp );
 
-		if( TempNumSpotFX != NumSpotFX )
+		if( ( TempNumSpotFX != NumSpotFX ) ||
+			( NumSpotFX && !pool_fit( &SpotFXPool, (u_int16_t) ( NumSpotFX - 1 ) ) ) )
 		{
 			fclose( fp );
 			return( NULL );
@@ -2520,9 +2510,7 @@ FILE * LoadAllSpotFX( FILE * fp )
 		fread( &TempIndex, sizeof( u_int16_t ), 1, fp );
 		if( TempIndex != (u_int16_t) -1 ) FirstSpotFXUsed = &SpotFX[ TempIndex ];
 		else FirstSpotFXUsed = NULL;
-		fread( &TempIndex, sizeof( u_int16_t ), 1, fp );
-		if( TempIndex != (u_int16_t) -1 ) FirstSpotFXFree = &SpotFX[ TempIndex ];
-		else FirstSpotFXFree = NULL;
+		fread( &TempIndex, sizeof( u_int16_t ), 1, fp );		// first free, the pool is rebuilt below
 
 		for( i = 0; i < NumSpotFX; i++ )
 		{
@@ -2558,12 +2546,8 @@ FILE * LoadAllSpotFX( FILE * fp )
 			fread( &TempIndex, sizeof( u_int16_t ), 1, fp );
 			if( TempIndex != (u_int16_t) -1 ) SpotFX[ i ].NextUsed = &SpotFX[ TempIndex ];
 			else SpotFX[ i ].NextUsed = NULL;
-			fread( &TempIndex, sizeof( u_int16_t ), 1, fp );
-			if( TempIndex != (u_int16_t) -1 ) SpotFX[ i ].PrevFree = &SpotFX[ TempIndex ];
-			else SpotFX[ i ].PrevFree = NULL;
-			fread( &TempIndex, sizeof( u_int16_t ), 1, fp );
-			if( TempIndex != (u_int16_t) -1 ) SpotFX[ i ].NextFree = &SpotFX[ TempIndex ];
-			else SpotFX[ i ].NextFree = NULL;
+			fread( &TempIndex, sizeof( u_int16_t ), 1, fp );		// was PrevFree
+			fread( &TempIndex, sizeof( u_int16_t ), 1, fp );		// was NextFree
 			fread( &TempIndex, sizeof( u_int16_t ), 1, fp );
 			if( TempIndex != (u_int16_t) -1 ) SpotFX[ i ].PrevInGroup = &SpotFX[ TempIndex ];
 			else SpotFX[ i ].PrevInGroup = NULL;
@@ -2571,6 +2555,11 @@ FILE * LoadAllSpotFX( FILE * fp )
 			if( TempIndex != (u_int16_t) -1 ) SpotFX[ i ].NextInGroup = &SpotFX[ TempIndex ];
 			else SpotFX[ i ].NextInGroup = NULL;
 		}
+
+		pool_clear( &SpotFXPool );
+		for( Object = FirstSpotFXUsed; Object != NULL; Object = Object->NextUsed )
+			pool_mark( &SpotFXPool, Object->Index );
+		pool_rebuild( &SpotFXPool );
 	}
 
 	return( fp );
@@ -102,8 +102,6 @@ typedef struct SPOTFX {
 	float		MaxHeight;
 	struct	SPOTFX	*	PrevUsed;
 	struct	SPOTFX	*	NextUsed;
-	struct	SPOTFX	*	PrevFree;
-	struct	SPOTFX	*	NextFree;
 	struct	SPOTFX	*	NextInGroup;
 	struct	SPOTFX	*	PrevInGroup;
 
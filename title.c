@@ -56,6 +56,8 @@
 #include "render.h"
 #include "file.h"
 #include "oct2.h"
+#include "perf.h"
+#include "pool.h"
 #include "tload.h"
 
 
@@ -202,7 +204,7 @@ extern int	TeamMembers[MAX_TEAMS];
 extern	int16_t	ShowPortal;
 extern float VduScaleX, VduScaleY;
 extern	FMPOLY			FmPolys[MAXNUMOF2DPOLYS];
-extern	POLY   			Polys[MAXPOLYS];
+extern	POLY   			*	Polys;
 extern  SCRPOLY			ScrPolys[ MAXNUMOFSCRPOLYS ];
 extern	LINE			Lines[ MAXLINES ];
 extern	MXALOADHEADER	MxaModelHeaders[ MAXMXAMODELHEADERS ];
@@ -253,7 +255,7 @@ extern	RENDERMATRIX view;
 extern	bool ClearBuffers( void );
 extern	MATRIX	MATRIX_Identity;
 extern	render_viewport_t viewport;
-extern	MODEL	Models[];
+extern	MODEL	* Models;
 u_int16_t	BackgroundModel[NUMOFTITLEMODELS];
 extern	TLOADHEADER Tloadheader;
 extern	float	LastDistance[];
@@ -9406,6 +9408,12 @@ void GetGamePrefs( void )
 
 	// use original textures if requested and textures/original folder exists
 	use_original_textures = config_get_bool( "UseOriginalTextures", false );
+
+	// frames longer than this (ms) are written to the hitch log, 0 disables
+	HitchBudget = config_get_int( "HitchBudget", 50 );
+
+	// entity tables may grow to this many times their starting size, 1 keeps them fixed
+	PoolGrowth = config_get_int( "PoolGrowth", 4 );
 }
 
 /*===================================================================
@@ -9519,6 +9527,9 @@ void SetGamePrefs( void )
 	config_set_float( "StereoFocalDist",		render_info.stereo_focal_dist );
 	config_set_float( "StereoRightColor",		render_info.stereo_right_color );
 
+	config_set_int( "HitchBudget",			HitchBudget );
+	config_set_int( "PoolGrowth",			PoolGrowth );
+
 	config_save();
 }
 
@@ -13,18 +13,58 @@
 
 #include "transexe.h"
 #include "models.h"
+#include "arena.h"
 
 /*===================================================================
 		Externals...
 ===================================================================*/
 extern RENDERMATRIX identity;
-extern MODEL Models[MAXNUMOFMODELS];
+extern MODEL * Models;
 
 /*===================================================================
 		Globals...
 ===================================================================*/
 int16_t	NumOfTransExe = 0;
-TRANSEXE TransExe[MAXTRANSEXE];
+TRANSEXE * TransExe = NULL;
+static int16_t MaxTransExe = 0;
+static u_int32_t TransExeGeneration = 0;
+
+/*===================================================================
+	Make room for one more TransExe in the frame arena...
+	Output	: bool false if there is no more room
+===================================================================*/
+static bool GrowTransExe( void )
+{
+	TRANSEXE * New;
+	int16_t NewMax;
+
+	// the arena has been reset since the list was made
+	if( TransExeGeneration != FrameArena.generation )
+	{
+		TransExe = NULL;
+		MaxTransExe = 0;
+		NumOfTransExe = 0;
+		TransExeGeneration = FrameArena.generation;
+	}
+
+	if( NumOfTransExe < MaxTransExe )
+		return true;
+
+	if( MaxTransExe >= MAXTRANSEXE )
+		return false;
+
+	NewMax = MaxTransExe ? MaxTransExe * 2 : TRANSEXE_START;
+	New = (TRANSEXE *) arena_alloc( &FrameArena, NewMax * sizeof( TRANSEXE ) );
+	if( !New )
+		return false;
+
+	if( NumOfTransExe )
+		memcpy( New, TransExe, NumOfTransExe * sizeof( TRANSEXE ) );
+
+	TransExe = New;
+	MaxTransExe = NewMax;
+	return true;
+}
 
 
 /*===================================================================
@@ -35,7 +75,7 @@ TRANSEXE TransExe[MAXTRANSEXE];
 ===================================================================*/
 void AddTransExe( /*LPD3DMATRIX Matrix*/RENDERMATRIX *Matrix , /*LPDIRECT3DEXECUTEBUFFER lpExBuf*/RENDEROBJECT *renderObject , int UseIdentity, u_int16_t Model, u_int16_t group, int16_t NumVerts )
 {
-	if( NumOfTransExe < MAXTRANSEXE	)
+	if( GrowTransExe() )
 	{
 		TransExe[NumOfTransExe].UseIdentity = UseIdentity;
 		
@@ -44,7 +84,7 @@ void AddTransExe( /*LPD3DMATRIX Matrix*/RENDERMATRIX *Matrix , /*LPDIRECT3DEXECU
 			TransExe[NumOfTransExe].Matrix = *Matrix;
 		}
 //		TransExe[NumOfTransExe].lpExBuf = lpExBuf;
-		TransExe[NumOfTransExe].renderObject = (*renderObject);
+		TransExe[NumOfTransExe].renderObject = renderObject;
 		TransExe[NumOfTransExe].Model = Model;
 		TransExe[NumOfTransExe].NumVerts = NumVerts;
 		TransExe[NumOfTransExe].group = group;
@@ -107,19 +147,19 @@ void ExecuteTransExe( u_int16_t group )
 				switch( Models[ Model ].Func )
 				{
 					case MODFUNC_Explode:
-						ProcessModelExec( /*TransExe[i].lpExBuf*/&TransExe[i].renderObject, TransExe[i].NumVerts, Models[ Model ].Scale, Models[ Model ].MaxScale, 1, 0, 0 );
+						ProcessModelExec( /*TransExe[i].lpExBuf*/TransExe[i].renderObject, TransExe[i].NumVerts, Models[ Model ].Scale, Models[ Model ].MaxScale, 1, 0, 0 );
 						break;
 		
 					case MODFUNC_Regen:
-						ProcessModelExec( /*TransExe[i].lpExBuf*/&TransExe[i].renderObject, TransExe[i].NumVerts, Models[ Model ].Scale, Models[ Model ].MaxScale, 0, 1, 0 );
+						ProcessModelExec( /*TransExe[i].lpExBuf*/TransExe[i].renderObject, TransExe[i].NumVerts, Models[ Model ].Scale, Models[ Model ].MaxScale, 0, 1, 0 );
 						break;
 					case MODFUNC_Scale:
 					case MODFUNC_Scale2:
-						ProcessModelExec( /*TransExe[i].lpExBuf*/&TransExe[i].renderObject, TransExe[i].NumVerts, Models[ Model ].Scale, Models[ Model ].MaxScale, 0, 0, 1 );
+						ProcessModelExec( /*TransExe[i].lpExBuf*/TransExe[i].renderObject, TransExe[i].NumVerts, Models[ Model ].Scale, Models[ Model ].MaxScale, 0, 0, 1 );
 						break;
 
 					case MODFUNC_SphereZone:
-						ProcessSphereZoneModelExec( /*TransExe[i].lpExBuf*/&TransExe[i].renderObject, TransExe[i].NumVerts, (u_int8_t) Models[ Model ].Red, (u_int8_t) Models[ Model ].Green, (u_int8_t) Models[ Model ].Blue );
+						ProcessSphereZoneModelExec( /*TransExe[i].lpExBuf*/TransExe[i].renderObject, TransExe[i].NumVerts, (u_int8_t) Models[ Model ].Red, (u_int8_t) Models[ Model ].Green, (u_int8_t) Models[ Model ].Blue );
 						break;
 
 					case MODFUNC_OrbitPulsar:
@@ -149,7 +189,7 @@ void ExecuteTransExe( u_int16_t group )
 			}
 
 			if( Display )
-					draw_object(&TransExe[i].renderObject);
+					draw_object(TransExe[i].renderObject);
 
 #ifdef NEW_LIGHTING
 			render_reset_lighting_variables();
@@ -201,19 +241,19 @@ void ExecuteTransExeUnclipped( u_int16_t group )
 				switch( Models[ Model ].Func )
 				{
 					case MODFUNC_Explode:
-						ProcessModelExec( /*TransExe[i].lpExBuf*/&TransExe[i].renderObject, TransExe[i].NumVerts, Models[ Model ].Scale, Models[ Model ].MaxScale, 1, 0, 0 );
+						ProcessModelExec( /*TransExe[i].lpExBuf*/TransExe[i].renderObject, TransExe[i].NumVerts, Models[ Model ].Scale, Models[ Model ].MaxScale, 1, 0, 0 );
 						break;
 					case MODFUNC_Regen:
-						ProcessModelExec( /*TransExe[i].lpExBuf*/&TransExe[i].renderObject, TransExe[i].NumVerts, Models[ Model ].Scale, Models[ Model ].MaxScale, 0, 1, 0 );
+						ProcessModelExec( /*TransExe[i].lpExBuf*/TransExe[i].renderObject, TransExe[i].NumVerts, Models[ Model ].Scale, Models[ Model ].MaxScale, 0, 1, 0 );
 						break;
 		
 					case MODFUNC_Scale:
 					case MODFUNC_Scale2:
-						ProcessModelExec( /*TransExe[i].lpExBuf*/&TransExe[i].renderObject, TransExe[i].NumVerts, Models[ Model ].Scale, Models[ Model ].MaxScale, 0, 0, 1 );
+						ProcessModelExec( /*TransExe[i].lpExBuf*/TransExe[i].renderObject, TransExe[i].NumVerts, Models[ Model ].Scale, Models[ Model ].MaxScale, 0, 0, 1 );
 						break;
 
 					case MODFUNC_SphereZone:
-						ProcessSphereZoneModelExec( /*TransExe[i].lpExBuf*/&TransExe[i].renderObject, TransExe[i].NumVerts, (u_int8_t) Models[ Model ].Red, (u_int8_t) Models[ Model ].Green, (u_int8_t) Models[ Model ].Blue );
+						ProcessSphereZoneModelExec( /*TransExe[i].lpExBuf*/TransExe[i].renderObject, TransExe[i].NumVerts, (u_int8_t) Models[ Model ].Red, (u_int8_t) Models[ Model ].Green, (u_int8_t) Models[ Model ].Blue );
 						break;
 
 					case MODFUNC_OrbitPulsar:
@@ -245,7 +285,7 @@ void ExecuteTransExeUnclipped( u_int16_t group )
 			}
 
 			if( Display )
-					draw_object(&TransExe[i].renderObject);
+					draw_object(TransExe[i].renderObject);
 
 #ifdef NEW_LIGHTING
 			render_reset_lighting_variables();
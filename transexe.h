@@ -4,12 +4,14 @@
 #include "render.h"
 #include "new3d.h"
 
-#define MAXTRANSEXE 128
+// TransExe lives in FrameArena and doubles from here when full
+#define TRANSEXE_START		(64)
+#define MAXTRANSEXE			(16384)
 
 typedef struct _TRANSEXE{
 	int	UseIdentity;
 	RENDERMATRIX  Matrix;
-	RENDEROBJECT renderObject;
+	RENDEROBJECT * renderObject;	// owned by the model / level, not copied
 	int16_t		NumVerts;
 	u_int16_t		Model;
 	u_int16_t		group;
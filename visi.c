@@ -27,6 +27,7 @@
 #include "util.h"
 #include "water.h"
 #include "render.h"
+#include "arena.h"
 
 extern render_info_t render_info;
 
@@ -93,12 +94,19 @@ static GROUPRELATION IndirectVisibleGroup;
 
 static bool InitConnections = false;
 
+static GROUPRELATION PvsGroup;				// groups a camera in each group might see
+static u_int32_t PvsNodes[ MAXGROUPS ];		// portal tree nodes left to clip in each group
+
 
 u_int16_t Num_IndirectVisible = 0;
 u_int16_t IndirectVisible[ MAXGROUPS ];
 
 static VECTOR clip_top, clip_bottom, clip_left, clip_right; // clipping planes
 
+// how far behind a portal the camera can be and still look through it,
+// only set while finding what a pair of stereo eyes can both see
+static float PortalSlack = 0.0F;
+
 int		NumOfVertsConsidered= 0;
 int		NumOfVertsTouched= 0;
 
@@ -365,7 +373,7 @@ bool ReadGroupConnections( MLOADHEADER *m, char **pbuf )
 	tabsize = m->num_groups * GTabRowSize * sizeof( u_int32_t );
 	if ( !ConnectedGroup.table )
 	{
-		ConnectedGroup.table = (u_int32_t *) malloc( tabsize );
+		ConnectedGroup.table = (u_int32_t *) arena_alloc( &LevelArena, tabsize );
 		if ( !ConnectedGroup.table )
 		{
 			Msg( "ReadGroupConnections: failed malloc for ConnectedGroup.table\n" );
@@ -374,7 +382,7 @@ bool ReadGroupConnections( MLOADHEADER *m, char **pbuf )
 	}
 	if ( !VisibleGroup.table )
 	{
-		VisibleGroup.table = (u_int32_t *) malloc( tabsize );
+		VisibleGroup.table = (u_int32_t *) arena_alloc( &LevelArena, tabsize );
 		if ( !VisibleGroup.table )
 		{
 			Msg( "ReadGroupConnections: failed malloc for VisibleGroup.table\n" );
@@ -383,7 +391,7 @@ bool ReadGroupConnections( MLOADHEADER *m, char **pbuf )
 	}
 	if ( !IndirectVisibleGroup.table )
 	{
-		IndirectVisibleGroup.table = (u_int32_t *) malloc( tabsize );
+		IndirectVisibleGroup.table = (u_int32_t *) arena_alloc( &LevelArena, tabsize );
 		if ( !IndirectVisibleGroup.table )
 		{
 			Msg( "ReadGroupConnections: failed malloc for IndirectVisibleGroup.table\n" );
@@ -406,7 +414,7 @@ bool ReadGroupConnections( MLOADHEADER *m, char **pbuf )
 		ConnectedGroup.list[ g ].groups = *buf16++;
 		if ( ConnectedGroup.list[ g ].groups )
 		{
-			ConnectedGroup.list[ g ].group = (u_int16_t *) calloc( ConnectedGroup.list[ g ].groups, sizeof( u_int16_t ) );
+			ConnectedGroup.list[ g ].group = (u_int16_t *) arena_calloc( &LevelArena, ConnectedGroup.list[ g ].groups, sizeof( u_int16_t ) );
 			if ( !ConnectedGroup.list[ g ].group )
 			{
 				Msg( "ReadGroupConnections: failed X_calloc for ConnectedGroup.list[ %d ]\n", g );
@@ -428,7 +436,7 @@ bool ReadGroupConnections( MLOADHEADER *m, char **pbuf )
 		VisibleGroup.list[ g ].groups = *buf16++;
 		if ( VisibleGroup.list[ g ].groups )
 		{
-			VisibleGroup.list[ g ].group = (u_int16_t *) calloc( VisibleGroup.list[ g ].groups, sizeof( u_int16_t ) );
+			VisibleGroup.list[ g ].group = (u_int16_t *) arena_calloc( &LevelArena, VisibleGroup.list[ g ].groups, sizeof( u_int16_t ) );
 			if ( !VisibleGroup.list[ g ].group )
 			{
 				Msg( "ReadGroupConnections: failed X_calloc for VisibleGroup.list[ %d ]\n", g );
@@ -450,7 +458,7 @@ bool ReadGroupConnections( MLOADHEADER *m, char **pbuf )
 		IndirectVisibleGroup.list[ g ].groups = *buf16++;
 		if ( IndirectVisibleGroup.list[ g ].groups )
 		{
-			IndirectVisibleGroup.list[ g ].group = (u_int16_t *) calloc( IndirectVisibleGroup.list[ g ].groups, sizeof( u_int16_t ) );
+			IndirectVisibleGroup.list[ g ].group = (u_int16_t *) arena_calloc( &LevelArena, IndirectVisibleGroup.list[ g ].groups, sizeof( u_int16_t ) );
 			if ( !IndirectVisibleGroup.list[ g ].group )
 			{
 				Msg( "ReadGroupConnections: failed X_calloc for IndirectVisibleGroup.list[ %d ]\n", g );
@@ -493,7 +501,7 @@ bool FindGroupConnections( MLOADHEADER *m )
 	tabsize = MAXGROUPS * GTabRowSize * sizeof( u_int32_t );
 	if ( !ConnectedGroup.table )
 	{
-		ConnectedGroup.table = (u_int32_t *) malloc( tabsize );
+		ConnectedGroup.table = (u_int32_t *) arena_alloc( &LevelArena, tabsize );
 		if ( !ConnectedGroup.table )
 		{
 			Msg( "FindGroupConnections: failed malloc for ConnectedGroup.table\n" );
@@ -502,7 +510,7 @@ bool FindGroupConnections( MLOADHEADER *m )
 	}
 	if ( !VisibleGroup.table )
 	{
-		VisibleGroup.table = (u_int32_t *) malloc( tabsize );
+		VisibleGroup.table = (u_int32_t *) arena_alloc( &LevelArena, tabsize );
 		if ( !VisibleGroup.table )
 		{
 			Msg( "FindGroupConnections: failed malloc for VisibleGroup.table\n" );
@@ -530,7 +538,7 @@ bool FindGroupConnections( MLOADHEADER *m )
 		}
 		if ( ConnectedGroup.list[ g ].groups )
 		{
-			ConnectedGroup.list[ g ].group = (u_int16_t *) calloc( ConnectedGroup.list[ g ].groups, sizeof( u_int16_t ) );
+			ConnectedGroup.list[ g ].group = (u_int16_t *) arena_calloc( &LevelArena, ConnectedGroup.list[ g ].groups, sizeof( u_int16_t ) );
 			if ( !ConnectedGroup.list[ g ].group )
 			{
 				Msg( "FindGroupConnections: failed X_calloc for ConnectedGroup.list[ %d ]\n", g );
@@ -551,7 +559,7 @@ bool FindGroupConnections( MLOADHEADER *m )
 		}
 		if ( VisibleGroup.list[ g ].groups )
 		{
-			VisibleGroup.list[ g ].group = (u_int16_t *) calloc( VisibleGroup.list[ g ].groups, sizeof( u_int16_t ) );
+			VisibleGroup.list[ g ].group = (u_int16_t *) arena_calloc( &LevelArena, VisibleGroup.list[ g ].groups, sizeof( u_int16_t ) );
 			if ( !VisibleGroup.list[ g ].group )
 			{
 				Msg( "FindGroupConnections: failed X_calloc for VisibleGroup.list[ %d ]\n", g );
@@ -582,45 +590,330 @@ void FreeGroupConnections( void )
 
 	if ( !InitConnections )
 		return;
+
+	// tables and lists live in LevelArena which is released with the level
 	for ( g = 0; g < MAXGROUPS; g++ )
 	{
 		ConnectedGroup.list[ g ].groups = 0;
-		if ( ConnectedGroup.list[ g ].group )
-		{
-			free( ConnectedGroup.list[ g ].group );
-		}
 		ConnectedGroup.list[ g ].group = NULL;
 		VisibleGroup.list[ g ].groups = 0;
-		if ( VisibleGroup.list[ g ].group )
-		{
-			free( VisibleGroup.list[ g ].group );
-		}
 		VisibleGroup.list[ g ].group = NULL;
 		IndirectVisibleGroup.list[ g ].groups = 0;
-		if ( IndirectVisibleGroup.list[ g ].group )
-		{
-			free( IndirectVisibleGroup.list[ g ].group );
-		}
 		IndirectVisibleGroup.list[ g ].group = NULL;
 	}
-	if ( ConnectedGroup.table )
+	ConnectedGroup.table = NULL;
+	VisibleGroup.table = NULL;
+	IndirectVisibleGroup.table = NULL;
+
+	for ( g = 0; g < MAXGROUPS; g++ )
 	{
-		free( ConnectedGroup.table );
-		ConnectedGroup.table = NULL;
+		PvsGroup.list[ g ].groups = 0;
+		PvsGroup.list[ g ].group = NULL;
+		PvsNodes[ g ] = 0;
 	}
-	if ( VisibleGroup.table )
+	PvsGroup.table = NULL;
+}
+
+
+
+/*===================================================================
+		Potentially visible sets...
+
+	each group's portal trees list every chain of portals the level
+	editor found, most of which no camera inside the group can ever
+	see down.  a chain is dropped when no camera position near the
+	group's bounding box is in front of all its portals, or when its
+	last portal lies wholly on the camera's side of an earlier one.
+	both tests only throw away chains FindVisible would not draw, so
+	the baked flags are just a shortcut for the runtime portal clip.
+
+	the flags are saved next to the level as a .pvs keyed by the
+	hash of the .mxv, so a changed level is baked again on load.
+===================================================================*/
+
+#define PVS_MAGIC			(0x31535650)	// "PVS1"
+#define PVS_VERSION			(1)
+#define PVS_MAX_DEPTH		(64)			// deeper portals are only tested against the first ones
+#define PVS_GROUP_TOLERANCE	(50.0F)			// twice the slack AmIOutsideGroup gives a ship
+#define PVS_PLANE_EPSILON	(1.0F)
+
+typedef struct
+{
+	u_int32_t magic;
+	u_int32_t version;
+	u_int32_t hash;
+	u_int32_t groups;
+	u_int32_t nodes;
+} PVSHEADER;
+
+// above this many nodes FindVisible draws the whole of the camera group's pvs instead
+static int PvsTreeBudget = 4096;
+
+static VECTOR PvsCorner[ 8 ];
+static PORTAL *PvsChain[ PVS_MAX_DEPTH ];
+
+
+static float PortalDistance( PORTAL *p, VECTOR *pos )
+{
+	MCFACE *pface;
+
+	pface = &p->Poly[ 0 ];
+	return pface->nx * pos->x + pface->ny * pos->y + pface->nz * pos->z + pface->D;
+}
+
+
+static void PvsSetCorners( LVLGROUP *g )
+{
+	int j;
+	VECTOR size;
+
+	size.x = g->half_size.x + PVS_GROUP_TOLERANCE;
+	size.y = g->half_size.y + PVS_GROUP_TOLERANCE;
+	size.z = g->half_size.z + PVS_GROUP_TOLERANCE;
+	for ( j = 0; j < 8; j++ )
 	{
-		free( VisibleGroup.table );
-		VisibleGroup.table = NULL;
+		PvsCorner[ j ].x = g->center.x + ( ( j & 1 ) ? size.x : -size.x );
+		PvsCorner[ j ].y = g->center.y + ( ( j & 2 ) ? size.y : -size.y );
+		PvsCorner[ j ].z = g->center.z + ( ( j & 4 ) ? size.z : -size.z );
 	}
-	if ( IndirectVisibleGroup.table )
+}
+
+
+// can a camera anywhere near the group be in front of the portal
+static bool PvsCameraInFront( PORTAL *p )
+{
+	int j;
+
+	for ( j = 0; j < 8; j++ )
+	{
+		if ( PortalDistance( p, &PvsCorner[ j ] ) >= 0.0F )
+			return true;
+	}
+	return false;
+}
+
+
+// does any of portal p reach past the far side of the earlier portal q
+static bool PvsPortalBeyond( PORTAL *p, PORTAL *q )
+{
+	int vnum;
+
+	for ( vnum = 0; vnum < p->num_vertices_in_portal; vnum++ )
+	{
+		if ( PortalDistance( q, (VECTOR *) &p->Verts[ vnum ] ) < PVS_PLANE_EPSILON )
+			return true;
+	}
+	return false;
+}
+
+
+static void PvsBakeTree( VISTREE *t, int depth )
+{
+	int j;
+
+	t->culled = !PvsCameraInFront( t->portal );
+	for ( j = 0; !t->culled && j < depth && j < PVS_MAX_DEPTH; j++ )
+	{
+		if ( !PvsPortalBeyond( t->portal, PvsChain[ j ] ) )
+			t->culled = true;
+	}
+	if ( depth < PVS_MAX_DEPTH )
+		PvsChain[ depth ] = t->portal;
+	for ( j = 0; j < t->num_visible; j++ )
+	{
+		PvsBakeTree( &t->visible[ j ], depth + 1 );
+	}
+}
+
+
+static void PvsCollectTree( u_int16_t from_group, VISTREE *t )
+{
+	int j;
+
+	if ( t->culled )
+		return;
+	RelateGroups( &PvsGroup, from_group, t->group );
+	PvsNodes[ from_group ]++;
+	for ( j = 0; j < t->num_visible; j++ )
+	{
+		PvsCollectTree( from_group, &t->visible[ j ] );
+	}
+}
+
+
+// calls f on every node of every portal tree in file order, with no f it just counts them
+static void PvsWalkTree( VISTREE *t, void (*f)( VISTREE *t, u_int32_t node ), u_int32_t *node )
+{
+	int j;
+
+	if ( f )
+		f( t, *node );
+	(*node)++;
+	for ( j = 0; j < t->num_visible; j++ )
+	{
+		PvsWalkTree( &t->visible[ j ], f, node );
+	}
+}
+
+
+static u_int32_t PvsWalk( MLOADHEADER *m, void (*f)( VISTREE *t, u_int32_t node ) )
+{
+	u_int16_t g, p;
+	u_int32_t node;
+
+	node = 0;
+	for ( g = 0; g < m->num_groups; g++ )
+	{
+		for ( p = 0; p < m->Group[ g ].num_portals; p++ )
+		{
+			PvsWalkTree( &m->Group[ g ].Portal[ p ].visible, f, &node );
+		}
+	}
+	return node;
+}
+
+
+static u_int8_t *PvsBits;
+
+static void PvsGetNode( VISTREE *t, u_int32_t node )
+{
+	if ( PvsBits[ node >> 3 ] & ( 1 << ( node & 7 ) ) )
+		t->culled = true;
+	else
+		t->culled = false;
+}
+
+static void PvsPutNode( VISTREE *t, u_int32_t node )
+{
+	if ( t->culled )
+		PvsBits[ node >> 3 ] |= 1 << ( node & 7 );
+}
+
+
+static bool PvsRead( MLOADHEADER *m, char *fname, u_int32_t nodes )
+{
+	PVSHEADER header;
+	char *buf;
+	long size;
+	bool ok;
+
+	size = sizeof( header ) + DIV_CEIL( nodes, 8 );
+	if ( !File_Exists( fname ) || Get_File_Size( fname ) != size )
+		return false;
+	buf = (char *) malloc( size );
+	if ( !buf )
+		return false;
+	ok = false;
+	if ( Read_File( fname, buf, size ) == size )
 	{
-		free( IndirectVisibleGroup.table );
-		IndirectVisibleGroup.table = NULL;
+		memmove( &header, buf, sizeof( header ) );
+		if ( header.magic == PVS_MAGIC && header.version == PVS_VERSION && header.hash == m->FileHash
+			&& header.groups == m->num_groups && header.nodes == nodes )
+		{
+			PvsBits = (u_int8_t *) ( buf + sizeof( header ) );
+			PvsWalk( m, PvsGetNode );
+			PvsBits = NULL;
+			ok = true;
+		}
 	}
+	free( buf );
+	return ok;
+}
+
+
+static void PvsWrite( MLOADHEADER *m, char *fname, u_int32_t nodes )
+{
+	PVSHEADER header;
+	char *buf;
+	long size;
+
+	size = sizeof( header ) + DIV_CEIL( nodes, 8 );
+	buf = (char *) calloc( 1, size );
+	if ( !buf )
+		return;
+	header.magic = PVS_MAGIC;
+	header.version = PVS_VERSION;
+	header.hash = m->FileHash;
+	header.groups = m->num_groups;
+	header.nodes = nodes;
+	memmove( buf, &header, sizeof( header ) );
+	PvsBits = (u_int8_t *) ( buf + sizeof( header ) );
+	PvsWalk( m, PvsPutNode );
+	PvsBits = NULL;
+	// a read only level folder just means baking again next time
+	if ( Write_File( fname, buf, size ) != size )
+		DebugPrintf( "PvsInit: could not write %s\n", fname );
+	free( buf );
 }
 
 
+/*===================================================================
+	Procedure	:	Load or bake the potentially visible sets of a level
+	Input		:	MLOADHEADER * , level file name
+	Output		:	bool false if out of memory
+===================================================================*/
+bool PvsInit( MLOADHEADER *m, char *lname )
+{
+	char fname[ 256 ];
+	u_int32_t tabsize, nodes, kept;
+	u_int16_t g, p, g2;
+	int gnum;
+
+	nodes = PvsWalk( m, NULL );
+	Change_Ext( lname, fname, ".pvs" );
+
+	if ( !PvsRead( m, fname, nodes ) )
+	{
+		for ( g = 0; g < m->num_groups; g++ )
+		{
+			PvsSetCorners( &m->Group[ g ] );
+			for ( p = 0; p < m->Group[ g ].num_portals; p++ )
+			{
+				PvsBakeTree( &m->Group[ g ].Portal[ p ].visible, 0 );
+			}
+		}
+		PvsWrite( m, fname, nodes );
+	}
+
+	GTabRowSize = DIV_CEIL( MAXGROUPS, 32 );
+	tabsize = MAXGROUPS * GTabRowSize * sizeof( u_int32_t );
+	PvsGroup.table = (u_int32_t *) arena_alloc( &LevelArena, tabsize );
+	if ( !PvsGroup.table )
+	{
+		Msg( "PvsInit: failed malloc for PvsGroup.table\n" );
+		return false;
+	}
+	memset( PvsGroup.table, 0, tabsize );
+
+	kept = 0;
+	for ( g = 0; g < m->num_groups; g++ )
+	{
+		PvsGroup.list[ g ].groups = 0;
+		PvsNodes[ g ] = 0;
+		RelateGroups( &PvsGroup, g, g );
+		for ( p = 0; p < m->Group[ g ].num_portals; p++ )
+		{
+			PvsCollectTree( g, &m->Group[ g ].Portal[ p ].visible );
+		}
+		kept += PvsNodes[ g ];
+		PvsGroup.list[ g ].group = (u_int16_t *) arena_calloc( &LevelArena, PvsGroup.list[ g ].groups, sizeof( u_int16_t ) );
+		if ( !PvsGroup.list[ g ].group )
+		{
+			Msg( "PvsInit: failed X_calloc for PvsGroup.list[ %d ]\n", g );
+			return false;
+		}
+		gnum = 0;
+		for ( g2 = 0; g2 < m->num_groups; g2++ )
+		{
+			if ( AreGroupsRelated( &PvsGroup, g, g2 ) )
+				PvsGroup.list[ g ].group[ gnum++ ] = g2;
+		}
+	}
+
+	DebugPrintf( "PvsInit: %u of %u portal tree nodes kept\n", kept, nodes );
+
+	return true;
+}
 
 
 GROUPLIST *ConnectedGroups( u_int16_t g )
@@ -884,7 +1177,7 @@ VisiblePortalExtent( CAMERA *cam, VISLIST *v, PORTAL *p, EXTENT *e )
 
 	pface = &p->Poly[ 0 ];
 	d = pface->nx * cam->Pos.x + pface->ny * cam->Pos.y + pface->nz * cam->Pos.z + pface->D;
-	if ( d < 0.0F )
+	if ( d < -PortalSlack )
 		return 0; // camera behind portal
 	init = 0;
 	clip_any = 0;
@@ -932,7 +1225,7 @@ VisiblePortalExtent( CAMERA *cam, VISLIST *v, PORTAL *p, EXTENT *e )
 
 
 static void
-ProcessVisiblePortal( CAMERA *cam, VISLIST *v, VISTREE *t, EXTENT *e )
+ProcessVisiblePortal( CAMERA *cam, VISLIST *v, VISTREE *t, EXTENT *e, float near_z )
 {
 	VISGROUP *adj_group;
 	PORTAL *p;
@@ -940,7 +1233,7 @@ ProcessVisiblePortal( CAMERA *cam, VISLIST *v, VISTREE *t, EXTENT *e )
 	VISTREE *tvis;
 	int vnum;
 
-	if ( !t )
+	if ( !t || t->culled )
 		return;
 	p = t->portal;
 	if ( !VisiblePortalExtent( cam, v, p, &extent ) )
@@ -950,14 +1243,19 @@ ProcessVisiblePortal( CAMERA *cam, VISLIST *v, VISTREE *t, EXTENT *e )
 	MinimiseXYExtent( &extent, e, &extent );
 	if ( !EmptyXYExtent( &extent ) )
 	{
+		if ( near_z > extent.min.z )
+			near_z = extent.min.z;
 		adj_group = &v->group[ t->group ];
 		if ( adj_group->visible )
 		{
 			MaximiseExtent( &adj_group->extent, &extent, &adj_group->extent );
+			if ( adj_group->near_z > near_z )
+				adj_group->near_z = near_z;
 		}
 		else
 		{
 			adj_group->extent = extent;
+			adj_group->near_z = near_z;
 			v->last_visible->next_visible = adj_group;
 			v->last_visible = adj_group;
 			adj_group->next_visible = NULL;
@@ -965,24 +1263,33 @@ ProcessVisiblePortal( CAMERA *cam, VISLIST *v, VISTREE *t, EXTENT *e )
 		adj_group->visible++;
 		for ( vnum = t->num_visible, tvis = t->visible; vnum--; tvis++)
 		{
-			ProcessVisiblePortal( cam, v, tvis, &extent );
+			ProcessVisiblePortal( cam, v, tvis, &extent, near_z );
 		}
 	}
 }
 
-void FindVisible( CAMERA *cam, MLOADHEADER *Mloadheader )
+static void
+AddFullscreenGroup( VISLIST *v, u_int16_t group )
+{
+	VISGROUP *g;
+
+	g = &v->group[ group ];
+	g->extent = v->first_visible->extent;
+	v->last_visible->next_visible = g;
+	v->last_visible = g;
+	g->next_visible = NULL;
+	g->visible++;
+}
+
+static void FindVisibleGroups( CAMERA *cam, MLOADHEADER *Mloadheader )
 {
 	VISLIST *v;
 	VISGROUP *g;
-	XYRECT clip;
-	render_viewport_t *vp;
-	VISGROUP *gsort, *gprev, *gnext;
+	GROUPLIST *pvs;
 	int j;
+	int k;
 	float w, h;
 
-	// helper variable used for stereo adjustment
-	float lr;
-
 	// calculate clipping planes
 	w = (float) tan( hfov );
 	h = w / render_info.aspect_ratio;
@@ -1021,6 +1328,7 @@ void FindVisible( CAMERA *cam, MLOADHEADER *Mloadheader )
 		g->extent.max.x = -HUGE_VALUE;
 		g->extent.max.y = -HUGE_VALUE;
 		g->extent.min.z = -HUGE_VALUE;
+		g->near_z = HUGE_VALUE;
 	}
 
 	// initialise current group
@@ -1037,6 +1345,7 @@ void FindVisible( CAMERA *cam, MLOADHEADER *Mloadheader )
 	g->extent.max.x = (float) ( v->viewport->X + v->viewport->Width );
 	g->extent.max.y = (float) ( v->viewport->Y + v->viewport->Height );
 	g->extent.max.z = HUGE_VALUE;
+	g->near_z = -HUGE_VALUE;
 
 	// process visible portals
 	if ( outside_map )
@@ -1044,23 +1353,40 @@ void FindVisible( CAMERA *cam, MLOADHEADER *Mloadheader )
 		for ( j = 0; j < Mloadheader->num_groups; j++ )
 		{
 			if ( j != cam->GroupImIn )
-			{
-				g = &v->group[ j ];
-				g->extent = v->first_visible->extent;
-				v->last_visible->next_visible = g;
-				v->last_visible = g;
-				g->next_visible = NULL;
-				g->visible++;
-			}
+				AddFullscreenGroup( v, j );
+		}
+	}
+	else if ( PvsGroup.table && PvsNodes[ cam->GroupImIn ] > (u_int32_t) PvsTreeBudget )
+	{
+		// too many portals to clip every frame, the pvs alone bounds what can be seen
+		pvs = &PvsGroup.list[ cam->GroupImIn ];
+		for ( k = 0; k < pvs->groups; k++ )
+		{
+			if ( pvs->group[ k ] != cam->GroupImIn )
+				AddFullscreenGroup( v, pvs->group[ k ] );
 		}
 	}
 	else
 	{
 		for ( j = 0; j < Mloadheader->Group[ cam->GroupImIn].num_portals; j++ )
 		{
-			ProcessVisiblePortal( cam, v, &Mloadheader->Group[ cam->GroupImIn ].Portal [ j ].visible, &g->extent );
+			ProcessVisiblePortal( cam, v, &Mloadheader->Group[ cam->GroupImIn ].Portal [ j ].visible, &g->extent, HUGE_VALUE );
 		}
 	}
+}
+
+static void SetVisibleViewports( CAMERA *cam )
+{
+	VISLIST *v;
+	VISGROUP *g;
+	XYRECT clip;
+	render_viewport_t *vp;
+	VISGROUP *gsort, *gprev, *gnext;
+
+	// helper variable used for stereo adjustment
+	float lr;
+
+	v = &cam->visible;
 
 	// set viewport and projection matrix for each visible group
 	for ( g = v->first_visible; g; g = g->next_visible )
@@ -1146,6 +1472,73 @@ void FindVisible( CAMERA *cam, MLOADHEADER *Mloadheader )
 	}
 }
 
+void FindVisible( CAMERA *cam, MLOADHEADER *Mloadheader )
+{
+	FindVisibleGroups( cam, Mloadheader );
+	SetVisibleViewports( cam );
+}
+
+/*===================================================================
+	Procedure	:	Find the visible groups for a camera and for one
+				:	that is up to offset away along its x axis, as
+				:	the left stereo eye does for the right one
+	Input		:	CAMERA * , MLOADHEADER * , offset
+	Output		:	nothing
+===================================================================*/
+void FindVisibleShared( CAMERA *cam, MLOADHEADER *Mloadheader, float offset )
+{
+	VISLIST *v;
+	VISGROUP *g;
+	float near_depth, depth, margin;
+	float left, right;
+
+	PortalSlack = offset;
+	FindVisibleGroups( cam, Mloadheader );
+	PortalSlack = 0.0F;
+
+	// widen each group by the most its portals can shift between the two
+	// views, which is at the nearest of them and never nearer than the near plane
+	v = &cam->visible;
+	near_depth = -cam->Proj._43 / cam->Proj._33;
+	left = (float) v->viewport->X;
+	right = (float) ( v->viewport->X + v->viewport->Width );
+	for ( g = v->first_visible->next_visible; g; g = g->next_visible )
+	{
+		if ( g->near_z < cam->Proj._33 )
+			depth = cam->Proj._43 / ( g->near_z - cam->Proj._33 );
+		else
+			depth = HUGE_VALUE;
+		if ( depth < near_depth )
+			depth = near_depth;
+		margin = offset * cam->Proj._11 * v->viewport->ScaleX / depth;
+		g->extent.min.x = MAX( g->extent.min.x - margin, left );
+		g->extent.max.x = MIN( g->extent.max.x + margin, right );
+	}
+
+	SetVisibleViewports( cam );
+}
+
+/*===================================================================
+	Procedure	:	Use the groups FindVisibleShared found again
+				:	for the other view, whose viewport has moved
+	Input		:	CAMERA * , how far the viewport has moved
+	Output		:	nothing
+===================================================================*/
+void ReuseVisible( CAMERA *cam, float dx, float dy )
+{
+	VISGROUP *g;
+
+	for ( g = cam->visible.first_visible; g; g = g->next_visible )
+	{
+		g->extent.min.x += dx;
+		g->extent.max.x += dx;
+		g->extent.min.y += dy;
+		g->extent.max.y += dy;
+	}
+
+	SetVisibleViewports( cam );
+}
+
 int ClipGroup( CAMERA *cam, u_int16_t group )
 {
 	VISGROUP *g;
@@ -1214,6 +1607,10 @@ DisplayBackground( MLOADHEADER	* Mloadheader, CAMERA *cam )
 		DisplayTeleportsInGroup( GroupImIn );
 		DisplayExternalForcesInGroup( GroupImIn );
 
+		// all the lighting is done before the first group is drawn
+		if ( !XLightVisibleGroups( Mloadheader, NumGroupsVisible, GroupsVisible ) )
+			return false;
+
 		t = 0;
 		for ( g = cam->visible.first_visible, i = 0; g; g = g->next_visible, i++ )
 		{
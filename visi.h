@@ -33,6 +33,8 @@ bool PortalTestTransformClip( MLOADHEADER * Mloadheader , u_int16_t group );
 void FindVisiblePortals( MLOADHEADER * Mloadheader , u_int16_t group );
 void BuildGroupList ( MLOADHEADER * Mloadheader , u_int16_t group );
 void FindVisible( CAMERA *cam, MLOADHEADER	* Mloadheader );
+void FindVisibleShared( CAMERA *cam, MLOADHEADER * Mloadheader, float offset );
+void ReuseVisible( CAMERA *cam, float dx, float dy );
 int ClipGroup( CAMERA *cam, u_int16_t group );
 bool DisplayBackground( MLOADHEADER	* Mloadheader, CAMERA *cam );
 void InitVisiStats( MLOADHEADER *m );
@@ -43,6 +45,7 @@ void FreeGroupConnections( void );
 GROUPLIST *ConnectedGroups( u_int16_t g );
 GROUPLIST *VisibleGroups( u_int16_t g );
 GROUPLIST *IndirectVisibleGroups( u_int16_t g );
+bool PvsInit( MLOADHEADER *m, char *lname );
 int VisibleOverlap( u_int16_t g1, u_int16_t g2, u_int16_t *overlapping_group );
 bool GroupsAreVisible( u_int16_t g1, u_int16_t g2 );
 bool GroupsAreConnected( u_int16_t g1, u_int16_t g2 );
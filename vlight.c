@@ -0,0 +1,421 @@
+#include <stdio.h>
+#include <math.h>
+#include "main.h"
+#include "util.h"
+#include "lights.h"
+#include "vlight.h"
+
+#if defined( __i386__ ) || defined( __x86_64__ ) || defined( _M_IX86 ) || defined( _M_X64 )
+#define VLIGHT_SSE2
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define VLIGHT_TARGET_SSE2
+#define VLIGHT_TARGET_AVX2
+#else
+#define VLIGHT_TARGET_SSE2 __attribute__(( target( "sse2" ) ))
+#define VLIGHT_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#endif
+#endif
+
+#define VLIGHT_CARRY	(0x01010100)	// lowest bit of each colour's neighbour above
+#define VLIGHT_RGB		(0x00ffffff)
+#define VLIGHT_ALPHA	(0xff000000)
+
+vlight_add_t vlight_add = vlight_add_c;
+
+// packed colour plus a light, each channel stops at 255 rather than spilling into the next
+static COLOR vlight_saturate( COLOR col, u_int32_t inc )
+{
+	u_int32_t carry, clamp;
+
+	carry = ( ( col + inc ) ^ ( col ^ inc ) ) & VLIGHT_CARRY;
+	clamp = carry - ( carry >> 8 );
+	return ( ( ( col + inc - carry ) | clamp ) & VLIGHT_RGB ) | ( col & VLIGHT_ALPHA );
+}
+
+/*===================================================================
+	Procedure	:	One vertex at a time, same sums in the same order
+				:	as XLightVertsScalar
+===================================================================*/
+void vlight_add_c( VLIGHT * light, float * x, float * y, float * z,
+				   u_int16_t * index, LPLVERTEX verts, u_int32_t count )
+{
+	float OSize = light->size;
+	float SizeX2 = OSize * OSize;
+	float Size = 1 / SizeX2;
+	float dx, dy, dz, distance, rlen, Cosa, cosarc2, intense;
+	u_int32_t i, inc;
+	LPLVERTEX v;
+
+	for( i = 0; i < count; i++ )
+	{
+		dx = x[ i ] - light->x;
+		dy = y[ i ] - light->y;
+		dz = z[ i ] - light->z;
+		distance = (dx*dx) + (dy*dy) + (dz*dz);
+		if( !( distance < SizeX2 ) )
+			continue;
+
+		if( !light->spot )
+		{
+			intense = 1.0F - ( distance * Size );
+		}
+		else
+		{
+			if( distance > 0.0F )
+			{
+				distance = (float) sqrt( distance );
+				rlen = 1.0F / distance;
+				dx *= rlen;
+				dy *= rlen;
+				dz *= rlen;
+			}
+			Cosa = ( ( dx*light->dirx ) + ( dy*light->diry ) + ( dz*light->dirz ) );
+
+			if( distance > 0.5F * OSize )
+			{
+				if( !( Cosa > light->cos_arc ) )
+					continue;
+				intense = ( ( OSize - distance ) / ( 0.75F * OSize ) ) * ( ( Cosa - light->cos_arc ) / ( 1.0F - light->cos_arc ) );
+			}
+			else if( distance > MIN_LIGHT_SIZE )
+			{
+				cosarc2 = light->cos_arc * ( 1.0F - ( ( OSize * 0.5F - distance ) / ( OSize * 0.5F - MIN_LIGHT_SIZE ) ) );
+				if( !( Cosa > cosarc2 ) )
+					continue;
+				intense = ( ( OSize - distance ) / ( OSize - MIN_LIGHT_SIZE ) ) * ( ( Cosa - cosarc2 ) / ( 1.0F - cosarc2 ) );
+			}
+			else
+			{
+				intense = ( Cosa > 0.0F ) ? 1.0F : 1.0F + Cosa;
+			}
+		}
+
+		inc = ( (u_int32_t) (int) ( light->r * intense ) << 16 ) +
+			  ( (u_int32_t) (int) ( light->g * intense ) << 8 ) +
+			  (u_int32_t) (int) ( light->b * intense );
+
+		v = index ? &verts[ index[ i ] ] : &verts[ i ];
+		v->color = vlight_saturate( v->color, inc );
+	}
+}
+
+#ifdef VLIGHT_SSE2
+
+/*===================================================================
+	Procedure	:	Four vertices a step, a lane is dropped wherever
+				:	the scalar loop would have skipped the vertex
+===================================================================*/
+VLIGHT_TARGET_SSE2
+static __m128 vlight_select_sse2( __m128 mask, __m128 a, __m128 b )
+{
+	// a where mask is set, b elsewhere
+	return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+}
+
+VLIGHT_TARGET_SSE2
+static void vlight_add_sse2( VLIGHT * light, float * x, float * y, float * z,
+							u_int16_t * index, LPLVERTEX verts, u_int32_t count )
+{
+	float OSize = light->size;
+	float SizeX2 = OSize * OSize;
+	__m128 px = _mm_set1_ps( light->x ), py = _mm_set1_ps( light->y ), pz = _mm_set1_ps( light->z );
+	__m128 size2 = _mm_set1_ps( SizeX2 ), size = _mm_set1_ps( 1 / SizeX2 );
+	__m128 lr = _mm_set1_ps( light->r ), lg = _mm_set1_ps( light->g ), lb = _mm_set1_ps( light->b );
+	__m128 dirx = _mm_set1_ps( light->dirx ), diry = _mm_set1_ps( light->diry ), dirz = _mm_set1_ps( light->dirz );
+	__m128 cos_arc = _mm_set1_ps( light->cos_arc ), cos_div = _mm_set1_ps( 1.0F - light->cos_arc );
+	__m128 osize = _mm_set1_ps( OSize ), half = _mm_set1_ps( OSize * 0.5F );
+	__m128 far_div = _mm_set1_ps( 0.75F * OSize );
+	__m128 min_size = _mm_set1_ps( MIN_LIGHT_SIZE );
+	__m128 near_div = _mm_set1_ps( OSize * 0.5F - MIN_LIGHT_SIZE ), mid_div = _mm_set1_ps( OSize - MIN_LIGHT_SIZE );
+	__m128 one = _mm_set1_ps( 1.0F ), zero = _mm_setzero_ps();
+	__m128 dx, dy, dz, d, ok, rlen, pos, cosa, cosarc2, far, mid, intense, i_far, i_mid, i_near, ok_spot;
+	__m128i lane = _mm_set_epi32( 3, 2, 1, 0 );
+	__m128i carry_bits = _mm_set1_epi32( VLIGHT_CARRY );
+	__m128i rgb = _mm_set1_epi32( VLIGHT_RGB ), alpha = _mm_set1_epi32( (int) VLIGHT_ALPHA );
+	__m128i inc, col, sum, carry, clamp;
+	u_int32_t lc[ 4 ];
+	u_int32_t i;
+	int mask, k;
+
+	for( i = 0; i < count; i += 4 )
+	{
+		// lanes past the end of the run
+		ok = _mm_castsi128_ps( _mm_cmplt_epi32( lane, _mm_set1_epi32( (int) ( count - i ) ) ) );
+
+		dx = _mm_sub_ps( _mm_loadu_ps( &x[ i ] ), px );
+		dy = _mm_sub_ps( _mm_loadu_ps( &y[ i ] ), py );
+		dz = _mm_sub_ps( _mm_loadu_ps( &z[ i ] ), pz );
+		d = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) ), _mm_mul_ps( dz, dz ) );
+		ok = _mm_and_ps( ok, _mm_cmplt_ps( d, size2 ) );
+		if( !_mm_movemask_ps( ok ) )
+			continue;
+
+		if( !light->spot )
+		{
+			intense = _mm_sub_ps( one, _mm_mul_ps( d, size ) );
+		}
+		else
+		{
+			// sqrt of 0 is 0, only the direction needs the > 0 test
+			pos = _mm_cmpgt_ps( d, zero );
+			d = _mm_sqrt_ps( d );
+			rlen = _mm_div_ps( one, d );
+			dx = vlight_select_sse2( pos, _mm_mul_ps( dx, rlen ), dx );
+			dy = vlight_select_sse2( pos, _mm_mul_ps( dy, rlen ), dy );
+			dz = vlight_select_sse2( pos, _mm_mul_ps( dz, rlen ), dz );
+			cosa = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, dirx ), _mm_mul_ps( dy, diry ) ), _mm_mul_ps( dz, dirz ) );
+
+			far = _mm_cmpgt_ps( d, half );
+			mid = _mm_cmpgt_ps( d, min_size );
+
+			i_far = _mm_mul_ps( _mm_div_ps( _mm_sub_ps( osize, d ), far_div ),
+								_mm_div_ps( _mm_sub_ps( cosa, cos_arc ), cos_div ) );
+
+			cosarc2 = _mm_mul_ps( cos_arc, _mm_sub_ps( one, _mm_div_ps( _mm_sub_ps( half, d ), near_div ) ) );
+			i_mid = _mm_mul_ps( _mm_div_ps( _mm_sub_ps( osize, d ), mid_div ),
+								_mm_div_ps( _mm_sub_ps( cosa, cosarc2 ), _mm_sub_ps( one, cosarc2 ) ) );
+
+			i_near = vlight_select_sse2( _mm_cmpgt_ps( cosa, zero ), one, _mm_add_ps( one, cosa ) );
+
+			intense = vlight_select_sse2( far, i_far, vlight_select_sse2( mid, i_mid, i_near ) );
+			ok_spot = vlight_select_sse2( far, _mm_cmpgt_ps( cosa, cos_arc ),
+										  vlight_select_sse2( mid, _mm_cmpgt_ps( cosa, cosarc2 ), _mm_cmpeq_ps( one, one ) ) );
+			ok = _mm_and_ps( ok, ok_spot );
+		}
+
+		mask = _mm_movemask_ps( ok );
+		if( !mask )
+			continue;
+
+		inc = _mm_add_epi32( _mm_add_epi32( _mm_slli_epi32( _mm_cvttps_epi32( _mm_mul_ps( lr, intense ) ), 16 ),
+											_mm_slli_epi32( _mm_cvttps_epi32( _mm_mul_ps( lg, intense ) ), 8 ) ),
+							 _mm_cvttps_epi32( _mm_mul_ps( lb, intense ) ) );
+
+		for( k = 0; k < 4; k++ )
+			lc[ k ] = ( mask & ( 1 << k ) ) ? ( index ? verts[ index[ i + k ] ].color : verts[ i + k ].color ) : 0;
+		col = _mm_loadu_si128( (__m128i *) lc );
+
+		sum = _mm_add_epi32( col, inc );
+		carry = _mm_and_si128( _mm_xor_si128( sum, _mm_xor_si128( col, inc ) ), carry_bits );
+		clamp = _mm_sub_epi32( carry, _mm_srli_epi32( carry, 8 ) );
+		col = _mm_or_si128( _mm_and_si128( _mm_or_si128( _mm_sub_epi32( sum, carry ), clamp ), rgb ),
+							_mm_and_si128( col, alpha ) );
+
+		_mm_storeu_si128( (__m128i *) lc, col );
+		for( k = 0; k < 4; k++ )
+		{
+			if( mask & ( 1 << k ) )
+			{
+				if( index )
+					verts[ index[ i + k ] ].color = lc[ k ];
+				else
+					verts[ i + k ].color = lc[ k ];
+			}
+		}
+	}
+}
+
+/*===================================================================
+	Procedure	:	Eight vertices a step, the sse2 kernel twice as
+				:	wide, no fused multiply adds so nothing rounds
+				:	differently
+===================================================================*/
+VLIGHT_TARGET_AVX2
+static void vlight_add_avx2( VLIGHT * light, float * x, float * y, float * z,
+							u_int16_t * index, LPLVERTEX verts, u_int32_t count )
+{
+	float OSize = light->size;
+	float SizeX2 = OSize * OSize;
+	__m256 px = _mm256_set1_ps( light->x ), py = _mm256_set1_ps( light->y ), pz = _mm256_set1_ps( light->z );
+	__m256 size2 = _mm256_set1_ps( SizeX2 ), size = _mm256_set1_ps( 1 / SizeX2 );
+	__m256 lr = _mm256_set1_ps( light->r ), lg = _mm256_set1_ps( light->g ), lb = _mm256_set1_ps( light->b );
+	__m256 dirx = _mm256_set1_ps( light->dirx ), diry = _mm256_set1_ps( light->diry ), dirz = _mm256_set1_ps( light->dirz );
+	__m256 cos_arc = _mm256_set1_ps( light->cos_arc ), cos_div = _mm256_set1_ps( 1.0F - light->cos_arc );
+	__m256 osize = _mm256_set1_ps( OSize ), half = _mm256_set1_ps( OSize * 0.5F );
+	__m256 far_div = _mm256_set1_ps( 0.75F * OSize );
+	__m256 min_size = _mm256_set1_ps( MIN_LIGHT_SIZE );
+	__m256 near_div = _mm256_set1_ps( OSize * 0.5F - MIN_LIGHT_SIZE ), mid_div = _mm256_set1_ps( OSize - MIN_LIGHT_SIZE );
+	__m256 one = _mm256_set1_ps( 1.0F ), zero = _mm256_setzero_ps();
+	__m256 all = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+	__m256 dx, dy, dz, d, ok, rlen, pos, cosa, cosarc2, far, mid, intense, i_far, i_mid, i_near, ok_spot;
+	__m256i lane = _mm256_set_epi32( 7, 6, 5, 4, 3, 2, 1, 0 );
+	__m256i carry_bits = _mm256_set1_epi32( VLIGHT_CARRY );
+	__m256i rgb = _mm256_set1_epi32( VLIGHT_RGB ), alpha = _mm256_set1_epi32( (int) VLIGHT_ALPHA );
+	__m256i inc, col, sum, carry, clamp;
+	u_int32_t lc[ 8 ];
+	u_int32_t i;
+	int mask, k;
+
+	for( i = 0; i < count; i += 8 )
+	{
+		// lanes past the end of the run
+		ok = _mm256_castsi256_ps( _mm256_cmpgt_epi32( _mm256_set1_epi32( (int) ( count - i ) ), lane ) );
+
+		dx = _mm256_sub_ps( _mm256_loadu_ps( &x[ i ] ), px );
+		dy = _mm256_sub_ps( _mm256_loadu_ps( &y[ i ] ), py );
+		dz = _mm256_sub_ps( _mm256_loadu_ps( &z[ i ] ), pz );
+		d = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dx, dx ), _mm256_mul_ps( dy, dy ) ), _mm256_mul_ps( dz, dz ) );
+		ok = _mm256_and_ps( ok, _mm256_cmp_ps( d, size2, _CMP_LT_OQ ) );
+		if( !_mm256_movemask_ps( ok ) )
+			continue;
+
+		if( !light->spot )
+		{
+			intense = _mm256_sub_ps( one, _mm256_mul_ps( d, size ) );
+		}
+		else
+		{
+			pos = _mm256_cmp_ps( d, zero, _CMP_GT_OQ );
+			d = _mm256_sqrt_ps( d );
+			rlen = _mm256_div_ps( one, d );
+			dx = _mm256_blendv_ps( dx, _mm256_mul_ps( dx, rlen ), pos );
+			dy = _mm256_blendv_ps( dy, _mm256_mul_ps( dy, rlen ), pos );
+			dz = _mm256_blendv_ps( dz, _mm256_mul_ps( dz, rlen ), pos );
+			cosa = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dx, dirx ), _mm256_mul_ps( dy, diry ) ), _mm256_mul_ps( dz, dirz ) );
+
+			far = _mm256_cmp_ps( d, half, _CMP_GT_OQ );
+			mid = _mm256_cmp_ps( d, min_size, _CMP_GT_OQ );
+
+			i_far = _mm256_mul_ps( _mm256_div_ps( _mm256_sub_ps( osize, d ), far_div ),
+								   _mm256_div_ps( _mm256_sub_ps( cosa, cos_arc ), cos_div ) );
+
+			cosarc2 = _mm256_mul_ps( cos_arc, _mm256_sub_ps( one, _mm256_div_ps( _mm256_sub_ps( half, d ), near_div ) ) );
+			i_mid = _mm256_mul_ps( _mm256_div_ps( _mm256_sub_ps( osize, d ), mid_div ),
+								   _mm256_div_ps( _mm256_sub_ps( cosa, cosarc2 ), _mm256_sub_ps( one, cosarc2 ) ) );
+
+			i_near = _mm256_blendv_ps( _mm256_add_ps( one, cosa ), one, _mm256_cmp_ps( cosa, zero, _CMP_GT_OQ ) );
+
+			intense = _mm256_blendv_ps( _mm256_blendv_ps( i_near, i_mid, mid ), i_far, far );
+			ok_spot = _mm256_blendv_ps( _mm256_blendv_ps( all, _mm256_cmp_ps( cosa, cosarc2, _CMP_GT_OQ ), mid ),
+										_mm256_cmp_ps( cosa, cos_arc, _CMP_GT_OQ ), far );
+			ok = _mm256_and_ps( ok, ok_spot );
+		}
+
+		mask = _mm256_movemask_ps( ok );
+		if( !mask )
+			continue;
+
+		inc = _mm256_add_epi32( _mm256_add_epi32( _mm256_slli_epi32( _mm256_cvttps_epi32( _mm256_mul_ps( lr, intense ) ), 16 ),
+												  _mm256_slli_epi32( _mm256_cvttps_epi32( _mm256_mul_ps( lg, intense ) ), 8 ) ),
+								_mm256_cvttps_epi32( _mm256_mul_ps( lb, intense ) ) );
+
+		for( k = 0; k < 8; k++ )
+			lc[ k ] = ( mask & ( 1 << k ) ) ? ( index ? verts[ index[ i + k ] ].color : verts[ i + k ].color ) : 0;
+		col = _mm256_loadu_si256( (__m256i *) lc );
+
+		sum = _mm256_add_epi32( col, inc );
+		carry = _mm256_and_si256( _mm256_xor_si256( sum, _mm256_xor_si256( col, inc ) ), carry_bits );
+		clamp = _mm256_sub_epi32( carry, _mm256_srli_epi32( carry, 8 ) );
+		col = _mm256_or_si256( _mm256_and_si256( _mm256_or_si256( _mm256_sub_epi32( sum, carry ), clamp ), rgb ),
+							   _mm256_and_si256( col, alpha ) );
+
+		_mm256_storeu_si256( (__m256i *) lc, col );
+		for( k = 0; k < 8; k++ )
+		{
+			if( mask & ( 1 << k ) )
+			{
+				if( index )
+					verts[ index[ i + k ] ].color = lc[ k ];
+				else
+					verts[ i + k ].color = lc[ k ];
+			}
+		}
+	}
+}
+
+static bool vlight_has_sse2( void )
+{
+#if defined( __x86_64__ ) || defined( _M_X64 )
+	return true;
+#elif defined( _MSC_VER )
+	int info[ 4 ];
+	__cpuid( info, 1 );
+	return ( info[ 3 ] & ( 1 << 26 ) ) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports( "sse2" ) != 0;
+#endif
+}
+
+static bool vlight_has_avx2( void )
+{
+#if defined( _MSC_VER )
+	int info[ 4 ];
+
+	// the os has to save the wide registers as well
+	__cpuid( info, 1 );
+	if( ( info[ 2 ] & ( ( 1 << 27 ) | ( 1 << 28 ) ) ) != ( ( 1 << 27 ) | ( 1 << 28 ) ) )
+		return false;
+	if( ( _xgetbv( 0 ) & 6 ) != 6 )
+		return false;
+	__cpuidex( info, 7, 0 );
+	return ( info[ 1 ] & ( 1 << 5 ) ) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+}
+
+#endif // VLIGHT_SSE2
+
+// widest first, a kernel is only handed out if the cpu can run it
+static const struct {
+	const char *	name;
+	vlight_add_t	add;
+	bool			(*has)( void );
+} vlight_kernels[] = {
+#ifdef VLIGHT_SSE2
+	{ "avx2", vlight_add_avx2, vlight_has_avx2 },
+	{ "sse2", vlight_add_sse2, vlight_has_sse2 },
+#endif
+	{ "scalar", vlight_add_c, NULL },
+};
+
+#define VLIGHT_KERNELS	( sizeof( vlight_kernels ) / sizeof( vlight_kernels[ 0 ] ) )
+
+/*===================================================================
+	Procedure	:	The n'th kernel this cpu can run, widest first
+	Input		:	int n , where to put its name ( may be NULL )
+	Output		:	vlight_add_t NULL once past the last one
+===================================================================*/
+vlight_add_t vlight_kernel( int n, const char ** name )
+{
+	unsigned i;
+
+	for( i = 0; i < VLIGHT_KERNELS; i++ )
+	{
+		if( vlight_kernels[ i ].has && !vlight_kernels[ i ].has() )
+			continue;
+		if( n-- )
+			continue;
+		if( name )
+			*name = vlight_kernels[ i ].name;
+		return vlight_kernels[ i ].add;
+	}
+
+	return NULL;
+}
+
+/*===================================================================
+	Procedure	:	Pick the widest kernel the cpu can run
+===================================================================*/
+void vlight_init( void )
+{
+	vlight_add = vlight_kernel( 0, NULL );
+	DebugPrintf( "vlight: using the %s vertex light kernel\n", vlight_name() );
+}
+
+const char * vlight_name( void )
+{
+	unsigned i;
+
+	for( i = 0; i < VLIGHT_KERNELS; i++ )
+	{
+		if( vlight_add == vlight_kernels[ i ].add )
+			return vlight_kernels[ i ].name;
+	}
+	return "scalar";
+}
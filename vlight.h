@@ -0,0 +1,59 @@
+#ifndef VLIGHT_INCLUDED
+#define VLIGHT_INCLUDED
+
+/*
+
+	description:
+
+			adds one point or spot light into the colours of a run of
+			vertices, eight at a time with avx2, four at a time with
+			sse2 and one at a time otherwise, every kernel gives the
+			same colours bit for bit as XLightVertsScalar in lights.c
+
+	once at startup, picks the kernel:
+
+			vlight_init();
+
+	or to try every kernel the cpu can run, widest first:
+
+			for( i = 0; ( add = vlight_kernel( i, &name ) ); i++ )
+
+	the positions come in rows, one row per axis, so a step loads
+	them straight in, the colours are wherever the vertices are:
+
+			vlight_add( &light, &x[ first ], &y[ first ], &z[ first ], &index[ first ], verts, count );
+
+	vertex i of the run is verts[ index[ i ] ], or verts[ i ] when
+	index is NULL, a row has to be readable VLIGHT_PAD floats past
+	the end of the run
+
+*/
+
+#include "main.h"
+#include "new3d.h"
+
+#define VLIGHT_PAD	(8)		// widest step less one, rounded up
+
+typedef struct {
+	bool		spot;
+	float		x, y, z;				// where the light is
+	float		size;					// how far it reaches
+	float		r, g, b;
+	float		dirx, diry, dirz;		// spot lights only
+	float		cos_arc;
+} VLIGHT;
+
+typedef void ( *vlight_add_t )( VLIGHT * light, float * x, float * y, float * z,
+							   u_int16_t * index, LPLVERTEX verts, u_int32_t count );
+
+extern vlight_add_t vlight_add;
+
+// one vertex at a time, what every other kernel has to match
+void		vlight_add_c	( VLIGHT * light, float * x, float * y, float * z,
+							  u_int16_t * index, LPLVERTEX verts, u_int32_t count );
+
+vlight_add_t	vlight_kernel	( int n, const char ** name );
+void		vlight_init		( void );
+const char *vlight_name		( void );
+
+#endif
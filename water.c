@@ -209,7 +209,7 @@ bool WaterLoad( void )
 		return( false );
 	}
 	
-	memset(FirstWaterObject, 0, NumOfWaterObjects * sizeof(FirstWaterObject));	
+	memset(FirstWaterObject, 0, NumOfWaterObjects * sizeof(WATEROBJECT));	
 	
 	WO = FirstWaterObject;
 	WO->Group = 0;
@@ -442,6 +442,8 @@ bool InitWaterObject(WATEROBJECT * WO)
 	}
 
 	/*	set the data for the execute buffer	*/
+	if (!FSReserveTextureGroups(&WO->renderObject, 1))
+		return false;
 	WO->renderObject.numTextureGroups = 1;
 	WO->renderObject.textureGroups[0].numTriangles = ntris;
 	WO->renderObject.textureGroups[0].numVerts = WO->num_of_verts;
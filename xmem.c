@@ -1,111 +1,268 @@
-#define XMEM_INCLUDED // we don't want xmem.h to include here
+#define XMEM_INCLUDED // we want the xmem.h api here but not its macros
 #include <stdio.h>
+#include <stdint.h>
 #include "main.h"
 #include "util.h"
 
+/*
+	blocks are kept in an open addressing hash keyed by pointer
+	( linear probing, backward shift delete ) so finding a block is
+	constant time and there is no limit on how many can be live.
+
+	every block points at the call site ( file & line ) that made it,
+	sites keep the live bytes / blocks so leaks can be tracked back.
+*/
+
 size_t	MemUsed = 0;
+int		BlocksUsed = 0;
 
-#define	MAXBLOCKS 16384
+typedef struct {
+	void *	Pnt;
+	size_t	Size;
+	int		Site;
+} XMEM_BLOCK;
 
-bool	BlockUsed[MAXBLOCKS];
-void *	BlockPnts[MAXBLOCKS];
-size_t	BlockSize[MAXBLOCKS];
-char *	BlockInFile[MAXBLOCKS];
-int		BlockInLine[MAXBLOCKS];
-int BlocksUsed = 0;
+#define	XMEM_START_BLOCKS	(16384)	// must be a power of two
+#define	XMEM_START_SITES	(1024)	// must be a power of two
 
-void XMem_Init( void )
+static XMEM_BLOCK *	Blocks = NULL;
+static size_t		BlockMask = 0;
+
+static XMEM_SITE *	Sites = NULL;
+static int			NumSites = 0;
+static int *		SiteHash = NULL;	// index into Sites or -1
+static size_t		SiteMask = 0;
+
+static size_t XMem_HashPnt( void * Pnt )
+{
+	uintptr_t h = (uintptr_t) Pnt;
+	h ^= h >> 4;
+	h *= (uintptr_t) 0x9E3779B97F4A7C15ULL;
+	h ^= h >> 16;
+	return (size_t) h;
+}
+
+static size_t XMem_HashSite( char * in_file, int in_line )
+{
+	return XMem_HashPnt( in_file ) ^ ( (size_t) in_line * 2654435761u );
+}
+
+static bool XMem_GrowBlocks( void )
+{
+	XMEM_BLOCK * Old = Blocks;
+	size_t OldSize = Old ? BlockMask + 1 : 0;
+	size_t NewSize = Old ? OldSize * 2 : XMEM_START_BLOCKS;
+	size_t i, j;
+
+	Blocks = calloc( NewSize, sizeof( XMEM_BLOCK ) );
+	if( !Blocks )
+	{
+		Blocks = Old;
+		return false;
+	}
+	BlockMask = NewSize - 1;
+
+	for( i = 0 ; i < OldSize ; i++ )
+	{
+		if( !Old[i].Pnt )
+			continue;
+		j = XMem_HashPnt( Old[i].Pnt ) & BlockMask;
+		while( Blocks[j].Pnt )
+			j = ( j + 1 ) & BlockMask;
+		Blocks[j] = Old[i];
+	}
+	free( Old );
+	return true;
+}
+
+static bool XMem_GrowSites( void )
 {
-	int i;
+	int * OldHash = SiteHash;
+	XMEM_SITE * NewSites;
+	size_t NewSize = SiteHash ? ( SiteMask + 1 ) * 2 : XMEM_START_SITES;
+	size_t i, j;
+
+	// Sites is only ever half the size of the hash
+	NewSites = realloc( Sites, ( NewSize / 2 ) * sizeof( XMEM_SITE ) );
+	if( !NewSites )
+		return false;
+	Sites = NewSites;
+
+	SiteHash = malloc( NewSize * sizeof( int ) );
+	if( !SiteHash )
+	{
+		SiteHash = OldHash;
+		return false;
+	}
+	SiteMask = NewSize - 1;
+	for( i = 0 ; i < NewSize ; i++ )
+		SiteHash[i] = -1;
 
-	MemUsed =0;
-	for( i = 0 ; i < MAXBLOCKS ; i++ )
+	for( i = 0 ; i < (size_t) NumSites ; i++ )
 	{
-		BlockUsed[i] = false;
-		BlockPnts[i] = NULL;
-		BlockSize[i] = 0;
+		j = XMem_HashSite( Sites[i].File, Sites[i].Line ) & SiteMask;
+		while( SiteHash[j] != -1 )
+			j = ( j + 1 ) & SiteMask;
+		SiteHash[j] = (int) i;
 	}
+	free( OldHash );
+	return true;
 }
 
-int XMem_FindFree( void )
+static int XMem_Site( char * in_file, int in_line )
 {
-	int i;
+	size_t i;
+	int s;
 
-	for( i = 0 ; i < MAXBLOCKS ; i++ )
+	if( ( !SiteHash || (size_t) ( NumSites + 1 ) * 2 > SiteMask + 1 ) && !XMem_GrowSites() )
+		return -1;
+
+	// __FILE__ is a literal so the pointer is enough to tell files apart
+	i = XMem_HashSite( in_file, in_line ) & SiteMask;
+	while( ( s = SiteHash[i] ) != -1 )
 	{
-		if( !BlockUsed[i] )
-		{
-			BlocksUsed++;
-			return i;
-		}
+		if( Sites[s].File == in_file && Sites[s].Line == in_line )
+			return s;
+		i = ( i + 1 ) & SiteMask;
 	}
 
-	return -1;
+	s = NumSites++;
+	memset( &Sites[s], 0, sizeof( XMEM_SITE ) );
+	Sites[s].File = in_file;
+	Sites[s].Line = in_line;
+	SiteHash[i] = s;
+	return s;
+}
+
+static void XMem_SiteAdd( int s, size_t size )
+{
+	if( s < 0 )
+		return;
+	Sites[s].Bytes += size;
+	Sites[s].Blocks++;
+	Sites[s].Total++;
 }
 
-int XMem_FindSame( void * Pnt )
+static void XMem_SiteRemove( int s, size_t size )
 {
-	int i;
-	for( i = 0 ; i < MAXBLOCKS ; i++ )
+	if( s < 0 )
+		return;
+	Sites[s].Bytes -= size;
+	Sites[s].Blocks--;
+}
+
+static XMEM_BLOCK * XMem_FindSame( void * Pnt )
+{
+	size_t i;
+
+	if( !Blocks )
+		return NULL;
+
+	i = XMem_HashPnt( Pnt ) & BlockMask;
+	while( Blocks[i].Pnt )
 	{
-		if( BlockUsed[i] && ( BlockPnts[i] == Pnt ) )
-			return i;
+		if( Blocks[i].Pnt == Pnt )
+			return &Blocks[i];
+		i = ( i + 1 ) & BlockMask;
 	}
-	return -1;
+	return NULL;
 }
 
-void * X_strdup( char *str, char *in_file, int in_line )
+static bool XMem_Add( void * Pnt, size_t size, char *in_file, int in_line )
 {
-	void * Pnt;
-	int i;
-	
-	i = XMem_FindFree();
-	if( i == -1 )
+	size_t i;
+
+	if( ( !Blocks || (size_t) ( BlocksUsed + 1 ) * 2 > BlockMask + 1 ) && !XMem_GrowBlocks() )
 	{
-		DebugPrintf( "MEM: Ran out of free memory Blocks\n"); // break point
-		return NULL;
+		DebugPrintf( "MEM: Ran out of memory for block table\n"); // break point
+		return false;
 	}
 
-	Pnt = strdup( str );
-	
-	if( !Pnt )
-		return Pnt;
+	i = XMem_HashPnt( Pnt ) & BlockMask;
+	while( Blocks[i].Pnt )
+		i = ( i + 1 ) & BlockMask;
 
-	int size = strlen(str)+1;
+	Blocks[i].Pnt = Pnt;
+	Blocks[i].Size = size;
+	Blocks[i].Site = XMem_Site( in_file, in_line );
+	XMem_SiteAdd( Blocks[i].Site, size );
 
-	BlockUsed[i] = true;
-	BlockPnts[i] = Pnt;
-	BlockSize[i] = size;
-	BlockInFile[i] = in_file;
-	BlockInLine[i] = in_line;
 	MemUsed += size;
+	BlocksUsed++;
+	return true;
+}
 
-	return Pnt;
+static void XMem_Remove( XMEM_BLOCK * Block )
+{
+	size_t i = Block - Blocks;
+	size_t j, k;
+
+	MemUsed -= Block->Size;
+	BlocksUsed--;
+	XMem_SiteRemove( Block->Site, Block->Size );
 
+	// shift the rest of the probe chain back so lookups never need tombstones
+	j = i;
+	for(;;)
+	{
+		j = ( j + 1 ) & BlockMask;
+		if( !Blocks[j].Pnt )
+			break;
+		k = XMem_HashPnt( Blocks[j].Pnt ) & BlockMask;
+		if( ( j > i && ( k <= i || k > j ) ) ||
+			( j < i && ( k <= i && k > j ) ) )
+		{
+			Blocks[i] = Blocks[j];
+			i = j;
+		}
+	}
+	Blocks[i].Pnt = NULL;
+	Blocks[i].Size = 0;
+	Blocks[i].Site = -1;
 }
-void * X_malloc( size_t size, char *in_file, int in_line )
+
+void XMem_Init( void )
+{
+	MemUsed = 0;
+	BlocksUsed = 0;
+	if( !Blocks )
+		XMem_GrowBlocks();
+	if( !SiteHash )
+		XMem_GrowSites();
+}
+
+void * X_strdup( char *str, char *in_file, int in_line )
 {
 	void * Pnt;
-	int i;
-	
-	i = XMem_FindFree();
-	if( i == -1 )
+
+	Pnt = strdup( str );
+
+	if( !Pnt )
+		return Pnt;
+
+	if( !XMem_Add( Pnt, strlen(str)+1, in_file, in_line ) )
 	{
-		DebugPrintf( "MEM: Ran out of free memory Blocks\n"); // break point
+		free( Pnt );
 		return NULL;
 	}
 
+	return Pnt;
+
+}
+void * X_malloc( size_t size, char *in_file, int in_line )
+{
+	void * Pnt;
+
 	Pnt = malloc( size );
-	
+
 	if( !Pnt )
 		return Pnt;
 
-	BlockUsed[i] = true;
-	BlockPnts[i] = Pnt;
-	BlockSize[i] = size;
-	BlockInFile[i] = in_file;
-	BlockInLine[i] = in_line;
-	MemUsed += size;
+	if( !XMem_Add( Pnt, size, in_file, in_line ) )
+	{
+		free( Pnt );
+		return NULL;
+	}
 
 	memset(Pnt,0,sizeof(Pnt)); // this protects whole program against dirty memory
 
@@ -116,27 +273,18 @@ void * X_malloc( size_t size, char *in_file, int in_line )
 void * X_calloc( size_t num,size_t size, char *in_file, int in_line )
 {
 	void * Pnt;
-	int i;
-
-	i = XMem_FindFree();
-	if( i == -1 )
-	{
-		DebugPrintf( "MEM: Ran out of free memory Blocks\n"); // break point
-		return NULL;
-	}
 
 	Pnt = calloc( num , size );
 
 	if( !Pnt )
 		return Pnt;
 
-	BlockUsed[i] = true;
-	BlockPnts[i] = Pnt;
-	BlockSize[i] = num * size;
-	BlockInFile[i] = in_file;
-	BlockInLine[i] = in_line;
-	MemUsed += num * size;
-	
+	if( !XMem_Add( Pnt, num * size, in_file, in_line ) )
+	{
+		free( Pnt );
+		return NULL;
+	}
+
 	memset(Pnt,0,sizeof(Pnt)); // this protects whole program against dirty memory
 
 	return Pnt;
@@ -145,10 +293,10 @@ void * X_calloc( size_t num,size_t size, char *in_file, int in_line )
 
 void X_free( void * Pnt, char *in_file, int in_line )
 {
-	int i;
+	XMEM_BLOCK * Block;
 	static char *last_file = NULL;
 	static int last_line = -1;
-	
+
 	if ( !Pnt )
 	{
 		if ( in_file != last_file || in_line != last_line )
@@ -157,8 +305,8 @@ void X_free( void * Pnt, char *in_file, int in_line )
 		last_line = in_line;
 		return;
 	}
-	i = XMem_FindSame( Pnt );
-	if( i == -1 )
+	Block = XMem_FindSame( Pnt );
+	if( !Block )
 	{
 		if ( in_file != last_file || in_line != last_line )
 	 		DebugPrintf( "MEM: Tried to free un-malloced block in %s line %d\n", in_file, in_line ); // break point
@@ -167,61 +315,136 @@ void X_free( void * Pnt, char *in_file, int in_line )
 		return;
 	}
 	free(Pnt);
-	BlockUsed[i] = false;
-	BlockPnts[i] = NULL;
-	BlockInFile[ i ] = NULL;
-	BlockInLine[ i ] = 0;
-
-	MemUsed -= BlockSize[i];
-
-	BlockSize[i] = 0;
-	BlocksUsed--;
+	XMem_Remove( Block );
 }
 
 void * X_realloc( void * Pnt , size_t size, char *in_file, int in_line )
 {
-	int i;
-	
-	i = XMem_FindSame( Pnt );
-	if( i == -1 )
+	XMEM_BLOCK * Block;
+	size_t OldSize;
+
+	// realloc( NULL, size ) is malloc( size ) as in the standard library
+	if( !Pnt )
+		return X_malloc( size, in_file, in_line );
+
+	Block = XMem_FindSame( Pnt );
+	if( !Block )
 	{
 		DebugPrintf( "MEM: tried to realloc un-alloced block\n"); // break point
 		return NULL;
 	}
+	OldSize = Block->Size;
 
 	Pnt = realloc( Pnt , size );
 
 	if( !Pnt )
 		return Pnt;
 
-	BlockUsed[i] = true;
-	BlockPnts[i] = Pnt;
-	BlockInFile[i] = in_file;
-	BlockInLine[i] = in_line;
+	// the block may have moved so it goes back in under its new pointer & site,
+	// removing the old one first leaves the table room so the add cannot grow it,
+	// but a block the table does not hold could never be X_free'd so it goes now
+	XMem_Remove( Block );
+	if( !XMem_Add( Pnt, size, in_file, in_line ) )
+	{
+		DebugPrintf( "MEM: realloc'd block in %s line %d could not be tracked\n", in_file, in_line ); // break point
+		free( Pnt );
+		return NULL;
+	}
 
-	if(size > BlockSize[i]) // this protects whole program against dirty memory
-		memset(Pnt+BlockSize[i],0,size-BlockSize[i]);
+	if(size > OldSize) // this protects whole program against dirty memory
+		memset((char*)Pnt+OldSize,0,size-OldSize);
 
-	MemUsed -= BlockSize[i];
-	BlockSize[i] = size;
-	MemUsed += size;
-	
 	return Pnt;
 
 }
 
+const XMEM_SITE * XMem_Sites( int * num )
+{
+	*num = NumSites;
+	return Sites;
+}
+
+static int XMem_CompareSites( const void * a, const void * b )
+{
+	const XMEM_SITE * sa = *(const XMEM_SITE **) a;
+	const XMEM_SITE * sb = *(const XMEM_SITE **) b;
+	if( sa->Bytes == sb->Bytes )
+		return 0;
+	return ( sa->Bytes < sb->Bytes ) ? 1 : -1;
+}
+
+void XMem_Dump( int max_sites )
+{
+	const XMEM_SITE ** sorted;
+	int i, n = 0;
+
+	DebugPrintf( "MEM: MemUsed = %u   BlocksUsed = %d   Sites = %d\n",
+		(unsigned) MemUsed, BlocksUsed, NumSites );
+
+	if( !NumSites )
+		return;
+
+	// use the real malloc so the dump doesn't show up in itself
+	sorted = malloc( NumSites * sizeof( XMEM_SITE * ) );
+	if( !sorted )
+		return;
+
+	for( i = 0 ; i < NumSites ; i++ )
+		if( Sites[i].Blocks )
+			sorted[n++] = &Sites[i];
+
+	qsort( sorted, n, sizeof( XMEM_SITE * ), XMem_CompareSites );
+
+	if( max_sites > 0 && n > max_sites )
+		n = max_sites;
+
+	for( i = 0 ; i < n ; i++ )
+		DebugPrintf( "MEM: %10u bytes %6d blocks ( %d total ) %s line %d\n",
+			(unsigned) sorted[i]->Bytes, sorted[i]->Blocks, sorted[i]->Total,
+			sorted[i]->File, sorted[i]->Line );
+
+	free( sorted );
+}
+
+int XMem_LevelCheck( void )
+{
+	int i, grown = 0;
+
+	DebugPrintf( "MEM: level change MemUsed = %u   BlocksUsed = %d\n",
+		(unsigned) MemUsed, BlocksUsed );
+
+	// anything holding more blocks than it did at the last level change
+	// is either a cache that is still warming up or a leak
+	for( i = 0 ; i < NumSites ; i++ )
+	{
+		if( Sites[i].Blocks > Sites[i].LevelBlocks )
+		{
+			DebugPrintf( "MEM: %s line %d grew from %d to %d blocks ( %u bytes live )\n",
+				Sites[i].File, Sites[i].Line, Sites[i].LevelBlocks,
+				Sites[i].Blocks, (unsigned) Sites[i].Bytes );
+			grown++;
+		}
+		Sites[i].LevelBytes = Sites[i].Bytes;
+		Sites[i].LevelBlocks = Sites[i].Blocks;
+	}
+
+	return grown;
+}
+
 int UnMallocedBlocks( void )
 {
-	int i;
+	size_t i;
 
 	if ( BlocksUsed )
 	{
-		for ( i = 0; i < MAXBLOCKS; i++ )
+		for ( i = 0; i <= BlockMask; i++ )
 		{
-			if ( BlockUsed[ i ] )
+			if ( Blocks[ i ].Pnt )
 			{
 				DebugPrintf( "MEM: Block size %d allocated in %s line %d but not freed\n",
-					BlockSize[ i ], BlockInFile[ i ], BlockInLine[ i ] ); // break point
+					(int) Blocks[ i ].Size,
+					( Blocks[ i ].Site >= 0 ) ? Sites[ Blocks[ i ].Site ].File : "?",
+					( Blocks[ i ].Site >= 0 ) ? Sites[ Blocks[ i ].Site ].Line : 0 ); // break point
 			}
 		}
 	}
@@ -16,14 +16,37 @@
 #define free( P )		X_free( (P), __FILE__, __LINE__ )
 #define strdup( P )		X_strdup( (P), __FILE__, __LINE__ )
 
+#endif
+
+#endif	// XMEM_INCLUDED
+
+// kept outside the guard above so xmem.c gets the api without the macros
+#ifndef XMEM_API_INCLUDED
+#define XMEM_API_INCLUDED
+
+#include <stddef.h>
+
+// everything allocated from one file & line
+typedef struct {
+	char *	File;
+	int		Line;
+	size_t	Bytes;			// live bytes
+	int		Blocks;			// live blocks
+	int		Total;			// blocks ever allocated
+	size_t	LevelBytes;		// live bytes at the last level change
+	int		LevelBlocks;	// live blocks at the last level change
+} XMEM_SITE;
+
 void XMem_Init( void );
 void * X_calloc( size_t num,size_t size, char *in_file, int in_line );
 void * X_malloc( size_t size, char *in_file, int in_line );
 void X_free( void * Pnt, char *in_file, int in_line );
 void * X_realloc( void * Pnt , size_t size, char *in_file, int in_line );
-void * X_strdup( void * Pnt , char *in_file, int in_line );
+void * X_strdup( char * str , char *in_file, int in_line );
 int UnMallocedBlocks( void );
 
-#endif
+const XMEM_SITE * XMem_Sites( int * num );
+void XMem_Dump( int max_sites );	// biggest sites by live bytes, 0 for all
+int XMem_LevelCheck( void );		// log sites that grew since the last call
 
-#endif	// XMEM_INCLUDED
+#endif	// XMEM_API_INCLUDED